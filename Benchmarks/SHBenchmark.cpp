@@ -0,0 +1,205 @@
+// Headless CPU benchmark of ProjectRadianceSH(): the scalar kernels, the AVX2 kernels and the AVX2 kernels
+// spread over the JobSystem, on a synthetic environment. Needs no window or GPU.
+//
+// SHBenchmark [--width N] [--iterations N] [--format rgba8|rgba16f|rgba32f] [--cube] [--seed N]
+//
+// --width is the width of the equirect image, or the face size with --cube.
+
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/Utils/SphericalHarmonics.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using namespace quark;
+
+namespace {
+
+struct BenchmarkConfig
+{
+    uint32_t width = 2048;
+    uint32_t iterations = 20;
+    rhi::DataFormat format = rhi::DataFormat::R32G32B32A32_SFLOAT;
+    bool cube = false;
+    uint32_t seed = 1;
+};
+
+// std::stoul accepts "-5" and wraps it around, and unsigned long may be wider than uint32_t
+uint32_t ParseUInt32(const char* text)
+{
+    size_t end = 0;
+    const unsigned long long value = std::stoull(text, &end);
+    if (std::strchr(text, '-') || text[end] != '\0')
+        throw std::invalid_argument(text);
+    if (value > std::numeric_limits<uint32_t>::max())
+        throw std::out_of_range(text);
+    return uint32_t(value);
+}
+
+bool ParseArgs(int argc, char** argv, BenchmarkConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        auto match = [&](const char* name) { return std::strcmp(argv[i], name) == 0 && i + 1 < argc; };
+        const char* arg = argv[i];
+
+        // ParseUInt32 throws std::invalid_argument or std::out_of_range on a bad value
+        try
+        {
+            if (match("--width"))               config.width = ParseUInt32(argv[++i]);
+            else if (match("--iterations"))     config.iterations = ParseUInt32(argv[++i]);
+            else if (match("--seed"))           config.seed = ParseUInt32(argv[++i]);
+            else if (std::strcmp(argv[i], "--cube") == 0) config.cube = true;
+            else if (match("--format"))
+            {
+                const std::string format = argv[++i];
+                if (format == "rgba8")          config.format = rhi::DataFormat::R8G8B8A8_UNORM;
+                else if (format == "rgba16f")   config.format = rhi::DataFormat::R16G16B16A16_SFLOAT;
+                else if (format == "rgba32f")   config.format = rhi::DataFormat::R32G32B32A32_SFLOAT;
+                else
+                {
+                    std::cerr << "Unknown format: " << format << std::endl;
+                    return false;
+                }
+            }
+            else
+            {
+                std::cerr << "Unknown or incomplete argument: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            std::cerr << "Invalid value for argument " << arg << ": " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    // The equirect height is half the width
+    if (config.width < 2)
+    {
+        std::cerr << "--width has to be at least 2" << std::endl;
+        return false;
+    }
+
+    config.iterations = std::max(config.iterations, 1u);
+    return true;
+}
+
+// Random radiance, the kernels don't care what the texels hold
+ImageAsset CreateEnvironment(const BenchmarkConfig& config)
+{
+    ImageAsset image;
+    image.format = config.format;
+    image.type = config.cube ? rhi::ImageType::TYPE_CUBE : rhi::ImageType::TYPE_2D;
+    image.width = config.width;
+    image.height = config.cube ? config.width : config.width / 2;
+    image.arraySize = config.cube ? 6 : 1;
+    image.layout.SetUp2D(image.format, image.width, image.height, image.arraySize, 1);
+    image.data.resize(image.layout.GetRequiredSize());
+
+    std::mt19937 rng(config.seed);
+    std::uniform_real_distribution<float> radiance(0.f, 4.f);
+    const uint32_t stride = image.layout.GetBlockStride();
+    for (size_t offset = 0; offset + stride <= image.data.size(); offset += stride)
+    {
+        uint8_t* texel = image.data.data() + offset;
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            const float value = radiance(rng);
+            if (config.format == rhi::DataFormat::R8G8B8A8_UNORM)
+                texel[c] = uint8_t(value * 63.f);
+            else if (config.format == rhi::DataFormat::R16G16B16A16_SFLOAT)
+                reinterpret_cast<uint16_t*>(texel)[c] = glm::packHalf1x16(value);
+            else
+                reinterpret_cast<float*>(texel)[c] = value;
+        }
+    }
+
+    return image;
+}
+
+struct RunStats
+{
+    double mean = 0;
+    double min = 0;
+    SHL2 sh = {};
+};
+
+RunStats Run(const ImageAsset& image, const SHProjectionDesc& desc, uint32_t iterations)
+{
+    using Clock = std::chrono::steady_clock;
+
+    RunStats stats;
+    stats.sh = ProjectRadianceSH(image, desc); // warm up caches and the workers
+    stats.min = 1e30;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        Clock::time_point t0 = Clock::now();
+        stats.sh = ProjectRadianceSH(image, desc);
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        stats.mean += ms / iterations;
+        stats.min = std::min(stats.min, ms);
+    }
+    return stats;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+    if (!ParseArgs(argc, argv, config))
+        return 1;
+
+    Logger::Init();
+    JobSystem job_system;
+
+    const ImageAsset image = CreateEnvironment(config);
+    const uint64_t texels = uint64_t(image.width) * image.height * image.arraySize;
+
+    SHProjectionDesc scalar_desc;
+    scalar_desc.use_simd = false;
+    SHProjectionDesc simd_desc;
+    SHProjectionDesc jobs_desc;
+    jobs_desc.job_system = &job_system;
+
+    const RunStats scalar = Run(image, scalar_desc, config.iterations);
+    const bool has_simd = IsSHProjectionSimdSupported();
+    const RunStats simd = has_simd ? Run(image, simd_desc, config.iterations) : scalar;
+    const RunStats jobs = Run(image, jobs_desc, config.iterations);
+
+    std::cout << "SHBenchmark: " << image.width << "x" << image.height << (config.cube ? " cube, " : " equirect, ")
+              << texels << " texels, " << config.iterations << " iterations, "
+              << job_system.GetNumWorkerThreads() << " workers" << (has_simd ? "" : ", no AVX2") << "\n";
+    std::cout << "kernel          mean_ms    min_ms   Mtexel/s   speedup\n";
+
+    auto print = [&](const char* name, const RunStats& stats)
+    {
+        std::printf("%-14s %9.3f %9.3f %10.1f %9.2f\n", name, stats.mean, stats.min, texels / stats.min / 1000.0, scalar.min / stats.min);
+    };
+    print("scalar", scalar);
+    if (has_simd)
+        print("avx2", simd);
+    print(has_simd ? "avx2_jobs" : "scalar_jobs", jobs);
+
+    // The kernels only differ in summation order
+    double max_difference = 0;
+    for (uint32_t i = 0; i < 9; i++)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+            max_difference = std::max(max_difference, (double)std::abs(scalar.sh[i][c] - jobs.sh[i][c]));
+    }
+    std::cout << "max coefficient difference to scalar: " << max_difference << "\n";
+
+    return 0;
+}
@@ -0,0 +1,437 @@
+// Headless CPU benchmark of the per-frame scene work: Scene::OnUpdate, visibility gathering,
+// render queue building, sorting and flushing the queue into a command list of rhi::Device_Null.
+// Needs no window, GPU or RenderSystem, so it runs on build servers.
+//
+// SceneBenchmark [--entities N] [--children N] [--frames N] [--warmup N] [--moving F] [--seed N]
+//                [--csv path] [--json path] [--record path]
+//
+// --record writes the command stream of the last frame, streams of two builds can be diffed.
+
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/TimeStep.h>
+#include <Quark/Render/IRenderable.h>
+#include <Quark/Render/RenderContext.h>
+#include <Quark/Render/RenderQueue.h>
+#include <Quark/Render/RenderComponents.h>
+#include <Quark/Render/RenderParameters.h>
+#include <Quark/RHI/Null/Device_Null.h>
+#include <Quark/Scene/Scene.h>
+#include <Quark/Scene/Components/TransformCmpt.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using namespace quark;
+
+namespace {
+
+struct BenchmarkConfig
+{
+    uint32_t entities = 10000;  // renderable root entities
+    uint32_t children = 0;      // renderable children per root, exercises the hierarchy
+    uint32_t frames = 500;
+    uint32_t warmup = 20;
+    float moving = 0.1f;        // fraction of roots moved every frame
+    uint32_t seed = 1;
+    std::string csv_path;
+    std::string json_path;
+    std::string record_path;
+};
+
+// Stands in for StaticMesh: same sort key and queue traffic, nothing to draw
+struct BenchmarkInstanceData
+{
+    glm::mat4 model;
+};
+
+struct BenchmarkDrawcallData
+{
+    const rhi::PipeLine* pipeline;
+    const rhi::Buffer* vbo;
+    const rhi::Buffer* ibo;
+    uint32_t index_count;
+};
+
+// Same command pattern as StaticMeshRender
+void BenchmarkRender(rhi::CommandList& cmd, const RenderQueueTask* task, unsigned instance_count)
+{
+    constexpr unsigned max_instances = 256;
+    const auto* drawcall_data = static_cast<const BenchmarkDrawcallData*>(task->perdrawcall_data);
+
+    cmd.BindPipeLine(*drawcall_data->pipeline);
+    cmd.BindVertexBuffer(0, *drawcall_data->vbo, 0);
+    cmd.BindIndexBuffer(*drawcall_data->ibo, 0, rhi::IndexBufferFormat::UINT32);
+
+    unsigned to_render = 0;
+    for (unsigned i = 0; i < instance_count; i += to_render)
+    {
+        to_render = std::min(max_instances, instance_count - i);
+        glm::mat4* ptr = static_cast<glm::mat4*>(cmd.AllocateConstantData(2, 0, sizeof(glm::mat4) * to_render));
+        for (unsigned j = 0; j < to_render; j++)
+            ptr[j] = static_cast<const BenchmarkInstanceData*>(task[i + j].instance_data)->model;
+
+        cmd.DrawIndexed(drawcall_data->index_count, to_render, 0, 0, 0);
+    }
+}
+
+// Gpu objects shared by all renderables
+struct BenchmarkResources
+{
+    std::vector<Ref<rhi::PipeLine>> pipelines; // one per material
+    Ref<rhi::Buffer> vbo;
+    Ref<rhi::Buffer> ibo;
+    uint32_t index_count = 36;
+};
+
+class BenchmarkRenderable : public IRenderable
+{
+public:
+    BenchmarkRenderable(const BenchmarkResources& resources, uint64_t material, uint64_t hash)
+        : m_resources(resources), m_material(material), m_hash(hash), m_aabb(glm::vec3(-0.5f), glm::vec3(0.5f)) {}
+
+    void GetRenderData(const RenderContext& context, const RenderInfoCmpt* transform, RenderQueue& queue) const override
+    {
+        util::Hasher h;
+        h.u64(m_material);
+        util::Hash pipeline_hash = h.get();
+        h.u64(m_hash);
+        util::Hash draw_hash = h.get();
+
+        uint64_t sort_key = BuiltInSortKey::GetSortKey(context, Queue::Opaque, pipeline_hash, pipeline_hash, draw_hash, transform->world_aabb.GetCenter());
+
+        auto* instance_data = queue.AllocateOne<BenchmarkInstanceData>();
+        instance_data->model = transform->world_transform;
+
+        auto* drawcall_data = queue.PushTask<BenchmarkDrawcallData>(Queue::Opaque, m_hash, sort_key, BenchmarkRender, instance_data);
+        if (drawcall_data)
+        {
+            drawcall_data->pipeline = m_resources.pipelines[m_material].get();
+            drawcall_data->vbo = m_resources.vbo.get();
+            drawcall_data->ibo = m_resources.ibo.get();
+            drawcall_data->index_count = m_resources.index_count;
+        }
+    }
+
+    bool HasStaticAabb() const override { return true; }
+    const math::Aabb* GetStaticAabb() const override { return &m_aabb; }
+
+private:
+    const BenchmarkResources& m_resources;
+    uint64_t m_material;
+    uint64_t m_hash;
+    math::Aabb m_aabb;
+};
+
+enum Stage
+{
+    STAGE_SCENE_UPDATE,
+    STAGE_VISIBILITY,
+    STAGE_QUEUE_BUILD,
+    STAGE_QUEUE_SORT,
+    STAGE_FLUSH,
+    STAGE_FRAME,
+    STAGE_COUNT
+};
+
+const char* s_stageNames[STAGE_COUNT] = { "scene_update", "visibility", "queue_build", "queue_sort", "flush", "frame" };
+
+struct StageStats
+{
+    double mean = 0;
+    double p50 = 0;
+    double p99 = 0;
+    double min = 0;
+    double max = 0;
+};
+
+// Nearest rank percentile of sorted samples
+double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+StageStats ComputeStats(std::vector<double> samples)
+{
+    StageStats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples)
+        sum += s;
+
+    stats.mean = sum / samples.size();
+    stats.p50 = Percentile(samples, 0.5);
+    stats.p99 = Percentile(samples, 0.99);
+    stats.min = samples.front();
+    stats.max = samples.back();
+    return stats;
+}
+
+// std::stoul accepts "-5" and wraps it around, and unsigned long may be wider than uint32_t
+uint32_t ParseUInt32(const char* text)
+{
+    size_t end = 0;
+    const unsigned long long value = std::stoull(text, &end);
+    if (std::strchr(text, '-') || text[end] != '\0')
+        throw std::invalid_argument(text);
+    if (value > std::numeric_limits<uint32_t>::max())
+        throw std::out_of_range(text);
+    return uint32_t(value);
+}
+
+bool ParseArgs(int argc, char** argv, BenchmarkConfig& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        auto match = [&](const char* name) { return std::strcmp(argv[i], name) == 0 && i + 1 < argc; };
+        const char* arg = argv[i];
+
+        // ParseUInt32 and std::stof throw std::invalid_argument or std::out_of_range on a bad value
+        try
+        {
+            if (match("--entities"))        config.entities = ParseUInt32(argv[++i]);
+            else if (match("--children"))   config.children = ParseUInt32(argv[++i]);
+            else if (match("--frames"))     config.frames = ParseUInt32(argv[++i]);
+            else if (match("--warmup"))     config.warmup = ParseUInt32(argv[++i]);
+            else if (match("--moving"))     config.moving = std::stof(argv[++i]);
+            else if (match("--seed"))       config.seed = ParseUInt32(argv[++i]);
+            else if (match("--csv"))        config.csv_path = argv[++i];
+            else if (match("--json"))       config.json_path = argv[++i];
+            else if (match("--record"))     config.record_path = argv[++i];
+            else
+            {
+                std::cerr << "Unknown or incomplete argument: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        catch (const std::logic_error&)
+        {
+            std::cerr << "Invalid value for argument " << arg << ": " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    config.frames = std::max(config.frames, 1u);
+    config.moving = std::clamp(config.moving, 0.f, 1.f);
+    return true;
+}
+
+void WriteCsv(const std::string& path, const BenchmarkConfig& config, const StageStats* stats)
+{
+    std::ofstream out(path);
+    out << "stage,entities,frames,mean_ms,p50_ms,p99_ms,min_ms,max_ms\n";
+    for (uint32_t s = 0; s < STAGE_COUNT; s++)
+    {
+        out << s_stageNames[s] << ',' << config.entities * (1 + config.children) << ',' << config.frames << ','
+            << stats[s].mean << ',' << stats[s].p50 << ',' << stats[s].p99 << ','
+            << stats[s].min << ',' << stats[s].max << '\n';
+    }
+}
+
+void WriteJson(const std::string& path, const BenchmarkConfig& config, const StageStats* stats, const rhi::CommandListStats& commands)
+{
+    std::ofstream out(path);
+    out << "{\n";
+    out << "  \"entities\": " << config.entities * (1 + config.children) << ",\n";
+    out << "  \"frames\": " << config.frames << ",\n";
+    out << "  \"moving\": " << config.moving << ",\n";
+    out << "  \"stages\": {\n";
+    for (uint32_t s = 0; s < STAGE_COUNT; s++)
+    {
+        out << "    \"" << s_stageNames[s] << "\": { "
+            << "\"mean_ms\": " << stats[s].mean << ", \"p50_ms\": " << stats[s].p50 << ", \"p99_ms\": " << stats[s].p99
+            << ", \"min_ms\": " << stats[s].min << ", \"max_ms\": " << stats[s].max << " }"
+            << (s + 1 < STAGE_COUNT ? ",\n" : "\n");
+    }
+    out << "  },\n";
+    out << "  \"commands_per_frame\": { "
+        << "\"pipeline_binds\": " << commands.pipelineBinds / config.frames
+        << ", \"vertex_buffer_binds\": " << commands.vertexBufferBinds / config.frames
+        << ", \"resource_binds\": " << commands.resourceBinds / config.frames
+        << ", \"constant_data_bytes\": " << commands.constantDataBytes / config.frames
+        << ", \"draws\": " << commands.draws / config.frames
+        << ", \"instances\": " << commands.instances / config.frames << " }\n";
+    out << "}\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkConfig config;
+    if (!ParseArgs(argc, argv, config))
+        return 1;
+
+    Logger::Init();
+
+    // Cpu only device, the flush stage records real command lists into it
+    rhi::DeviceConfig device_config;
+    rhi::Device_Null device(device_config);
+
+    BenchmarkResources resources;
+    {
+        const uint32_t dummy_code = 0x07230203; // spir-v magic, never looked at
+        rhi::GraphicPipeLineDesc pipeline_desc;
+        pipeline_desc.vertShader = device.CreateShaderFromBytes(rhi::ShaderStage::STAGE_VERTEX, &dummy_code, sizeof(dummy_code));
+        pipeline_desc.fragShader = device.CreateShaderFromBytes(rhi::ShaderStage::STAGE_FRAGEMNT, &dummy_code, sizeof(dummy_code));
+        for (uint32_t m = 0; m < 32; m++)
+            resources.pipelines.push_back(device.CreateGraphicPipeLine(pipeline_desc));
+
+        rhi::BufferDesc buffer_desc;
+        buffer_desc.size = 24 * sizeof(glm::vec3);
+        buffer_desc.usageBits = rhi::BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        resources.vbo = device.CreateBuffer(buffer_desc);
+        buffer_desc.size = resources.index_count * sizeof(uint32_t);
+        buffer_desc.usageBits = rhi::BUFFER_USAGE_INDEX_BUFFER_BIT;
+        resources.ibo = device.CreateBuffer(buffer_desc);
+    }
+
+    rhi::RenderPassInfo render_pass_info;
+    render_pass_info.numColorAttachments = 1;
+    render_pass_info.colorAttachmentFormats[0] = device.GetPresentImageFormat();
+    rhi::FrameBufferInfo frame_buffer_info = {};
+    frame_buffer_info.colorAttachments[0] = &device.GetPresentImage()->GetDefaultView();
+    frame_buffer_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
+    frame_buffer_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
+
+    // Build the scene: roots scattered in a box in front of the camera, some outside the frustum
+    Scene scene("Benchmark");
+    std::mt19937 rng(config.seed);
+    std::uniform_real_distribution<float> pos_xy(-200.f, 200.f);
+    std::uniform_real_distribution<float> pos_z(-400.f, 10.f);
+    std::uniform_real_distribution<float> offset(-2.f, 2.f);
+
+    const uint32_t material_count = (uint32_t)resources.pipelines.size();
+    std::vector<Ref<IRenderable>> renderables;
+    std::vector<Entity*> roots;
+    scene.ReserveEntities(config.entities * (1 + config.children));
+    for (uint32_t i = 0; i < config.entities; i++)
+    {
+        Entity* root = scene.CreateEntity();
+        root->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(pos_xy(rng), pos_xy(rng), pos_z(rng)));
+
+        renderables.push_back(CreateRef<BenchmarkRenderable>(resources, i % material_count, i + 1));
+        scene.AddRenderableComponent(root, renderables.back());
+        roots.push_back(root);
+
+        for (uint32_t c = 0; c < config.children; c++)
+        {
+            Entity* child = scene.CreateEntity("", root);
+            child->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(offset(rng), offset(rng), offset(rng)));
+            scene.AddRenderableComponent(child, renderables.back());
+        }
+    }
+
+    RenderContext context;
+    context.SetScene(&scene);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.f, 0.f, 20.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 1000.f);
+    context.SetCamera(view, proj);
+
+    VisibilityList visibility_list;
+    RenderQueue render_queue;
+
+    std::vector<double> samples[STAGE_COUNT];
+    for (auto& s : samples)
+        s.reserve(config.frames);
+
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](Clock::time_point a, Clock::time_point b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+
+    const uint32_t moving_count = (uint32_t)(config.moving * roots.size());
+    uint32_t move_cursor = 0;
+    size_t visible = 0;
+    for (uint32_t frame = 0; frame < config.warmup + config.frames; frame++)
+    {
+        // Game logic outside the measured stages, a rolling window of roots moves every frame
+        for (uint32_t m = 0; m < moving_count; m++)
+        {
+            auto* transform = roots[move_cursor]->GetComponent<TransformCmpt>();
+            transform->Translate(glm::vec3(0.f, std::sin(frame * 0.1f) * 0.05f, 0.f));
+            move_cursor = (move_cursor + 1) % roots.size();
+        }
+
+        Clock::time_point t0 = Clock::now();
+        scene.OnUpdate(TimeStep(1.f / 60.f));
+
+        Clock::time_point t1 = Clock::now();
+        visibility_list.clear();
+        scene.GatherVisibleOpaqueRenderables(context.GetVisibilityFrustum(), visibility_list);
+
+        Clock::time_point t2 = Clock::now();
+        render_queue.Reset();
+        render_queue.PushRenderables(context, visibility_list.data(), visibility_list.size());
+
+        Clock::time_point t3 = Clock::now();
+        render_queue.Sort();
+
+        Clock::time_point t4 = Clock::now();
+        // Recording only the last frame keeps the stream small and comparable between runs
+        const bool last_frame = frame + 1 == config.warmup + config.frames;
+        device.SetRecordingEnabled(last_frame && !config.record_path.empty());
+        device.BeiginFrame(TimeStep(1.f / 60.f));
+        rhi::CommandList* cmd = device.BeginCommandList();
+        cmd->BeginRenderPass(render_pass_info, frame_buffer_info);
+        // What RenderSystem::Flush does, without the singleton
+        *static_cast<CameraParameters*>(cmd->AllocateConstantData(0, 0, sizeof(CameraParameters))) = context.GetCameraParameters();
+        render_queue.Dispatch(Queue::Opaque, *cmd);
+        cmd->EndRenderPass();
+        device.SubmitCommandList(cmd);
+        device.EndFrame(TimeStep(1.f / 60.f));
+        Clock::time_point t5 = Clock::now();
+
+        if (frame < config.warmup)
+        {
+            device.ResetStats();
+            continue;
+        }
+
+        samples[STAGE_SCENE_UPDATE].push_back(elapsed_ms(t0, t1));
+        samples[STAGE_VISIBILITY].push_back(elapsed_ms(t1, t2));
+        samples[STAGE_QUEUE_BUILD].push_back(elapsed_ms(t2, t3));
+        samples[STAGE_QUEUE_SORT].push_back(elapsed_ms(t3, t4));
+        samples[STAGE_FLUSH].push_back(elapsed_ms(t4, t5));
+        samples[STAGE_FRAME].push_back(elapsed_ms(t0, t5));
+        visible = visibility_list.size();
+    }
+
+    StageStats stats[STAGE_COUNT];
+    for (uint32_t s = 0; s < STAGE_COUNT; s++)
+        stats[s] = ComputeStats(samples[s]);
+
+    std::cout << "SceneBenchmark: " << config.entities * (1 + config.children) << " renderables, "
+              << visible << " visible, " << config.frames << " frames, " << moving_count << " roots moving per frame\n";
+    std::cout << "stage           mean_ms    p50_ms    p99_ms\n";
+    for (uint32_t s = 0; s < STAGE_COUNT; s++)
+    {
+        std::printf("%-14s %9.4f %9.4f %9.4f\n", s_stageNames[s], stats[s].mean, stats[s].p50, stats[s].p99);
+    }
+
+    const rhi::CommandListStats& commands = device.GetStats();
+    std::cout << "per frame: " << commands.pipelineBinds / config.frames << " pipeline binds, "
+              << commands.draws / config.frames << " draws, "
+              << commands.instances / config.frames << " instances\n";
+
+    if (!config.csv_path.empty())
+        WriteCsv(config.csv_path, config, stats);
+    if (!config.json_path.empty())
+        WriteJson(config.json_path, config, stats, commands);
+    if (!config.record_path.empty() && !device.SaveRecordedStream(config.record_path))
+        std::cerr << "Failed to write the command stream to " << config.record_path << std::endl;
+
+    Logger::ShutDown();
+    return 0;
+}
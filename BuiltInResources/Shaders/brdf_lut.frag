@@ -0,0 +1,76 @@
+#version 450
+
+// Split sum environment BRDF, u = NdotV and v = roughness, stores the scale and bias applied to F0 in rg
+layout(location = 0) in vec2 vUV;
+layout(location = 0) out vec4 outFragColor;
+
+const float PI = 3.14159265359;
+const uint SAMPLE_COUNT = 1024u;
+
+float RadicalInverseVdC(uint bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10;
+}
+
+vec2 Hammersley(uint i, uint n)
+{
+	return vec2(float(i) / float(n), RadicalInverseVdC(i));
+}
+
+vec3 ImportanceSampleGGX(vec2 xi, float roughness)
+{
+	float a = roughness * roughness;
+	float phi = 2.0 * PI * xi.x;
+	float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+	float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+	return vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
+}
+
+float GeometrySchlickGGX(float n_dot_v, float roughness)
+{
+	// k for image based lighting
+	float k = (roughness * roughness) / 2.0;
+	return n_dot_v / (n_dot_v * (1.0 - k) + k);
+}
+
+float GeometrySmith(float n_dot_v, float n_dot_l, float roughness)
+{
+	return GeometrySchlickGGX(n_dot_v, roughness) * GeometrySchlickGGX(n_dot_l, roughness);
+}
+
+void main()
+{
+	float n_dot_v = max(vUV.x, 1e-4);
+	float roughness = vUV.y;
+
+	vec3 v = vec3(sqrt(1.0 - n_dot_v * n_dot_v), 0.0, n_dot_v);
+
+	float a = 0.0;
+	float b = 0.0;
+	for (uint i = 0u; i < SAMPLE_COUNT; i++)
+	{
+		vec3 h = ImportanceSampleGGX(Hammersley(i, SAMPLE_COUNT), roughness);
+		vec3 l = normalize(2.0 * dot(v, h) * h - v);
+
+		float n_dot_l = max(l.z, 0.0);
+		float n_dot_h = max(h.z, 0.0);
+		float v_dot_h = max(dot(v, h), 0.0);
+
+		if (n_dot_l > 0.0)
+		{
+			float g = GeometrySmith(n_dot_v, n_dot_l, roughness);
+			float g_vis = (g * v_dot_h) / (n_dot_h * n_dot_v);
+			float fc = pow(1.0 - v_dot_h, 5.0);
+
+			a += (1.0 - fc) * g_vis;
+			b += fc * g_vis;
+		}
+	}
+
+	outFragColor = vec4(a / float(SAMPLE_COUNT), b / float(SAMPLE_COUNT), 0.0, 1.0);
+}
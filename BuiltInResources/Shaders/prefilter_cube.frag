@@ -0,0 +1,91 @@
+#version 450
+
+// GGX prefiltered radiance for image based lighting, rendered once per face and mip level.
+// Source mips are picked from the pdf of each sample to keep the result free of fireflies with few samples.
+layout(set = 2, binding = 0) uniform samplerCube uEnvironment;
+
+layout(std430, push_constant) uniform PrefilterParameters
+{
+	float roughness;
+	float source_size;	// width of the source face at mip 0
+} u_prefilter;
+
+layout(location = 0) in vec3 vDirection;
+layout(location = 0) out vec4 outFragColor;
+
+const float PI = 3.14159265359;
+const uint SAMPLE_COUNT = 512u;
+
+float RadicalInverseVdC(uint bits)
+{
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return float(bits) * 2.3283064365386963e-10;
+}
+
+vec2 Hammersley(uint i, uint n)
+{
+	return vec2(float(i) / float(n), RadicalInverseVdC(i));
+}
+
+vec3 ImportanceSampleGGX(vec2 xi, vec3 n, float roughness)
+{
+	float a = roughness * roughness;
+	float phi = 2.0 * PI * xi.x;
+	float cos_theta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+	float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+
+	vec3 h = vec3(cos(phi) * sin_theta, sin(phi) * sin_theta, cos_theta);
+	vec3 up = abs(n.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, n));
+	vec3 bitangent = cross(n, tangent);
+
+	return normalize(tangent * h.x + bitangent * h.y + n * h.z);
+}
+
+float DistributionGGX(float n_dot_h, float roughness)
+{
+	float a = roughness * roughness;
+	float a2 = a * a;
+	float d = n_dot_h * n_dot_h * (a2 - 1.0) + 1.0;
+	return a2 / (PI * d * d);
+}
+
+void main()
+{
+	// Assume view == normal == reflection, as in the split sum approximation
+	vec3 n = normalize(vDirection);
+
+	if (u_prefilter.roughness <= 0.0)
+	{
+		outFragColor = vec4(textureLod(uEnvironment, n, 0.0).rgb, 1.0);
+		return;
+	}
+
+	float texel_solid_angle = 4.0 * PI / (6.0 * u_prefilter.source_size * u_prefilter.source_size);
+
+	vec3 color = vec3(0.0);
+	float total_weight = 0.0;
+	for (uint i = 0u; i < SAMPLE_COUNT; i++)
+	{
+		vec3 h = ImportanceSampleGGX(Hammersley(i, SAMPLE_COUNT), n, u_prefilter.roughness);
+		vec3 l = normalize(2.0 * dot(n, h) * h - n);
+
+		float n_dot_l = dot(n, l);
+		if (n_dot_l > 0.0)
+		{
+			float n_dot_h = max(dot(n, h), 0.0);
+			float pdf = DistributionGGX(n_dot_h, u_prefilter.roughness) * 0.25 + 0.0001;
+			float sample_solid_angle = 1.0 / (float(SAMPLE_COUNT) * pdf);
+			float mip = 0.5 * log2(sample_solid_angle / texel_solid_angle) + 1.0;
+
+			color += textureLod(uEnvironment, l, max(mip, 0.0)).rgb * n_dot_l;
+			total_weight += n_dot_l;
+		}
+	}
+
+	outFragColor = vec4(color / max(total_weight, 0.0001), 1.0);
+}
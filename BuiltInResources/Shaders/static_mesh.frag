@@ -18,6 +18,21 @@ layout(location = 4) in vec4 vColor;
 
 layout (location = 0) out vec4 outFragColor;
 
+#ifdef BINDLESS
+#include "include/bindless.glslh"
+#include "include/gpu_materials.glslh"
+
+// MaterialTable, bound once for all draws
+layout(set = 1, binding = 0, std430) readonly buffer Materials
+{
+	GpuMaterial u_materials[];
+};
+
+layout(std430, push_constant) uniform StaticMeshFragment
+{
+	uint material_index;
+} u_staticmesh_frag;
+#else
 layout(set = 1, binding = 0) uniform sampler2D u_albedoTex;
 // layout(set = 2, binding = 1) uniform sampler2D u_normalTex;
 // layout(set = 2, binding = 2) uniform sampler2D u_metalRoughTex;
@@ -30,6 +45,7 @@ layout(std430, push_constant) uniform StaticMeshFragment
     float metallic;
     float normal_scale;
 } u_staticmesh_frag;
+#endif
 
 void main() 
 {
@@ -39,7 +55,14 @@ void main()
 	vec3 directional_light_color = u_lighting_parameters.directional.color;
 	directional_light_dir = normalize(directional_light_dir);
 
+#if defined(BINDLESS)
 #ifdef HAVE_UV
+	GpuMaterial material = u_materials[u_staticmesh_frag.material_index];
+	baseColor *= material.base_color.xyz;
+	if ((material.texture_mask & (1u << GPU_MATERIAL_TEXTURE_ALBEDO)) != 0)
+		baseColor *= SampleBindless2D(material.textures[GPU_MATERIAL_TEXTURE_ALBEDO], material.sampler_index, vUV).xyz;
+#endif
+#elif defined(HAVE_UV)
 	baseColor *= (u_staticmesh_frag.base_color.xyz * texture(u_albedoTex, vUV).xyz);
 #endif
 
@@ -56,7 +79,7 @@ void main()
 	// lighting calculations
 	float ldotn = max(dot(normal, directional_light_dir), 0.1f);
 	vec3 diffuse = baseColor * directional_light_color * ldotn;
-	vec3 ambient = baseColor * 0.1;
+	vec3 ambient = baseColor * EvaluateIrradianceSH(normal) * (1.0 / 3.14159265);
 	vec3 result = diffuse + ambient;
 
 	outFragColor = vec4(result ,1.0f);
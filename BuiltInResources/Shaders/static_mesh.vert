@@ -33,6 +33,32 @@ layout(std140, set = 3, binding = 1) uniform BonesWorld
 {
     mat4 u_currentBoneWorldTransforms[256];
 };
+#elif defined(GPU_DRIVEN)
+#include "include/gpu_instances.glslh"
+
+// Written by GpuDrivenRenderer, gl_InstanceIndex starts at the batch's first visible instance
+layout(set = 2, binding = 0, std430) readonly buffer VisibleInstances
+{
+    uint u_visibleInstances[];
+};
+
+layout(set = 2, binding = 1, std430) readonly buffer Instances
+{
+    GpuSceneInstance u_instances[];
+};
+#elif defined(GPU_SCENE)
+#include "include/gpu_instances.glslh"
+
+// GpuScene instance ids, four per element
+layout(set = 2, binding = 0, std140) uniform InstanceIds
+{
+    uvec4 u_instanceIds[64];
+};
+
+layout(set = 2, binding = 1, std430) readonly buffer Instances
+{
+    GpuSceneInstance u_instances[];
+};
 #else
 struct StaticMeshInfo
 {
@@ -49,7 +75,13 @@ void main()
 {
 	vec4 position = vec4(inPosition, 1.0f);
 
+#if defined(GPU_DRIVEN)
+	mat4 world_transform = u_instances[u_visibleInstances[gl_InstanceIndex]].model;
+#elif defined(GPU_SCENE)
+	mat4 world_transform = u_instances[u_instanceIds[gl_InstanceIndex / 4][gl_InstanceIndex % 4]].model;
+#else
 	mat4 world_transform = u_currentInfos[gl_InstanceIndex].model;
+#endif
 	gl_Position = u_camera_parameters.view_projection * world_transform * position;
 
 #ifdef HAVE_NORMAL
@@ -64,13 +64,16 @@ EditorApp::EditorApp(const ApplicationSpecification& specs)
     m_hoverdEntity = nullptr;
 
     // register event callbacks
-    EventManager::Get().Subscribe<KeyPressedEvent>([&](const KeyPressedEvent& e) { OnKeyPressed(e); });
-    EventManager::Get().Subscribe<MouseButtonPressedEvent>([&](const MouseButtonPressedEvent& e) { OnMouseButtonPressed(e); });
+    m_key_subscription = EventManager::Get().Subscribe<KeyPressedEvent>([&](const KeyPressedEvent& e) { OnKeyPressed(e); });
+    m_mouse_subscription = EventManager::Get().Subscribe<MouseButtonPressedEvent>([&](const MouseButtonPressedEvent& e) { OnMouseButtonPressed(e); });
     
 }
 
 EditorApp::~EditorApp()
 {   
+    EventManager::Get().Unsubscribe(m_key_subscription);
+    EventManager::Get().Unsubscribe(m_mouse_subscription);
+
     // save asset registry
     // AssetManager::Get().SaveAssetRegistry();
 }
@@ -163,6 +166,13 @@ void EditorApp::OnImGuiUpdate()
         ImGui::Text("Frame Time: %f ms", m_status.lastFrameDuration);
         ImGui::Text("CmdList Record Time: %f ms", m_cmdListRecordTime);
 
+#ifdef QK_ENABLE_PROFILER
+        if (Profiler::IsCapturePending())
+            ImGui::Text("Capturing cpu trace...");
+        else if (ImGui::Button("Capture CPU Trace (10 frames)"))
+            Profiler::RequestCapture(10, "cpu_trace.json");
+#endif
+
         std::string entityName = "None";
         if (m_hoverdEntity)
             entityName = m_hoverdEntity->GetComponent<NameCmpt>()->name;
@@ -181,6 +191,12 @@ void EditorApp::OnImGuiUpdate()
     // Content Browser
     m_contentBrowserPanel.OnImGuiUpdate();
 
+    // GPU timings
+    m_gpuProfilerPanel.OnImGuiUpdate();
+
+    // Command list stats
+    m_renderStatsPanel.OnImGuiUpdate();
+
     // Scene view port
     ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{ 0, 0 });
     ImGui::Begin("Viewport");
@@ -265,7 +281,7 @@ void EditorApp::NewScene()
 
 void EditorApp::OpenScene()
 {
-    std::filesystem::path filepath = FileSystem::OpenFileDialog({ { "Quark Scene", "qkscene" } });
+    std::filesystem::path filepath = FileSystem::OpenFileDialog({ { "Quark Scene", "qkscene,qkbscene" } });
     if (!filepath.empty())
         OpenScene(filepath);
 }
@@ -273,8 +289,11 @@ void EditorApp::OpenScene()
 void EditorApp::OpenScene(const std::filesystem::path& path)
 {
     m_scene = CreateRef<Scene>("");
-    SceneSerializer serializer(m_scene);
-    serializer.Deserialize(path.string());
+    SceneSerializer serializer(m_scene, Application::Get().GetJobSystem());
+    if (SceneSerializer::IsBinaryScene(path))
+        serializer.DeserializeBinary(path);
+    else
+        serializer.Deserialize(path);
 
     m_heirarchyPanel.SetScene(m_scene);
     m_inspectorPanel.SetScene(m_scene);
@@ -284,11 +303,14 @@ void EditorApp::OpenScene(const std::filesystem::path& path)
 
 void EditorApp::SaveSceneAs()
 {
-    std::filesystem::path filepath = FileSystem::SaveFileDialog({ { "Quark Scene", "qkscene" } });
+    std::filesystem::path filepath = FileSystem::SaveFileDialog({ { "Quark Scene", "qkscene" }, { "Quark Binary Scene", "qkbscene" } });
     if (!filepath.empty())
     {
         SceneSerializer serializer(m_scene);
-        serializer.Serialize(filepath.string());
+        if (SceneSerializer::IsBinaryScene(filepath))
+            serializer.SerializeBinary(filepath);
+        else
+            serializer.Serialize(filepath);
     }
 }
 
@@ -360,152 +382,105 @@ void EditorApp::OnRender(TimeStep ts)
         scissor.offset.x = 0;
         scissor.offset.y = 0;
 
+        // Render graph: barriers, attachment lifetimes and store ops are derived from the declared accesses
+        RenderGraph& graph = *m_render_graph;
+        graph.Reset();
+
+        const RenderResourceManager& resource_manager = render_system.GetRenderResourceManager();
+        RenderGraphImageDesc depth_desc;
+        depth_desc.width = m_color_attachment->GetDesc().width;
+        depth_desc.height = m_color_attachment->GetDesc().height;
+        depth_desc.format = resource_manager.format_depthAttachment_main;
+
+        RenderGraphResource color = graph.ImportImage("Main color", m_color_attachment.get(),
+            rhi::ImageLayout::UNDEFINED, rhi::ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+        RenderGraphResource depth = graph.CreateImage("Main depth", depth_desc);
+        RenderGraphResource swapchain = graph.ImportImage("Swapchain", swap_chain_image,
+            rhi::ImageLayout::UNDEFINED, rhi::ImageLayout::PRESENT);
+
         // Main pass
         {
-            rhi::PipelineImageBarrier image_barrier;
-            image_barrier.image = m_color_attachment.get();
-            image_barrier.srcStageBits = rhi::PIPELINE_STAGE_ALL_GRAPHICS_BIT;
-            image_barrier.srcMemoryAccessBits = 0;
-            image_barrier.dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_READ_BIT | rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barrier.layoutBefore = rhi::ImageLayout::UNDEFINED;
-            image_barrier.layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, &image_barrier, 1, nullptr, 0);
-
-            // Begin pass
-            rhi::FrameBufferInfo fb_info;
-            fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.colorAttachments[0] = m_color_attachment.get();
-            fb_info.clearColors[0] = { 0.2f, 0.2f, 0.2f, 0.f };
-            fb_info.depthAttachment = m_depth_attachment.get();
-            fb_info.depthAttachmentLoadOp = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.depthAttachmentStoreOp = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.clearDepthStencil.depth_stencil = { 1.f, 0 };
-
-            graphic_cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_simpleMainPass, fb_info);
-            graphic_cmd->SetViewPort(viewport);
-            graphic_cmd->SetScissor(scissor);
-
-            // draw skybox
-            // render_system.DrawSkybox(m_drawContext, m_cubeMapTexture, graphic_cmd);
-            render_system.DrawSkybox(m_cubeMapId, graphic_cmd);
-            
-            // draw infinite grid
-            // render_system.DrawGrid(graphic_cmd);
-
-            // draw scene
-            auto geometry_start = m_timer.ElapsedMillis();
-            render_system.DrawScene(*render_scene, render_scene->main_camera_visibility, graphic_cmd);
-            m_cmdListRecordTime = m_timer.ElapsedMillis() - geometry_start;
-
-            graphic_cmd->EndRenderPass();
+            rhi::ClearValue clear_color = { 0.2f, 0.2f, 0.2f, 0.f };
+
+            RenderGraphPass& pass = graph.AddPass("Main pass");
+            pass.AddColorOutput(color, rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR, clear_color);
+            pass.SetDepthStencilOutput(depth);
+            pass.SetExecute([&](rhi::CommandList& cmd) 
+            {
+                cmd.SetViewPort(viewport);
+                cmd.SetScissor(scissor);
+
+                // draw skybox
+                render_system.DrawSkybox(m_cubeMapId, &cmd);
+
+                // draw infinite grid
+                // render_system.DrawGrid(&cmd);
+
+                // draw scene
+                auto geometry_start = m_timer.ElapsedMillis();
+                render_system.DrawScene(*render_scene, render_scene->main_camera_visibility, &cmd);
+                m_cmdListRecordTime = m_timer.ElapsedMillis() - geometry_start;
+            });
         }
 
         // ui pass
         {
-            rhi::PipelineImageBarrier image_barriers[2];
-            image_barriers[0].image = swap_chain_image;
-            image_barriers[0].srcStageBits = rhi::PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-            image_barriers[0].srcMemoryAccessBits = 0;
-            image_barriers[0].dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barriers[0].dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barriers[0].layoutBefore = rhi::ImageLayout::UNDEFINED;
-            image_barriers[0].layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            image_barriers[1].image = m_color_attachment.get();
-            image_barriers[1].srcStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            image_barriers[1].srcMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            image_barriers[1].dstStageBits = rhi::PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-            image_barriers[1].dstMemoryAccessBits = rhi::BARRIER_ACCESS_SHADER_READ_BIT;
-            image_barriers[1].layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            image_barriers[1].layoutAfter = rhi::ImageLayout::SHADER_READ_ONLY_OPTIMAL;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, image_barriers, 2, nullptr, 0);
-
-            rhi::FrameBufferInfo fb_info;
-            fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-            fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-            fb_info.colorAttachments[0] = swap_chain_image;
-
-            graphic_cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_swapchainPass, fb_info);
-            UI::Get()->OnRender(graphic_cmd);
-            graphic_cmd->EndRenderPass();
+            RenderGraphPass& pass = graph.AddPass("UI pass");
+            pass.AddTextureInput(color);
+            pass.AddColorOutput(swapchain);
+            pass.SetExecute([](rhi::CommandList& cmd) { UI::Get()->OnRender(&cmd); });
         }
 
-        // transit swapchain image to present layout for presenting
+        // color picking
+        if (m_viewportHovered)
         {
-            rhi::PipelineImageBarrier present_barrier;
-            present_barrier.image = swap_chain_image;
-            present_barrier.srcStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-            present_barrier.srcMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-            present_barrier.dstStageBits = rhi::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-            present_barrier.dstMemoryAccessBits = 0;
-            present_barrier.layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-            present_barrier.layoutAfter = rhi::ImageLayout::PRESENT;
-            graphic_cmd->PipeLineBarriers(nullptr, 0, &present_barrier, 1, nullptr, 0);
-
-            // Submit graphic command list
-            rhi_device->SubmitCommandList(graphic_cmd);
+            RenderGraphImageDesc entity_id_desc = depth_desc;
+            entity_id_desc.format = rhi::DataFormat::R32G32_UINT;
+
+            // The depth image has the same desc as the main depth and is aliased onto it
+            RenderGraphResource entity_id = graph.CreateImage("EntityID color", entity_id_desc);
+            RenderGraphResource entity_id_depth = graph.CreateImage("EntityID depth", depth_desc);
+
+            rhi::ClearValue clear_id = {};
+            clear_id.color.uint32[0] = 0;
+            clear_id.color.uint32[1] = 10;
+
+            RenderGraphPass& id_pass = graph.AddPass("EntityID pass");
+            id_pass.AddColorOutput(entity_id, rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR, clear_id);
+            id_pass.SetDepthStencilOutput(entity_id_depth);
+            id_pass.SetExecute([&](rhi::CommandList& cmd)
+            {
+                cmd.SetViewPort(viewport);
+                cmd.SetScissor(scissor);
+                render_system.DrawEntityID(*render_scene, render_scene->main_camera_visibility, &cmd);
+            });
+
+            // transfer data back to cpu buffer
+            RenderGraphPass& readback_pass = graph.AddPass("EntityID readback");
+            readback_pass.AddTransferInput(entity_id);
+            readback_pass.SetSideEffect();
+            readback_pass.SetExecute([&, entity_id](rhi::CommandList& cmd)
+            {
+                auto [mx, my] = ImGui::GetMousePos();
+                mx -= m_viewportBounds[0].x;
+                my -= m_viewportBounds[0].y;
+                glm::vec2 viewportSize = m_viewportBounds[1] - m_viewportBounds[0];
+                int mouseX = (int)mx;
+                int mouseY = (int)my;
+                uint32_t image_width = m_color_attachment->GetDesc().width;
+                uint32_t image_height = m_color_attachment->GetDesc().height;
+                int x = static_cast<int>(((mouseX / viewportSize.x) * image_width));
+                int y = static_cast<int>(((mouseY / viewportSize.y) * image_height));
+                cmd.CopyImageToBuffer(*m_stage_buffer, *graph.GetImage(entity_id), 0, { x, y, 0 },
+                    { 1, 1, 1 }, 0, 0, { rhi::ImageAspect::COLOR, 0, 0, 1 });
+            });
         }
 
-         // color picking
-         if (m_viewportHovered)
-         {
-             // color ID pass
-             rhi::CommandList* cmd = rhi_device->BeginCommandList();
-
-             rhi::PipelineImageBarrier image_barrier;
-             image_barrier.image = m_entityID_color_attachment.get();
-             image_barrier.srcStageBits = rhi::PIPELINE_STAGE_TRANSFER_BIT;
-             image_barrier.srcMemoryAccessBits = rhi::BARRIER_ACCESS_TRANSFER_READ_BIT;
-             image_barrier.dstStageBits = rhi::PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-             image_barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-             image_barrier.layoutBefore = rhi::ImageLayout::UNDEFINED;
-             image_barrier.layoutAfter = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-             cmd->PipeLineBarriers(nullptr, 0, &image_barrier, 1, nullptr, 0);
-
-             rhi::FrameBufferInfo fb_info;
-             fb_info.colorAttatchemtsLoadOp[0] = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-             fb_info.colorAttatchemtsStoreOp[0] = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-             fb_info.colorAttachments[0] = m_entityID_color_attachment.get();
-             fb_info.clearColors[0].color.uint32[0] = 0;
-             fb_info.clearColors[0].color.uint32[1] = 10;
-             fb_info.depthAttachment = m_entityID_depth_attachment.get();
-             fb_info.depthAttachmentLoadOp = rhi::FrameBufferInfo::AttachmentLoadOp::CLEAR;
-             fb_info.depthAttachmentStoreOp = rhi::FrameBufferInfo::AttachmentStoreOp::STORE;
-             fb_info.clearDepthStencil.depth_stencil = { 1.f, 0 };
-
-             cmd->BeginRenderPass(render_system.GetRenderResourceManager().renderPassInfo_entityIdPass, fb_info);
-             cmd->SetViewPort(viewport);
-             cmd->SetScissor(scissor);
-             render_system.DrawEntityID(*render_scene, render_scene->main_camera_visibility, cmd);
-             cmd->EndRenderPass();
-
-             // transfer data back to cpu buffer
-             rhi::PipelineImageBarrier barrier;
-             barrier.image = m_entityID_color_attachment.get();
-             barrier.srcStageBits = rhi::PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-             barrier.srcMemoryAccessBits = 0;
-             barrier.dstStageBits = rhi::PIPELINE_STAGE_TRANSFER_BIT;
-             barrier.dstMemoryAccessBits = rhi::BARRIER_ACCESS_TRANSFER_READ_BIT;
-             barrier.layoutBefore = rhi::ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
-             barrier.layoutAfter = rhi::ImageLayout::TRANSFER_SRC_OPTIMAL;
-             cmd->PipeLineBarriers(nullptr, 0, &barrier, 1, nullptr, 0);
-
-             auto [mx, my] = ImGui::GetMousePos();
-             mx -= m_viewportBounds[0].x;
-             my -= m_viewportBounds[0].y;
-             glm::vec2 viewportSize = m_viewportBounds[1] - m_viewportBounds[0];
-             int mouseX = (int)mx;
-             int mouseY = (int)my;
-             uint32_t image_width = m_color_attachment->GetDesc().width;
-             uint32_t image_height = m_color_attachment->GetDesc().height;
-             int x = static_cast<int>(((mouseX / viewportSize.x) * image_width));
-             int y = static_cast<int>(((mouseY / viewportSize.y) * image_height));
-             cmd->CopyImageToBuffer(*m_stage_buffer, *m_entityID_color_attachment, 0, { x, y, 0 },
-                 { 1, 1, 1 }, 0, 0, { rhi::ImageAspect::COLOR, 0, 0, 1 });
-
-             rhi_device->SubmitCommandList(cmd, nullptr, 0, false);
-         }
+        graph.Compile();
+        graph.Execute(*graphic_cmd);
+
+        // Submit graphic command list
+        rhi_device->SubmitCommandList(graphic_cmd);
 
         rhi_device->EndFrame(ts);
     }
@@ -564,32 +539,23 @@ void EditorApp::CreateGraphicResources()
 {
     using namespace quark::rhi;
     auto rhi_device = RenderSystem::Get().GetDevice();
-    // Create depth image
+    // Create viewport color image
     ImageDesc image_desc;
     image_desc.type = ImageType::TYPE_2D;
-    auto ratio = Application::Get().GetWindow()->GetRatio();
     image_desc.width = uint32_t(Application::Get().GetWindow()->GetMonitorWidth() * Application::Get().GetWindow()->GetRatio());
     image_desc.height = uint32_t(Application::Get().GetWindow()->GetMonitorHeight() * Application::Get().GetWindow()->GetRatio());
     image_desc.depth = 1;
-    image_desc.format = RenderSystem::Get().GetRenderResourceManager().format_depthAttachment_main;
     image_desc.arraySize = 1;
     image_desc.mipLevels = 1;
-    image_desc.initialLayout = ImageLayout::DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-    image_desc.usageBits = IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-    m_depth_attachment = rhi_device->CreateImage(image_desc);
-    m_entityID_depth_attachment = rhi_device->CreateImage(image_desc);
 
-    // Create color image
+    // Depth and entity ID attachments are transient images of the render graph
+    m_render_graph = CreateScope<RenderGraph>(rhi_device);
+
     image_desc.format = RenderSystem::Get().GetRenderResourceManager().format_colorAttachment_main;
     image_desc.initialLayout = ImageLayout::UNDEFINED;
     image_desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rhi::IMAGE_USAGE_SAMPLING_BIT;
     m_color_attachment = rhi_device->CreateImage(image_desc);
 
-    // Create entityID image
-    image_desc.format = DataFormat::R32G32_UINT;
-    image_desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_CAN_COPY_FROM_BIT;
-    m_entityID_color_attachment = rhi_device->CreateImage(image_desc);
-
     // Create stage buffer
     BufferDesc buffer_desc;
     buffer_desc.domain = BufferMemoryDomain::CPU;
@@ -3,6 +3,7 @@
 #include <Quark/Core/FileSystem.h>
 #include <Quark/Scene/Scene.h>
 #include <Quark/Render/RenderSystem.h>
+#include <Quark/Render/RenderGraph.h>
 #include <Quark/Events/KeyEvent.h>
 #include <Quark/Events/MouseEvent.h>
 #include <Quark/Asset/GLTFImporter.h>
@@ -11,6 +12,8 @@
 #include "Editor/Panel/SceneHeirarchyPanel.h"
 #include "Editor/Panel/InspectorPanel.h"
 #include "Editor/Panel/ContentBrowserPanel.h"
+#include "Editor/Panel/GpuProfilerPanel.h"
+#include "Editor/Panel/RenderStatsPanel.h"
 
 namespace quark {
 class EditorApp : public quark::Application {
@@ -37,10 +40,8 @@ private:
     void CreateGraphicResources();
 
     GLTFImporter m_gltfImporter;
-    Ref<rhi::Image> m_depth_attachment;
-    Ref<rhi::Image> m_color_attachment;
-    Ref<rhi::Image> m_entityID_color_attachment;
-    Ref<rhi::Image> m_entityID_depth_attachment;
+    Scope<RenderGraph> m_render_graph;
+    Ref<rhi::Image> m_color_attachment; // imported into the graph, sampled by the viewport panel
 
     Ref<rhi::Buffer> m_stage_buffer;
 
@@ -58,10 +59,15 @@ private:
     bool m_viewportHovered;
     int m_gizmoType = -1;
 
+    EventManager::SubscriptionId m_key_subscription = EventManager::invalid_subscription;
+    EventManager::SubscriptionId m_mouse_subscription = EventManager::invalid_subscription;
+
     // UI window
     SceneHeirarchyPanel m_heirarchyPanel;
     InspectorPanel m_inspectorPanel;
     ContentBrowserPanel m_contentBrowserPanel;
+    GpuProfilerPanel m_gpuProfilerPanel;
+    RenderStatsPanel m_renderStatsPanel;
     
     // Debug
     double m_cmdListRecordTime = 0;
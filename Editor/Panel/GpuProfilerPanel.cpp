@@ -0,0 +1,100 @@
+#include "Editor/Panel/GpuProfilerPanel.h"
+
+#include <Quark/Render/RenderSystem.h>
+#include <imgui.h>
+
+namespace quark {
+
+static constexpr double s_averageFactor = 0.05;
+
+void GpuProfilerPanel::OnImGuiUpdate()
+{
+    Ref<rhi::Device> device = RenderSystem::Get().GetDevice();
+
+    if (ImGui::Begin("GPU Profiler"))
+    {
+        bool enabled = device->IsGpuProfilingEnabled();
+        if (ImGui::Checkbox("Enabled", &enabled))
+            device->SetGpuProfilingEnabled(enabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Pause", &m_paused);
+
+        const rhi::GpuFrameTimings& latest = device->GetGpuFrameTimings();
+        if (!m_paused && latest.frameIndex != m_timings.frameIndex)
+        {
+            m_timings = latest;
+
+            // Rebuild the tree, regions are in depth first order so parents come first
+            m_roots.clear();
+            m_children.assign(m_timings.regions.size(), {});
+            m_paths.assign(m_timings.regions.size(), {});
+            for (uint32_t i = 0; i < (uint32_t)m_timings.regions.size(); i++)
+            {
+                const rhi::GpuTimingRegion& region = m_timings.regions[i];
+                if (region.parent == ~0u)
+                {
+                    m_roots.push_back(i);
+                    m_paths[i] = region.name;
+                }
+                else
+                {
+                    m_children[region.parent].push_back(i);
+                    m_paths[i] = m_paths[region.parent] + "/" + region.name;
+                }
+
+                auto [it, inserted] = m_averageMs.try_emplace(m_paths[i], region.durationMs);
+                if (!inserted)
+                    it->second += (region.durationMs - it->second) * s_averageFactor;
+            }
+        }
+
+        ImGui::Text("Frame %llu: %.3f ms", (unsigned long long)m_timings.frameIndex, m_timings.totalMs);
+
+        ImGuiTableFlags table_flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable;
+        if (ImGui::BeginTable("GpuTimings", 4, table_flags))
+        {
+            ImGui::TableSetupColumn("Region", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("Start (ms)");
+            ImGui::TableSetupColumn("Time (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableHeadersRow();
+
+            for (uint32_t root : m_roots)
+                DrawRegion(root);
+
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+void GpuProfilerPanel::DrawRegion(uint32_t index)
+{
+    const rhi::GpuTimingRegion& region = m_timings.regions[index];
+    const std::vector<uint32_t>& children = m_children[index];
+    auto average = m_averageMs.find(m_paths[index]);
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+    if (children.empty())
+        flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+    bool open = ImGui::TreeNodeEx((void*)(uint64_t)index, flags, "%s", region.name.c_str());
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", region.startMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", region.durationMs);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", average != m_averageMs.end() ? average->second : region.durationMs);
+
+    if (open && !children.empty())
+    {
+        for (uint32_t child : children)
+            DrawRegion(child);
+        ImGui::TreePop();
+    }
+}
+
+}
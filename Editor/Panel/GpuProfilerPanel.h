@@ -0,0 +1,27 @@
+#pragma once
+#include <Quark/RHI/Device.h>
+
+#include "Editor/Panel/Panel.h"
+
+namespace quark {
+
+// Shows the gpu timing tree of the latest resolved frame
+class GpuProfilerPanel final : public Panel {
+public:
+    GpuProfilerPanel() = default;
+
+    void OnImGuiUpdate() override;
+
+private:
+    void DrawRegion(uint32_t index);
+
+    rhi::GpuFrameTimings m_timings;
+    std::vector<std::vector<uint32_t>> m_children;
+    std::vector<uint32_t> m_roots;
+    std::vector<std::string> m_paths;
+    std::unordered_map<std::string, double> m_averageMs; // smoothed durations, keyed by region path
+
+    bool m_paused = false;
+};
+
+}
@@ -0,0 +1,74 @@
+#include "Editor/Panel/RenderStatsPanel.h"
+
+#include <Quark/Render/RenderSystem.h>
+#include <imgui.h>
+
+namespace quark {
+
+static constexpr double s_averageFactor = 0.05;
+
+void RenderStatsPanel::OnImGuiUpdate()
+{
+    if (ImGui::Begin("Render Stats"))
+    {
+        ImGui::Checkbox("Pause", &m_paused);
+        if (!m_paused)
+            m_stats = RenderSystem::Get().GetDevice()->GetFrameStats();
+
+        ImGui::Text("Descriptor set cache hit rate: %.1f%%", m_stats.GetDescriptorSetHitRate() * 100.0);
+
+        ImGuiTableFlags table_flags = ImGuiTableFlags_BordersV | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable;
+        if (ImGui::BeginTable("render_stats", 3, table_flags))
+        {
+            ImGui::TableSetupColumn("Counter", ImGuiTableColumnFlags_NoHide);
+            ImGui::TableSetupColumn("Frame");
+            ImGui::TableSetupColumn("Avg");
+            ImGui::TableHeadersRow();
+
+            uint32_t row = 0;
+            DrawRow("Command lists", m_stats.commandLists, m_average[row++]);
+            DrawRow("Pipeline binds", m_stats.pipelineBinds, m_average[row++]);
+            DrawRow("Resource binds", m_stats.resourceBinds, m_average[row++]);
+            DrawRow("Descriptor set requests", m_stats.descriptorSetRequests, m_average[row++]);
+            DrawRow("Descriptor set cache hits", m_stats.descriptorSetCacheHits, m_average[row++]);
+            DrawRow("Descriptor set updates", m_stats.descriptorSetUpdates, m_average[row++]);
+            DrawRow("Descriptor set rebinds", m_stats.descriptorSetRebinds, m_average[row++]);
+            DrawRow("Vertex buffer binds", m_stats.vertexBufferBinds, m_average[row++]);
+            DrawRow("Index buffer binds", m_stats.indexBufferBinds, m_average[row++]);
+            DrawRow("Push constant updates", m_stats.pushConstantUpdates, m_average[row++]);
+            DrawRow("Draws", m_stats.draws, m_average[row++]);
+            DrawRow("Indirect draws", m_stats.indirectDraws, m_average[row++]);
+            DrawRow("Instances", m_stats.instances, m_average[row++]);
+            DrawRow("Primitives", m_stats.primitives, m_average[row++]);
+            DrawRow("Dispatches", m_stats.dispatches, m_average[row++]);
+            DrawRow("Render passes", m_stats.renderPasses, m_average[row++]);
+            DrawRow("Barriers", m_stats.barriers, m_average[row++]);
+            DrawRow("Copies", m_stats.copies, m_average[row++]);
+            DrawRow("Constant data (KB)", m_stats.constantDataBytes / 1024, m_average[row++]);
+            DrawRow("Vertex data (KB)", m_stats.vertexDataBytes / 1024, m_average[row++]);
+            QK_CORE_ASSERT(row <= MAX_ROWS)
+            m_averageValid = true;
+
+            ImGui::EndTable();
+        }
+    }
+    ImGui::End();
+}
+
+void RenderStatsPanel::DrawRow(const char* name, uint64_t value, double& average)
+{
+    if (!m_averageValid)
+        average = (double)value;
+    else if (!m_paused)
+        average += ((double)value - average) * s_averageFactor;
+
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted(name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%llu", (unsigned long long)value);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", average);
+}
+
+}
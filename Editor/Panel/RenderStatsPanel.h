@@ -0,0 +1,27 @@
+#pragma once
+#include <Quark/RHI/CommandList.h>
+
+#include "Editor/Panel/Panel.h"
+
+namespace quark {
+
+// Shows the command list stats of the previous frame
+class RenderStatsPanel final : public Panel {
+public:
+    RenderStatsPanel() = default;
+
+    void OnImGuiUpdate() override;
+
+private:
+    void DrawRow(const char* name, uint64_t value, double& average);
+
+    rhi::CommandListStats m_stats;
+
+    // Smoothed values, in the order of the rows
+    static constexpr uint32_t MAX_ROWS = 32;
+    double m_average[MAX_ROWS] = {};
+    bool m_averageValid = false;
+    bool m_paused = false;
+};
+
+}
@@ -159,7 +159,7 @@ AssetType AssetManager::GetAssetTypeFromExtension(const std::string& extension)
 	std::string ext = util::string::ToLowerCopy(extension);
 	if (s_AssetExtensionMap.find(ext) == s_AssetExtensionMap.end())
 	{
-		QK_CORE_LOGW_TAG("AssetManger", "No asset type found for extension{0}", ext);
+		QK_CORE_LOGW_TAG("AssetManager", "No asset type found for extension{0}", ext);
 		return AssetType::None;
 	}
 
@@ -2,6 +2,7 @@
 #include "Quark/Asset/GLTFImporter.h"
 #include "Quark/Asset/ImageAsset.h"
 #include "Quark/Asset/AssetManager.h"
+#include "Quark/Asset/TextureCooker.h"
 #include "Quark/Animation/SkeletonAsset.h"
 #include "Quark/Animation/AnimationAsset.h"
 #include "Quark/Core/Application.h"
@@ -139,12 +140,12 @@ namespace quark {
                 if (std::find(m_gltf_model.extensionsRequired.begin(), m_gltf_model.extensionsRequired.end(), used_extension) != m_gltf_model.extensionsRequired.end())
                     QK_CORE_VERIFY(0, "Cannot load glTF file. Contains a required unsupported extension: {}", used_extension)
                 else
-                    QK_CORE_LOGW_TAG("AssetManger", "glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+                    QK_CORE_LOGW_TAG("AssetManager", "glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
             }
             else
             {
                 // Extension is supported, so enable it
-                QK_CORE_LOGI_TAG("AssetManger", "glTF file contains extension: {}", used_extension);
+                QK_CORE_LOGI_TAG("AssetManager", "glTF file contains extension: {}", used_extension);
                 it->second = true;
             }
         }
@@ -163,6 +164,8 @@ namespace quark {
                 Ref<ImageAsset> newImage = ParseImage(m_gltf_model.images[image_index]);
                 m_images[image_index] = newImage;
             }
+
+            CookImages();
         }
 
         if (flags & ImportingFlags::ImportAnimations)
@@ -522,10 +525,60 @@ namespace quark {
             }
         }
 
-        QK_CORE_LOGW_TAG("AssetManger", "GLTFImporter::ParseImage::Failed to load image: {}", gltf_image.uri);
+        QK_CORE_LOGW_TAG("AssetManager", "GLTFImporter::ParseImage::Failed to load image: {}", gltf_image.uri);
         return nullptr;
     }
 
+    void GLTFImporter::CookImages()
+    {
+        // Images which no material references are cooked as color
+        std::vector<std::optional<TextureRole>> roles(m_images.size());
+        auto set_role = [&](int texture_index, TextureRole role)
+        {
+            if (texture_index < 0 || texture_index >= (int)m_gltf_model.textures.size() || m_gltf_model.textures[texture_index].source < 0)
+                return;
+
+            // An image sampled as color and as something else stays color, BC7 keeps all four channels. Otherwise the first role wins.
+            const int image_index = m_gltf_model.textures[texture_index].source;
+            std::optional<TextureRole>& image_role = roles[image_index];
+            if (image_role && *image_role != role)
+            {
+                const TextureRole kept = (role == TextureRole::Color) ? role : *image_role;
+                const char* role_names[] = { "color", "normal", "data" };
+                QK_CORE_LOGW_TAG("AssetManager", "GLTFImporter::CookImages: Image {} is sampled as {} and as {}, cooking it as {}",
+                    image_index, role_names[(int)*image_role], role_names[(int)role], role_names[(int)kept]);
+                image_role = kept;
+                return;
+            }
+            image_role = role;
+        };
+
+        for (const auto& gltf_material : m_gltf_model.materials)
+        {
+            set_role(gltf_material.pbrMetallicRoughness.baseColorTexture.index, TextureRole::Color);
+            set_role(gltf_material.emissiveTexture.index, TextureRole::Color);
+            set_role(gltf_material.pbrMetallicRoughness.metallicRoughnessTexture.index, TextureRole::Data);
+            set_role(gltf_material.occlusionTexture.index, TextureRole::Data);
+            set_role(gltf_material.normalTexture.index, TextureRole::Normal);
+        }
+
+        // Without BC support the images are still uploaded with their mips, just uncompressed
+        const bool compression_supported = m_rhi_device && m_rhi_device->GetDeviceFeatures().textureCompressionBC;
+
+        TextureCooker cooker;
+        for (size_t image_index = 0; image_index < m_images.size(); image_index++)
+        {
+            if (!m_images[image_index])
+                continue;
+
+            TextureCookSettings settings;
+            settings.role = roles[image_index].value_or(TextureRole::Color);
+            settings.compress = compression_supported && m_rhi_device->isFormatSupported(TextureCooker::GetCompressedFormat(settings.role));
+            settings.job_system = Application::Get().GetJobSystem().get();
+            cooker.Cook(*m_images[image_index], settings);
+        }
+    }
+
     Ref<MaterialAsset> GLTFImporter::ParseMaterial(const tinygltf::Material& mat)
     {
         auto newMaterial = CreateRef<MaterialAsset>();
@@ -572,6 +625,12 @@ namespace quark {
             Ref<ImageAsset> img = m_images[m_gltf_model.textures[textureIndex].source];
             newMaterial->baseColorImage = img->GetAssetID();
         }
+
+        if (mat.normalTexture.index >= 0)
+        {
+            Ref<ImageAsset> img = m_images[m_gltf_model.textures[mat.normalTexture.index].source];
+            newMaterial->normalImage = img->GetAssetID();
+        }
     
         return newMaterial;
     }
@@ -764,7 +823,7 @@ namespace quark {
                     break;
                 }
                 default:
-                    QK_CORE_LOGW_TAG("AssetManger", "Index component type: {} not supported!", accessor.componentType);
+                    QK_CORE_LOGW_TAG("AssetManager", "Index component type: {} not supported!", accessor.componentType);
                     return nullptr;
                 }
             }
@@ -49,6 +49,10 @@ private:
     Ref<MeshAsset> ParseMesh(const tinygltf::Mesh& gltf_mesh);
     Entity* ParseNode(const tinygltf::Node& gltf_node);
 
+    // Builds the mips of the images and block compresses them by how the materials sample them, see TextureCooker.
+    // Images imported on their own by ImageImporter are left as they are, nothing tells their role there.
+    void CookImages();
+
     void LoadSkins();
     void LoadAnimations();
     void MatchAnimationsToSkeletons();
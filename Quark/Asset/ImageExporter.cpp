@@ -0,0 +1,160 @@
+#include "Quark/qkpch.h"
+#include "Quark/Asset/ImageExporter.h"
+#include "Quark/Asset/Ktx2Format.h"
+#include "Quark/Core/FileSystem.h"
+
+namespace quark
+{
+
+    // Basic data format descriptor for four channel RGBA texels with the same type per channel
+    static void WriteBasicDataFormatDescriptor(std::vector<uint32_t>& dfd, uint32_t type_size, bool is_float)
+    {
+        constexpr uint32_t sample_count = 4;
+        constexpr uint32_t block_size = 24 + 16 * sample_count;
+        const uint32_t bits = type_size * 8;
+
+        dfd.clear();
+        dfd.push_back(4 + block_size);                  // dfdTotalSize
+        dfd.push_back(0);                               // vendorId = Khronos, descriptorType = basic
+        dfd.push_back(2 | (block_size << 16));          // versionNumber = 1.3, descriptorBlockSize
+        dfd.push_back(1 | (1 << 8) | (1 << 16));        // colorModel = RGBSDA, primaries = BT709, transfer = linear
+        dfd.push_back(0);                               // texel block dimensions 1x1x1
+        dfd.push_back(type_size * sample_count);        // bytesPlane0
+        dfd.push_back(0);
+
+        for (uint32_t c = 0; c < sample_count; c++)
+        {
+            const uint32_t channel = (c == 3) ? 15 : c;  // R, G, B, A
+            const uint32_t qualifiers = is_float ? (0x80 | 0x40) : 0; // float, signed
+
+            dfd.push_back((c * bits) | ((bits - 1) << 16) | ((channel | qualifiers) << 24));
+            dfd.push_back(0);   // sample position
+            dfd.push_back(is_float ? 0xBF800000u : 0u); // -1.0f
+            dfd.push_back(is_float ? 0x3F800000u : (bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1)); // 1.0f
+        }
+    }
+
+    // Descriptor of the BC formats, the samples cover whole 4x4 blocks, see the "Compressed formats" section of the KDF spec
+    static void WriteBlockCompressedDataFormatDescriptor(std::vector<uint32_t>& dfd, rhi::DataFormat format)
+    {
+        struct Sample { uint32_t bit_offset, bit_length, channel; };
+        uint32_t color_model = 0;
+        std::vector<Sample> samples;
+        switch (format)
+        {
+        case rhi::DataFormat::BC1_RGBA_UNORM_BLOCK:
+            color_model = 128;
+            samples = { { 0, 64, 0 }, { 0, 64, 1 } };      // color, alpha present
+            break;
+        case rhi::DataFormat::BC3_UNORM_BLOCK:
+            color_model = 130;
+            samples = { { 0, 64, 15 }, { 64, 64, 0 } };    // alpha, color
+            break;
+        case rhi::DataFormat::BC5_UNORM_BLOCK:
+            color_model = 132;
+            samples = { { 0, 64, 0 }, { 64, 64, 1 } };     // red, green
+            break;
+        default: // BC7_UNORM_BLOCK
+            color_model = 134;
+            samples = { { 0, 128, 0 } };                   // color
+            break;
+        }
+
+        const uint32_t block_size = 24 + 16 * uint32_t(samples.size());
+
+        dfd.clear();
+        dfd.push_back(4 + block_size);                      // dfdTotalSize
+        dfd.push_back(0);                                   // vendorId = Khronos, descriptorType = basic
+        dfd.push_back(2 | (block_size << 16));              // versionNumber = 1.3, descriptorBlockSize
+        dfd.push_back(color_model | (1 << 8) | (1 << 16));  // primaries = BT709, transfer = linear
+        dfd.push_back(3 | (3 << 8));                        // texel block dimensions 4x4x1
+        dfd.push_back(rhi::GetFormatStride(format));        // bytesPlane0
+        dfd.push_back(0);
+
+        for (const Sample& sample : samples)
+        {
+            dfd.push_back(sample.bit_offset | ((sample.bit_length - 1) << 16) | (sample.channel << 24));
+            dfd.push_back(0);
+            dfd.push_back(0);
+            dfd.push_back(0xFFFFFFFFu);
+        }
+    }
+
+    bool ImageExporter::ExportKtx2(const ImageAsset& image, const std::string& file_path)
+    {
+        const uint32_t vk_format = ktx2::ToVkFormat(image.format);
+        if (vk_format == 0)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "ImageExporter::ExportKtx2: Unsupported format for file {}", file_path);
+            return false;
+        }
+
+        const bool is_cube = image.type == rhi::ImageType::TYPE_CUBE;
+        const bool is_float = image.format == rhi::DataFormat::R16G16B16A16_SFLOAT || image.format == rhi::DataFormat::R32G32B32A32_SFLOAT;
+        const uint32_t faces = is_cube ? 6 : 1;
+        const uint32_t layers = image.arraySize / faces;
+
+        rhi::TextureFormatLayout layout;
+        layout.SetUp2D(image.format, image.width, image.height, image.arraySize, image.mipLevels);
+        if (image.data.size() < layout.GetRequiredSize())
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "ImageExporter::ExportKtx2: Image data is smaller than its layout for file {}", file_path);
+            return false;
+        }
+
+        // Block compressed levels are arrays of bytes, the others of their channel type
+        const bool is_block_compressed = layout.GetBlockDimX() > 1;
+        const uint32_t type_size = is_block_compressed ? 1 : layout.GetBlockStride() / 4;
+
+        std::vector<uint32_t> dfd;
+        if (is_block_compressed)
+            WriteBlockCompressedDataFormatDescriptor(dfd, image.format);
+        else
+            WriteBasicDataFormatDescriptor(dfd, type_size, is_float);
+
+        ktx2::Header header = {};
+        memcpy(header.identifier, ktx2::identifier, sizeof(ktx2::identifier));
+        header.vkFormat = vk_format;
+        header.typeSize = type_size;
+        header.pixelWidth = image.width;
+        header.pixelHeight = image.height;
+        header.pixelDepth = 0;
+        header.layerCount = layers > 1 ? layers : 0;
+        header.faceCount = faces;
+        header.levelCount = layout.GetMipLevels();
+        header.supercompressionScheme = 0;
+        header.dfdByteOffset = uint32_t(sizeof(ktx2::Header) + sizeof(ktx2::LevelIndex) * header.levelCount);
+        header.dfdByteLength = uint32_t(dfd.size() * sizeof(uint32_t));
+
+        // Levels are stored from the smallest to the largest, each aligned to lcm(texel or block size, 4)
+        const uint64_t alignment = layout.GetBlockStride();
+        std::vector<ktx2::LevelIndex> levels(header.levelCount);
+        uint64_t offset = header.dfdByteOffset + header.dfdByteLength;
+        for (int level = int(header.levelCount) - 1; level >= 0; level--)
+        {
+            const auto& mip = layout.GetMipInfo(level);
+            offset = (offset + alignment - 1) / alignment * alignment;
+            levels[level].byteOffset = offset;
+            levels[level].byteLength = uint64_t(mip.slice_pitch) * image.arraySize;
+            levels[level].uncompressedByteLength = levels[level].byteLength;
+            offset += levels[level].byteLength;
+        }
+
+        std::vector<byte> file(offset, 0);
+        memcpy(file.data(), &header, sizeof(header));
+        memcpy(file.data() + sizeof(header), levels.data(), levels.size() * sizeof(ktx2::LevelIndex));
+        memcpy(file.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+        for (uint32_t level = 0; level < header.levelCount; level++)
+            memcpy(file.data() + levels[level].byteOffset, image.data.data() + layout.GetMipInfo(level).offset, levels[level].byteLength);
+
+        if (!FileSystem::WriteFileBytes(file_path, file))
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "ImageExporter::ExportKtx2: Failed to write file {}", file_path);
+            return false;
+        }
+
+        QK_CORE_LOGI_TAG("AssetManager", "ImageExporter: Export image asset: {0}", file_path);
+        return true;
+    }
+
+}
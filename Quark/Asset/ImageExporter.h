@@ -0,0 +1,16 @@
+#pragma once
+#include "Quark/Asset/ImageAsset.h"
+
+namespace quark {
+
+class ImageExporter {
+public:
+    ImageExporter() = default;
+
+    // Writes a KTX2 file without supercompression which ImageImporter::ImportKtx2() reads back. Supports RGBA8,
+    // RGBA16F, RGBA32F and the BC formats, the asset's data has to be laid out like its TextureFormatLayout
+    bool ExportKtx2(const ImageAsset& image, const std::string& file_path);
+
+};
+
+}
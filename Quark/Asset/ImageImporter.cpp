@@ -1,5 +1,6 @@
 #include "Quark/qkpch.h"
 #include "Quark/Asset/ImageImporter.h"
+#include "Quark/Asset/Ktx2Format.h"
 #include "Quark/Core/FileSystem.h"
 #include "Quark/Render/RenderSystem.h"
 
@@ -117,6 +118,9 @@ namespace quark
             return nullptr;
         }
 
+        if (binary_data.size() >= sizeof(ktx2::Header) && reinterpret_cast<const ktx2::Header*>(binary_data.data())->vkFormat != 0)
+            return ImportKtx2Levels(binary_data, file_path);
+
         static bool basis_init = false; // within lock!
         if (!basis_init) 
         {
@@ -219,6 +223,81 @@ namespace quark
         return new_image_asset;
     }
 
+    Ref<ImageAsset> ImageImporter::ImportKtx2Levels(const std::vector<byte>& binary_data, const std::string& file_path)
+    {
+        ktx2::Header header;
+        memcpy(&header, binary_data.data(), sizeof(header));
+
+        if (memcmp(header.identifier, ktx2::identifier, sizeof(ktx2::identifier)) != 0 || header.supercompressionScheme != 0)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "TextureImporter::LoadKtx2: Unsupported ktx2 file {}", file_path);
+            return nullptr;
+        }
+
+        const rhi::DataFormat format = ktx2::FromVkFormat(header.vkFormat);
+        if (format == rhi::DataFormat::UNDEFINED || header.pixelDepth > 1)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "TextureImporter::LoadKtx2: Unsupported vkFormat {} in file {}", header.vkFormat, file_path);
+            return nullptr;
+        }
+
+        // Cooked textures are only BC compressed for devices which can sample them, see TextureCooker
+        uint32_t block_dim_x, block_dim_y;
+        rhi::GetFormatBlockDim(format, block_dim_x, block_dim_y);
+        if (block_dim_x > 1 && !RenderSystem::Get().GetDevice()->GetDeviceFeatures().textureCompressionBC)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "TextureImporter::LoadKtx2: Device doesn't support the BC compressed file {}", file_path);
+            return nullptr;
+        }
+
+        Ref<ImageAsset> new_image_asset = CreateRef<ImageAsset>();
+        new_image_asset->width = header.pixelWidth;
+        new_image_asset->height = std::max(1u, header.pixelHeight);
+        new_image_asset->arraySize = std::max(1u, header.layerCount) * header.faceCount;
+        new_image_asset->mipLevels = std::max(1u, header.levelCount);
+        new_image_asset->format = format;
+        new_image_asset->type = header.faceCount == 6 ? rhi::ImageType::TYPE_CUBE : rhi::ImageType::TYPE_2D;
+
+        rhi::TextureFormatLayout& layout = new_image_asset->layout;
+        layout.SetUp2D(format, new_image_asset->width, new_image_asset->height, new_image_asset->arraySize, new_image_asset->mipLevels);
+
+        const size_t level_index_offset = sizeof(ktx2::Header);
+        if (binary_data.size() < level_index_offset + sizeof(ktx2::LevelIndex) * new_image_asset->mipLevels)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "TextureImporter::LoadKtx2: Truncated file {}", file_path);
+            return nullptr;
+        }
+
+        // Levels hold their layers and faces tightly packed, which is also how TextureFormatLayout lays out a level
+        new_image_asset->data.resize(layout.GetRequiredSize());
+        for (uint32_t level = 0; level < new_image_asset->mipLevels; level++)
+        {
+            ktx2::LevelIndex level_index;
+            memcpy(&level_index, binary_data.data() + level_index_offset + sizeof(ktx2::LevelIndex) * level, sizeof(level_index));
+
+            const auto& mip_info = layout.GetMipInfo(level);
+            const uint64_t level_size = uint64_t(mip_info.slice_pitch) * new_image_asset->arraySize;
+            if (level_index.byteLength != level_size || level_index.byteOffset + level_size > binary_data.size())
+            {
+                QK_CORE_LOGW_TAG("AssetManager", "TextureImporter::LoadKtx2: Invalid level {} in file {}", level, file_path);
+                return nullptr;
+            }
+
+            memcpy(new_image_asset->data.data() + mip_info.offset, binary_data.data() + level_index.byteOffset, level_size);
+
+            for (uint32_t layer = 0; layer < new_image_asset->arraySize; layer++)
+            {
+                rhi::ImageInitData& subresource = new_image_asset->slices.emplace_back();
+                subresource.data = new_image_asset->data.data() + mip_info.offset + uint64_t(mip_info.slice_pitch) * layer;
+                subresource.rowPitch = mip_info.row_pitch;
+                subresource.slicePitch = mip_info.slice_pitch;
+            }
+        }
+
+        QK_CORE_LOGI_TAG("ImageAssetImporter", "ImageAssetImporter: Import Image asset: {0}", file_path);
+        return new_image_asset;
+    }
+
     Ref<ImageAsset> ImageImporter::ImportStb(const std::string& file_path)
     {
         int width, height, channels;
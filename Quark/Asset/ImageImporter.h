@@ -13,6 +13,9 @@ public:
     Ref<ImageAsset> ImportStb(const std::string& file_path);
     Ref<ImageAsset> ImportHdr(const std::string& file_path);
 
+private:
+    // KTX2 files with a vkFormat, i.e. not basis supercompressed, their levels are copied as they are
+    Ref<ImageAsset> ImportKtx2Levels(const std::vector<byte>& binary_data, const std::string& file_path);
 };
 
 }
\ No newline at end of file
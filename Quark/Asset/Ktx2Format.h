@@ -0,0 +1,71 @@
+#pragma once
+#include "Quark/RHI/Common.h"
+
+// File layout of KTX2 containers which are not basis supercompressed, shared by ImageImporter and ImageExporter.
+// The vendored libktx only knows KTX1 and basisu only transcodes, so plain KTX2 files are read and written by hand.
+// See https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+namespace quark::ktx2 {
+
+    inline constexpr uint8_t identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;      // 0 for basis supercompressed files
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;    // 0 for 1D and 2D images
+        uint32_t layerCount;    // 0 for non array images
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+    static_assert(sizeof(Header) == 80, "KTX2 header is 80 bytes");
+
+    struct LevelIndex
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    // VkFormat values, the asset module doesn't include vulkan headers
+    inline uint32_t ToVkFormat(rhi::DataFormat format)
+    {
+        switch (format)
+        {
+        case rhi::DataFormat::R8G8B8A8_UNORM:       return 37;
+        case rhi::DataFormat::R16G16B16A16_SFLOAT:  return 97;
+        case rhi::DataFormat::R32G32B32A32_SFLOAT:  return 109;
+        case rhi::DataFormat::BC1_RGBA_UNORM_BLOCK: return 133;
+        case rhi::DataFormat::BC3_UNORM_BLOCK:      return 137;
+        case rhi::DataFormat::BC5_UNORM_BLOCK:      return 141;
+        case rhi::DataFormat::BC7_UNORM_BLOCK:      return 145;
+        default:                                    return 0;
+        }
+    }
+
+    inline rhi::DataFormat FromVkFormat(uint32_t vk_format)
+    {
+        switch (vk_format)
+        {
+        case 37:  return rhi::DataFormat::R8G8B8A8_UNORM;
+        case 97:  return rhi::DataFormat::R16G16B16A16_SFLOAT;
+        case 109: return rhi::DataFormat::R32G32B32A32_SFLOAT;
+        case 133: return rhi::DataFormat::BC1_RGBA_UNORM_BLOCK;
+        case 137: return rhi::DataFormat::BC3_UNORM_BLOCK;
+        case 141: return rhi::DataFormat::BC5_UNORM_BLOCK;
+        case 145: return rhi::DataFormat::BC7_UNORM_BLOCK;
+        default:  return rhi::DataFormat::UNDEFINED;
+        }
+    }
+
+}
@@ -26,7 +26,7 @@ bool MaterialSerializer::TryLoadData(const std::string& filepath, Ref<MaterialAs
     std::ifstream stream(filepath);
     if (!stream.is_open())
     {
-        QK_CORE_LOGE_TAG("AssetManger", "MaterialSerializer::TryLoadData: Failed to open file {0}", filepath);
+        QK_CORE_LOGE_TAG("AssetManager", "MaterialSerializer::TryLoadData: Failed to open file {0}", filepath);
         return false;
     }
 
@@ -19,7 +19,7 @@ Ref<MeshAsset> MeshImporter::ImportGLTF(const std::string& filepath) {
 	std::vector<Ref<MeshAsset>>& meshes = gltf_importer.GetMeshes();
 	if (meshes.empty())
 	{
-		QK_CORE_LOGW_TAG("No mesh found in gltf file: {}", filepath);
+		QK_CORE_LOGW_TAG("AssetManager", "No mesh found in gltf file: {}", filepath);
 		return nullptr;
 	}
 
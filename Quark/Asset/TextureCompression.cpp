@@ -0,0 +1,396 @@
+#include "Quark/qkpch.h"
+#include "Quark/Asset/TextureCompression.h"
+
+#include <cmath>
+#include <limits>
+
+namespace quark {
+
+    namespace {
+
+    using Color = std::array<float, 4>;
+
+    constexpr uint32_t block_texels = 16;
+
+    void LoadTexels(const uint8_t* texels, Color* colors)
+    {
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            for (uint32_t c = 0; c < 4; c++)
+                colors[i][c] = float(texels[i * 4 + c]);
+        }
+    }
+
+    // Endpoints at the extent of the texels along their principal axis, which is found by power iteration
+    // of the covariance matrix. Only the first N channels are fitted.
+    template<uint32_t N>
+    void FitEndpoints(const Color* colors, Color& e0, Color& e1)
+    {
+        Color mean = {};
+        Color lo = colors[0];
+        Color hi = colors[0];
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            for (uint32_t c = 0; c < N; c++)
+            {
+                mean[c] += colors[i][c] / block_texels;
+                lo[c] = std::min(lo[c], colors[i][c]);
+                hi[c] = std::max(hi[c], colors[i][c]);
+            }
+        }
+
+        float covariance[N][N] = {};
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            for (uint32_t a = 0; a < N; a++)
+            {
+                for (uint32_t b = 0; b < N; b++)
+                    covariance[a][b] += (colors[i][a] - mean[a]) * (colors[i][b] - mean[b]);
+            }
+        }
+
+        // The diagonal of the bounding box is a good first guess, a few iterations are enough for 16 texels
+        Color axis = {};
+        for (uint32_t c = 0; c < N; c++)
+            axis[c] = hi[c] - lo[c];
+
+        for (uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            Color next = {};
+            float length = 0;
+            for (uint32_t a = 0; a < N; a++)
+            {
+                for (uint32_t b = 0; b < N; b++)
+                    next[a] += covariance[a][b] * axis[b];
+                length += next[a] * next[a];
+            }
+
+            if (length < 1e-12f)
+                break;
+
+            length = std::sqrt(length);
+            for (uint32_t c = 0; c < N; c++)
+                axis[c] = next[c] / length;
+        }
+
+        float t_min = 0, t_max = 0;
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            float t = 0;
+            for (uint32_t c = 0; c < N; c++)
+                t += (colors[i][c] - mean[c]) * axis[c];
+            t_min = std::min(t_min, t);
+            t_max = std::max(t_max, t);
+        }
+
+        e0 = mean;
+        e1 = mean;
+        for (uint32_t c = 0; c < N; c++)
+        {
+            e0[c] = std::clamp(mean[c] + axis[c] * t_max, 0.f, 255.f);
+            e1[c] = std::clamp(mean[c] + axis[c] * t_min, 0.f, 255.f);
+        }
+    }
+
+    // Least squares endpoints for the chosen indices, weights[i] is how much of e1 texel i is interpolated from
+    template<uint32_t N>
+    bool RefineEndpoints(const Color* colors, const float* weights, Color& e0, Color& e1)
+    {
+        float aa = 0, ab = 0, bb = 0;
+        Color ax = {}, bx = {};
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            const float a = 1.f - weights[i];
+            const float b = weights[i];
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (uint32_t c = 0; c < N; c++)
+            {
+                ax[c] += a * colors[i][c];
+                bx[c] += b * colors[i][c];
+            }
+        }
+
+        const float det = aa * bb - ab * ab;
+        if (std::abs(det) < 1e-6f)
+            return false;
+
+        for (uint32_t c = 0; c < N; c++)
+        {
+            e0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.f, 255.f);
+            e1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.f, 255.f);
+        }
+        return true;
+    }
+
+    template<uint32_t N>
+    float Distance(const Color& a, const Color& b)
+    {
+        float d = 0;
+        for (uint32_t c = 0; c < N; c++)
+            d += (a[c] - b[c]) * (a[c] - b[c]);
+        return d;
+    }
+
+    uint16_t PackRGB565(const Color& color)
+    {
+        const uint32_t r = uint32_t(color[0] * 31.f / 255.f + 0.5f);
+        const uint32_t g = uint32_t(color[1] * 63.f / 255.f + 0.5f);
+        const uint32_t b = uint32_t(color[2] * 31.f / 255.f + 0.5f);
+        return uint16_t((r << 11) | (g << 5) | b);
+    }
+
+    Color UnpackRGB565(uint16_t packed)
+    {
+        const uint32_t r = (packed >> 11) & 31;
+        const uint32_t g = (packed >> 5) & 63;
+        const uint32_t b = packed & 31;
+        return { float((r << 3) | (r >> 2)), float((g << 2) | (g >> 4)), float((b << 3) | (b >> 2)), 0.f };
+    }
+
+    // Little endian bit stream, the block has to be zeroed
+    struct BitWriter
+    {
+        uint8_t* data;
+        uint32_t offset = 0;
+
+        void Write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t b = 0; b < bits; b++, offset++)
+            {
+                if ((value >> b) & 1)
+                    data[offset >> 3] |= uint8_t(1u << (offset & 7));
+            }
+        }
+    };
+
+    void CompressBlockBC4(const uint8_t* texels, uint32_t channel, uint8_t* block)
+    {
+        uint32_t lo = 255, hi = 0;
+        for (uint32_t i = 0; i < block_texels; i++)
+        {
+            lo = std::min<uint32_t>(lo, texels[i * 4 + channel]);
+            hi = std::max<uint32_t>(hi, texels[i * 4 + channel]);
+        }
+
+        // r0 > r1 selects the mode with 6 interpolated values, index 0 is r0, 1 is r1 and i in [2, 7] is ((8 - i) * r0 + (i - 1) * r1) / 7
+        uint64_t indices = 0;
+        if (hi > lo)
+        {
+            for (uint32_t i = 0; i < block_texels; i++)
+            {
+                const uint32_t k = uint32_t((texels[i * 4 + channel] - lo) * 7.f / (hi - lo) + 0.5f);
+                const uint64_t index = (k == 7) ? 0 : (k == 0) ? 1 : 8 - k;
+                indices |= index << (3 * i);
+            }
+        }
+
+        block[0] = uint8_t(hi);
+        block[1] = uint8_t(lo);
+        for (uint32_t i = 0; i < 6; i++)
+            block[2 + i] = uint8_t(indices >> (8 * i));
+    }
+
+    // Mode 6 endpoints are 7 bits per channel plus a p-bit shared by the channels of an endpoint
+    float QuantizeEndpointBC7(const Color& endpoint, uint32_t* quantized, uint32_t& p_bit)
+    {
+        float best_error = std::numeric_limits<float>::max();
+        for (uint32_t p = 0; p < 2; p++)
+        {
+            uint32_t q[4];
+            float error = 0;
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                q[c] = uint32_t(std::clamp((endpoint[c] - p) * 0.5f + 0.5f, 0.f, 127.f));
+                const float value = float((q[c] << 1) | p);
+                error += (value - endpoint[c]) * (value - endpoint[c]);
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                p_bit = p;
+                memcpy(quantized, q, sizeof(q));
+            }
+        }
+        return best_error;
+    }
+
+    }
+
+    void CompressBlockBC1(const uint8_t* texels, uint8_t* block)
+    {
+        Color colors[block_texels];
+        LoadTexels(texels, colors);
+
+        Color e0, e1;
+        FitEndpoints<3>(colors, e0, e1);
+
+        // Weight of the second endpoint per index
+        constexpr float index_weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+        uint16_t best_c0 = 0, best_c1 = 0;
+        uint32_t best_indices = 0;
+        float best_error = std::numeric_limits<float>::max();
+        for (uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            // The four color mode needs c0 > c1, swapping the endpoints only reorders the palette. If they are
+            // equal the block is in the three color mode, in which index 0 is still c0.
+            uint16_t c0 = PackRGB565(e0);
+            uint16_t c1 = PackRGB565(e1);
+            if (c0 < c1)
+                std::swap(c0, c1);
+            const uint32_t palette_size = (c0 == c1) ? 1 : 4;
+
+            Color palette[4];
+            palette[0] = UnpackRGB565(c0);
+            palette[1] = UnpackRGB565(c1);
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2.f * palette[0][c] + palette[1][c]) / 3.f;
+                palette[3][c] = (palette[0][c] + 2.f * palette[1][c]) / 3.f;
+            }
+
+            uint32_t indices = 0;
+            float error = 0;
+            float weights[block_texels];
+            for (uint32_t i = 0; i < block_texels; i++)
+            {
+                uint32_t best_index = 0;
+                float best_distance = Distance<3>(colors[i], palette[0]);
+                for (uint32_t j = 1; j < palette_size; j++)
+                {
+                    const float distance = Distance<3>(colors[i], palette[j]);
+                    if (distance < best_distance)
+                    {
+                        best_distance = distance;
+                        best_index = j;
+                    }
+                }
+
+                indices |= best_index << (2 * i);
+                weights[i] = index_weights[best_index];
+                error += best_distance;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                best_c0 = c0;
+                best_c1 = c1;
+                best_indices = indices;
+            }
+
+            if (error == 0 || palette_size == 1)
+                break;
+
+            // The weights are relative to the reordered palette
+            e0 = palette[0];
+            e1 = palette[1];
+            if (!RefineEndpoints<3>(colors, weights, e0, e1))
+                break;
+        }
+
+        memcpy(block, &best_c0, 2);
+        memcpy(block + 2, &best_c1, 2);
+        memcpy(block + 4, &best_indices, 4);
+    }
+
+    void CompressBlockBC5(const uint8_t* texels, uint8_t* block)
+    {
+        CompressBlockBC4(texels, 0, block);
+        CompressBlockBC4(texels, 1, block + 8);
+    }
+
+    void CompressBlockBC7(const uint8_t* texels, uint8_t* block)
+    {
+        Color colors[block_texels];
+        LoadTexels(texels, colors);
+
+        Color e0, e1;
+        FitEndpoints<4>(colors, e0, e1);
+
+        constexpr uint32_t index_weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        uint32_t best_q0[4] = {}, best_q1[4] = {}, best_p0 = 0, best_p1 = 0;
+        uint32_t best_indices[block_texels] = {};
+        float best_error = std::numeric_limits<float>::max();
+        for (uint32_t iteration = 0; iteration < 3; iteration++)
+        {
+            uint32_t q0[4], q1[4], p0, p1;
+            QuantizeEndpointBC7(e0, q0, p0);
+            QuantizeEndpointBC7(e1, q1, p1);
+
+            Color palette[16];
+            for (uint32_t j = 0; j < 16; j++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    const uint32_t v0 = (q0[c] << 1) | p0;
+                    const uint32_t v1 = (q1[c] << 1) | p1;
+                    palette[j][c] = float(((64 - index_weights[j]) * v0 + index_weights[j] * v1 + 32) >> 6);
+                }
+            }
+
+            uint32_t indices[block_texels];
+            float error = 0;
+            float weights[block_texels];
+            for (uint32_t i = 0; i < block_texels; i++)
+            {
+                uint32_t best_index = 0;
+                float best_distance = Distance<4>(colors[i], palette[0]);
+                for (uint32_t j = 1; j < 16; j++)
+                {
+                    const float distance = Distance<4>(colors[i], palette[j]);
+                    if (distance < best_distance)
+                    {
+                        best_distance = distance;
+                        best_index = j;
+                    }
+                }
+
+                indices[i] = best_index;
+                weights[i] = index_weights[best_index] / 64.f;
+                error += best_distance;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                memcpy(best_q0, q0, sizeof(q0));
+                memcpy(best_q1, q1, sizeof(q1));
+                best_p0 = p0;
+                best_p1 = p1;
+                memcpy(best_indices, indices, sizeof(indices));
+            }
+
+            if (error == 0 || !RefineEndpoints<4>(colors, weights, e0, e1))
+                break;
+        }
+
+        // The most significant bit of the first index is implied to be 0
+        if (best_indices[0] >= 8)
+        {
+            std::swap(best_q0, best_q1);
+            std::swap(best_p0, best_p1);
+            for (uint32_t i = 0; i < block_texels; i++)
+                best_indices[i] = 15 - best_indices[i];
+        }
+
+        memset(block, 0, 16);
+        BitWriter writer = { block };
+        writer.Write(1u << 6, 7);   // mode 6
+        for (uint32_t c = 0; c < 4; c++)
+        {
+            writer.Write(best_q0[c], 7);
+            writer.Write(best_q1[c], 7);
+        }
+        writer.Write(best_p0, 1);
+        writer.Write(best_p1, 1);
+        writer.Write(best_indices[0], 3);
+        for (uint32_t i = 1; i < block_texels; i++)
+            writer.Write(best_indices[i], 4);
+    }
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+
+namespace quark {
+
+    // Encoders of single 4x4 blocks. The texels are 16 RGBA8 texels in row major order, blocks at the edge
+    // of an image which isn't a multiple of 4 are padded by the caller.
+
+    // BC1 in the opaque four color mode, alpha is ignored. 8 bytes per block.
+    void CompressBlockBC1(const uint8_t* texels, uint8_t* block);
+
+    // BC5, two BC4 blocks of the red and the green channel. 16 bytes per block.
+    void CompressBlockBC5(const uint8_t* texels, uint8_t* block);
+
+    // BC7 in mode 6, a single subset with 7777 endpoints plus a p-bit and 4 bit indices, which is what
+    // most encoders pick for smooth color and alpha. 16 bytes per block.
+    void CompressBlockBC7(const uint8_t* texels, uint8_t* block);
+
+}
@@ -0,0 +1,376 @@
+#include "Quark/qkpch.h"
+#include "Quark/Asset/TextureCooker.h"
+#include "Quark/Asset/TextureCompression.h"
+#include "Quark/Asset/ImageImporter.h"
+#include "Quark/Asset/ImageExporter.h"
+#include "Quark/Core/FileSystem.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Profiler.h"
+#include "Quark/Core/Util/Hash.h"
+
+#include <cmath>
+
+// SSE2 is part of x86-64, no runtime detection needed
+#if defined(__x86_64__) || defined(_M_X64)
+    #define QK_TEXTURE_COOKER_SSE
+    #include <emmintrin.h>
+#endif
+
+namespace quark {
+
+    // Bump when the cooked output changes, e.g. the encoders or the mip filter, so stale cache files are not picked up
+    static constexpr uint32_t texture_cook_version = 1;
+
+    // Texel rows per job when building the pyramid, and block rows per tile when encoding
+    static constexpr uint32_t rows_per_job = 32;
+    static constexpr uint32_t block_rows_per_tile = 8;
+
+    namespace {
+
+    // A level of the pyramid in linear RGBA32F, normals are in [-1, 1]
+    struct FloatLevel
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<float> texels;
+    };
+
+    void ParallelFor(JobSystem* job_system, uint32_t count, uint32_t group_size, const std::function<void(uint32_t, uint32_t)>& func)
+    {
+        if (job_system && job_system->GetNumWorkerThreads() > 0 && count > group_size)
+        {
+            JobSystem::Counter counter;
+            job_system->Dispatch(count, group_size, func, &counter);
+            job_system->Wait(&counter, 1);
+        }
+        else if (count > 0)
+        {
+            func(0, count);
+        }
+    }
+
+    float SrgbToLinear(float v)
+    {
+        return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float v)
+    {
+        return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.f / 2.4f) - 0.055f;
+    }
+
+    uint8_t FloatToUnorm8(float v)
+    {
+        return uint8_t(std::clamp(v, 0.f, 1.f) * 255.f + 0.5f);
+    }
+
+    const std::array<float, 256>& GetSrgbToLinearTable()
+    {
+        static const std::array<float, 256> table = []
+        {
+            std::array<float, 256> t;
+            for (uint32_t i = 0; i < 256; i++)
+                t[i] = SrgbToLinear(i / 255.f);
+            return t;
+        }();
+        return table;
+    }
+
+    // Table of the sRGB codes indexed by the exponent and the top 10 mantissa bits of a float in [2^-13, 1), each
+    // entry is the code at the middle of its bucket. Below 2^-13 the code rounds to 0 anyway.
+    uint8_t LinearToSrgb8(float v)
+    {
+        constexpr uint32_t min_bits = 0x39000000;   // 2^-13
+        constexpr uint32_t max_bits = 0x3f800000;   // 1.0
+        constexpr uint32_t shift = 13;
+
+        static const std::vector<uint8_t> table = []
+        {
+            std::vector<uint8_t> t((max_bits - min_bits) >> shift);
+            for (uint32_t i = 0; i < t.size(); i++)
+            {
+                const uint32_t bits = min_bits + (i << shift) + (1u << (shift - 1));
+                float x;
+                memcpy(&x, &bits, sizeof(x));
+                t[i] = FloatToUnorm8(LinearToSrgb(x));
+            }
+            return t;
+        }();
+
+        if (!(v >= 0x1p-13f)) // and NaN
+            return 0;
+        if (v >= 1.f)
+            return 255;
+
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        return table[(bits - min_bits) >> shift];
+    }
+
+    void DecodeRows(const uint8_t* src, FloatLevel& level, TextureRole role, uint32_t begin, uint32_t end)
+    {
+        const std::array<float, 256>& srgb_to_linear = GetSrgbToLinearTable();
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const uint8_t* in = src + size_t(y) * level.width * 4;
+            float* out = level.texels.data() + size_t(y) * level.width * 4;
+            for (uint32_t i = 0; i < level.width * 4; i += 4)
+            {
+                for (uint32_t c = 0; c < 3; c++)
+                {
+                    switch (role)
+                    {
+                    case TextureRole::Color:    out[i + c] = srgb_to_linear[in[i + c]]; break;
+                    case TextureRole::Normal:   out[i + c] = in[i + c] / 255.f * 2.f - 1.f; break;
+                    default:                    out[i + c] = in[i + c] / 255.f; break;
+                    }
+                }
+                out[i + 3] = in[i + 3] / 255.f;
+            }
+        }
+    }
+
+    // 2x2 box filter, the last row or column is repeated for levels which are 1 texel wide or high
+    void DownsampleRows(const FloatLevel& src, FloatLevel& dst, bool renormalize, uint32_t begin, uint32_t end)
+    {
+        for (uint32_t y = begin; y < end; y++)
+        {
+            const float* row0 = src.texels.data() + size_t(std::min(2 * y, src.height - 1)) * src.width * 4;
+            const float* row1 = src.texels.data() + size_t(std::min(2 * y + 1, src.height - 1)) * src.width * 4;
+            float* out = dst.texels.data() + size_t(y) * dst.width * 4;
+
+            for (uint32_t x = 0; x < dst.width; x++)
+            {
+                const uint32_t x0 = std::min(2 * x, src.width - 1) * 4;
+                const uint32_t x1 = std::min(2 * x + 1, src.width - 1) * 4;
+                float* texel = out + x * 4;
+#ifdef QK_TEXTURE_COOKER_SSE
+                const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(row0 + x0), _mm_loadu_ps(row0 + x1)),
+                                              _mm_add_ps(_mm_loadu_ps(row1 + x0), _mm_loadu_ps(row1 + x1)));
+                _mm_storeu_ps(texel, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+                for (uint32_t c = 0; c < 4; c++)
+                    texel[c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c]) * 0.25f;
+#endif
+                if (renormalize)
+                {
+                    const float length = std::sqrt(texel[0] * texel[0] + texel[1] * texel[1] + texel[2] * texel[2]);
+                    if (length > 1e-6f)
+                    {
+                        texel[0] /= length;
+                        texel[1] /= length;
+                        texel[2] /= length;
+                    }
+                    else
+                    {
+                        texel[0] = 0.f;
+                        texel[1] = 0.f;
+                        texel[2] = 1.f;
+                    }
+                }
+            }
+        }
+    }
+
+    void QuantizeTexel(const float* texel, TextureRole role, uint8_t* out)
+    {
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            switch (role)
+            {
+            case TextureRole::Color:    out[c] = LinearToSrgb8(texel[c]); break;
+            case TextureRole::Normal:   out[c] = FloatToUnorm8(texel[c] * 0.5f + 0.5f); break;
+            default:                    out[c] = FloatToUnorm8(texel[c]); break;
+            }
+        }
+        out[3] = FloatToUnorm8(texel[3]);
+    }
+
+    util::Hash HashTexture(const ImageAsset& image, TextureRole role, rhi::DataFormat format, uint32_t mip_levels)
+    {
+        util::Hasher h;
+        h.u32(texture_cook_version);
+        h.u32(uint32_t(role));
+        h.u32(uint32_t(format));
+        h.u32(mip_levels);
+        h.u32(image.width);
+        h.u32(image.height);
+        h.data(reinterpret_cast<const uint32_t*>(image.data.data()), size_t(image.width) * image.height * 4);
+        return h.get();
+    }
+
+    void SetUpSlices(ImageAsset& image)
+    {
+        image.slices.clear();
+        for (uint32_t level = 0; level < image.mipLevels; level++)
+        {
+            const auto& mip_info = image.layout.GetMipInfo(level);
+            rhi::ImageInitData& subresource = image.slices.emplace_back();
+            subresource.data = image.data.data() + mip_info.offset;
+            subresource.rowPitch = mip_info.row_pitch;
+            subresource.slicePitch = mip_info.slice_pitch;
+        }
+    }
+
+    }
+
+    rhi::DataFormat TextureCooker::GetCompressedFormat(TextureRole role)
+    {
+        switch (role)
+        {
+        case TextureRole::Color:    return rhi::DataFormat::BC7_UNORM_BLOCK;
+        case TextureRole::Normal:   return rhi::DataFormat::BC5_UNORM_BLOCK;
+        default:                    return rhi::DataFormat::BC1_RGBA_UNORM_BLOCK;
+        }
+    }
+
+    bool TextureCooker::Cook(ImageAsset& image, const TextureCookSettings& settings)
+    {
+        QK_PROFILE_SCOPE("TextureCooker::Cook");
+
+        if (image.format != rhi::DataFormat::R8G8B8A8_UNORM || image.type != rhi::ImageType::TYPE_2D || image.arraySize != 1 || image.mipLevels != 1
+            || image.width == 0 || image.height == 0 || image.data.size() < size_t(image.width) * image.height * 4)
+        {
+            QK_CORE_LOGW_TAG("AssetManager", "TextureCooker::Cook: Only single level 2D RGBA8 images can be cooked");
+            return false;
+        }
+
+        const rhi::DataFormat format = settings.compress ? GetCompressedFormat(settings.role) : rhi::DataFormat::R8G8B8A8_UNORM;
+        rhi::TextureFormatLayout layout;
+        layout.SetUp2D(format, image.width, image.height, 1, settings.generate_mips ? 0 : 1);
+
+        std::string cache_path;
+        if (!settings.cache_directory.empty())
+        {
+            char key[17];
+            snprintf(key, sizeof(key), "%016llx", (unsigned long long)HashTexture(image, settings.role, format, layout.GetMipLevels()));
+            cache_path = (std::filesystem::path(settings.cache_directory) / (std::string(key) + ".ktx2")).string();
+
+            if (FileSystem::Exists(cache_path))
+            {
+                Ref<ImageAsset> cached = ImageImporter().ImportKtx2(cache_path);
+                if (cached && cached->format == format && cached->width == image.width && cached->height == image.height && cached->mipLevels == layout.GetMipLevels())
+                {
+                    image.format = format;
+                    image.mipLevels = cached->mipLevels;
+                    image.layout = cached->layout;
+                    image.data = std::move(cached->data);
+                    SetUpSlices(image);
+                    return true;
+                }
+
+                QK_CORE_LOGW_TAG("AssetManager", "TextureCooker::Cook: Cache file {} is invalid, cooking the texture again", cache_path);
+            }
+        }
+
+        // Filtered in linear space, averaging sRGB codes would darken the mips
+        std::vector<FloatLevel> levels(layout.GetMipLevels());
+        for (uint32_t level = 0; level < layout.GetMipLevels(); level++)
+        {
+            FloatLevel& dst = levels[level];
+            dst.width = layout.GetMipInfo(level).width;
+            dst.height = layout.GetMipInfo(level).height;
+            dst.texels.resize(size_t(dst.width) * dst.height * 4);
+
+            if (level == 0)
+            {
+                ParallelFor(settings.job_system, dst.height, rows_per_job, [&](uint32_t begin, uint32_t end)
+                {
+                    DecodeRows(image.data.data(), dst, settings.role, begin, end);
+                });
+            }
+            else
+            {
+                ParallelFor(settings.job_system, dst.height, rows_per_job, [&](uint32_t begin, uint32_t end)
+                {
+                    DownsampleRows(levels[level - 1], dst, settings.role == TextureRole::Normal, begin, end);
+                });
+            }
+        }
+
+        // Tiles of block rows of all levels are encoded at once, so the small levels don't leave the workers idle
+        struct Tile
+        {
+            uint32_t level;
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        const uint32_t tile_rows = settings.compress ? block_rows_per_tile : block_rows_per_tile * 4;
+        std::vector<Tile> tiles;
+        for (uint32_t level = 0; level < layout.GetMipLevels(); level++)
+        {
+            const uint32_t num_block_y = layout.GetMipInfo(level).num_block_y;
+            for (uint32_t begin = 0; begin < num_block_y; begin += tile_rows)
+                tiles.push_back({ level, begin, std::min(begin + tile_rows, num_block_y) });
+        }
+
+        void (*compress_block)(const uint8_t*, uint8_t*) = nullptr;
+        switch (format)
+        {
+        case rhi::DataFormat::BC7_UNORM_BLOCK:      compress_block = CompressBlockBC7; break;
+        case rhi::DataFormat::BC5_UNORM_BLOCK:      compress_block = CompressBlockBC5; break;
+        case rhi::DataFormat::BC1_RGBA_UNORM_BLOCK: compress_block = CompressBlockBC1; break;
+        default: break;
+        }
+
+        std::vector<uint8_t> data(layout.GetRequiredSize());
+        const uint32_t stride = layout.GetBlockStride();
+        ParallelFor(settings.job_system, uint32_t(tiles.size()), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t t = begin; t < end; t++)
+            {
+                const Tile& tile = tiles[t];
+                const FloatLevel& level = levels[tile.level];
+                const auto& mip_info = layout.GetMipInfo(tile.level);
+                uint8_t* dst = data.data() + mip_info.offset;
+
+                for (uint32_t y = tile.begin; y < tile.end; y++)
+                {
+                    uint8_t* row = dst + size_t(y) * mip_info.row_pitch;
+                    for (uint32_t x = 0; x < mip_info.num_block_x; x++)
+                    {
+                        if (!compress_block)
+                        {
+                            QuantizeTexel(level.texels.data() + (size_t(y) * level.width + x) * 4, settings.role, row + x * stride);
+                            continue;
+                        }
+
+                        // Blocks over the edge of a level repeat its last row and column
+                        uint8_t texels[16 * 4];
+                        for (uint32_t i = 0; i < 16; i++)
+                        {
+                            const uint32_t tx = std::min(x * 4 + (i & 3), level.width - 1);
+                            const uint32_t ty = std::min(y * 4 + (i >> 2), level.height - 1);
+                            QuantizeTexel(level.texels.data() + (size_t(ty) * level.width + tx) * 4, settings.role, texels + i * 4);
+                        }
+                        compress_block(texels, row + x * stride);
+                    }
+                }
+            }
+        });
+
+        rhi::TextureFormatLayout uncompressed_layout;
+        uncompressed_layout.SetUp2D(rhi::DataFormat::R8G8B8A8_UNORM, image.width, image.height, 1, layout.GetMipLevels());
+
+        image.format = format;
+        image.mipLevels = layout.GetMipLevels();
+        image.layout = layout;
+        image.data = std::move(data);
+        SetUpSlices(image);
+
+        QK_CORE_LOGI_TAG("AssetManager", "TextureCooker::Cook: Cooked {}x{} texture into {} levels of format {}, {} KB instead of {} KB as uncompressed RGBA8",
+            image.width, image.height, image.mipLevels, uint32_t(format), image.data.size() / 1024, uncompressed_layout.GetRequiredSize() / 1024);
+
+        if (!cache_path.empty())
+        {
+            const std::filesystem::path directory(settings.cache_directory);
+            if (!FileSystem::Exists(directory))
+                FileSystem::CreateDirectory(directory);
+            ImageExporter().ExportKtx2(image, cache_path);
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "Quark/Asset/ImageAsset.h"
+
+namespace quark {
+
+class JobSystem;
+
+enum class TextureRole
+{
+    Color,      // sRGB encoded color, e.g. base color or emission, mips are filtered in linear space. BC7
+    Normal,     // tangent space normals, mips are renormalized. BC5, z has to be reconstructed from x and y
+    Data,       // linear data, e.g. metallic roughness or occlusion. BC1
+};
+
+struct TextureCookSettings
+{
+    TextureRole role = TextureRole::Color;
+    bool generate_mips = true;
+    bool compress = true;               // only for devices with DeviceFeatures::textureCompressionBC
+    JobSystem* job_system = nullptr;    // mip rows and block tiles are processed on the workers if set
+    std::string cache_directory = "BuiltInResources/Cache/Textures"; // cooked textures are cached as KTX2, empty disables the cache
+};
+
+// Import stage turning a single level RGBA8 image, as ImportStb() or a glTF file decodes it, into what is
+// uploaded: a mip pyramid built on the cpu, block compressed according to the role of the texture.
+class TextureCooker {
+public:
+    TextureCooker() = default;
+
+    // Replaces the format, the levels and the data of the image in place, so its AssetID stays valid.
+    // Returns false and leaves the image untouched if it isn't a single level 2D RGBA8 image.
+    bool Cook(ImageAsset& image, const TextureCookSettings& settings);
+
+    static rhi::DataFormat GetCompressedFormat(TextureRole role);
+};
+
+}
@@ -1,6 +1,7 @@
 #include "Quark/qkpch.h"
 #include "Quark/Core/Application.h"
 #include "Quark/Core/Input.h"
+#include "Quark/Core/Profiler.h"
 #include "Quark/Events/EventManager.h"
 #include "Quark/Events/ApplicationEvent.h"
 #include "Quark/Asset/AssetManager.h"
@@ -27,6 +28,7 @@ Application::Application(const ApplicationSpecification& specs)
         std::filesystem::current_path(specs.workingDirectory);
 
     Logger::Init();
+    QK_PROFILE_THREAD("Main");
 
     // Init Job System
     m_jobSystem = CreateRef<JobSystem>();
@@ -84,12 +86,16 @@ Application::Application(const ApplicationSpecification& specs)
     UI::Get()->Init(RenderSystem::Get().GetDevice(), specs.uiSpecs);
 
     // Register application callback functions
-    EventManager::Get().Subscribe<WindowCloseEvent>([this](const WindowCloseEvent& event) { OnWindowClose(event);});
-    EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event); });
+    m_close_subscription = EventManager::Get().Subscribe<WindowCloseEvent>([this](const WindowCloseEvent& event) { OnWindowClose(event);});
+    m_resize_subscription = EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event); });
 }
 
 Application::~Application() {
 
+    // The callbacks capture this
+    EventManager::Get().Unsubscribe(m_close_subscription);
+    EventManager::Get().Unsubscribe(m_resize_subscription);
+
     UI::Get()->Finalize();
     UI::FreeSingleton();
 
@@ -124,15 +130,29 @@ void Application::Run()
         if (!m_status.isMinimized)
         {
             // TODO: Multithreading
-            OnUpdate(m_status.lastFrameDuration);
-
-            OnImGuiUpdate();
-
-            OnRender(m_status.lastFrameDuration);
+            {
+                QK_PROFILE_SCOPE("Application::OnUpdate");
+                OnUpdate(m_status.lastFrameDuration);
+            }
+
+            {
+                QK_PROFILE_SCOPE("Application::OnImGuiUpdate");
+                OnImGuiUpdate();
+            }
+
+            {
+                QK_PROFILE_SCOPE("Application::OnRender");
+                OnRender(m_status.lastFrameDuration);
+            }
         }
 
         // Dispatch events
-        EventManager::Get().DispatchEvents();
+        {
+            QK_PROFILE_SCOPE("EventManager::DispatchEvents");
+            EventManager::Get().DispatchEvents();
+        }
+
+        QK_PROFILE_FRAME();
 
         m_status.lastFrameDuration = m_timer.ElapsedSeconds() - start_frame;
         m_status.fps = 1.f / m_status.lastFrameDuration;
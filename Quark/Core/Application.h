@@ -5,6 +5,7 @@
 #include "Quark/Core/Window.h"
 #include "Quark/Core/JobSystem.h"
 #include "Quark/Events/ApplicationEvent.h"
+#include "Quark/Events/EventManager.h"
 #include "Quark/UI/UI.h"
 #include "Quark/Render/RenderSystem.h"
 
@@ -62,6 +63,9 @@ protected:
     Scope<Window> m_window;
 
 private:
+    EventManager::SubscriptionId m_close_subscription = EventManager::invalid_subscription;
+    EventManager::SubscriptionId m_resize_subscription = EventManager::invalid_subscription;
+
     static Application* s_instance;
 };
 
@@ -1,5 +1,6 @@
 #include "Quark/qkpch.h"
 #include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Profiler.h"
 
 namespace quark {
 
@@ -85,7 +86,9 @@ void JobSystem::JobQueue::SignalWorkDone()
 
 JobSystem::JobSystem()
 {
-	m_numWorkerThreads = std::thread::hardware_concurrency() - 1; // Leave one thread for the main thread
+	// Leave one thread for the main thread, but keep a worker on single core machines, Execute() needs a queue to push to.
+	// hardware_concurrency() may also return 0 if it can't tell.
+	m_numWorkerThreads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
 
 	// Initialize the job queues
 	m_jobQueues = std::vector<JobQueue>(m_numWorkerThreads);
@@ -138,9 +141,21 @@ void JobSystem::Execute(const JobFunction& jobFunc, Counter* counter)
 	m_jobQueues[queueIndex % m_numWorkerThreads].BlockingPush(job);
 }
 
+void JobSystem::Dispatch(uint32_t count, uint32_t groupSize, const std::function<void(uint32_t begin, uint32_t end)>& func, Counter* counter)
+{
+	QK_CORE_ASSERT(groupSize > 0);
+
+	for (uint32_t begin = 0; begin < count; begin += groupSize)
+	{
+		uint32_t end = std::min(begin + groupSize, count);
+		Execute([func, begin, end]() { func(begin, end); }, counter);
+	}
+}
+
 bool JobSystem::IsBusy(const Counter& counter) const
 {
-	return counter.count > 0;
+	// Pairs with the release in RunThread, results written by the jobs are visible once this returns false
+	return counter.count.load(std::memory_order_acquire) > 0;
 }
 
 void JobSystem::Wait(const Counter* counters, uint32_t numCounters)
@@ -157,6 +172,7 @@ void JobSystem::Wait(const Counter* counters, uint32_t numCounters)
 void JobSystem::RunThread(uint32_t threadId)
 {
 	QK_CORE_LOGT_TAG("Core", "Thread{} Start Working", threadId);
+	QK_PROFILE_THREAD("Worker " + std::to_string(threadId));
 
 	while (true)
 	{
@@ -178,12 +194,15 @@ void JobSystem::RunThread(uint32_t threadId)
 		if (!job.isValid() && !m_jobQueues[threadId].BlockingPop(job))
 			break;
 
-		job.jobFunction();
+		{
+			QK_PROFILE_SCOPE("Job");
+			job.jobFunction();
+		}
 
 		if (job.counter)
 		{
 			// Decrement the counter
-			job.counter->count.fetch_sub(1, std::memory_order_relaxed);
+			job.counter->count.fetch_sub(1, std::memory_order_release);
 		}
 	}
 
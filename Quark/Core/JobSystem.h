@@ -24,6 +24,11 @@ public:
 
 	void Execute(const JobFunction& jobFunc, Counter* counter = nullptr);
 
+	// Split [0, count) into groups of groupSize and run func(begin, end) for each group on the workers
+	void Dispatch(uint32_t count, uint32_t groupSize, const std::function<void(uint32_t begin, uint32_t end)>& func, Counter* counter);
+
+	uint32_t GetNumWorkerThreads() const { return m_numWorkerThreads; }
+
 	bool IsBusy(const Counter& conter) const;
 
 	void Wait(const Counter* counter, uint32_t numCounters);
@@ -3,6 +3,10 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace quark {
 
 std::shared_ptr<spdlog::logger> Logger::s_CoreLogger;
@@ -22,13 +26,244 @@ std::map<std::string, Logger::TagDetails> Logger::s_DefaultTagDetails = {
     { "UI",                TagDetails{  true, Level::Info  } },
 };
 
-void Logger::Init()
+namespace {
+
+constexpr uint64_t RING_SIZE = 64 * 1024;               // bytes per thread, power of two
+constexpr uint64_t RECORD_ALIGNMENT = 16;
+constexpr uint32_t MAX_MESSAGE_SIZE = RING_SIZE / 4;    // longer messages are truncated
+constexpr uint8_t PADDING_RECORD = 0xFF;                // marks the unused tail of the ring before a wrap
+
+struct RecordHeader
+{
+    int64_t time;       // spdlog::log_clock ticks, taken on the producing thread
+    uint32_t size;      // message bytes following the header
+    uint8_t type;
+    uint8_t level;
+    uint16_t padding;
+};
+static_assert(sizeof(RecordHeader) == RECORD_ALIGNMENT);
+
+// Single producer (the owning thread), single consumer (whoever holds the drain mutex).
+// Positions grow monotonically and are wrapped with the mask.
+struct ThreadRing
+{
+    alignas(64) std::atomic<uint64_t> write = 0;
+    alignas(64) std::atomic<uint64_t> read = 0;
+    std::atomic_bool abandoned = false; // owning thread has exited
+    std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(RING_SIZE);
+};
+
+struct ThreadRingHandle
+{
+    ThreadRing* ring = nullptr;
+    ~ThreadRingHandle() { if (ring) ring->abandoned.store(true, std::memory_order_release); }
+};
+
+struct AsyncState
+{
+    std::mutex registry_mutex;
+    std::vector<std::unique_ptr<ThreadRing>> rings;
+
+    std::mutex drain_mutex;
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    bool wake = false;
+    bool stop = false;
+    std::thread flusher;
+
+    std::atomic_bool running = false;
+    std::atomic<uint64_t> stalls = 0;
+
+    ~AsyncState()
+    {
+        // Logger::ShutDown() was never called, don't terminate on a joinable thread
+        if (flusher.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                stop = true;
+            }
+            wake_cv.notify_one();
+            flusher.join();
+        }
+    }
+};
+
+AsyncState s_async;
+
+std::mutex s_tag_details_mutex;
+Logger::TagDetails s_tag_details[Logger::s_KnownTagCount];
+
+constexpr uint64_t AlignRecord(uint64_t size)
+{
+    return (size + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+}
+
+spdlog::level::level_enum ToSpdlogLevel(Logger::Level level)
+{
+    switch (level)
+    {
+    case Logger::Level::Trace: return spdlog::level::trace;
+    case Logger::Level::Info:  return spdlog::level::info;
+    case Logger::Level::Warn:  return spdlog::level::warn;
+    case Logger::Level::Error: return spdlog::level::err;
+    case Logger::Level::Fatal: return spdlog::level::critical;
+    }
+    return spdlog::level::info;
+}
+
+ThreadRing& GetThreadRing()
+{
+    thread_local ThreadRingHandle handle;
+    if (!handle.ring)
+    {
+        std::lock_guard<std::mutex> lock(s_async.registry_mutex);
+        s_async.rings.push_back(std::make_unique<ThreadRing>());
+        handle.ring = s_async.rings.back().get();
+    }
+    return *handle.ring;
+}
+
+void WakeFlusher()
+{
+    {
+        std::lock_guard<std::mutex> lock(s_async.wake_mutex);
+        s_async.wake = true;
+    }
+    s_async.wake_cv.notify_one();
+}
+
+void PushRecord(Logger::Type type, Logger::Level level, std::string_view message)
+{
+    ThreadRing& ring = GetThreadRing();
+
+    uint32_t size = (uint32_t)std::min<size_t>(message.size(), MAX_MESSAGE_SIZE);
+    uint64_t record_size = AlignRecord(sizeof(RecordHeader) + size);
+
+    uint64_t write = ring.write.load(std::memory_order_relaxed);
+    uint64_t offset = write & (RING_SIZE - 1);
+    uint64_t tail = RING_SIZE - offset;
+    uint64_t needed = (tail < record_size) ? tail + record_size : record_size;
+
+    if (RING_SIZE - (write - ring.read.load(std::memory_order_acquire)) < needed)
+    {
+        s_async.stalls.fetch_add(1, std::memory_order_relaxed);
+        WakeFlusher();
+        while (RING_SIZE - (write - ring.read.load(std::memory_order_acquire)) < needed)
+            std::this_thread::yield();
+    }
+
+    if (tail < record_size)
+    {
+        // Not enough room before the end, skip the tail and start over at the front
+        RecordHeader* padding = reinterpret_cast<RecordHeader*>(ring.data.get() + offset);
+        padding->size = uint32_t(tail - sizeof(RecordHeader));
+        padding->level = PADDING_RECORD;
+        write += tail;
+        offset = 0;
+    }
+
+    RecordHeader* header = reinterpret_cast<RecordHeader*>(ring.data.get() + offset);
+    header->time = spdlog::log_clock::now().time_since_epoch().count();
+    header->size = size;
+    header->type = uint8_t(type);
+    header->level = uint8_t(level);
+    std::memcpy(header + 1, message.data(), size);
+
+    ring.write.store(write + record_size, std::memory_order_release);
+}
+
+// Write out everything queued so far. Records of all threads are merged by their timestamps.
+void Drain()
+{
+    struct Entry
+    {
+        int64_t time;
+        Logger::Type type;
+        Logger::Level level;
+        std::string_view message;
+    };
+
+    std::lock_guard<std::mutex> drain_lock(s_async.drain_mutex);
+
+    std::vector<std::pair<ThreadRing*, uint64_t>> consumed;
+    {
+        std::lock_guard<std::mutex> lock(s_async.registry_mutex);
+
+        // Rings of exited threads are dropped once they are empty
+        auto& rings = s_async.rings;
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::unique_ptr<ThreadRing>& ring) {
+            return ring->abandoned.load(std::memory_order_acquire) &&
+                ring->read.load(std::memory_order_relaxed) == ring->write.load(std::memory_order_acquire);
+        }), rings.end());
+
+        consumed.reserve(rings.size());
+        for (auto& ring : rings)
+            consumed.emplace_back(ring.get(), ring->write.load(std::memory_order_acquire));
+    }
+
+    thread_local std::vector<Entry> entries;
+    entries.clear();
+
+    for (auto& [ring, end] : consumed)
+    {
+        for (uint64_t pos = ring->read.load(std::memory_order_relaxed); pos < end;)
+        {
+            const RecordHeader* header = reinterpret_cast<const RecordHeader*>(ring->data.get() + (pos & (RING_SIZE - 1)));
+            pos += AlignRecord(sizeof(RecordHeader) + header->size);
+            if (header->level == PADDING_RECORD)
+                continue;
+
+            entries.push_back({ header->time, Logger::Type(header->type), Logger::Level(header->level),
+                std::string_view(reinterpret_cast<const char*>(header + 1), header->size) });
+        }
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+
+    for (const Entry& entry : entries)
+    {
+        auto& logger = (entry.type == Logger::Type::CORE) ? Logger::GetCoreLogger() : Logger::GetClientLogger();
+        if (!logger)
+            continue;
+
+        spdlog::log_clock::time_point time{ spdlog::log_clock::duration(entry.time) };
+        logger->log(time, spdlog::source_loc{}, ToSpdlogLevel(entry.level), spdlog::string_view_t(entry.message.data(), entry.message.size()));
+    }
+
+    // Hand the space back to the producers only after the messages were copied out by the sinks
+    for (auto& [ring, end] : consumed)
+        ring->read.store(end, std::memory_order_release);
+}
+
+void FlusherMain()
+{
+    constexpr auto flush_interval = std::chrono::milliseconds(5);
+
+    bool stop = false;
+    while (!stop)
+    {
+        {
+            std::unique_lock<std::mutex> lock(s_async.wake_mutex);
+            s_async.wake_cv.wait_for(lock, flush_interval, [] { return s_async.wake || s_async.stop; });
+            s_async.wake = false;
+            stop = s_async.stop;
+        }
+
+        Drain();
+    }
+}
+
+}
+
+void Logger::Init(Mode mode)
 {
     // Create "logs" directory if doesn't exist
     std::string logsDirectory = "logs";
     if (!std::filesystem::exists(logsDirectory))
         std::filesystem::create_directories(logsDirectory);
-    
+
     std::vector<spdlog::sink_ptr> quarkSinks =
     {
         std::make_shared<spdlog::sinks::basic_file_sink_mt>("logs/QUARK.log", true),
@@ -53,15 +288,99 @@ void Logger::Init()
     s_ClientLogger = std::make_shared<spdlog::logger>("APP", appSinks.begin(), appSinks.end());
     s_ClientLogger->set_level(spdlog::level::trace);
 
-    s_EnabledTags = s_DefaultTagDetails;
+    for (uint32_t i = 0; i < s_KnownTagCount; i++)
+        SetTagDetails(s_KnownTags[i], TagDetails());
+    for (const auto& [tag, details] : s_DefaultTagDetails)
+        SetTagDetails(tag, details);
 
+    if (mode == Mode::Async && !s_async.running.load())
+    {
+        s_async.stop = false;
+        s_async.flusher = std::thread(FlusherMain);
+        s_async.running.store(true, std::memory_order_release);
+    }
 }
 
 void Logger::ShutDown()
 {
+    if (s_async.running.exchange(false))
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_async.wake_mutex);
+            s_async.stop = true;
+        }
+        s_async.wake_cv.notify_one();
+        s_async.flusher.join();
+    }
+
+    // Messages pushed while the flusher was stopping
+    Drain();
+
     s_CoreLogger.reset();
     s_ClientLogger.reset();
     spdlog::drop_all();
 }
 
-}
\ No newline at end of file
+void Logger::Flush()
+{
+    if (s_async.running.load(std::memory_order_acquire))
+        Drain();
+
+    if (s_CoreLogger)
+        s_CoreLogger->flush();
+    if (s_ClientLogger)
+        s_ClientLogger->flush();
+}
+
+void Logger::SetTagDetails(std::string_view tag, const TagDetails& details)
+{
+    uint32_t id = InternTag(tag);
+    if (id == 0 && tag != s_KnownTags[0])
+        QK_CORE_LOGW_TAG("Core", "Log tag \"{}\" is not interned, changing the filter of all unknown tags", tag);
+
+    std::lock_guard<std::mutex> lock(s_tag_details_mutex);
+    s_tag_details[id] = details;
+    s_TagMinLevel[id].store(details.enabled ? uint8_t(details.levelFilter) : s_LevelOff, std::memory_order_relaxed);
+}
+
+Logger::TagDetails Logger::GetTagDetails(std::string_view tag)
+{
+    std::lock_guard<std::mutex> lock(s_tag_details_mutex);
+    return s_tag_details[InternTag(tag)];
+}
+
+uint64_t Logger::GetAsyncStallCount()
+{
+    return s_async.stalls.load(std::memory_order_relaxed);
+}
+
+std::string& Logger::GetFormatBuffer()
+{
+    thread_local std::string buffer = [] {
+        std::string s;
+        s.reserve(256);
+        return s;
+    }();
+    return buffer;
+}
+
+void Logger::Write(Type type, Level level, std::string_view message)
+{
+    if (s_async.running.load(std::memory_order_acquire))
+    {
+        PushRecord(type, level, message);
+
+        if (level == Level::Fatal)
+            Flush();
+        else if (level == Level::Error)
+            WakeFlusher();
+        return;
+    }
+
+    auto& logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
+    logger->log(spdlog::log_clock::now(), spdlog::source_loc{}, ToSpdlogLevel(level), spdlog::string_view_t(message.data(), message.size()));
+    if (level == Level::Fatal)
+        logger->flush();
+}
+
+}
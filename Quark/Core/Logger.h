@@ -1,8 +1,10 @@
 #pragma once
 #include "Quark/Core/Base.h"
 
+#include <atomic>
 #include <map>
 #include <format>
+#include <string_view>
 
 #include <spdlog/spdlog.h>
 
@@ -31,17 +33,43 @@ public:
     {
         Trace = 0, Info, Warn, Error, Fatal
     };
+    enum class Mode : uint8_t
+    {
+        Sync,   // format and write on the calling thread
+        Async   // format on the calling thread, a background thread does the I/O
+    };
     struct TagDetails
     {
         bool enabled = true;
         Level levelFilter = Level::Trace;
     };
 
-    static void Init();
+    // Tags known at compile time. Each is interned to its index, unknown tags share the filter of "Default".
+    static constexpr std::string_view s_KnownTags[] = {
+        "Default", "ANIMATION", "AssetManager", "Core", "Editor", "EventManager", "GLFW", "GLTFImporter", "Graphic",
+        "ImageAssetImporter", "Mesh", "Physics", "Project", "ProjectSerializer", "Renderer", "RHI", "Scene", "UI",
+    };
+    static constexpr uint32_t s_KnownTagCount = uint32_t(sizeof(s_KnownTags) / sizeof(s_KnownTags[0]));
+
+    static constexpr uint32_t InternTag(std::string_view tag)
+    {
+        for (uint32_t i = 1; i < s_KnownTagCount; i++)
+        {
+            if (s_KnownTags[i] == tag)
+                return i;
+        }
+        return 0;
+    }
+
+    static void Init(Mode mode = Mode::Async);
     static void ShutDown();
 
-    template<typename... Args>
+    // Block until all queued messages are written
+    static void Flush();
+
+    template<uint32_t TagId, typename... Args> requires (sizeof...(Args) > 0)
     static void PrintMessageTag(Logger::Type type, Logger::Level level, std::string_view tag, std::format_string<Args...> format, Args&&... args);
+    template<uint32_t TagId>
     static void PrintMessageTag(Logger::Type type, Logger::Level level, std::string_view tag, std::string_view message);
 
     template<typename... Args>
@@ -51,14 +79,24 @@ public:
     const static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
     const static std::shared_ptr<spdlog::logger>& GetClientLogger() { return s_ClientLogger; }
 
-    static bool HasTag(const std::string& tag) { return s_EnabledTags.find(tag) != s_EnabledTags.end(); }
-    static std::map<std::string, TagDetails>& GetEnabledTags() { return s_EnabledTags; }
+    static void SetTagDetails(std::string_view tag, const TagDetails& details);
+    static TagDetails GetTagDetails(std::string_view tag);
+
+    // Messages which had to wait for the background thread because the ring of their thread was full
+    static uint64_t GetAsyncStallCount();
 
 private:
+    QK_FORCE_INLINE static bool IsEnabled(uint32_t tag_id, Level level) { return uint8_t(level) >= s_TagMinLevel[tag_id].load(std::memory_order_relaxed); }
+
+    // Per-thread scratch string, reused to avoid allocations when formatting
+    static std::string& GetFormatBuffer();
+    static void Write(Type type, Level level, std::string_view message);
+
     static std::shared_ptr<spdlog::logger> s_CoreLogger;
     static std::shared_ptr<spdlog::logger> s_ClientLogger;
 
-    inline static std::map<std::string, TagDetails> s_EnabledTags;
+    static constexpr uint8_t s_LevelOff = 0xFF;
+    inline static std::atomic_uint8_t s_TagMinLevel[s_KnownTagCount] = {};   // min level written per tag, s_LevelOff if disabled
     static std::map<std::string, TagDetails> s_DefaultTagDetails;
 };
 
@@ -94,90 +132,65 @@ private:
 //////////////////////////////////////////////////////////////////////////////////////
 // 
 // Core logging
-#define QK_CORE_LOGT_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CORE, ::quark::Logger::Level::Trace, tag, __VA_ARGS__)
-#define QK_CORE_LOGI_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CORE, ::quark::Logger::Level::Info, tag, __VA_ARGS__)
-#define QK_CORE_LOGW_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CORE, ::quark::Logger::Level::Warn, tag, __VA_ARGS__)
-#define QK_CORE_LOGE_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CORE, ::quark::Logger::Level::Error, tag, __VA_ARGS__)
-#define QK_CORE_LOGF_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CORE, ::quark::Logger::Level::Fatal, tag, __VA_ARGS__)
+#define QK_CORE_LOGT_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CORE, ::quark::Logger::Level::Trace, tag, __VA_ARGS__)
+#define QK_CORE_LOGI_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CORE, ::quark::Logger::Level::Info, tag, __VA_ARGS__)
+#define QK_CORE_LOGW_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CORE, ::quark::Logger::Level::Warn, tag, __VA_ARGS__)
+#define QK_CORE_LOGE_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CORE, ::quark::Logger::Level::Error, tag, __VA_ARGS__)
+#define QK_CORE_LOGF_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CORE, ::quark::Logger::Level::Fatal, tag, __VA_ARGS__)
 
 // Client logging
-#define QK_APP_LOGT_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Trace, tag, __VA_ARGS__)
-#define QK_APP_LOGI_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Info, tag, __VA_ARGS__)
-#define QK_APP_LOGW_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Warn, tag, __VA_ARGS__)
-#define QK_APP_LOGE_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Error, tag, __VA_ARGS__)
-#define QK_APP_LOGF_TAG(tag, ...) ::quark::Logger::PrintMessageTag(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Fatal, tag, __VA_ARGS__)
+#define QK_APP_LOGT_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Trace, tag, __VA_ARGS__)
+#define QK_APP_LOGI_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Info, tag, __VA_ARGS__)
+#define QK_APP_LOGW_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Warn, tag, __VA_ARGS__)
+#define QK_APP_LOGE_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Error, tag, __VA_ARGS__)
+#define QK_APP_LOGF_TAG(tag, ...) ::quark::Logger::PrintMessageTag<::quark::Logger::InternTag(tag)>(::quark::Logger::Type::CLIENT, ::quark::Logger::Level::Fatal, tag, __VA_ARGS__)
 
 namespace quark
 {
-template<typename... Args>
+template<uint32_t TagId, typename... Args> requires (sizeof...(Args) > 0)
 void Logger::PrintMessageTag(Logger::Type type, Logger::Level level, std::string_view tag, const std::format_string<Args...> format, Args&&... args)
 {
-    auto detail = s_EnabledTags[std::string(tag)];
-    if (detail.enabled && detail.levelFilter <= level)
-    {
-        auto logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
-        std::string formatted = std::format(format, std::forward<Args>(args)...);
-        switch (level)
-        {
-        case Level::Trace:
-            logger->trace("[{0}] {1}", tag, formatted);
-            break;
-        case Level::Info:
-            logger->info("[{0}] {1}", tag, formatted);
-            break;
-        case Level::Warn:
-            logger->warn("[{0}] {1}", tag, formatted);
-            break;
-        case Level::Error:
-            logger->error("[{0}] {1}", tag, formatted);
-            break;
-        case Level::Fatal:
-            logger->critical("[{0}] {1}", tag, formatted);
-            break;
-        }
-    }
+    if (!IsEnabled(TagId, level))
+        return;
+
+    std::string& buffer = GetFormatBuffer();
+    buffer.clear();
+    std::format_to(std::back_inserter(buffer), "[{0}] ", tag);
+    std::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+    Write(type, level, buffer);
 }
 
-inline void Logger::PrintMessageTag(Logger::Type type, Logger::Level level, std::string_view tag, std::string_view message)
+template<uint32_t TagId>
+void Logger::PrintMessageTag(Logger::Type type, Logger::Level level, std::string_view tag, std::string_view message)
 {
-    auto detail = s_EnabledTags[std::string(tag)];
-    if (detail.enabled && detail.levelFilter <= level)
-    {
-        auto logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
-        switch (level)
-        {
-        case Level::Trace:
-            logger->trace("[{0}] {1}", tag, message);
-            break;
-        case Level::Info:
-            logger->info("[{0}] {1}", tag, message);
-            break;
-        case Level::Warn:
-            logger->warn("[{0}] {1}", tag, message);
-            break;
-        case Level::Error:
-            logger->error("[{0}] {1}", tag, message);
-            break;
-        case Level::Fatal:
-            logger->critical("[{0}] {1}", tag, message);
-            break;
-        }
-    }
+    if (!IsEnabled(TagId, level))
+        return;
+
+    std::string& buffer = GetFormatBuffer();
+    buffer.clear();
+    std::format_to(std::back_inserter(buffer), "[{0}] {1}", tag, message);
+    Write(type, level, buffer);
 }
 
 template<typename... Args>
 void Logger::PrintAssertMessage(Logger::Type type, std::string_view prefix, std::string_view condition, std::string_view inFile, uint32_t inLine, std::format_string<Args...> message, Args&&... args)
 {
-    auto logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
     auto formatted = std::format(message, std::forward<Args>(args)...);
+
+    // The assert is likely followed by a break, don't leave queued messages behind
+    Flush();
+    auto logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
     logger->error("{0}: {1}, message: {2}, in file {3}, in line {4}", prefix, condition, formatted, inFile, inLine);
+    logger->flush();
 }
 
 
 inline void Logger::PrintAssertMessage(Logger::Type type, std::string_view prefix, std::string_view condition, std::string_view inFile, uint32_t inLine)
 {
+    Flush();
     auto logger = (type == Type::CORE) ? GetCoreLogger() : GetClientLogger();
     logger->error("{0}: {1}, in file {2}, in line {3}", prefix, condition, inFile, inLine);
+    logger->flush();
 }
 
 }
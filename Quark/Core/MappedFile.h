@@ -0,0 +1,36 @@
+#pragma once
+#include "Quark/Core/Base.h"
+
+#include <filesystem>
+
+namespace quark {
+
+// Read-only view of a whole file mapped into memory.
+// Pages are loaded by the OS on first access, nothing is copied on Open().
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::filesystem::path& filepath);
+	void Close();
+
+	bool IsOpen() const { return m_data != nullptr; }
+	const byte* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const byte* m_data = nullptr;
+	size_t m_size = 0;
+
+#ifdef QK_PLATFORM_WINDOWS
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
+
+}
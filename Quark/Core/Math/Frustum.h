@@ -14,6 +14,9 @@ public:
 
     void Build(const glm::mat4& inv_view_proj_mat);
     bool CheckSphere(const Aabb& aabb) const;
+
+    // Normals point inside, dot(plane, vec4(p, 1)) >= 0 for points inside the frustum
+    const std::array<glm::vec4, 6>& GetPlanes() const { return planes; }
 private:
     glm::mat4 inv_view_proj_matrix_;
     std::array<glm::vec4, 6> planes;
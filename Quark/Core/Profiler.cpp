@@ -0,0 +1,239 @@
+#include "Quark/qkpch.h"
+#include "Quark/Core/Profiler.h"
+
+#include <fstream>
+#include <mutex>
+
+namespace quark {
+
+namespace {
+
+// Single producer (the owning thread), single consumer (the main thread at frame end)
+struct ThreadRing
+{
+    static constexpr uint32_t capacity = 1 << 14;
+
+    struct Event
+    {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    std::vector<Event> events = std::vector<Event>(capacity);
+    std::atomic_uint32_t write = 0;
+    std::atomic_uint32_t read = 0;
+    std::atomic_uint32_t dropped = 0;
+    uint32_t id = 0;
+    std::string name;
+};
+
+struct CapturedEvent
+{
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+    uint32_t thread;
+};
+
+struct ProfilerState
+{
+    std::mutex lock;
+    std::vector<Scope<ThreadRing>> rings;   // rings outlive their threads
+
+    // capture
+    uint32_t requested_frames = 0;
+    std::string requested_path;
+    uint32_t remaining_frames = 0;
+    std::string path;
+    std::vector<CapturedEvent> events;
+    uint64_t frame_begin_ticks = 0;
+
+    // tick calibration against the steady clock
+    uint64_t start_ticks = 0;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+ProfilerState& GetState()
+{
+    static ProfilerState state;
+    return state;
+}
+
+thread_local ThreadRing* t_ring = nullptr;
+
+ThreadRing& GetThreadRing()
+{
+    if (!t_ring)
+    {
+        ProfilerState& state = GetState();
+        std::lock_guard<std::mutex> lock(state.lock);
+        auto& ring = state.rings.emplace_back(CreateScope<ThreadRing>());
+        ring->id = (uint32_t)state.rings.size() - 1;
+        ring->name = "Thread " + std::to_string(ring->id);
+        t_ring = ring.get();
+    }
+
+    return *t_ring;
+}
+
+// Move everything recorded so far out of the rings. Must hold the state lock.
+void DrainRingsNoLock(ProfilerState& state, bool keep)
+{
+    for (auto& ring : state.rings)
+    {
+        uint32_t read = ring->read.load(std::memory_order_relaxed);
+        uint32_t write = ring->write.load(std::memory_order_acquire);
+        if (keep)
+        {
+            for (uint32_t i = read; i != write; i++)
+            {
+                const ThreadRing::Event& e = ring->events[i & (ThreadRing::capacity - 1)];
+                state.events.push_back({ e.name, e.begin, e.end, ring->id });
+            }
+        }
+        ring->read.store(write, std::memory_order_release);
+    }
+}
+
+void WriteJsonString(std::ofstream& out, const char* str)
+{
+    out << '"';
+    for (const char* c = str; *c; c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out << '\\';
+        if ((unsigned char)*c >= 0x20)
+            out << *c;
+    }
+    out << '"';
+}
+
+void WriteCaptureNoLock(ProfilerState& state)
+{
+    // Ticks per microsecond, measured over the capture
+    auto end_time = std::chrono::steady_clock::now();
+    uint64_t end_ticks = Profiler::GetTicks();
+    double elapsed_us = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - state.start_time).count() * 1e-3;
+    double ticks_per_us = elapsed_us > 0.0 ? double(end_ticks - state.start_ticks) / elapsed_us : 1.0;
+
+    std::ofstream out(state.path, std::ios::out | std::ios::trunc);
+    if (!out.is_open())
+    {
+        QK_CORE_LOGE_TAG("Core", "Profiler: failed to open {} for writing", state.path);
+        return;
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const auto& ring : state.rings)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << ring->id << ",\"args\":{\"name\":";
+        WriteJsonString(out, ring->name.c_str());
+        out << "}}";
+        first = false;
+    }
+
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    for (const CapturedEvent& e : state.events)
+    {
+        if (e.begin < state.start_ticks)
+            continue; // scope began before the capture
+
+        double ts = double(e.begin - state.start_ticks) / ticks_per_us;
+        double dur = double(e.end - e.begin) / ticks_per_us;
+        out << (first ? "" : ",\n") << "{\"name\":";
+        WriteJsonString(out, e.name);
+        out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+
+    uint32_t dropped = 0;
+    for (const auto& ring : state.rings)
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+
+    QK_CORE_LOGI_TAG("Core", "Profiler: wrote {} events to {} ({} dropped)", state.events.size(), state.path, dropped);
+}
+
+}
+
+void Profiler::Record(const char* name, uint64_t begin, uint64_t end)
+{
+    ThreadRing& ring = GetThreadRing();
+
+    uint32_t write = ring.write.load(std::memory_order_relaxed);
+    if (write - ring.read.load(std::memory_order_acquire) >= ThreadRing::capacity)
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring.events[write & (ThreadRing::capacity - 1)] = { name, begin, end };
+    ring.write.store(write + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    ThreadRing& ring = GetThreadRing();
+
+    std::lock_guard<std::mutex> lock(GetState().lock);
+    ring.name = name;
+}
+
+void Profiler::RequestCapture(uint32_t frame_count, const std::string& path)
+{
+    QK_CORE_ASSERT(frame_count > 0);
+
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.lock);
+    state.requested_frames = frame_count;
+    state.requested_path = path;
+}
+
+bool Profiler::IsCapturePending()
+{
+    ProfilerState& state = GetState();
+    std::lock_guard<std::mutex> lock(state.lock);
+    return state.requested_frames > 0 || state.remaining_frames > 0;
+}
+
+void Profiler::OnFrameEnd()
+{
+    ProfilerState& state = GetState();
+    uint64_t now = GetTicks();
+
+    if (IsCapturing())
+        Record("Frame", state.frame_begin_ticks, now);
+
+    std::lock_guard<std::mutex> lock(state.lock);
+    DrainRingsNoLock(state, IsCapturing());
+    state.frame_begin_ticks = now;
+
+    if (state.remaining_frames > 0 && --state.remaining_frames == 0)
+    {
+        s_capturing.store(false, std::memory_order_relaxed);
+        DrainRingsNoLock(state, true);  // scopes of other threads which ended after the first drain
+        WriteCaptureNoLock(state);
+        state.events.clear();
+        state.events.shrink_to_fit();
+    }
+
+    if (state.requested_frames > 0 && state.remaining_frames == 0)
+    {
+        state.remaining_frames = state.requested_frames;
+        state.path = state.requested_path;
+        state.requested_frames = 0;
+        state.start_ticks = GetTicks();
+        state.start_time = std::chrono::steady_clock::now();
+        state.frame_begin_ticks = state.start_ticks;
+        for (auto& ring : state.rings)
+            ring->dropped.store(0, std::memory_order_relaxed);
+
+        s_capturing.store(true, std::memory_order_relaxed);
+    }
+}
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "Quark/Core/Base.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#if defined(QK_COMPILER_MSVC)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace quark {
+
+// Low overhead cpu scope profiler.
+// Scopes are only recorded while a capture is running. Every thread writes into its own lock-free
+// ring, the main thread drains all rings at the end of each frame. Captured frames are written as
+// Chrome trace json, which can be opened with chrome://tracing or ui.perfetto.dev.
+// Scope names are not copied and must have static storage duration (string literals).
+class Profiler
+{
+public:
+    QK_FORCE_INLINE static uint64_t GetTicks()
+    {
+#if defined(QK_COMPILER_MSVC) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        uint64_t ticks;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+        return ticks;
+#else
+        return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    QK_FORCE_INLINE static bool IsCapturing() { return s_capturing.load(std::memory_order_relaxed); }
+
+    static void Record(const char* name, uint64_t begin, uint64_t end);
+    static void SetThreadName(const std::string& name);
+
+    // Capture the next frame_count frames into a Chrome trace json file. The capture starts at the next frame boundary.
+    static void RequestCapture(uint32_t frame_count, const std::string& path);
+    static bool IsCapturePending();
+
+    // Frame boundary, call once per frame from the main thread
+    static void OnFrameEnd();
+
+private:
+    static inline std::atomic_bool s_capturing = false;
+};
+
+class ProfileScope
+{
+public:
+    QK_FORCE_INLINE ProfileScope(const char* name)
+        : m_name(Profiler::IsCapturing() ? name : nullptr)
+    {
+        if (m_name)
+            m_begin = Profiler::GetTicks();
+    }
+
+    QK_FORCE_INLINE ~ProfileScope()
+    {
+        if (m_name)
+            Profiler::Record(m_name, m_begin, Profiler::GetTicks());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_name;
+    uint64_t m_begin = 0;
+};
+
+}
+
+#ifdef QK_ENABLE_PROFILER
+    #define QK_PROFILE_CONCAT_INNER(a, b) a##b
+    #define QK_PROFILE_CONCAT(a, b) QK_PROFILE_CONCAT_INNER(a, b)
+    #define QK_PROFILE_SCOPE(name) ::quark::ProfileScope QK_PROFILE_CONCAT(_qk_profile_scope_, __LINE__){ name }
+    #define QK_PROFILE_FUNCTION() QK_PROFILE_SCOPE(__FUNCTION__)
+    #define QK_PROFILE_THREAD(name) ::quark::Profiler::SetThreadName(name)
+    #define QK_PROFILE_FRAME() ::quark::Profiler::OnFrameEnd()
+#else
+    #define QK_PROFILE_SCOPE(name)
+    #define QK_PROFILE_FUNCTION()
+    #define QK_PROFILE_THREAD(name)
+    #define QK_PROFILE_FRAME()
+#endif
@@ -0,0 +1,133 @@
+#include "Quark/qkpch.h"
+#include "Quark/Core/Util/OffsetAllocator.h"
+
+namespace quark::util {
+
+void OffsetAllocator::Reset(uint64_t capacity)
+{
+	m_capacity = capacity;
+	m_used = 0;
+	m_free_by_offset.clear();
+	m_free_by_size.clear();
+
+	if (capacity > 0)
+		InsertFreeBlock(0, capacity);
+}
+
+OffsetAllocator::Allocation OffsetAllocator::Allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0)
+		return {};
+	if (alignment == 0)
+		alignment = 1;
+
+	// Best fit: walk from the smallest block which could hold the data without padding
+	for (auto it = m_free_by_size.lower_bound({ size, 0 }); it != m_free_by_size.end(); ++it)
+	{
+		uint64_t block_size = it->first;
+		uint64_t block_offset = it->second;
+
+		uint64_t aligned_offset = (block_offset + alignment - 1) / alignment * alignment;
+		uint64_t padding = aligned_offset - block_offset;
+		if (padding + size > block_size)
+			continue;
+
+		EraseFreeBlock(m_free_by_offset.find(block_offset));
+
+		// Give the remainder back
+		uint64_t reserved = padding + size;
+		if (block_size > reserved)
+			InsertFreeBlock(block_offset + reserved, block_size - reserved);
+
+		m_used += reserved;
+
+		Allocation allocation;
+		allocation.offset = aligned_offset;
+		allocation.size = reserved;
+		allocation.padding = padding;
+		return allocation;
+	}
+
+	return {};
+}
+
+void OffsetAllocator::Free(const Allocation& allocation)
+{
+	if (!allocation.IsValid())
+		return;
+
+	uint64_t offset = allocation.offset - allocation.padding;
+	uint64_t size = allocation.size;
+	QK_CORE_ASSERT(offset + size <= m_capacity)
+	QK_CORE_ASSERT(m_used >= size)
+	m_used -= size;
+
+	// Coalesce with the following block
+	auto next = m_free_by_offset.find(offset + size);
+	if (next != m_free_by_offset.end())
+	{
+		size += next->second;
+		EraseFreeBlock(next);
+	}
+
+	// Coalesce with the previous block
+	auto prev = m_free_by_offset.lower_bound(offset);
+	if (prev != m_free_by_offset.begin())
+	{
+		--prev;
+		QK_CORE_ASSERT(prev->first + prev->second <= offset, "Double free in OffsetAllocator")
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			EraseFreeBlock(prev);
+		}
+	}
+
+	InsertFreeBlock(offset, size);
+}
+
+void OffsetAllocator::Grow(uint64_t new_capacity)
+{
+	if (new_capacity <= m_capacity)
+		return;
+
+	Allocation tail;
+	tail.offset = m_capacity;
+	tail.size = new_capacity - m_capacity;
+
+	m_used += tail.size; // Free() below gives it back
+	m_capacity = new_capacity;
+	Free(tail);
+}
+
+uint64_t OffsetAllocator::GetLargestFreeBlock() const
+{
+	if (m_free_by_size.empty())
+		return 0;
+
+	return m_free_by_size.rbegin()->first;
+}
+
+float OffsetAllocator::GetFragmentation() const
+{
+	uint64_t free_size = GetFreeSize();
+	if (free_size == 0)
+		return 0.f;
+
+	return 1.f - float(GetLargestFreeBlock()) / float(free_size);
+}
+
+void OffsetAllocator::InsertFreeBlock(uint64_t offset, uint64_t size)
+{
+	m_free_by_offset.emplace(offset, size);
+	m_free_by_size.emplace(size, offset);
+}
+
+void OffsetAllocator::EraseFreeBlock(std::map<uint64_t, uint64_t>::iterator it)
+{
+	m_free_by_size.erase({ it->second, it->first });
+	m_free_by_offset.erase(it);
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <set>
+
+namespace quark::util {
+
+// Manages a linear range [0, capacity) and hands out sub-ranges of it.
+// Free ranges are kept sorted by offset so neighbours coalesce on Free(),
+// and indexed by size so Allocate() can do a best fit lookup.
+// The allocator never touches memory, it only does the bookkeeping.
+class OffsetAllocator
+{
+public:
+	static constexpr uint64_t invalid_offset = ~uint64_t(0);
+
+	struct Allocation
+	{
+		uint64_t offset = invalid_offset;
+		uint64_t size = 0;	// size reserved for this allocation, including alignment padding
+		uint64_t padding = 0; // bytes skipped at the front of the reserved range to satisfy the alignment
+
+		bool IsValid() const { return offset != invalid_offset; }
+	};
+
+	OffsetAllocator() = default;
+	explicit OffsetAllocator(uint64_t capacity) { Reset(capacity); }
+
+	void Reset(uint64_t capacity);
+
+	// Alignment does not need to be a power of two, vertex streams are aligned to their stride.
+	Allocation Allocate(uint64_t size, uint64_t alignment = 1);
+	void Free(const Allocation& allocation);
+
+	// Grows the managed range, the new tail is merged into the free list.
+	void Grow(uint64_t new_capacity);
+
+	uint64_t GetCapacity() const { return m_capacity; }
+	uint64_t GetUsedSize() const { return m_used; }
+	uint64_t GetFreeSize() const { return m_capacity - m_used; }
+	uint64_t GetLargestFreeBlock() const;
+	uint32_t GetFreeBlockCount() const { return (uint32_t)m_free_by_offset.size(); }
+
+	// 0 means all free space is one contiguous block, approaching 1 means free space is scattered
+	float GetFragmentation() const;
+
+private:
+	void InsertFreeBlock(uint64_t offset, uint64_t size);
+	void EraseFreeBlock(std::map<uint64_t, uint64_t>::iterator it);
+
+	uint64_t m_capacity = 0;
+	uint64_t m_used = 0;
+
+	std::map<uint64_t, uint64_t> m_free_by_offset;			// offset -> size
+	std::set<std::pair<uint64_t, uint64_t>> m_free_by_size;	// (size, offset)
+};
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include "Quark/Core/Base.h"
+#include "Quark/Ecs/Component.h"
+
+#include <atomic>
+#include <bitset>
+
+namespace quark {
+
+static constexpr uint32_t MAX_COMPONENT_TYPES = 128;
+
+// One bit per component type an entity has, indexed by ComponentTypeIndex
+using ComponentSignature = std::bitset<MAX_COMPONENT_TYPES>;
+
+// Dense index of a component type, assigned on first use. Indexes the per-type storage.
+class ComponentTypeIndex
+{
+public:
+    template<typename T>
+    static uint32_t Get()
+    {
+        static const uint32_t index = s_Count.fetch_add(1, std::memory_order_relaxed);
+        QK_CORE_ASSERT(index < MAX_COMPONENT_TYPES, "Too many component types");
+        return index;
+    }
+
+    static uint32_t GetCount() { return s_Count.load(std::memory_order_relaxed); }
+
+private:
+    inline static std::atomic<uint32_t> s_Count = 0;
+};
+
+// Sparse set of the components of one type, keyed by entity index.
+// The sparse side is paged so a few entities with high indices don't allocate the full range,
+// the dense side keeps the live components packed for iteration.
+// Every component also carries the change tick it was last modified at, see ComponentStorage.
+class ComponentSparseSet
+{
+public:
+    static constexpr uint32_t PAGE_SIZE = 1024;
+    static constexpr uint32_t INVALID = ~0u;
+
+    Component* Get(uint32_t entity_index) const
+    {
+        uint32_t dense = GetDenseIndex(entity_index);
+        return dense != INVALID ? m_Dense[dense] : nullptr;
+    }
+
+    bool Has(uint32_t entity_index) const { return GetDenseIndex(entity_index) != INVALID; }
+
+    uint32_t GetDenseIndex(uint32_t entity_index) const
+    {
+        uint32_t page = entity_index / PAGE_SIZE;
+        if (page >= m_Sparse.size() || !m_Sparse[page])
+            return INVALID;
+        return m_Sparse[page][entity_index % PAGE_SIZE];
+    }
+
+    void Insert(uint32_t entity_index, Component* component, uint32_t version)
+    {
+        uint32_t page = entity_index / PAGE_SIZE;
+        if (page >= m_Sparse.size())
+            m_Sparse.resize(page + 1);
+        if (!m_Sparse[page])
+        {
+            m_Sparse[page] = std::make_unique<uint32_t[]>(PAGE_SIZE);
+            std::fill_n(m_Sparse[page].get(), PAGE_SIZE, INVALID);
+        }
+
+        m_Sparse[page][entity_index % PAGE_SIZE] = (uint32_t)m_Dense.size();
+        m_Dense.push_back(component);
+        m_DenseEntities.push_back(entity_index);
+        m_Versions.push_back(version);
+    }
+
+    // Swap with the last element, the order of the dense arrays is not stable
+    void Remove(uint32_t entity_index)
+    {
+        uint32_t dense = GetDenseIndex(entity_index);
+        if (dense == INVALID)
+            return;
+
+        uint32_t last_entity = m_DenseEntities.back();
+        m_Dense[dense] = m_Dense.back();
+        m_DenseEntities[dense] = last_entity;
+        m_Versions[dense] = m_Versions.back();
+        m_Sparse[last_entity / PAGE_SIZE][last_entity % PAGE_SIZE] = dense;
+
+        m_Sparse[entity_index / PAGE_SIZE][entity_index % PAGE_SIZE] = INVALID;
+        m_Dense.pop_back();
+        m_DenseEntities.pop_back();
+        m_Versions.pop_back();
+    }
+
+    uint32_t GetVersion(uint32_t entity_index) const
+    {
+        uint32_t dense = GetDenseIndex(entity_index);
+        return dense != INVALID ? m_Versions[dense] : 0;
+    }
+
+    void SetVersion(uint32_t entity_index, uint32_t version)
+    {
+        uint32_t dense = GetDenseIndex(entity_index);
+        if (dense != INVALID)
+            m_Versions[dense] = version;
+    }
+
+    uint32_t GetSize() const { return (uint32_t)m_Dense.size(); }
+    Component* const* GetComponents() const { return m_Dense.data(); }
+    const uint32_t* GetEntityIndices() const { return m_DenseEntities.data(); }
+    const uint32_t* GetVersions() const { return m_Versions.data(); }
+
+private:
+    std::vector<std::unique_ptr<uint32_t[]>> m_Sparse;
+    std::vector<Component*> m_Dense;
+    std::vector<uint32_t> m_DenseEntities;
+    std::vector<uint32_t> m_Versions;
+};
+
+// One sparse set per component type, indexed by ComponentTypeIndex.
+// Components added or marked changed are stamped with the current change tick. A system remembers
+// the tick it last ran at and only visits components stamped after it, see EntityGroup::ForEachChangedSince().
+class ComponentStorage
+{
+public:
+    uint32_t GetChangeTick() const { return m_ChangeTick; }
+    void AdvanceChangeTick() { m_ChangeTick++; }
+
+    void MarkChanged(uint32_t type_index, uint32_t entity_index)
+    {
+        if (type_index < m_Sets.size())
+            m_Sets[type_index].SetVersion(entity_index, m_ChangeTick);
+    }
+
+    uint32_t GetVersion(uint32_t type_index, uint32_t entity_index) const
+    {
+        return type_index < m_Sets.size() ? m_Sets[type_index].GetVersion(entity_index) : 0;
+    }
+
+    Component* Get(uint32_t type_index, uint32_t entity_index) const
+    {
+        return type_index < m_Sets.size() ? m_Sets[type_index].Get(entity_index) : nullptr;
+    }
+
+    bool Has(uint32_t type_index, uint32_t entity_index) const
+    {
+        return type_index < m_Sets.size() && m_Sets[type_index].Has(entity_index);
+    }
+
+    ComponentSparseSet& GetSet(uint32_t type_index)
+    {
+        if (type_index >= m_Sets.size())
+            m_Sets.resize(type_index + 1);
+        return m_Sets[type_index];
+    }
+
+    uint32_t GetTypeCount() const { return (uint32_t)m_Sets.size(); }
+
+private:
+    std::vector<ComponentSparseSet> m_Sets;
+    uint32_t m_ChangeTick = 1; // 0 is "never seen", so everything counts as changed for a new system
+};
+
+}
@@ -1,62 +1,69 @@
 #pragma once
 #include "Quark/Core/Base.h"
 #include "Quark/Core/Util/CompileTimeHash.h"
-#include "Quark/Core/Util/IntrusiveHashMap.h"
 #include "Quark/Ecs/Component.h"
+#include "Quark/Ecs/ComponentStorage.h"
+#include "Quark/Ecs/EntityHandle.h"
 
 // Please include EntityRegistry.h file in you .cpp not this file.
 namespace quark {
 class EntityRegistry;
 class Entity {
 public:
-    Entity(EntityRegistry* registry, util::Hash hashId)
-        : m_Registry(registry), m_HashId(hashId), m_OffsetInRegistry(0)
+    Entity(EntityRegistry* registry, ComponentStorage* storage, EntityHandle handle)
+        : m_Registry(registry), m_Storage(storage), m_Handle(handle), m_OffsetInRegistry(0)
     {
 
     }
 
     ~Entity() = default;
 
+    EntityHandle GetHandle() const { return m_Handle; }
+
+    const ComponentSignature& GetSignature() const { return m_Signature; }
+
     template<typename T>
-    bool HasComponent() const { return HasComponent(T::GetStaticComponentType()); }
-    bool HasComponent(ComponentType id) const { return m_ComponentMap.find(id) != nullptr; }
+    bool HasComponent() const { return m_Signature.test(ComponentTypeIndex::Get<T>()); }
 
     template<typename T>
-    T* GetComponent() 
+    T* GetComponent()
     {
-        auto* find = m_ComponentMap.find(T::GetStaticComponentType());
-        if (find)
-            return static_cast<T*>(find->get());
-        else
-            return nullptr;;
+        return static_cast<T*>(m_Storage->Get(ComponentTypeIndex::Get<T>(), m_Handle.GetIndex()));
     }
 
     template<typename T>
-    const T* GetComponent() const 
+    const T* GetComponent() const
     {
-        auto* find = m_ComponentMap.find(T::GetStaticComponentType());
-        if (find)
-            return static_cast<T*>(find->get());
-        else
-            return nullptr;;
+        return static_cast<const T*>(m_Storage->Get(ComponentTypeIndex::Get<T>(), m_Handle.GetIndex()));
     }
 
+    // Stamp the component with the current change tick
+    template<typename T>
+    void MarkChanged() { m_Storage->MarkChanged(ComponentTypeIndex::Get<T>(), m_Handle.GetIndex()); }
+
+    template<typename T>
+    uint32_t GetComponentVersion() const { return m_Storage->GetVersion(ComponentTypeIndex::Get<T>(), m_Handle.GetIndex()); }
+
+    template<typename T>
+    bool IsChangedSince(uint32_t tick) const { return GetComponentVersion<T>() > tick; }
+
     template<typename T, typename... Ts>
     T* AddComponent(Ts&&... ts);    // defined in EntityRegistry.h
 
     template<typename T>
     void RemoveComponent();
-    
+
 private:
     EntityRegistry* m_Registry;
+    ComponentStorage* m_Storage; // owned by the registry
+    EntityHandle m_Handle;
+    ComponentSignature m_Signature;
     size_t m_OffsetInRegistry; // be allocated and used in EntityRegistry
-    util::Hash m_HashId;    
-    util::IntrusiveHashMapHolder<util::IntrusivePODWrapper<Component*>> m_ComponentMap;
 
     friend class EntityRegistry;
-    
+
     template<typename...>
     friend class EntityGroup;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,171 @@
+#include "Quark/qkpch.h"
+#include "Quark/Ecs/EntityCommandBuffer.h"
+
+namespace quark {
+
+EntityCommandBuffer::~EntityCommandBuffer()
+{
+    Clear();
+}
+
+CommandEntity EntityCommandBuffer::CreateEntity()
+{
+    CommandEntity entity;
+    entity.temp_id = m_NextTempId++;
+
+    m_Commands.push_back({ m_SortKey, CommandType::CreateEntity, 0, entity, nullptr });
+    return entity;
+}
+
+void EntityCommandBuffer::DestroyEntity(CommandEntity entity)
+{
+    m_Commands.push_back({ m_SortKey, CommandType::DestroyEntity, 0, entity, nullptr });
+}
+
+void EntityCommandBuffer::Clear()
+{
+    for (Command& cmd : m_Commands)
+    {
+        if (cmd.payload)
+            cmd.payload->~ComponentPayload();
+    }
+
+    m_Commands.clear();
+    m_CreatedEntities.clear();
+    m_BlockIndex = 0;
+    m_BlockOffset = 0;
+    m_SortKey = 0;
+    m_NextTempId = 0;
+}
+
+void* EntityCommandBuffer::Allocate(size_t size, size_t alignment)
+{
+    while (m_BlockIndex < m_Blocks.size())
+    {
+        Block& block = m_Blocks[m_BlockIndex];
+        size_t offset = (m_BlockOffset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block.size)
+        {
+            m_BlockOffset = offset + size;
+            return block.data.get() + offset;
+        }
+
+        m_BlockIndex++;
+        m_BlockOffset = 0;
+    }
+
+    // operator new[] alignment is enough for anything but over-aligned components
+    QK_CORE_ASSERT(alignment <= alignof(std::max_align_t));
+
+    size_t block_size = std::max(BLOCK_SIZE, size);
+    m_Blocks.push_back({ std::make_unique<std::byte[]>(block_size), block_size });
+    m_BlockIndex = m_Blocks.size() - 1;
+    m_BlockOffset = size;
+    return m_Blocks.back().data.get();
+}
+
+EntityCommandQueue::EntityCommandQueue()
+    : m_Serial(s_NextSerial.fetch_add(1, std::memory_order_relaxed))
+{
+}
+
+EntityCommandBuffer& EntityCommandQueue::GetThreadBuffer()
+{
+    struct Cache
+    {
+        uint64_t serial = 0;
+        EntityCommandBuffer* buffer = nullptr;
+    };
+    // A thread records into a handful of queues at most
+    thread_local std::vector<Cache> caches;
+
+    for (const Cache& c : caches)
+    {
+        if (c.serial == m_Serial)
+            return *c.buffer;
+    }
+
+    EntityCommandBuffer* buffer;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Buffers.push_back(std::make_unique<EntityCommandBuffer>());
+        buffer = m_Buffers.back().get();
+    }
+
+    // Entries of destroyed queues never match again, don't let them pile up
+    if (caches.size() >= 8)
+        caches.erase(caches.begin());
+    caches.push_back({ m_Serial, buffer });
+    return *buffer;
+}
+
+void EntityCommandQueue::Playback(EntityRegistry& registry, const PlaybackHooks& hooks)
+{
+    struct Entry
+    {
+        uint32_t sort_key;
+        uint32_t buffer;
+        uint32_t command;
+    };
+
+    std::vector<Entry> entries;
+    for (uint32_t b = 0; b < m_Buffers.size(); b++)
+    {
+        EntityCommandBuffer& buffer = *m_Buffers[b];
+        buffer.m_CreatedEntities.assign(buffer.m_NextTempId, EntityHandle());
+        for (uint32_t c = 0; c < buffer.m_Commands.size(); c++)
+            entries.push_back({ buffer.m_Commands[c].sort_key, b, c });
+    }
+
+    if (entries.empty())
+        return;
+
+    // Stable on the recording order, sort keys are expected to be unique to one thread
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.sort_key < b.sort_key; });
+
+    for (const Entry& e : entries)
+    {
+        EntityCommandBuffer& buffer = *m_Buffers[e.buffer];
+        const EntityCommandBuffer::Command& cmd = buffer.m_Commands[e.command];
+
+        if (cmd.type == EntityCommandBuffer::CommandType::CreateEntity)
+        {
+            Entity* entity = hooks.create_entity ? hooks.create_entity() : registry.CreateEntity();
+            buffer.m_CreatedEntities[cmd.target.temp_id] = entity->GetHandle();
+            continue;
+        }
+
+        // Destroyed by an earlier command, or a temporary entity whose creation was sorted after its use
+        EntityHandle handle = cmd.target.IsTemporary() ? buffer.m_CreatedEntities[cmd.target.temp_id] : cmd.target.handle;
+        Entity* entity = registry.GetEntity(handle);
+        if (!entity)
+        {
+            QK_CORE_LOGW_TAG("Scene", "EntityCommandQueue: Skipped a command on an entity which doesn't exist");
+            continue;
+        }
+
+        switch (cmd.type)
+        {
+        case EntityCommandBuffer::CommandType::DestroyEntity:
+            if (hooks.destroy_entity)
+                hooks.destroy_entity(entity);
+            else
+                registry.DeleteEntity(entity);
+            break;
+        case EntityCommandBuffer::CommandType::AddComponent:
+            cmd.payload->Apply(registry, entity);
+            break;
+        case EntityCommandBuffer::CommandType::RemoveComponent:
+            registry.UnRegister(entity, cmd.type_index);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // Keep the buffers and their blocks for the next frame
+    for (auto& buffer : m_Buffers)
+        buffer->Clear();
+}
+
+}
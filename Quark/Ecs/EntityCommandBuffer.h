@@ -0,0 +1,163 @@
+#pragma once
+#include "Quark/Ecs/EntityRegistry.h"
+
+#include <mutex>
+
+namespace quark {
+
+// Entity referenced by a recorded command. Either an existing entity, or a temporary id for an
+// entity created earlier in the same buffer, which only becomes real during playback.
+struct CommandEntity
+{
+    EntityHandle handle;
+    uint32_t temp_id = ~0u;
+
+    CommandEntity(EntityHandle h) : handle(h) {}
+    CommandEntity(const Entity* e) : handle(e->GetHandle()) {}
+
+    bool IsTemporary() const { return temp_id != ~0u; }
+
+private:
+    CommandEntity() = default;
+    friend class EntityCommandBuffer;
+};
+
+// Records structural changes (create/destroy entities, add/remove components) without touching
+// the registry, so systems running on worker threads can request them.
+// A buffer is only used by one thread at a time, get one from EntityCommandQueue::GetThreadBuffer().
+class EntityCommandBuffer
+{
+public:
+    EntityCommandBuffer() = default;
+    ~EntityCommandBuffer();
+    EntityCommandBuffer(const EntityCommandBuffer&) = delete;
+    void operator=(const EntityCommandBuffer&) = delete;
+
+    // Playback is ordered by sort key first, then by recording order. Set it to something that
+    // identifies the work item (e.g. the index of the entity being processed) and not the thread,
+    // so the result doesn't depend on how the work was spread over the workers.
+    void SetSortKey(uint32_t key) { m_SortKey = key; }
+
+    CommandEntity CreateEntity();
+    void DestroyEntity(CommandEntity entity);
+
+    template<typename T, typename... Args>
+    void AddComponent(CommandEntity entity, Args&&... args);
+
+    template<typename T>
+    void RemoveComponent(CommandEntity entity);
+
+    bool IsEmpty() const { return m_Commands.empty(); }
+    void Clear();
+
+private:
+    enum class CommandType : uint8_t
+    {
+        CreateEntity,
+        DestroyEntity,
+        AddComponent,
+        RemoveComponent
+    };
+
+    class ComponentPayload
+    {
+    public:
+        virtual ~ComponentPayload() = default;
+        virtual void Apply(EntityRegistry& registry, Entity* entity) = 0;
+    };
+
+    template<typename T, typename... Args>
+    class ComponentPayloadImpl final : public ComponentPayload
+    {
+    public:
+        template<typename... Ts>
+        ComponentPayloadImpl(Ts&&... ts) : m_Args(std::forward<Ts>(ts)...) {}
+
+        void Apply(EntityRegistry& registry, Entity* entity) override final
+        {
+            std::apply([&](auto&... args) { registry.Register<T>(entity, std::move(args)...); }, m_Args);
+        }
+
+    private:
+        std::tuple<Args...> m_Args;
+    };
+
+    struct Command
+    {
+        uint32_t sort_key;
+        CommandType type;
+        uint32_t type_index;            // RemoveComponent
+        CommandEntity target;
+        ComponentPayload* payload;      // AddComponent, lives in m_Blocks
+    };
+
+    // Payloads are placed in reused blocks instead of being allocated one by one
+    void* Allocate(size_t size, size_t alignment);
+
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+
+    std::vector<Command> m_Commands;
+    std::vector<Block> m_Blocks;
+    size_t m_BlockIndex = 0;
+    size_t m_BlockOffset = 0;
+    uint32_t m_SortKey = 0;
+    uint32_t m_NextTempId = 0;
+    std::vector<EntityHandle> m_CreatedEntities; // temp id -> entity, filled during playback
+
+    friend class EntityCommandQueue;
+};
+
+// Owns one EntityCommandBuffer per recording thread and plays all of them back at a sync point.
+// Buffers are merged by (sort key, recording order), so the outcome, including the indices of the
+// created entities, is the same no matter which thread recorded what.
+class EntityCommandQueue
+{
+public:
+    // Replace the plain registry calls, e.g. to let Scene create its default components
+    struct PlaybackHooks
+    {
+        std::function<Entity*()> create_entity;
+        std::function<void(Entity*)> destroy_entity;
+    };
+
+    EntityCommandQueue();
+    EntityCommandQueue(const EntityCommandQueue&) = delete;
+    void operator=(const EntityCommandQueue&) = delete;
+
+    // Thread safe. The buffer stays assigned to the calling thread for the lifetime of the queue.
+    EntityCommandBuffer& GetThreadBuffer();
+
+    // Main thread, no recording may be in flight
+    void Playback(EntityRegistry& registry, const PlaybackHooks& hooks = {});
+
+private:
+    std::mutex m_Mutex;
+    std::vector<std::unique_ptr<EntityCommandBuffer>> m_Buffers;
+    uint64_t m_Serial; // tells the per-thread cache apart from an earlier queue at the same address
+
+    inline static std::atomic<uint64_t> s_NextSerial = 1;
+};
+
+template<typename T, typename... Args>
+void EntityCommandBuffer::AddComponent(CommandEntity entity, Args&&... args)
+{
+    using Payload = ComponentPayloadImpl<T, std::decay_t<Args>...>;
+    void* memory = Allocate(sizeof(Payload), alignof(Payload));
+    auto* payload = new (memory) Payload(std::forward<Args>(args)...);
+
+    m_Commands.push_back({ m_SortKey, CommandType::AddComponent, ComponentTypeIndex::Get<T>(), entity, payload });
+}
+
+template<typename T>
+void EntityCommandBuffer::RemoveComponent(CommandEntity entity)
+{
+    m_Commands.push_back({ m_SortKey, CommandType::RemoveComponent, ComponentTypeIndex::Get<T>(), entity, nullptr });
+}
+
+}
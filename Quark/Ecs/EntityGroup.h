@@ -1,84 +1,149 @@
 #pragma once
+#include "Quark/Core/Util/IntrusiveHashMap.h"
 #include "Quark/Ecs/Entity.h"
 
 namespace quark {
 
+// Exclusion filter for EntityRegistry::GetEntityGroup(), e.g. GetEntityGroup<A, B>(Without<C>{})
+template <typename... Ts>
+struct Without {};
+
 class EntityGroupBase : public util::IntrusiveHashMapEnabled<EntityGroupBase> {
 public:
     EntityGroupBase() = default;
 	virtual ~EntityGroupBase() = default;
 
+	// Caller checks Matches() first
 	virtual void AddEntity(Entity& entity) = 0;
 	virtual void RemoveEntity(const Entity& entity) = 0;
 	virtual void Reset() = 0;
+
+	bool Matches(const ComponentSignature& signature) const
+	{
+		return (signature & m_Include) == m_Include && (signature & m_Exclude).none();
+	}
+
+	const ComponentSignature& GetIncludeSignature() const { return m_Include; }
+	const ComponentSignature& GetExcludeSignature() const { return m_Exclude; }
+
+	// Bumped whenever an entity joins or leaves the group
+	uint32_t GetMembershipVersion() const { return m_MembershipVersion; }
+
+protected:
+	ComponentSignature m_Include;
+	ComponentSignature m_Exclude;
+	uint32_t m_MembershipVersion = 0;
+	ComponentStorage* m_Storage = nullptr; // owned by the registry
+
+	friend class EntityRegistry;
 };
 
 template <typename... Ts>
 class EntityGroup final : public EntityGroupBase {
 public:
+    EntityGroup() { (m_Include.set(ComponentTypeIndex::Get<Ts>()), ...); }
+
     const std::vector<Entity*>& GetEntities() const  { return m_Entities; }
     std::vector<Entity*>& GetEntities() { return m_Entities; }
     const ComponentGroupVector<Ts...>& GetComponentGroup() const  { return m_ComponentGroups; }
     ComponentGroupVector<Ts...>& GetComponentGroup() { return m_ComponentGroups; }
 
     void AddEntity(Entity& entity) override final {
-		if (has_all_components<Ts...>(entity)) {
-			m_EntityToIndexMap[entity.m_HashId].get() = m_Entities.size();
-			m_ComponentGroups.push_back(std::make_tuple(entity.GetComponent<Ts>()...));
-			m_Entities.push_back(&entity);
-		}
+		QK_CORE_ASSERT(Matches(entity.m_Signature))
+
+		uint32_t index = entity.m_Handle.GetIndex();
+		if (Contains(index))
+			return;
+
+		if (index >= m_EntityToIndex.size())
+			m_EntityToIndex.resize(index + 1, INVALID_INDEX);
+
+		m_EntityToIndex[index] = (uint32_t)m_Entities.size();
+		m_ComponentGroups.push_back(std::make_tuple(entity.GetComponent<Ts>()...));
+		m_Entities.push_back(&entity);
+		m_MembershipVersion++;
     }
     void RemoveEntity(const Entity& entity) override final {
-        size_t offset = 0;
-        if (m_EntityToIndexMap.find_and_consume_pod(entity.m_HashId, offset)) {
-            m_Entities[offset] = m_Entities.back();
-            m_ComponentGroups[offset] = m_ComponentGroups.back();
-            m_EntityToIndexMap[m_Entities[offset]->m_HashId].get() = offset;
-
-            m_EntityToIndexMap.erase(entity.m_HashId);
-            m_Entities.pop_back();
-            m_ComponentGroups.pop_back();
-        }
+        uint32_t index = entity.m_Handle.GetIndex();
+        if (!Contains(index))
+            return;
+
+        uint32_t offset = m_EntityToIndex[index];
+        m_Entities[offset] = m_Entities.back();
+        m_ComponentGroups[offset] = m_ComponentGroups.back();
+        m_EntityToIndex[m_Entities[offset]->m_Handle.GetIndex()] = offset;
+
+        m_EntityToIndex[index] = INVALID_INDEX;
+        m_Entities.pop_back();
+        m_ComponentGroups.pop_back();
+        m_MembershipVersion++;
     }
 
     void Reset() override final {
         m_Entities.clear();
         m_ComponentGroups.clear();
-        m_EntityToIndexMap.clear();
+        m_EntityToIndex.clear();
+        m_VisitMarks.clear();
+        m_MembershipVersion++;
+    }
+
+    // Calls func(Entity&, ComponentGroup<Ts...>&) once for every member where any of Us was added
+    // or marked changed after since_tick. Us don't have to be part of the group.
+    // Walks the packed version arrays of Us, so members that didn't change cost one compare.
+    template <typename... Us, typename Func>
+    void ForEachChangedSince(uint32_t since_tick, Func&& func)
+    {
+        static_assert(sizeof...(Us) > 0);
+
+        // Don't visit an entity twice when several of Us changed
+        if constexpr (sizeof...(Us) > 1)
+        {
+            m_VisitMarks.resize(m_Entities.size(), 0);
+            if (++m_VisitSerial == 0)
+            {
+                std::fill(m_VisitMarks.begin(), m_VisitMarks.end(), 0);
+                m_VisitSerial = 1;
+            }
+        }
+
+        (VisitChanged<sizeof...(Us) == 1>(ComponentTypeIndex::Get<Us>(), since_tick, func), ...);
     }
 
 private:
-    ComponentGroupVector<Ts...> m_ComponentGroups;
-    std::vector<Entity*> m_Entities;
-    util::IntrusiveHashMap<util::IntrusivePODWrapper<size_t>> m_EntityToIndexMap;
+    static constexpr uint32_t INVALID_INDEX = ~0u;
 
-	template <typename... Us>
-	struct HasAllComponents;
+    bool Contains(uint32_t entity_index) const { return entity_index < m_EntityToIndex.size() && m_EntityToIndex[entity_index] != INVALID_INDEX; }
 
-	template <typename U, typename... Us>
-	struct HasAllComponents<U, Us...> 
-	{
-		static bool has_component(const Entity& entity) 
-		{
-			return entity.HasComponent(U::GetStaticComponentType()) &&
-		           HasAllComponents<Us...>::has_component(entity);
-		}
-	};
-
-	template <typename U>
-	struct HasAllComponents<U>
-	{
-		static bool has_component(const Entity& entity) 
-		{
-			return entity.HasComponent(U::GetStaticComponentType());
-		}
-	};
-
-	template <typename... Us>
-	bool has_all_components(const Entity& entity)
-	{
-		return HasAllComponents<Us...>::has_component(entity);
-	}
+    template <bool single, typename Func>
+    void VisitChanged(uint32_t type_index, uint32_t since_tick, Func& func)
+    {
+        if (type_index >= m_Storage->GetTypeCount())
+            return;
+
+        const ComponentSparseSet& set = m_Storage->GetSet(type_index);
+        const uint32_t* versions = set.GetVersions();
+        const uint32_t* entities = set.GetEntityIndices();
+        for (uint32_t i = 0; i < set.GetSize(); i++)
+        {
+            if (versions[i] <= since_tick || !Contains(entities[i]))
+                continue;
+
+            uint32_t offset = m_EntityToIndex[entities[i]];
+            if constexpr (!single)
+            {
+                if (m_VisitMarks[offset] == m_VisitSerial)
+                    continue;
+                m_VisitMarks[offset] = m_VisitSerial;
+            }
+            func(*m_Entities[offset], m_ComponentGroups[offset]);
+        }
+    }
+
+    ComponentGroupVector<Ts...> m_ComponentGroups;
+    std::vector<Entity*> m_Entities;
+    std::vector<uint32_t> m_EntityToIndex; // entity index -> offset in m_Entities
+    std::vector<uint32_t> m_VisitMarks;    // per offset, used by ForEachChangedSince()
+    uint32_t m_VisitSerial = 0;
 };
 
-}
\ No newline at end of file
+}
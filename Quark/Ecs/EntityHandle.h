@@ -0,0 +1,45 @@
+#pragma once
+#include "Quark/Core/Base.h"
+
+namespace quark {
+
+// 32-bit reference to an entity: slot index in the registry + generation of the slot.
+// The generation is bumped when the entity is deleted, so a handle kept after the
+// deletion no longer resolves instead of pointing to freed or reused memory. A slot is
+// retired once its generation reaches GENERATION_MASK, so generations never wrap around.
+struct EntityHandle
+{
+    static constexpr uint32_t INDEX_BITS = 20;
+    static constexpr uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+    static constexpr uint32_t MAX_ENTITIES = INDEX_MASK; // the last index is reserved for the null handle
+
+    uint32_t value = ~0u;
+
+    EntityHandle() = default;
+    EntityHandle(uint32_t index, uint32_t generation)
+        : value((index & INDEX_MASK) | ((generation & GENERATION_MASK) << INDEX_BITS)) {}
+
+    uint32_t GetIndex() const { return value & INDEX_MASK; }
+    uint32_t GetGeneration() const { return value >> INDEX_BITS; }
+    bool IsNull() const { return value == ~0u; }
+
+    bool operator==(const EntityHandle& other) const { return value == other.value; }
+    bool operator!=(const EntityHandle& other) const { return value != other.value; }
+};
+
+}
+
+namespace std {
+
+template <>
+struct hash<quark::EntityHandle>
+{
+    std::size_t operator()(const quark::EntityHandle& handle) const
+    {
+        return std::hash<uint32_t>()(handle.value);
+    }
+};
+
+}
@@ -3,34 +3,105 @@
 #include "Quark/Ecs/EntityRegistry.h"
 
 namespace quark {
-void EntityRegistry::UnRegister(Entity* entity, Component* component)
+void EntityRegistry::UnRegister(Entity* entity, uint32_t type_index)
 {
-    if (component == nullptr)
+    if (type_index >= MAX_COMPONENT_TYPES || !entity->m_Signature.test(type_index))
         return;
 
-    auto id = component->GetType();
-    entity->m_ComponentMap.erase(id);
+    // Leave the groups while the component is still alive
+    entity->m_Signature.reset(type_index);
+    UpdateGroups(*entity, type_index);
 
-    auto* group_key_set = m_ComponentToGroups.find(id);
-    if (group_key_set) {
-        for (auto &group_key : *group_key_set) {
-            auto* group = m_EntityGroups.find(group_key.get_hash());
-            if (group)
-                group->RemoveEntity(*entity);
-        }
-    }  
+    FreeComponent(entity, type_index);
+}
 
-    auto* allocator = m_ComponentAllocators.find(id);
-    QK_CORE_ASSERT(allocator)
+void EntityRegistry::FreeComponent(Entity* entity, uint32_t type_index)
+{
+    ComponentSparseSet& set = m_Storage.GetSet(type_index);
+    const uint32_t entity_index = entity->m_Handle.GetIndex();
+    Component* component = set.Get(entity_index);
+    QK_CORE_ASSERT(component)
 
-    allocator->FreeComponent(component);
+    if (type_index < m_RemovedCallbacks.size() && m_RemovedCallbacks[type_index])
+        m_RemovedCallbacks[type_index](*entity, *component);
+
+    set.Remove(entity_index);
+
+    QK_CORE_ASSERT(type_index < m_ComponentAllocators.size() && m_ComponentAllocators[type_index])
+    m_ComponentAllocators[type_index]->FreeComponent(component);
+}
+
+void EntityRegistry::UpdateGroups(Entity& entity, uint32_t type_index)
+{
+    if (type_index >= m_TypeToGroups.size())
+        return;
+
+    // Only groups that mention this type can change their mind about the entity
+    for (EntityGroupBase* group : m_TypeToGroups[type_index])
+    {
+        if (group->Matches(entity.m_Signature))
+            group->AddEntity(entity);
+        else
+            group->RemoveEntity(entity);
+    }
+}
+
+void EntityRegistry::AddGroup(EntityGroupBase* group)
+{
+    const ComponentSignature mentioned = group->m_Include | group->m_Exclude;
+    for (uint32_t i = 0; i < MAX_COMPONENT_TYPES; i++)
+    {
+        if (!mentioned.test(i))
+            continue;
+        if (i >= m_TypeToGroups.size())
+            m_TypeToGroups.resize(i + 1);
+        m_TypeToGroups[i].push_back(group);
+    }
+
+    // Fill the group. Every member has all included components, so walking the smallest
+    // included storage is enough instead of visiting every entity.
+    const ComponentSparseSet* smallest = nullptr;
+    for (uint32_t i = 0; i < m_Storage.GetTypeCount(); i++)
+    {
+        if (!group->m_Include.test(i))
+            continue;
+        const ComponentSparseSet& set = m_Storage.GetSet(i);
+        if (!smallest || set.GetSize() < smallest->GetSize())
+            smallest = &set;
+    }
+
+    // No storage yet for some included type: nothing can match
+    if (!smallest)
+        return;
+
+    const uint32_t* indices = smallest->GetEntityIndices();
+    for (uint32_t i = 0; i < smallest->GetSize(); i++)
+    {
+        Entity* entity = m_Slots[indices[i]].entity;
+        if (group->Matches(entity->m_Signature))
+            group->AddEntity(*entity);
+    }
 }
 
 Entity* EntityRegistry::CreateEntity()
 {
-	util::Hasher hasher;
-    hasher.u64(m_Cookie++);
-	auto* entity = m_EntityPool.allocate(this, hasher.get());
+    uint32_t index;
+    if (!m_FreeSlots.empty())
+    {
+        index = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)m_Slots.size();
+        QK_CORE_ASSERT(index < EntityHandle::MAX_ENTITIES, "Too many entities");
+        m_Slots.emplace_back();
+    }
+
+    EntitySlot& slot = m_Slots[index];
+	auto* entity = m_EntityPool.allocate(this, &m_Storage, EntityHandle(index, slot.generation));
+    slot.entity = entity;
+
 	entity->m_OffsetInRegistry = m_Entities.size();
 	m_Entities.push_back(entity);
 	return entity;
@@ -38,49 +109,56 @@ Entity* EntityRegistry::CreateEntity()
 
 void EntityRegistry::DeleteEntity(Entity *entity)
 {
-    // Delete all components of entity
+    // Leave every group first, removing the components one by one would move the entity
+    // in and out of groups with exclusion filters
+    const ComponentSignature signature = entity->m_Signature;
+    entity->m_Signature.reset();
+    for (uint32_t type_index = 0; type_index < m_Storage.GetTypeCount(); type_index++)
     {
-        auto& list = entity->m_ComponentMap.inner_list();
-        auto itr = list.begin();
-        while (itr != list.end()) {
-            UnRegister(entity, itr.get()->get());
-            itr = list.erase(itr);
-        }
+        if (!signature.test(type_index))
+            continue;
+        if (type_index < m_TypeToGroups.size())
+            for (EntityGroupBase* group : m_TypeToGroups[type_index])
+                group->RemoveEntity(*entity);
     }
 
+    // Delete all components of entity
+    for (uint32_t type_index = 0; type_index < m_Storage.GetTypeCount(); type_index++)
+        if (signature.test(type_index))
+            FreeComponent(entity, type_index);
+
 	auto offset = entity->m_OffsetInRegistry;
 	QK_CORE_ASSERT(offset < m_Entities.size());
 
 	m_Entities[offset] = m_Entities.back();
 	m_Entities[offset]->m_OffsetInRegistry = offset;
 	m_Entities.pop_back();
-	m_EntityPool.free(entity);
-}
 
-void EntityRegistry::GroupKeySet::insert(ComponentType type)
-{
-    set.emplace_yield(type);
+    // Invalidate all handles to this entity before the slot is reused. A slot whose generation
+    // would wrap is retired instead, otherwise a handle from 4096 reuses ago would resolve again.
+    const uint32_t index = entity->m_Handle.GetIndex();
+    EntitySlot& slot = m_Slots[index];
+    slot.entity = nullptr;
+    if (slot.generation < EntityHandle::GENERATION_MASK)
+    {
+        slot.generation++;
+        m_FreeSlots.push_back(index);
+    }
+
+	m_EntityPool.free(entity);
 }
 
 EntityRegistry::~EntityRegistry()
 {
-    // Delete all entities
-    for (auto e : m_Entities) {
-        DeleteEntity(e);
+    // The owner of the callbacks may already be partly destroyed
+    m_RemovedCallbacks.clear();
+
+    // Delete all entities. DeleteEntity() moves the last entity into the freed spot, so go from the back.
+    while (!m_Entities.empty()) {
+        DeleteEntity(m_Entities.back());
     }
-    
-    // Delete manually allocated component allocator
-    {
-		auto &list = m_ComponentAllocators.inner_list();
-		auto itr = list.begin();
-		while (itr != list.end())
-		{
-			auto *to_free = itr.get();
-			itr = list.erase(itr);
-			delete to_free;
-		}
-        m_ComponentAllocators.clear();
-	}
+
+    m_ComponentAllocators.clear();
 
     // Delete manully allocated entity group
     {
@@ -97,4 +175,4 @@ EntityRegistry::~EntityRegistry()
 
 }
 
-}
\ No newline at end of file
+}
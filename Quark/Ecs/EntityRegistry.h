@@ -10,26 +10,44 @@ public:
     void operator=(const EntityRegistry &) = delete;
     EntityRegistry(const EntityRegistry &) = delete;
 
-    const std::vector<Entity*>& GetEntities() const { return m_Entities;}    
+    const std::vector<Entity*>& GetEntities() const { return m_Entities;}
     std::vector<Entity*>& GetEntities() { return m_Entities;}
-    
+
     Entity* CreateEntity();
     void DeleteEntity(Entity* entity);
 
+    // nullptr if the entity has been deleted since the handle was taken
+    Entity* GetEntity(EntityHandle handle) const
+    {
+        uint32_t index = handle.GetIndex();
+        if (index >= m_Slots.size() || m_Slots[index].generation != handle.GetGeneration())
+            return nullptr;
+        return m_Slots[index].entity;
+    }
+    bool IsAlive(EntityHandle handle) const { return GetEntity(handle) != nullptr; }
+
+    // A system reads the tick, visits what changed since its previous tick, keeps the read tick and
+    // advances it, so changes made by itself are not seen again but later changes are
+    uint32_t GetChangeTick() const { return m_Storage.GetChangeTick(); }
+    void AdvanceChangeTick() { m_Storage.AdvanceChangeTick(); }
+
 	template <typename... Ts>
-	EntityGroup<Ts...>* GetEntityGroup() {
-		constexpr ComponentType group_id = GetComponentGroupId<Ts...>();
+	EntityGroup<Ts...>* GetEntityGroup() { return GetEntityGroup<Ts...>(Without<>{}); }
+
+	// Entities that have all of Ts and none of Us
+	template <typename... Ts, typename... Us>
+	EntityGroup<Ts...>* GetEntityGroup(Without<Us...>) {
+		static_assert(sizeof...(Ts) > 0, "A group needs at least one included component");
+		constexpr ComponentType group_id = GetGroupId<Ts...>(Without<Us...>{});
 		auto* t = m_EntityGroups.find(group_id);
 		if (!t) {
-			register_group<Ts...>(group_id);
-
 			t = new EntityGroup<Ts...>();
+			(t->m_Exclude.set(ComponentTypeIndex::Get<Us>()), ...);
+			t->m_Storage = &m_Storage;
 			t->set_hash(group_id);
 			m_EntityGroups.insert_yield(t);
 
-			auto* group = static_cast<EntityGroup<Ts...> *>(t);
-			for (auto entity : m_Entities)
-				group->AddEntity(*entity);
+			AddGroup(t);
 		}
 
 		return static_cast<EntityGroup<Ts...> *>(t);
@@ -39,40 +57,36 @@ public:
     template<typename T, typename... Ts>
     T* Register(Entity* entity, Ts&&... ts )
     {
-        auto id = T::GetStaticComponentType();
-		auto* t = m_ComponentAllocators.find(id);
-		if (!t)
-		{
-			t = new ComponentAllocator<T>();
-			t->set_hash(id);
-			m_ComponentAllocators.insert_yield(t);
-		}
+        const uint32_t type_index = ComponentTypeIndex::Get<T>();
+        const uint32_t entity_index = entity->m_Handle.GetIndex();
 
-		auto* allocator = static_cast<ComponentAllocator<T>*>(t);
-		auto find = entity->m_ComponentMap.find(id);
+        if (type_index >= m_ComponentAllocators.size())
+            m_ComponentAllocators.resize(type_index + 1);
+        if (!m_ComponentAllocators[type_index])
+            m_ComponentAllocators[type_index] = std::make_unique<ComponentAllocator<T>>();
 
-		if (find != nullptr) 
+		auto* allocator = static_cast<ComponentAllocator<T>*>(m_ComponentAllocators[type_index].get());
+        ComponentSparseSet& set = m_Storage.GetSet(type_index);
+
+		if (Component* find = set.Get(entity_index))
 		{
-			auto* comp = static_cast<T*>(find->get());
+			auto* comp = static_cast<T*>(find);
 			// In-place modify. Destroy old data, and in-place construct.
 			// Do not need to fiddle with data structures internally.
 			comp->~T();
             new(comp) T(std::forward<Ts>(ts)...);
             comp->m_Entity = entity;
+            set.SetVersion(entity_index, m_Storage.GetChangeTick());
 			return comp;
 		}
-		else 
+		else
 		{
 			auto* comp = allocator->pool.allocate(std::forward<Ts>(ts)...);
             comp->m_Entity = entity;
-            auto* node = m_componentNodePool.allocate(comp);
-            node->set_hash(id);
-			entity->m_ComponentMap.insert_replace(node);
+            set.Insert(entity_index, comp, m_Storage.GetChangeTick());
 
-			auto* group_set = m_ComponentToGroups.find(id);
-			if (group_set)
-				for (auto& group : *group_set)
-					m_EntityGroups.find(group.get_hash())->AddEntity(*entity);
+            entity->m_Signature.set(type_index);
+            UpdateGroups(*entity, type_index);
 
 			return comp;
 		}
@@ -80,11 +94,23 @@ public:
 
     // Unregister a component of a entity
     template<typename T>
-    void UnRegister(Entity* entity) { UnRegister(entity, entity->GetComponent<T>()); }
-    void UnRegister(Entity* entity, Component* component);
+    void UnRegister(Entity* entity) { UnRegister(entity, ComponentTypeIndex::Get<T>()); }
+    void UnRegister(Entity* entity, uint32_t type_index);
+
+    // Called right before a component of type T is freed, whether it is removed on its own or with its entity.
+    // Not called for the entities deleted by the registry's destructor.
+    using ComponentRemovedCallback = std::function<void(Entity&, Component&)>;
+    template<typename T>
+    void SetComponentRemovedCallback(ComponentRemovedCallback callback)
+    {
+        const uint32_t type_index = ComponentTypeIndex::Get<T>();
+        if (type_index >= m_RemovedCallbacks.size())
+            m_RemovedCallbacks.resize(type_index + 1);
+        m_RemovedCallbacks[type_index] = std::move(callback);
+    }
 
 private:
-    class ComponentAllocatorBase : public util::IntrusiveHashMapEnabled<ComponentAllocatorBase>
+    class ComponentAllocatorBase
     {
     public:
         virtual ~ComponentAllocatorBase() = default;
@@ -101,67 +127,34 @@ private:
         }
     };
 
-    struct GroupKey : util::IntrusiveHashMapEnabled<GroupKey>
-    {
- 
-    };
-
-    class GroupKeySet : public util::IntrusiveHashMapEnabled<GroupKeySet>
+    struct EntitySlot
     {
-    public:
-        void insert(ComponentType type);
-
-        util::IntrusiveList<GroupKey>::Iterator begin()
-        {
-            return set.begin();
-        }
-
-        util::IntrusiveList<GroupKey>::Iterator end()
-        {
-            return set.end();
-        }
-
-    private:
-        util::IntrusiveHashMap<GroupKey> set;
+        Entity* entity = nullptr;
+        uint32_t generation = 0;
     };
 
     util::ObjectPool<Entity> m_EntityPool;
-    util::IntrusiveHashMapHolder<ComponentAllocatorBase> m_ComponentAllocators;
+    ComponentStorage m_Storage;
+    std::vector<std::unique_ptr<ComponentAllocatorBase>> m_ComponentAllocators; // indexed by ComponentTypeIndex
+    std::vector<ComponentRemovedCallback> m_RemovedCallbacks;  // indexed by ComponentTypeIndex
     util::IntrusiveHashMapHolder<EntityGroupBase> m_EntityGroups;
-    util::IntrusiveHashMap<GroupKeySet> m_ComponentToGroups;
-    util::ObjectPool<util::IntrusivePODWrapper<Component*>> m_componentNodePool;
+    std::vector<std::vector<EntityGroupBase*>> m_TypeToGroups; // groups including or excluding a type, indexed by ComponentTypeIndex
     std::vector<Entity*> m_Entities;
-    uint64_t m_Cookie = 0;
-
-	template <typename... Us>
-	struct GroupRegisters;
+    std::vector<EntitySlot> m_Slots;        // indexed by EntityHandle::GetIndex()
+    std::vector<uint32_t> m_FreeSlots;
 
-	template <typename U, typename... Us>
-	struct GroupRegisters<U, Us...>
+	template <typename... Ts, typename... Us>
+	static constexpr ComponentType GetGroupId(Without<Us...>)
 	{
-		static void register_group(util::IntrusiveHashMap<GroupKeySet> &groups,
-		                           ComponentType group_id)
-		{
-			groups.emplace_yield(U::GetStaticComponentType())->insert(group_id);
-			GroupRegisters<Us...>::register_group(groups, group_id);
-		}
-	};
-
-	template <typename U>
-	struct GroupRegisters<U>
-	{
-		static void register_group(util::IntrusiveHashMap<GroupKeySet> &groups,
-		                           ComponentType group_id)
-		{
-			groups.emplace_yield(U::GetStaticComponentType())->insert(group_id);
-		}
-	};
-
-	template <typename U, typename... Us>
-	void register_group(ComponentType group_id)
-	{
-		GroupRegisters<U, Us...>::register_group(m_ComponentToGroups, group_id);
+		if constexpr (sizeof...(Us) == 0)
+			return GetComponentGroupId<Ts...>();
+		else
+			return util::compile_time_fnv1_merged(GetComponentGroupId<Ts...>(), util::compile_time_fnv1("Without"), Us::GetStaticComponentType()...);
 	}
+
+    void AddGroup(EntityGroupBase* group);
+    void UpdateGroups(Entity& entity, uint32_t type_index);
+    void FreeComponent(Entity* entity, uint32_t type_index);
 };
 
 template<typename T, typename... Ts>
@@ -171,8 +164,8 @@ T* Entity::AddComponent(Ts&&... ts)
 }
 
 template<typename T>
-void Entity::RemoveComponent() 
+void Entity::RemoveComponent()
 {
     m_Registry->UnRegister<T>(this);
 }
-}
\ No newline at end of file
+}
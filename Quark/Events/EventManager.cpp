@@ -3,26 +3,24 @@
 
 namespace quark {
 
-void EventManager::TriggerEvent(const Event &event) 
+void EventManager::Unsubscribe(SubscriptionId id)
 {
-    event.Log();
+    if (id == invalid_subscription)
+        return;
 
-    for (auto& subscriber : subscribers_[event.GetEventType()])
-    {
-        if (!event.isHandled)
-            subscriber->Exec(event);
-        else
-            return; // If the event is handled, stop send to other subscribers
-    }
+    uint32_t index = uint32_t(id >> 32);
+    BaseChannel* channel = index < MAX_EVENT_TYPES ? m_channels[index].load(std::memory_order_acquire) : nullptr;
+    if (!channel || !channel->Unsubscribe(id))
+        QK_CORE_LOGW_TAG("EventManager", "Unsubscribe: subscription {} doesn't exist", id);
 }
 
 void EventManager::DispatchEvents() 
 {
-    for (auto eventItr = event_queue_.begin(); eventItr != event_queue_.end();) {
-        // CORE_LOGT("{}", eventItr->get()->ToString());
-        TriggerEvent(*(eventItr->get()));
-        eventItr = event_queue_.erase(eventItr);
+    for (uint32_t i = 0; i < MAX_EVENT_TYPES; i++)
+    {
+        if (BaseChannel* channel = m_channels[i].load(std::memory_order_acquire))
+            channel->Dispatch();
     }
 }
 
-}
\ No newline at end of file
+}
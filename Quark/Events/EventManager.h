@@ -2,78 +2,331 @@
 #include "Quark/Core/Util/Singleton.h"
 #include "Quark/Events/EventHandler.h"
 
-#include <iostream>
+#include <atomic>
+#include <mutex>
 
 namespace quark {
 
+// Typed event bus.
+// Every event type gets its own channel, found by a per-type index instead of a hash lookup.
+// - TriggerEvent() calls the subscribers right away. Main thread only, like Subscribe/Unsubscribe.
+// - QueueEvent() may be called from any thread. Events are copied into a fixed ring buffer of
+//   the channel (spilling into a locked vector when it is full) and delivered by DispatchEvents().
+// Events of one type are delivered in the order they were queued.
 class EventManager : public util::MakeSingleton<EventManager> {
 public:
     using EventType = Event::EventType;
+    using SubscriptionId = uint64_t;
+    static constexpr SubscriptionId invalid_subscription = 0;
+
     EventManager() = default;
 
 public:
     template<typename T, typename = std::enable_if_t<std::is_base_of_v<Event, T>>>
-    void Subscribe(const EventCallbackFn<T>& func);
+    SubscriptionId Subscribe(EventCallbackFn<T> func);
+    void Unsubscribe(SubscriptionId id);
 
     template<typename T, typename = std::enable_if_t<std::is_base_of_v<Event, T>>>
-    void Unsubscribe(const EventCallbackFn<T>& func);
+    void QueueEvent(const T& event);
 
     template<typename T, typename = std::enable_if_t<std::is_base_of_v<Event, T>>>
-    void QueueEvent(std::unique_ptr<T>&& event);
+    void TriggerEvent(const T& event);
 
     void DispatchEvents();
-    void TriggerEvent(const Event& evnet);
 
 private:
-    std::vector<std::unique_ptr<Event>> event_queue_;
-    std::unordered_map<EventType, std::vector<std::unique_ptr<BaseEventHandler>>> subscribers_;
+    static constexpr uint32_t MAX_EVENT_TYPES = 64;
+    static constexpr uint32_t RING_CAPACITY = 256; // queued events per type before spilling, power of two
+
+    class BaseChannel
+    {
+    public:
+        virtual ~BaseChannel() = default;
+        virtual void Dispatch() = 0;
+        virtual bool Unsubscribe(SubscriptionId id) = 0;
+    };
+
+    template<typename T>
+    class Channel : public BaseChannel
+    {
+    public:
+        Channel();
+        ~Channel() override;
+
+        void Push(const T& event);
+        void Dispatch() override;
+        void Trigger(const T& event);
+        bool Unsubscribe(SubscriptionId id) override;
+
+        void AddSubscriber(SubscriptionId id, EventCallbackFn<T>&& func);
+
+    private:
+        struct Subscriber
+        {
+            SubscriptionId id; // invalid_subscription once unsubscribed during a dispatch
+            EventCallbackFn<T> func;
+        };
+
+        // Bounded MPMC queue (D. Vyukov), each cell carries a sequence number telling
+        // producers and the consumer whether it is free or filled.
+        struct alignas(64) Cell
+        {
+            std::atomic<uint32_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        bool TryPush(const T& event);
+        template<typename F>
+        bool TryConsume(F&& consume);
+
+        Cell* m_cells;
+        alignas(64) std::atomic<uint32_t> m_enqueue_pos = 0;
+        alignas(64) std::atomic<uint32_t> m_dequeue_pos = 0;
 
+        std::mutex m_overflow_mutex;
+        std::vector<T> m_overflow;
+        std::atomic_bool m_has_overflow = false;
+
+        std::vector<Subscriber> m_subscribers;
+        std::vector<Subscriber> m_pending_subscribers; // added by a callback, joined after the dispatch
+        uint32_t m_dispatch_depth = 0;
+        bool m_has_removed = false;
+    };
+
+    // Dense per-type index, assigned on first use
+    template<typename T>
+    static uint32_t GetChannelIndex()
+    {
+        static const uint32_t index = s_nextChannelIndex.fetch_add(1, std::memory_order_relaxed);
+        QK_CORE_ASSERT(index < MAX_EVENT_TYPES, "Too many event types");
+        return index;
+    }
+
+    template<typename T>
+    Channel<T>& GetOrCreateChannel();
+
+    inline static std::atomic<uint32_t> s_nextChannelIndex = 0;
+
+    std::atomic<BaseChannel*> m_channels[MAX_EVENT_TYPES] = {};
+    std::vector<std::unique_ptr<BaseChannel>> m_ownedChannels;
+    std::mutex m_channelCreateMutex;
+    uint32_t m_nextSubscription = 1;
 };
 
-template<typename T, typename>
-void EventManager::Subscribe(const EventCallbackFn<T>& func) 
+template<typename T>
+EventManager::Channel<T>::Channel()
+{
+    m_cells = static_cast<Cell*>(::operator new[](sizeof(Cell) * RING_CAPACITY, std::align_val_t(alignof(Cell))));
+    for (uint32_t i = 0; i < RING_CAPACITY; i++)
+        new (&m_cells[i].sequence) std::atomic<uint32_t>(i);
+}
+
+template<typename T>
+EventManager::Channel<T>::~Channel()
 {
-    auto handler = std::make_unique<EventHandler<T>>(func);
-    std::string name = func.target_type().name();
-
-    auto itr = subscribers_.find(T::GetStaticEventType());
-    if (itr != subscribers_.end()) {
-        auto& subscribers = itr->second;
-        for (auto& subscriber : subscribers) {
-            if (subscriber->GetName() == name) {
-                std::cerr << "This callback function has been registered" << std::endl;
-                return;
+    while (TryConsume([](const T&) {})) {}
+    ::operator delete[](m_cells, std::align_val_t(alignof(Cell)));
+}
+
+template<typename T>
+bool EventManager::Channel<T>::TryPush(const T& event)
+{
+    uint32_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[pos & (RING_CAPACITY - 1)];
+        uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+        int32_t diff = int32_t(seq - pos);
+        if (diff == 0)
+        {
+            if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                new (cell.storage) T(event);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
             }
         }
-        itr->second.push_back(std::move(handler));
-    }
-    else {
-        subscribers_[T::GetStaticEventType()].push_back(std::move(handler));
+        else if (diff < 0)
+        {
+            return false; // full
+        }
+        else
+        {
+            pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        }
     }
 }
 
-template<typename T, typename>
-void EventManager::Unsubscribe(const EventCallbackFn<T>& func) 
+template<typename T>
+template<typename F>
+bool EventManager::Channel<T>::TryConsume(F&& consume)
 {
-    std::string name = func.target_type().name();
-    auto itr = subscribers_.find(T::GetStaticEventType());
-    if (itr != subscribers_.end()) {
-        auto& subscribers = itr->second;
-        for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
-            if (it->get()->GetName() == name) {
-                subscribers.erase(it);
-                return;
+    uint32_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell& cell = m_cells[pos & (RING_CAPACITY - 1)];
+        uint32_t seq = cell.sequence.load(std::memory_order_acquire);
+        int32_t diff = int32_t(seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                // The cell stays owned by the consumer until it is released below
+                T* event = std::launder(reinterpret_cast<T*>(cell.storage));
+                consume(*event);
+                event->~T();
+                cell.sequence.store(pos + RING_CAPACITY, std::memory_order_release);
+                return true;
             }
         }
+        else if (diff < 0)
+        {
+            return false; // empty
+        }
+        else
+        {
+            pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T>
+void EventManager::Channel<T>::Push(const T& event)
+{
+    // Once spilled, keep spilling until the next dispatch so the order is preserved
+    if (!m_has_overflow.load(std::memory_order_acquire) && TryPush(event))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_overflow_mutex);
+    m_overflow.push_back(event);
+    m_has_overflow.store(true, std::memory_order_release);
+}
+
+template<typename T>
+void EventManager::Channel<T>::Trigger(const T& event)
+{
+    m_dispatch_depth++;
+
+    for (size_t i = 0; i < m_subscribers.size() && !event.isHandled; i++)
+    {
+        if (m_subscribers[i].id != invalid_subscription)
+            m_subscribers[i].func(event);
+    }
+
+    if (--m_dispatch_depth > 0)
+        return;
+
+    if (m_has_removed)
+    {
+        std::erase_if(m_subscribers, [](const Subscriber& s) { return s.id == invalid_subscription; });
+        m_has_removed = false;
+    }
+
+    if (!m_pending_subscribers.empty())
+    {
+        for (Subscriber& s : m_pending_subscribers)
+            m_subscribers.push_back(std::move(s));
+        m_pending_subscribers.clear();
+    }
+}
+
+template<typename T>
+void EventManager::Channel<T>::AddSubscriber(SubscriptionId id, EventCallbackFn<T>&& func)
+{
+    // Growing the vector would move the callback which is running right now
+    if (m_dispatch_depth > 0)
+        m_pending_subscribers.push_back({ id, std::move(func) });
+    else
+        m_subscribers.push_back({ id, std::move(func) });
+}
+
+template<typename T>
+void EventManager::Channel<T>::Dispatch()
+{
+    // Only deliver what was queued before this point, callbacks may queue new events
+    uint32_t count = m_enqueue_pos.load(std::memory_order_acquire) - m_dequeue_pos.load(std::memory_order_relaxed);
+    while (count-- > 0 && TryConsume([this](const T& event) { Trigger(event); })) {}
+
+    if (m_has_overflow.load(std::memory_order_acquire))
+    {
+        thread_local std::vector<T> spilled;
+        {
+            std::lock_guard<std::mutex> lock(m_overflow_mutex);
+            spilled.swap(m_overflow);
+            m_has_overflow.store(false, std::memory_order_release);
+        }
+
+        for (const T& e : spilled)
+            Trigger(e);
+        spilled.clear();
+    }
+}
+
+template<typename T>
+bool EventManager::Channel<T>::Unsubscribe(SubscriptionId id)
+{
+    auto match = [id](const Subscriber& s) { return s.id == id; };
+    if (std::erase_if(m_pending_subscribers, match) > 0)
+        return true;
+
+    auto it = std::find_if(m_subscribers.begin(), m_subscribers.end(), match);
+    if (it == m_subscribers.end())
+        return false;
+
+    if (m_dispatch_depth > 0)
+    {
+        // Don't shift the vector or destroy the callback under a running dispatch
+        it->id = invalid_subscription;
+        m_has_removed = true;
+    }
+    else
+    {
+        m_subscribers.erase(it);
+    }
+    return true;
+}
+
+template<typename T>
+EventManager::Channel<T>& EventManager::GetOrCreateChannel()
+{
+    const uint32_t index = GetChannelIndex<T>();
+    BaseChannel* channel = m_channels[index].load(std::memory_order_acquire);
+    if (!channel)
+    {
+        std::lock_guard<std::mutex> lock(m_channelCreateMutex);
+        channel = m_channels[index].load(std::memory_order_relaxed);
+        if (!channel)
+        {
+            m_ownedChannels.push_back(std::make_unique<Channel<T>>());
+            channel = m_ownedChannels.back().get();
+            m_channels[index].store(channel, std::memory_order_release);
+        }
     }
+    return *static_cast<Channel<T>*>(channel);
+}
 
-    std::cerr << "this event callback function doesn't exist." << std::endl;
+template<typename T, typename>
+EventManager::SubscriptionId EventManager::Subscribe(EventCallbackFn<T> func)
+{
+    // The channel index lives in the upper bits so Unsubscribe() finds the channel directly
+    SubscriptionId id = (SubscriptionId(GetChannelIndex<T>()) << 32) | m_nextSubscription++;
+    GetOrCreateChannel<T>().AddSubscriber(id, std::move(func));
+    return id;
 }
 
 template<typename T, typename>
-void EventManager::QueueEvent(std::unique_ptr<T>&& event) 
+void EventManager::QueueEvent(const T& event)
 {
-    event_queue_.push_back(std::move(event));
+    GetOrCreateChannel<T>().Push(event);
 }
 
-}
\ No newline at end of file
+template<typename T, typename>
+void EventManager::TriggerEvent(const T& event)
+{
+    // Nobody ever subscribed: a single load
+    BaseChannel* channel = m_channels[GetChannelIndex<T>()].load(std::memory_order_acquire);
+    if (channel)
+        static_cast<Channel<T>*>(channel)->Trigger(event);
+}
+
+}
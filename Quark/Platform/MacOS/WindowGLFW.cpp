@@ -80,8 +80,7 @@ void WindowGLFW::Init()
 
     glfwSetWindowCloseCallback(m_glfwWindow, [](GLFWwindow* window)
     {
-        std::unique_ptr<WindowCloseEvent> closeEvent = std::make_unique<WindowCloseEvent>();
-        EventManager::Get().QueueEvent(std::move(closeEvent));
+        EventManager::Get().QueueEvent(WindowCloseEvent());
     });
     
     glfwSetKeyCallback(m_glfwWindow, [](GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -11,6 +11,7 @@
 #include <Quark/Core/TimeStep.h>
 #include <Quark/Core/Window.h>
 #include <Quark/Core/Timer.h>
+#include <Quark/Core/Profiler.h>
 
 #include <Quark/Core/Math/Aabb.h>
 #include <Quark/Core/Math/Frustum.h>
@@ -47,6 +47,11 @@ enum PipelineMemoryAccessBits : uint64_t { // TODO: Make this consistent
     BARRIER_ACCESS_SHADER_STORAGE_WRITE_BIT = 0x400000000ULL,
 };
 
+enum class RenderPassContents {
+    INLINE,                     // commands are recorded into the primary command list
+    SECONDARY_COMMAND_LISTS,    // the pass only executes secondary command lists
+};
+
 struct PipelineMemoryBarrier
 {
     uint32_t srcStageBits = 0;
@@ -81,6 +86,58 @@ struct PipelineImageBarrier
     ImageLayout layoutAfter = ImageLayout::UNDEFINED;
 };
 
+// Work recorded into a command list, reset when the recording begins.
+// The device sums up the lists submitted during a frame, see Device::GetFrameStats().
+struct CommandListStats
+{
+    uint64_t commandLists = 0;
+    uint64_t pipelineBinds = 0;
+    uint64_t resourceBinds = 0;             // buffers, images and samplers bound to a set, an image sampler counts twice
+    uint64_t descriptorSetRequests = 0;     // sets requested from the allocators because their bindings changed
+    uint64_t descriptorSetCacheHits = 0;    // requested sets which were found already written
+    uint64_t descriptorSetUpdates = 0;      // requested sets which had to be written with their update template
+    uint64_t descriptorSetRebinds = 0;      // sets rebound with new dynamic offsets only
+    uint64_t vertexBufferBinds = 0;
+    uint64_t indexBufferBinds = 0;
+    uint64_t pushConstantUpdates = 0;
+    uint64_t draws = 0;
+    uint64_t indirectDraws = 0;             // part of draws, their draw and instance counts are only known on the gpu
+    uint64_t instances = 0;
+    uint64_t primitives = 0;                // vertices or indices times instances
+    uint64_t dispatches = 0;                // direct and indirect
+    uint64_t renderPasses = 0;
+    uint64_t barriers = 0;
+    uint64_t copies = 0;                    // image to buffer copies, blits and mipmap generations
+    uint64_t constantDataBytes = 0;
+    uint64_t vertexDataBytes = 0;
+
+    void Add(const CommandListStats& other)
+    {
+        commandLists += other.commandLists;
+        pipelineBinds += other.pipelineBinds;
+        resourceBinds += other.resourceBinds;
+        descriptorSetRequests += other.descriptorSetRequests;
+        descriptorSetCacheHits += other.descriptorSetCacheHits;
+        descriptorSetUpdates += other.descriptorSetUpdates;
+        descriptorSetRebinds += other.descriptorSetRebinds;
+        vertexBufferBinds += other.vertexBufferBinds;
+        indexBufferBinds += other.indexBufferBinds;
+        pushConstantUpdates += other.pushConstantUpdates;
+        draws += other.draws;
+        indirectDraws += other.indirectDraws;
+        instances += other.instances;
+        primitives += other.primitives;
+        dispatches += other.dispatches;
+        renderPasses += other.renderPasses;
+        barriers += other.barriers;
+        copies += other.copies;
+        constantDataBytes += other.constantDataBytes;
+        vertexDataBytes += other.vertexDataBytes;
+    }
+
+    double GetDescriptorSetHitRate() const { return descriptorSetRequests > 0 ? double(descriptorSetCacheHits) / descriptorSetRequests : 0.0; }
+};
+
 class CommandList : public GpuResource {
 public:
     CommandList(QueueType type) : m_queueType(type) {};
@@ -92,16 +149,22 @@ public:
     virtual void BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) = 0;
     virtual void BindImage(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout) = 0;
     virtual void BindImageSampler(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout, const Sampler& sampler) = 0;
+    virtual void BindStorageImage(uint32_t set, uint32_t binding, const ImageView& image_view) = 0; // image must be in GENERAL layout
     virtual void BindPipeLine(const PipeLine& pipeline) = 0;
     virtual void BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset) = 0;
     virtual void BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format) = 0;
     virtual void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) = 0;
     virtual void DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance) = 0;
     virtual void Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) = 0;
+    virtual void DrawIndexedIndirect(const Buffer& buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) = 0; // draw_count > 1 needs DeviceFeatures::multiDrawIndirect
+    virtual void DrawIndexedIndirectCount(const Buffer& buffer, uint64_t offset, const Buffer& count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride) = 0; // needs DeviceFeatures::drawIndirectCount
+    virtual void Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) = 0;
+    virtual void DispatchIndirect(const Buffer& buffer, uint64_t offset) = 0;  // three uint32 group counts at offset
     virtual void SetViewPort(const Viewport& viewport) = 0;
     virtual void SetScissor(const Scissor& scissor) = 0;
     virtual void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* iamgeBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) = 0;
-    virtual void BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo) = 0; //TODO: remove renderpass info from parameter list
+    virtual void BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) = 0; //TODO: remove renderpass info from parameter list
+    virtual void ExecuteCommandLists(CommandList* const* cmds, uint32_t count) = 0; // secondary lists in order, inside a SECONDARY_COMMAND_LISTS pass
     virtual void EndRenderPass() = 0;
     virtual void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageCopySubresourceRange& subresouce) = 0;
     virtual void GenerateMipmap(Image& image, ImageLayout base_level_layout) = 0;
@@ -120,10 +183,14 @@ public:
     virtual void EndRegion() = 0;
 
     QueueType GetQueueType() const { return m_queueType; }
+    bool IsSecondary() const { return m_secondary; }
     GpuResourceType GetGpuResourceType() const override { return GpuResourceType::COMMAND_LIST; }
+    const CommandListStats& GetStats() const { return m_stats; }
 
 protected:
     QueueType m_queueType;
+    bool m_secondary = false;
+    CommandListStats m_stats;
 };
 
 }
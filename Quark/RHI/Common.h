@@ -8,6 +8,9 @@ namespace quark::rhi {
 #define DESCRIPTOR_SET_MAX_NUM 4
 #define SET_BINDINGS_MAX_NUM 16
 #define PUSH_CONSTANT_DATA_SIZE 128
+#define BINDLESS_DESCRIPTOR_SET 3
+#define BINDLESS_IMAGE_MAX_NUM 16384
+#define BINDLESS_SAMPLER_MAX_NUM 64
 #define VERTEX_BUFFER_MAX_NUM 8
 #define MAX_COLOR_ATTHACHEMNT_NUM 8
 #define MAX_FRAME_NUM_IN_FLIGHT 2
@@ -86,6 +89,8 @@ enum class DataFormat
     ETC2_R8G8B8A8_UNORM_BLOCK,
     BC7_UNORM_BLOCK,
     BC3_UNORM_BLOCK,
+    BC1_RGBA_UNORM_BLOCK,
+    BC5_UNORM_BLOCK,
 };
 
 enum class LogicOperation : uint8_t
@@ -195,6 +200,10 @@ inline u32 GetFormatStride(DataFormat format)
         return 8u;
     case DataFormat::R16G16B16_SFLOAT:
         return 6u;
+    case DataFormat::BC1_RGBA_UNORM_BLOCK:
+        return 8u;
+    case DataFormat::BC3_UNORM_BLOCK:
+    case DataFormat::BC5_UNORM_BLOCK:
     case DataFormat::BC7_UNORM_BLOCK:
     case DataFormat::R32G32B32A32_SFLOAT:
         return 16u;
@@ -246,6 +255,8 @@ inline void GetFormatBlockDim(DataFormat format, uint32_t& block_dim_x, uint32_t
     fmt(ETC2_R8G8B8A8_UNORM_BLOCK, 4, 4);
     fmt(BC7_UNORM_BLOCK, 4, 4);
     fmt(BC3_UNORM_BLOCK, 4, 4);
+    fmt(BC1_RGBA_UNORM_BLOCK, 4, 4);
+    fmt(BC5_UNORM_BLOCK, 4, 4);
     
     // non-block
     default:
@@ -31,9 +31,43 @@ namespace quark::rhi {
         bool textureCompressionASTC_LDR = false;
         bool textureCompressionETC2 = false;
         bool supports_format_feature_flags2 = false;
+        bool multiDrawIndirect = false;
+        bool drawIndirectCount = false;
+        bool bindless = false;  // see Device::RegisterBindlessImage()
 
     };
 
+    // Statistics of the batched static data uploads (CreateBuffer/CreateImage with initial data, CopyBuffer)
+    struct UploadStats
+    {
+        uint64_t submittedBatches = 0;
+        uint64_t completedBatches = 0;
+        uint64_t uploadCount = 0;
+        uint64_t uploadedBytes = 0;         // bytes of completed batches
+        double busySeconds = 0.0;           // accumulated submit-to-completion time of completed batches
+        double lastBatchThroughputMBs = 0.0;
+
+        double GetAverageThroughputMBs() const { return busySeconds > 0.0 ? (uploadedBytes / (1024.0 * 1024.0)) / busySeconds : 0.0; }
+    };
+
+    // A region between CommandList::BeginRegion() and EndRegion() measured with gpu timestamps
+    struct GpuTimingRegion
+    {
+        std::string name;
+        uint32_t parent = ~0u;      // index into GpuFrameTimings::regions, ~0u for root regions
+        uint32_t depth = 0;
+        double startMs = 0.0;       // relative to the first timestamp of the frame
+        double durationMs = 0.0;
+    };
+
+    // Gpu timings of one frame, resolved a few frames later when the frame's queries are available
+    struct GpuFrameTimings
+    {
+        uint64_t frameIndex = 0;
+        double totalMs = 0.0;       // first to last timestamp of the frame
+        std::vector<GpuTimingRegion> regions; // depth first order
+    };
+
     class Device
     {
     public:
@@ -50,6 +84,7 @@ namespace quark::rhi {
         virtual void NextFrameContext() = 0;
         virtual bool BeiginFrame(TimeStep ts) = 0;  
         virtual bool EndFrame(TimeStep ts) = 0;
+        virtual uint64_t GetFrameCount() const = 0;    // frames begun so far, increased by NextFrameContext()
         virtual void OnWindowResize(const WindowResizeEvent& event) = 0;    // window resize callback
         virtual void WaitIdle() = 0;
 
@@ -60,17 +95,50 @@ namespace quark::rhi {
         virtual Ref<Shader> CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize) = 0;
         virtual Ref<Shader> CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path) = 0;
         virtual Ref<PipeLine> CreateGraphicPipeLine(const GraphicPipeLineDesc& desc) = 0;
+        virtual Ref<PipeLine> CreateComputePipeLine(const ComputePipeLineDesc& desc) = 0;
         virtual Ref<Sampler> CreateSampler(const SamplerDesc& desc) = 0;
         virtual void SetName(const Ref<GpuResource>& resouce, const char* name) = 0;
 
+        /*** BINDLESS ***/
+        // Requires DeviceFeatures::bindless. Registered views and samplers get a slot in one global descriptor set,
+        // declared by shaders as unsized arrays in set BINDLESS_DESCRIPTOR_SET (see include/bindless.glslh) and
+        // indexed with the returned value. The set is bound with the pipeline, so switching textures costs no descriptor work.
+        // The caller keeps the view alive while it is registered. Unregistering frees the slot once the frames in flight are done.
+        virtual uint32_t RegisterBindlessImage(const ImageView& view) = 0;
+        virtual uint32_t RegisterBindlessSampler(const Sampler& sampler) = 0;
+        virtual void UnregisterBindlessImage(uint32_t index) = 0;
+
         // helper functions to upload data to GPU
         // only use in the initialization stage
         virtual void CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) = 0;
+        // Same as CopyBuffer() from cpu memory, the data is staged in the upload batch's staging ring
+        virtual void UpdateBuffer(Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset = 0) = 0;
+
+        // Uploads are packed into batches and submitted together. Pending uploads are flushed implicitly
+        // before any command list submission, FlushUploads() forces it and returns the batch id to poll.
+        virtual uint64_t FlushUploads() = 0;
+        virtual bool IsUploadComplete(uint64_t batchId) = 0;
+        virtual UploadStats GetUploadStats() = 0;
+
+        // Gpu profiling of the named command list regions
+        virtual void SetGpuProfilingEnabled(bool enable) = 0;
+        virtual bool IsGpuProfilingEnabled() const = 0;
+        virtual const GpuFrameTimings& GetGpuFrameTimings() const = 0; // latest resolved frame
+
+        // Sum of the stats of all command lists submitted during the previous frame
+        virtual const CommandListStats& GetFrameStats() const = 0;
 
         /*** COMMAND LIST ***/
+        // Command lists of QUEUE_TYPE_ASYNC_COMPUTE run on the compute queue. To consume their results on
+        // another queue, submit them with signal = true and pass them as waitedCmds of the consumer.
         virtual CommandList* BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) = 0;
         virtual void SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) = 0;
 
+        // Secondary command lists record a part of the render pass the primary is in, so several threads can record
+        // one pass. They inherit its attachments, viewport and scissor, and are run with primary.ExecuteCommandLists().
+        // Thread safe, each list has its own command pool and transient buffer blocks and is never submitted by itself.
+        virtual CommandList* BeginSecondaryCommandList(CommandList& primary) = 0;
+
         /*** SWAPCHAIN ***/
         virtual Image* GetPresentImage() = 0; // Owned by device.
         virtual DataFormat GetPresentImageFormat() = 0;
@@ -0,0 +1,472 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Null/CommandList_Null.h"
+#include "Quark/RHI/Null/Device_Null.h"
+#include "Quark/Core/Util/Hash.h"
+
+namespace quark::rhi {
+
+namespace {
+
+uint64_t HashData(const void* data, uint64_t size)
+{
+    util::Hasher h;
+    h.data(static_cast<const uint8_t*>(data), size);
+    return h.get();
+}
+
+uint32_t GetId(const Buffer& buffer) { return static_cast<const Buffer_Null&>(buffer).GetId(); }
+uint32_t GetId(const Image& image) { return static_cast<const Image_Null&>(image).GetId(); }
+uint32_t GetId(const ImageView& view) { return static_cast<const ImageView_Null&>(view).GetId(); }
+uint32_t GetId(const Sampler& sampler) { return static_cast<const Sampler_Null&>(sampler).GetId(); }
+uint32_t GetId(const PipeLine& pipeline) { return static_cast<const PipeLine_Null&>(pipeline).GetId(); }
+
+}
+
+CommandList_Null::CommandList_Null(Device_Null* device, QueueType type)
+    : CommandList(type), m_device(device)
+{
+}
+
+void CommandList_Null::Reset()
+{
+    m_recording = m_device->IsRecordingEnabled();
+    m_stream.clear();
+    m_pendingHashes.clear();
+    m_stats = {};
+    m_stats.commandLists = 1;
+
+    m_scratchBlockIndex = 0;
+    m_scratchOffset = 0;
+
+    m_currentRenderPassInfo = {};
+    m_currentPipeline = nullptr;
+    for (BufferBinding& binding : m_vertexBuffers)
+        binding = {};
+    m_indexBuffer = {};
+    m_inRenderPass = false;
+    m_renderPassContents = RenderPassContents::INLINE;
+    m_secondary = false;
+}
+
+void CommandList_Null::BeginSecondary(const CommandList_Null& primary)
+{
+    QK_CORE_ASSERT(primary.m_inRenderPass && primary.m_renderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+
+    Reset();
+    m_secondary = true;
+    m_inRenderPass = true;
+    m_currentRenderPassInfo = primary.m_currentRenderPassInfo;
+}
+
+void CommandList_Null::Finish()
+{
+    QK_CORE_ASSERT(!m_inRenderPass)
+
+    // The data is written by the caller after the allocation, so hash it as late as possible
+    for (const PendingHash& pending : m_pendingHashes)
+    {
+        uint64_t hash = HashData(pending.data, pending.size);
+        std::memcpy(m_stream.data() + pending.streamOffset, &hash, sizeof(hash));
+    }
+    m_pendingHashes.clear();
+}
+
+void CommandList_Null::PushConstant(const void* data, uint32_t offset, uint32_t size)
+{
+    m_stats.pushConstantUpdates++;
+
+    WriteOp(NullCommand::PUSH_CONSTANT);
+    Write(offset);
+    Write(size);
+    Write(HashData(data, size));
+}
+
+void CommandList_Null::BindUniformBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size)
+{
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::BIND_UNIFORM_BUFFER);
+    Write(set);
+    Write(binding);
+    Write(GetId(buffer));
+    Write(offset);
+    Write(size);
+}
+
+void CommandList_Null::BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size)
+{
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::BIND_STORAGE_BUFFER);
+    Write(set);
+    Write(binding);
+    Write(GetId(buffer));
+    Write(offset);
+    Write(size);
+}
+
+void CommandList_Null::BindImage(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout)
+{
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::BIND_IMAGE);
+    Write(set);
+    Write(binding);
+    Write(GetId(image_view));
+    Write(util::ecast(layout));
+}
+
+void CommandList_Null::BindImageSampler(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout, const Sampler& sampler)
+{
+    m_stats.resourceBinds += 2;   // image and sampler, like BindImage() + BindSampler()
+
+    WriteOp(NullCommand::BIND_IMAGE_SAMPLER);
+    Write(set);
+    Write(binding);
+    Write(GetId(image_view));
+    Write(util::ecast(layout));
+    Write(GetId(sampler));
+}
+
+void CommandList_Null::BindStorageImage(uint32_t set, uint32_t binding, const ImageView& image_view)
+{
+    QK_CORE_ASSERT(image_view.GetDesc().image->GetDesc().usageBits & IMAGE_USAGE_STORAGE_BIT)
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::BIND_STORAGE_IMAGE);
+    Write(set);
+    Write(binding);
+    Write(GetId(image_view));
+}
+
+void CommandList_Null::BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler)
+{
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::BIND_SAMPLER);
+    Write(set);
+    Write(binding);
+    Write(GetId(sampler));
+}
+
+void CommandList_Null::BindPipeLine(const PipeLine& pipeline)
+{
+    // Same filtering as the vulkan backend, rebinding the current pipeline is free
+    if (m_currentPipeline == &pipeline)
+        return;
+
+    m_currentPipeline = &pipeline;
+    m_stats.pipelineBinds++;
+
+    WriteOp(NullCommand::BIND_PIPELINE);
+    Write(GetId(pipeline));
+}
+
+void CommandList_Null::BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset)
+{
+    QK_CORE_ASSERT(binding < MAX_VERTEX_BUFFERS)
+
+    BufferBinding& state = m_vertexBuffers[binding];
+    if (state.id == GetId(buffer) && state.offset == offset)
+        return;
+
+    state.id = GetId(buffer);
+    state.offset = offset;
+    m_stats.vertexBufferBinds++;
+
+    WriteOp(NullCommand::BIND_VERTEX_BUFFER);
+    Write(binding);
+    Write(GetId(buffer));
+    Write(offset);
+}
+
+void CommandList_Null::BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format)
+{
+    if (m_indexBuffer.id == GetId(buffer) && m_indexBuffer.offset == offset && m_indexBuffer.format == (uint8_t)format)
+        return;
+
+    m_indexBuffer = { GetId(buffer), offset, (uint8_t)format };
+    m_stats.indexBufferBinds++;
+
+    WriteOp(NullCommand::BIND_INDEX_BUFFER);
+    Write(GetId(buffer));
+    Write(offset);
+    Write((uint8_t)format);
+}
+
+void CommandList_Null::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance)
+{
+    QK_CORE_ASSERT(m_currentPipeline)
+
+    m_stats.draws++;
+    m_stats.instances += instance_count;
+    m_stats.primitives += (uint64_t)index_count * instance_count;
+
+    WriteOp(NullCommand::DRAW_INDEXED);
+    Write(index_count);
+    Write(instance_count);
+    Write(first_index);
+    Write(vertex_offset);
+    Write(first_instance);
+}
+
+void CommandList_Null::Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+    QK_CORE_ASSERT(m_currentPipeline)
+
+    m_stats.draws++;
+    m_stats.instances += instance_count;
+    m_stats.primitives += (uint64_t)vertex_count * instance_count;
+
+    WriteOp(NullCommand::DRAW);
+    Write(vertex_count);
+    Write(instance_count);
+    Write(first_vertex);
+    Write(first_instance);
+}
+
+void CommandList_Null::DrawIndexedIndirect(const Buffer& buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+{
+    QK_CORE_ASSERT(m_currentPipeline)
+    QK_CORE_ASSERT(m_indexBuffer.id != ~0u)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+
+    m_stats.draws++;
+    m_stats.indirectDraws++;
+
+    WriteOp(NullCommand::DRAW_INDEXED_INDIRECT);
+    Write(GetId(buffer));
+    Write(offset);
+    Write(draw_count);
+    Write(stride);
+}
+
+void CommandList_Null::DrawIndexedIndirectCount(const Buffer& buffer, uint64_t offset, const Buffer& count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+    QK_CORE_ASSERT(m_currentPipeline)
+    QK_CORE_ASSERT(m_indexBuffer.id != ~0u)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+    QK_CORE_ASSERT(count_buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+
+    m_stats.draws++;
+    m_stats.indirectDraws++;
+
+    WriteOp(NullCommand::DRAW_INDEXED_INDIRECT_COUNT);
+    Write(GetId(buffer));
+    Write(offset);
+    Write(GetId(count_buffer));
+    Write(count_offset);
+    Write(max_draw_count);
+    Write(stride);
+}
+
+void CommandList_Null::Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    QK_CORE_ASSERT(!m_inRenderPass)
+    QK_CORE_ASSERT(m_currentPipeline && m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::COMPUTE)
+
+    m_stats.dispatches++;
+
+    WriteOp(NullCommand::DISPATCH);
+    Write(group_count_x);
+    Write(group_count_y);
+    Write(group_count_z);
+}
+
+void CommandList_Null::DispatchIndirect(const Buffer& buffer, uint64_t offset)
+{
+    QK_CORE_ASSERT(!m_inRenderPass)
+    QK_CORE_ASSERT(m_currentPipeline && m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::COMPUTE)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+
+    m_stats.dispatches++;
+
+    WriteOp(NullCommand::DISPATCH_INDIRECT);
+    Write(GetId(buffer));
+    Write(offset);
+}
+
+void CommandList_Null::SetViewPort(const Viewport& viewport)
+{
+    WriteOp(NullCommand::SET_VIEWPORT);
+    Write(viewport);
+}
+
+void CommandList_Null::SetScissor(const Scissor& scissor)
+{
+    WriteOp(NullCommand::SET_SCISSOR);
+    Write(scissor);
+}
+
+void CommandList_Null::PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* iamgeBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount)
+{
+    m_stats.barriers += memoryBarriersCount + iamgeBarriersCount + bufferBarriersCount;
+
+    WriteOp(NullCommand::BARRIERS);
+    Write(memoryBarriersCount);
+    Write(iamgeBarriersCount);
+    Write(bufferBarriersCount);
+}
+
+void CommandList_Null::BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents)
+{
+    QK_CORE_ASSERT(!m_inRenderPass && !m_secondary)
+
+    m_inRenderPass = true;
+    m_renderPassContents = contents;
+    m_currentRenderPassInfo = renderPassInfo;
+    m_currentPipeline = nullptr;
+    m_stats.renderPasses++;
+
+    WriteOp(NullCommand::BEGIN_RENDER_PASS);
+    Write(renderPassInfo.numColorAttachments);
+    for (uint32_t i = 0; i < renderPassInfo.numColorAttachments; i++)
+        Write(frameBufferInfo.colorAttachments[i] ? GetId(*frameBufferInfo.colorAttachments[i]) : ~0u);
+    Write(frameBufferInfo.depthAttachment ? GetId(*frameBufferInfo.depthAttachment) : ~0u);
+}
+
+void CommandList_Null::EndRenderPass()
+{
+    QK_CORE_ASSERT(m_inRenderPass && !m_secondary)
+
+    m_inRenderPass = false;
+    m_renderPassContents = RenderPassContents::INLINE;
+    m_currentRenderPassInfo = {};
+    m_currentPipeline = nullptr;
+
+    WriteOp(NullCommand::END_RENDER_PASS);
+}
+
+void CommandList_Null::ExecuteCommandLists(CommandList* const* cmds, uint32_t count)
+{
+    QK_CORE_ASSERT(m_inRenderPass && m_renderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto& secondary = static_cast<CommandList_Null&>(*cmds[i]);
+        QK_CORE_ASSERT(secondary.m_secondary && secondary.m_inRenderPass)
+
+        secondary.m_inRenderPass = false;
+        secondary.Finish();
+        m_stats.Add(secondary.GetStats());
+
+        // Inlined, so the recorded stream reads the same as if the pass had been recorded on one thread
+        const std::vector<uint8_t>& stream = secondary.GetStream();
+        WriteOp(NullCommand::EXECUTE_COMMAND_LIST);
+        Write((uint32_t)stream.size());
+        if (m_recording)
+            m_stream.insert(m_stream.end(), stream.begin(), stream.end());
+    }
+}
+
+void CommandList_Null::CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageCopySubresourceRange& subresouce)
+{
+    m_stats.copies++;
+
+    WriteOp(NullCommand::COPY_IMAGE_TO_BUFFER);
+    Write(GetId(buffer));
+    Write(GetId(image));
+    Write(buffer_offset);
+}
+
+void CommandList_Null::GenerateMipmap(Image& image, ImageLayout base_level_layout)
+{
+    m_stats.copies++;
+
+    WriteOp(NullCommand::GENERATE_MIPMAP);
+    Write(GetId(image));
+}
+
+void CommandList_Null::BlitImage(const Image& dst, const Image& src, const Offset3D& dst_offset, const Offset3D& dst_extent, const Offset3D& src_offset, const Offset3D& src_extent, uint32_t dst_level, uint32_t src_level, uint32_t dst_base_layer, uint32_t src_base_layer, uint32_t num_layers, SamplerFilter filter)
+{
+    m_stats.copies++;
+
+    WriteOp(NullCommand::BLIT_IMAGE);
+    Write(GetId(dst));
+    Write(GetId(src));
+    Write(dst_level);
+    Write(src_level);
+}
+
+void* CommandList_Null::AllocateConstantData(uint32_t set, uint32_t binding, uint64_t size)
+{
+    void* data = AllocateScratch(size);
+    m_stats.constantDataBytes += size;
+    m_stats.resourceBinds++;
+
+    WriteOp(NullCommand::CONSTANT_DATA);
+    Write(set);
+    Write(binding);
+    Write(size);
+    RecordTransientData(data, size);
+    return data;
+}
+
+void* CommandList_Null::AllocateVertexData(unsigned binding, uint64_t size)
+{
+    QK_CORE_ASSERT(binding < MAX_VERTEX_BUFFERS)
+
+    // Lands in a transient buffer, the next bind of this slot is never redundant
+    void* data = AllocateScratch(size);
+    m_vertexBuffers[binding] = {};
+    m_stats.vertexDataBytes += size;
+    m_stats.vertexBufferBinds++;
+
+    WriteOp(NullCommand::VERTEX_DATA);
+    Write((uint32_t)binding);
+    Write(size);
+    RecordTransientData(data, size);
+    return data;
+}
+
+void CommandList_Null::BeginRegion(const char* name, const float* color)
+{
+    uint32_t length = (uint32_t)std::strlen(name);
+
+    WriteOp(NullCommand::BEGIN_REGION);
+    Write(length);
+    if (m_recording)
+        m_stream.insert(m_stream.end(), name, name + length);
+}
+
+void CommandList_Null::EndRegion()
+{
+    WriteOp(NullCommand::END_REGION);
+}
+
+void* CommandList_Null::AllocateScratch(uint64_t size)
+{
+    // Same alignment as a uniform buffer offset on most hardware
+    constexpr uint64_t alignment = 256;
+
+    while (m_scratchBlockIndex < m_scratchBlocks.size())
+    {
+        ScratchBlock& block = m_scratchBlocks[m_scratchBlockIndex];
+        uint64_t offset = (m_scratchOffset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= block.size)
+        {
+            m_scratchOffset = offset + size;
+            return block.data.get() + offset;
+        }
+
+        m_scratchBlockIndex++;
+        m_scratchOffset = 0;
+    }
+
+    uint64_t block_size = std::max(SCRATCH_BLOCK_SIZE, size);
+    m_scratchBlocks.push_back({ std::make_unique<uint8_t[]>(block_size), block_size });
+    m_scratchBlockIndex = m_scratchBlocks.size() - 1;
+    m_scratchOffset = size;
+    return m_scratchBlocks.back().data.get();
+}
+
+void CommandList_Null::RecordTransientData(const void* data, uint64_t size)
+{
+    if (!m_recording)
+        return;
+
+    m_pendingHashes.push_back({ m_stream.size(), data, size });
+    Write(uint64_t(0));
+}
+
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include "Quark/RHI/CommandList.h"
+#include "Quark/RHI/Null/Resources_Null.h"
+
+#include <cstring>
+
+namespace quark::rhi {
+
+class Device_Null;
+
+// Opcodes of the recorded command stream. Every command is its opcode byte followed by its
+// arguments as little endian integers, resources are referenced by their ids.
+enum class NullCommand : uint8_t
+{
+    FRAME_BEGIN,            // u64 frame index
+    UPLOAD,                 // u32 destination resource, u64 size. Static data uploads, outside of command lists
+    SUBMIT,                 // u8 queue, u32 byte size of the commands that follow
+    PUSH_CONSTANT,          // u32 offset, u32 size, u64 data hash
+    BIND_UNIFORM_BUFFER,    // u32 set, u32 binding, u32 buffer, u64 offset, u64 size
+    BIND_STORAGE_BUFFER,    // u32 set, u32 binding, u32 buffer, u64 offset, u64 size
+    BIND_IMAGE,             // u32 set, u32 binding, u32 view, u8 layout
+    BIND_IMAGE_SAMPLER,     // u32 set, u32 binding, u32 view, u8 layout, u32 sampler
+    BIND_SAMPLER,           // u32 set, u32 binding, u32 sampler
+    BIND_PIPELINE,          // u32 pipeline
+    BIND_VERTEX_BUFFER,     // u32 binding, u32 buffer, u64 offset
+    BIND_INDEX_BUFFER,      // u32 buffer, u64 offset, u8 format
+    DRAW,                   // u32 vertex count, u32 instance count, u32 first vertex, u32 first instance
+    DRAW_INDEXED,           // u32 index count, u32 instance count, u32 first index, u32 vertex offset, u32 first instance
+    SET_VIEWPORT,           // 6 x f32
+    SET_SCISSOR,            // 4 x i32
+    BARRIERS,               // u32 memory, u32 image, u32 buffer barrier counts
+    BEGIN_RENDER_PASS,      // u32 color count, u32 view per color attachment, u32 depth view (~0u for none)
+    END_RENDER_PASS,
+    COPY_IMAGE_TO_BUFFER,   // u32 buffer, u32 image, u64 buffer offset
+    GENERATE_MIPMAP,        // u32 image
+    BLIT_IMAGE,             // u32 dst image, u32 src image, u32 dst level, u32 src level
+    CONSTANT_DATA,          // u32 set, u32 binding, u64 size, u64 data hash
+    VERTEX_DATA,            // u32 binding, u64 size, u64 data hash
+    BEGIN_REGION,           // u32 length, name
+    END_REGION,
+    BIND_STORAGE_IMAGE,     // u32 set, u32 binding, u32 view
+    DISPATCH,               // u32 group count x, y, z
+    DISPATCH_INDIRECT,      // u32 buffer, u64 offset
+    DRAW_INDEXED_INDIRECT,  // u32 buffer, u64 offset, u32 draw count, u32 stride
+    DRAW_INDEXED_INDIRECT_COUNT, // u32 buffer, u64 offset, u32 count buffer, u64 count offset, u32 max draw count, u32 stride
+    EXECUTE_COMMAND_LIST,   // u32 byte size of the secondary list's commands that follow
+};
+
+class CommandList_Null final : public CommandList {
+    friend class Device_Null;
+
+public:
+    CommandList_Null(Device_Null* device, QueueType type);
+    ~CommandList_Null() = default;
+
+    void PushConstant(const void* data, uint32_t offset, uint32_t size) override final;
+    void BindUniformBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) override final;
+    void BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) override final;
+    void BindImage(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout) override final;
+    void BindImageSampler(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout, const Sampler& sampler) override final;
+    void BindStorageImage(uint32_t set, uint32_t binding, const ImageView& image_view) override final;
+    void BindPipeLine(const PipeLine& pipeline) override final;
+    void BindVertexBuffer(uint32_t binding, const Buffer& buffer, uint64_t offset) override final;
+    void BindIndexBuffer(const Buffer& buffer, uint64_t offset, const IndexBufferFormat format) override final;
+    void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) override final;
+    void DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance) override final;
+    void Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override final;
+    void DrawIndexedIndirect(const Buffer& buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) override final;
+    void DrawIndexedIndirectCount(const Buffer& buffer, uint64_t offset, const Buffer& count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride) override final;
+    void Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override final;
+    void DispatchIndirect(const Buffer& buffer, uint64_t offset) override final;
+    void SetViewPort(const Viewport& viewport) override final;
+    void SetScissor(const Scissor& scissor) override final;
+    void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* iamgeBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) override final;
+    void BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) override final;
+    void ExecuteCommandLists(CommandList* const* cmds, uint32_t count) override final;
+    void EndRenderPass() override final;
+    void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageCopySubresourceRange& subresouce) override final;
+    void GenerateMipmap(Image& image, ImageLayout base_level_layout) override final;
+    void BlitImage(const Image& dst, const Image& src, const Offset3D& dst_offset, const Offset3D& dst_extent, const Offset3D& src_offset, const Offset3D& src_extent, uint32_t dst_level, uint32_t src_level, uint32_t dst_base_layer, uint32_t src_base_layer, uint32_t num_layers, SamplerFilter filter) override final;
+
+    void* AllocateConstantData(uint32_t set, uint32_t binding, uint64_t size) override final;
+    void* AllocateVertexData(unsigned binding, uint64_t size) override final;
+
+    const RenderPassInfo& GetCurrentRenderPassInfo() const override final { return m_currentRenderPassInfo; }
+    const PipeLine* GetCurrentGraphicsPipeline() const override final { return m_currentPipeline; }
+
+    void BeginRegion(const char* name, const float* color = nullptr) override final;
+    void EndRegion() override final;
+
+    const std::vector<uint8_t>& GetStream() const { return m_stream; }
+
+private:
+    void Reset();
+    void BeginSecondary(const CommandList_Null& primary);
+    void Finish();  // resolves the hashes of the transient data, called on submit
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (!m_recording)
+            return;
+        size_t offset = m_stream.size();
+        m_stream.resize(offset + sizeof(T));
+        std::memcpy(m_stream.data() + offset, &value, sizeof(T));
+    }
+    void WriteOp(NullCommand op) { Write(util::ecast(op)); }
+
+    // Transient constant and vertex data lives in blocks which are kept for the next use of the list
+    void* AllocateScratch(uint64_t size);
+    void RecordTransientData(const void* data, uint64_t size);
+
+    struct ScratchBlock
+    {
+        std::unique_ptr<uint8_t[]> data;
+        uint64_t size;
+    };
+
+    struct PendingHash
+    {
+        size_t streamOffset;
+        const void* data;
+        uint64_t size;
+    };
+
+    static constexpr uint64_t SCRATCH_BLOCK_SIZE = 64 * 1024;
+
+    Device_Null* m_device;
+    bool m_recording = false;
+    std::vector<uint8_t> m_stream;
+    std::vector<PendingHash> m_pendingHashes;
+
+    std::vector<ScratchBlock> m_scratchBlocks;
+    size_t m_scratchBlockIndex = 0;
+    uint64_t m_scratchOffset = 0;
+
+    // Binding state, redundant binds are filtered like the vulkan backend does
+    struct BufferBinding
+    {
+        uint32_t id = ~0u;
+        uint64_t offset = 0;
+        uint8_t format = 0;
+    };
+    static constexpr uint32_t MAX_VERTEX_BUFFERS = 8;
+
+    RenderPassInfo m_currentRenderPassInfo = {};
+    const PipeLine* m_currentPipeline = nullptr;
+    BufferBinding m_vertexBuffers[MAX_VERTEX_BUFFERS];
+    BufferBinding m_indexBuffer;
+    bool m_inRenderPass = false;
+    RenderPassContents m_renderPassContents = RenderPassContents::INLINE;
+};
+
+}
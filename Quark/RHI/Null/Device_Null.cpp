@@ -0,0 +1,337 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Null/Device_Null.h"
+#include "Quark/RHI/TextureFormatLayout.h"
+#include "Quark/Core/FileSystem.h"
+
+#include <fstream>
+
+namespace quark::rhi {
+
+Device_Null::Device_Null(const DeviceConfig& config, uint32_t width, uint32_t height)
+{
+    QK_CORE_LOGI_TAG("RHI", "Creating Device_Null...");
+
+    m_config = config;
+    m_frameBufferWidth = width;
+    m_frameBufferHeight = height;
+    m_properties.limits.minUniformBufferOffsetAlignment = 256;
+    m_features.multiDrawIndirect = true;
+    m_features.drawIndirectCount = true;
+    m_features.bindless = true;
+
+    m_frames.resize(std::max<uint32_t>(config.framesInFlight, 1));
+    CreatePresentImage();
+
+    // Headless users have no event manager
+    if (EventManager::IsAllocated())
+        m_resizeSubscription = EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event); });
+
+    QK_CORE_LOGI_TAG("RHI", "Device_Null Created");
+}
+
+Device_Null::~Device_Null()
+{
+    if (m_resizeSubscription != EventManager::invalid_subscription && EventManager::IsAllocated())
+        EventManager::Get().Unsubscribe(m_resizeSubscription);
+}
+
+void Device_Null::NextFrameContext()
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    m_frameIndex++;
+    m_frameContextIndex = (m_frameContextIndex + 1) % m_frames.size();
+
+    FrameContext& frame = m_frames[m_frameContextIndex];
+    for (uint32_t& count : frame.cmdListCount)
+        count = 0;
+    frame.secondaryCmdListCount = 0;
+
+    m_freeBindlessImages.insert(m_freeBindlessImages.end(), frame.garbageBindlessImages.begin(), frame.garbageBindlessImages.end());
+    frame.garbageBindlessImages.clear();
+
+    m_frameStats = m_pendingFrameStats;
+    m_pendingFrameStats = {};
+
+    if (m_recording)
+    {
+        uint8_t op = util::ecast(NullCommand::FRAME_BEGIN);
+        WriteRecord(&op, sizeof(op));
+        WriteRecord(&m_frameIndex, sizeof(m_frameIndex));
+    }
+}
+
+bool Device_Null::BeiginFrame(TimeStep ts)
+{
+    NextFrameContext();
+    return true;
+}
+
+bool Device_Null::EndFrame(TimeStep ts)
+{
+    FlushUploads();
+    return true;
+}
+
+void Device_Null::OnWindowResize(const WindowResizeEvent& event)
+{
+    m_frameBufferWidth = event.width;
+    m_frameBufferHeight = event.height;
+    CreatePresentImage();
+}
+
+void Device_Null::CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset, uint64_t srcOffset)
+{
+    void* dst_data = dst.GetMappedDataPtr();
+    void* src_data = src.GetMappedDataPtr();
+    if (dst_data && src_data)
+        std::memcpy((uint8_t*)dst_data + dstOffset, (uint8_t*)src_data + srcOffset, size);
+
+    CountUpload(static_cast<Buffer_Null&>(dst).GetId(), size);
+}
+
+void Device_Null::UpdateBuffer(Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset)
+{
+    if (void* dst_data = dst.GetMappedDataPtr())
+        std::memcpy((uint8_t*)dst_data + dstOffset, data, size);
+
+    CountUpload(static_cast<Buffer_Null&>(dst).GetId(), size);
+}
+
+uint64_t Device_Null::FlushUploads()
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    // Nothing to wait for, a batch completes as soon as it is submitted
+    if (m_pendingUploads > 0)
+    {
+        m_uploadStats.submittedBatches++;
+        m_uploadStats.completedBatches++;
+        m_uploadStats.uploadCount += m_pendingUploads;
+        m_uploadStats.uploadedBytes += m_pendingUploadBytes;
+        m_pendingUploads = 0;
+        m_pendingUploadBytes = 0;
+    }
+
+    return m_uploadStats.submittedBatches;
+}
+
+UploadStats Device_Null::GetUploadStats()
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+    return m_uploadStats;
+}
+
+Ref<Buffer> Device_Null::CreateBuffer(const BufferDesc& desc, const void* initialData)
+{
+    auto buffer = CreateRef<Buffer_Null>(AllocateId(), desc, initialData);
+
+    // Host visible buffers are written directly, everything else goes through the upload path
+    if (initialData && desc.domain == BufferMemoryDomain::GPU)
+        CountUpload(buffer->GetId(), desc.size);
+
+    return buffer;
+}
+
+Ref<Image> Device_Null::CreateImage(const ImageDesc& desc, const ImageInitData* init_data)
+{
+    uint32_t id = AllocateId();
+    auto image = CreateRef<Image_Null>(id, AllocateId(), desc);
+
+    if (init_data)
+    {
+        TextureFormatLayout layout;
+        layout.SetUp2D(desc.format, desc.width, desc.height, desc.arraySize, desc.generateMipMaps ? 1 : desc.mipLevels);
+        CountUpload(id, layout.GetRequiredSize());
+    }
+
+    return image;
+}
+
+Ref<ImageView> Device_Null::CreateImageView(const ImageViewDesc& desc)
+{
+    QK_CORE_ASSERT(desc.image)
+    return CreateRef<ImageView_Null>(AllocateId(), desc);
+}
+
+Ref<Shader> Device_Null::CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize)
+{
+    if (!byteCode || codeSize == 0)
+    {
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: Empty shader byte code");
+        return nullptr;
+    }
+
+    return CreateRef<Shader_Null>(AllocateId(), stage, codeSize);
+}
+
+Ref<Shader> Device_Null::CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path)
+{
+    std::vector<uint8_t> buffer;
+    FileSystem::ReadFileBytes(file_path, buffer);
+
+    auto new_shader = CreateShaderFromBytes(stage, buffer.data(), buffer.size());
+    if (new_shader == nullptr)
+    {
+        QK_CORE_LOGE_TAG("RHI", "Faile to create shader from file: {}", file_path);
+        return nullptr;
+    }
+
+    return new_shader;
+}
+
+Ref<PipeLine> Device_Null::CreateGraphicPipeLine(const GraphicPipeLineDesc& desc)
+{
+    QK_CORE_ASSERT(desc.vertShader && desc.fragShader)
+    return CreateRef<PipeLine_Null>(AllocateId(), desc);
+}
+
+Ref<PipeLine> Device_Null::CreateComputePipeLine(const ComputePipeLineDesc& desc)
+{
+    QK_CORE_ASSERT(desc.compShader && desc.compShader->GetStage() == ShaderStage::STAGE_COMPUTE)
+    return CreateRef<PipeLine_Null>(AllocateId(), desc);
+}
+
+Ref<Sampler> Device_Null::CreateSampler(const SamplerDesc& desc)
+{
+    return CreateRef<Sampler_Null>(AllocateId(), desc);
+}
+
+uint32_t Device_Null::RegisterBindlessImage(const ImageView& view)
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    if (!m_freeBindlessImages.empty())
+    {
+        uint32_t index = m_freeBindlessImages.back();
+        m_freeBindlessImages.pop_back();
+        return index;
+    }
+
+    QK_CORE_ASSERT(m_bindlessImageCount < BINDLESS_IMAGE_MAX_NUM)
+    return m_bindlessImageCount++;
+}
+
+uint32_t Device_Null::RegisterBindlessSampler(const Sampler& sampler)
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    QK_CORE_ASSERT(m_bindlessSamplerCount < BINDLESS_SAMPLER_MAX_NUM)
+    return m_bindlessSamplerCount++;
+}
+
+void Device_Null::UnregisterBindlessImage(uint32_t index)
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    QK_CORE_ASSERT(index < m_bindlessImageCount)
+    m_frames[m_frameContextIndex].garbageBindlessImages.push_back(index);
+}
+
+CommandList* Device_Null::BeginCommandList(QueueType type)
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    FrameContext& frame = m_frames[m_frameContextIndex];
+    uint32_t index = frame.cmdListCount[type]++;
+    if (index >= frame.cmdLists[type].size())
+        frame.cmdLists[type].push_back(CreateScope<CommandList_Null>(this, type));
+
+    CommandList_Null* cmd = frame.cmdLists[type][index].get();
+    cmd->Reset();
+    return cmd;
+}
+
+CommandList* Device_Null::BeginSecondaryCommandList(CommandList& primary)
+{
+    QK_CORE_ASSERT(primary.GetQueueType() == QUEUE_TYPE_GRAPHICS)
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    FrameContext& frame = m_frames[m_frameContextIndex];
+    uint32_t index = frame.secondaryCmdListCount++;
+    if (index >= frame.secondaryCmdLists.size())
+        frame.secondaryCmdLists.push_back(CreateScope<CommandList_Null>(this, QUEUE_TYPE_GRAPHICS));
+
+    CommandList_Null* cmd = frame.secondaryCmdLists[index].get();
+    cmd->BeginSecondary(static_cast<CommandList_Null&>(primary));
+    return cmd;
+}
+
+void Device_Null::SubmitCommandList(CommandList* cmd, CommandList* waitedCmds, uint32_t waitedCmdCounts, bool signal)
+{
+    // Like the vulkan device, pending uploads are visible to the submitted work
+    FlushUploads();
+
+    auto& internal_cmd = static_cast<CommandList_Null&>(*cmd);
+    internal_cmd.Finish();
+
+    std::lock_guard<std::mutex> lock(m_locker);
+    m_stats.Add(internal_cmd.GetStats());
+    m_pendingFrameStats.Add(internal_cmd.GetStats());
+
+    if (!internal_cmd.m_recording)
+        return;
+
+    const std::vector<uint8_t>& stream = internal_cmd.GetStream();
+    uint8_t op = util::ecast(NullCommand::SUBMIT);
+    uint8_t queue = internal_cmd.GetQueueType();
+    uint32_t size = (uint32_t)stream.size();
+    WriteRecord(&op, sizeof(op));
+    WriteRecord(&queue, sizeof(queue));
+    WriteRecord(&size, sizeof(size));
+    WriteRecord(stream.data(), stream.size());
+}
+
+void Device_Null::ClearRecordedStream()
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+    m_recordedStream.clear();
+}
+
+bool Device_Null::SaveRecordedStream(const std::string& file_path) const
+{
+    std::ofstream out(file_path, std::ios::binary);
+    if (!out)
+    {
+        QK_CORE_LOGE_TAG("RHI", "Device_Null: Failed to open {} for writing", file_path);
+        return false;
+    }
+
+    out.write((const char*)m_recordedStream.data(), m_recordedStream.size());
+    return (bool)out;
+}
+
+void Device_Null::CountUpload(uint32_t dst_id, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(m_locker);
+
+    m_pendingUploads++;
+    m_pendingUploadBytes += size;
+
+    if (m_recording)
+    {
+        uint8_t op = util::ecast(NullCommand::UPLOAD);
+        WriteRecord(&op, sizeof(op));
+        WriteRecord(&dst_id, sizeof(dst_id));
+        WriteRecord(&size, sizeof(size));
+    }
+}
+
+void Device_Null::WriteRecord(const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_recordedStream.insert(m_recordedStream.end(), bytes, bytes + size);
+}
+
+void Device_Null::CreatePresentImage()
+{
+    ImageDesc desc;
+    desc.width = m_frameBufferWidth;
+    desc.height = m_frameBufferHeight;
+    desc.format = GetPresentImageFormat();
+    desc.usageBits = IMAGE_USAGE_COLOR_ATTACHMENT_BIT | IMAGE_USAGE_CAN_COPY_TO_BIT;
+    desc.initialLayout = ImageLayout::UNDEFINED;
+    m_presentImage = CreateImage(desc);
+}
+
+}
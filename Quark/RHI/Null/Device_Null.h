@@ -0,0 +1,128 @@
+#pragma once
+#include "Quark/RHI/Device.h"
+#include "Quark/RHI/Null/CommandList_Null.h"
+#include "Quark/RHI/Null/Resources_Null.h"
+#include "Quark/Events/EventManager.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace quark::rhi {
+
+// A device without gpu. Resources are plain descriptions, command lists only count what is
+// recorded into them and, if enabled, serialize it into a binary stream (see NullCommand).
+// Used to run and benchmark the whole render front end headless, and to diff the produced
+// commands between two versions of the renderer.
+class Device_Null final : public Device {
+public:
+    Device_Null(const DeviceConfig& config, uint32_t width = 1280, uint32_t height = 720);
+    virtual ~Device_Null();
+
+    const DeviceFeatures& GetDeviceFeatures() const override final { return m_features; }
+
+    void NextFrameContext() override final;
+    bool BeiginFrame(TimeStep ts) override final;
+    bool EndFrame(TimeStep ts) override final;
+    uint64_t GetFrameCount() const override final { return m_frameIndex; }
+    void OnWindowResize(const WindowResizeEvent& event) override final;
+    void CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) override final;
+    void UpdateBuffer(Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset = 0) override final;
+    uint64_t FlushUploads() override final;
+    bool IsUploadComplete(uint64_t batchId) override final { return batchId <= m_uploadStats.submittedBatches; }
+    UploadStats GetUploadStats() override final;
+    void SetGpuProfilingEnabled(bool enable) override final {}
+    bool IsGpuProfilingEnabled() const override final { return false; }
+    const GpuFrameTimings& GetGpuFrameTimings() const override final { return m_gpuTimings; }
+    const CommandListStats& GetFrameStats() const override final { return m_frameStats; }
+    void WaitIdle() override final {}
+
+    /*** RESOURCES ***/
+    Ref<Buffer>         CreateBuffer(const BufferDesc& desc, const void* initialData = nullptr) override final;
+    Ref<Image>          CreateImage(const ImageDesc& desc, const ImageInitData* init_data = nullptr) override final;
+    Ref<ImageView>      CreateImageView(const ImageViewDesc& desc) override final;
+    Ref<Shader>         CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize) override final;
+    Ref<Shader>         CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path) override final;
+    Ref<PipeLine>       CreateGraphicPipeLine(const GraphicPipeLineDesc& desc) override final;
+    Ref<PipeLine>       CreateComputePipeLine(const ComputePipeLineDesc& desc) override final;
+    Ref<Sampler>        CreateSampler(const SamplerDesc& desc) override final;
+    void                SetName(const Ref<GpuResource>& resouce, const char* name) override final {}
+
+    /*** BINDLESS ***/
+    uint32_t            RegisterBindlessImage(const ImageView& view) override final;
+    uint32_t            RegisterBindlessSampler(const Sampler& sampler) override final;
+    void                UnregisterBindlessImage(uint32_t index) override final;
+
+    /*** COMMAND LIST ***/
+    CommandList*        BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) override final;
+    void                SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) override final;
+    CommandList*        BeginSecondaryCommandList(CommandList& primary) override final;
+
+    /*** SWAPCHAIN ***/
+    Image*              GetPresentImage() override final { return m_presentImage.get(); }
+    DataFormat          GetPresentImageFormat() override final { return DataFormat::B8G8R8A8_UNORM; }
+
+    /*** PROPERTIES ***/
+    bool                isFormatSupported(DataFormat format) override final { return true; }
+
+    ///////////////////// Null specific //////////////////////////
+    //////////////////////////////////////////////////////////////
+
+    // Command lists begun after this call serialize their commands, the submitted ones are
+    // appended to the recorded stream in submission order
+    void SetRecordingEnabled(bool enable) { m_recording = enable; }
+    bool IsRecordingEnabled() const { return m_recording; }
+    const std::vector<uint8_t>& GetRecordedStream() const { return m_recordedStream; }
+    void ClearRecordedStream();
+    bool SaveRecordedStream(const std::string& file_path) const;
+
+    // Accumulated over all submitted command lists since the last reset
+    const CommandListStats& GetStats() const { return m_stats; }
+    void ResetStats() { m_stats = {}; }
+
+    uint64_t GetFrameIndex() const { return m_frameIndex; }
+
+private:
+    uint32_t AllocateId() { return m_nextId.fetch_add(1, std::memory_order_relaxed); }
+    void CountUpload(uint32_t dst_id, uint64_t size);
+    void WriteRecord(const void* data, size_t size);
+    void CreatePresentImage();
+
+    DeviceFeatures m_features;
+    GpuFrameTimings m_gpuTimings;
+    Ref<Image> m_presentImage;
+
+    std::atomic<uint32_t> m_nextId = 0;
+    uint64_t m_frameIndex = 0;
+    bool m_recording = false;
+
+    // Command lists are handed out round robin per frame and reused once the frame comes around again
+    struct FrameContext
+    {
+        std::vector<Scope<CommandList_Null>> cmdLists[QUEUE_TYPE_MAX_ENUM];
+        uint32_t cmdListCount[QUEUE_TYPE_MAX_ENUM] = {};
+        std::vector<Scope<CommandList_Null>> secondaryCmdLists;
+        uint32_t secondaryCmdListCount = 0;
+        std::vector<uint32_t> garbageBindlessImages;
+    };
+    std::vector<FrameContext> m_frames;
+    uint32_t m_frameContextIndex = 0;
+
+    UploadStats m_uploadStats;
+    uint64_t m_pendingUploads = 0;
+    uint64_t m_pendingUploadBytes = 0;
+
+    CommandListStats m_stats;
+    CommandListStats m_frameStats;      // previous frame
+    CommandListStats m_pendingFrameStats;
+    std::vector<uint8_t> m_recordedStream;
+
+    // Slots only, same allocation scheme as the vulkan bindless set
+    std::vector<uint32_t> m_freeBindlessImages;
+    uint32_t m_bindlessImageCount = 0;
+    uint32_t m_bindlessSamplerCount = 0;
+    std::mutex m_locker;
+
+    EventManager::SubscriptionId m_resizeSubscription = EventManager::invalid_subscription;
+};
+
+}
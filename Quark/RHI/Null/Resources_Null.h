@@ -0,0 +1,110 @@
+#pragma once
+#include "Quark/RHI/Buffer.h"
+#include "Quark/RHI/Image.h"
+#include "Quark/RHI/Shader.h"
+#include "Quark/RHI/PipeLine.h"
+
+#include <cstring>
+
+namespace quark::rhi {
+
+// Resources of Device_Null only carry their description and an id. Ids are handed out in creation
+// order, so the recorded command streams of two runs doing the same work are identical.
+
+class Buffer_Null final : public Buffer {
+public:
+    Buffer_Null(uint32_t id, const BufferDesc& desc, const void* init_data)
+        : Buffer(desc), m_id(id)
+    {
+        // Only host visible buffers get memory, gpu buffers are never read on the cpu
+        if (desc.domain == BufferMemoryDomain::CPU)
+        {
+            m_storage = std::make_unique<uint8_t[]>(desc.size);
+            m_pMappedData = m_storage.get();
+            if (init_data)
+                std::memcpy(m_pMappedData, init_data, desc.size);
+        }
+    }
+
+    uint32_t GetId() const { return m_id; }
+
+private:
+    uint32_t m_id;
+    std::unique_ptr<uint8_t[]> m_storage;
+};
+
+class ImageView_Null final : public ImageView {
+public:
+    ImageView_Null(uint32_t id, const ImageViewDesc& desc) : ImageView(desc), m_id(id) {}
+
+    uint32_t GetId() const { return m_id; }
+
+private:
+    uint32_t m_id;
+};
+
+class Image_Null final : public Image {
+public:
+    Image_Null(uint32_t id, uint32_t view_id, const ImageDesc& desc)
+        : Image(desc), m_id(id)
+    {
+        ImageViewDesc view_desc;
+        view_desc.image = this;
+        view_desc.format = desc.format;
+        view_desc.viewType = desc.type == ImageType::TYPE_CUBE ? ImageViewType::TYPE_CUBE :
+            (desc.type == ImageType::TYPE_3D ? ImageViewType::TYPE_3D : ImageViewType::TYPE_2D);
+        view_desc.aspect = FormatToImageAspect(desc.format);
+        view_desc.levelCount = desc.mipLevels;
+        view_desc.layerCount = desc.arraySize;
+        m_defaultView = CreateScope<ImageView_Null>(view_id, view_desc);
+    }
+
+    const ImageView& GetDefaultView() const override final { return *m_defaultView; }
+    ImageView& GetDefaultView() override final { return *m_defaultView; }
+
+    uint32_t GetId() const { return m_id; }
+
+private:
+    uint32_t m_id;
+    Scope<ImageView_Null> m_defaultView;
+};
+
+class Shader_Null final : public Shader {
+public:
+    Shader_Null(uint32_t id, ShaderStage stage, size_t code_size)
+        : Shader(stage), m_id(id), m_codeSize(code_size) {}
+
+    uint32_t GetId() const { return m_id; }
+    size_t GetCodeSize() const { return m_codeSize; }
+
+private:
+    uint32_t m_id;
+    size_t m_codeSize;
+};
+
+class PipeLine_Null final : public PipeLine {
+public:
+    PipeLine_Null(uint32_t id, const GraphicPipeLineDesc& desc)
+        : PipeLine(PipeLineBindingPoint::GRAPHIC), m_id(id), m_desc(desc) {}
+    PipeLine_Null(uint32_t id, const ComputePipeLineDesc& desc)
+        : PipeLine(PipeLineBindingPoint::COMPUTE), m_id(id) {}
+
+    uint32_t GetId() const { return m_id; }
+    const GraphicPipeLineDesc& GetDesc() const { return m_desc; }
+
+private:
+    uint32_t m_id;
+    GraphicPipeLineDesc m_desc;
+};
+
+class Sampler_Null final : public Sampler {
+public:
+    Sampler_Null(uint32_t id, const SamplerDesc& desc) : Sampler(desc), m_id(id) {}
+
+    uint32_t GetId() const { return m_id; }
+
+private:
+    uint32_t m_id;
+};
+
+}
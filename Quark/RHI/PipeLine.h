@@ -186,6 +186,11 @@ struct GraphicPipeLineDesc
     RenderPassInfo renderPassInfo = {};
 };
 
+struct ComputePipeLineDesc
+{
+    Ref<Shader> compShader;
+};
+
 enum class PipeLineBindingPoint 
 {
     GRAPHIC,
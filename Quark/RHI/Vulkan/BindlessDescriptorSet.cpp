@@ -0,0 +1,129 @@
+#include "Quark/qkpch.h"
+#include "Quark/RHI/Vulkan/BindlessDescriptorSet.h"
+#include "Quark/RHI/Vulkan/Device_Vulkan.h"
+
+namespace quark::rhi {
+
+void BindlessDescriptorSet::init(Device_Vulkan* device)
+{
+    m_device = device;
+
+    const VkPhysicalDeviceVulkan12Properties& properties12 = device->GetVulkanContext().properties12;
+    m_maxImages = std::min<uint32_t>(BINDLESS_IMAGE_MAX_NUM, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages);
+    m_maxSamplers = std::min<uint32_t>(BINDLESS_SAMPLER_MAX_NUM, properties12.maxPerStageDescriptorUpdateAfterBindSamplers);
+
+    VkDescriptorSetLayoutBinding bindings[2] = {};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+    bindings[0].descriptorCount = m_maxSamplers;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = 1;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    bindings[1].descriptorCount = m_maxImages;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    // Unregistered slots are never written, and registering a slot must not disturb frames which use other slots
+    VkDescriptorBindingFlags binding_flags[2];
+    binding_flags[0] = binding_flags[1] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+    flags_info.bindingCount = 2;
+    flags_info.pBindingFlags = binding_flags;
+
+    VkDescriptorSetLayoutCreateInfo layout_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    layout_info.pNext = &flags_info;
+    layout_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layout_info.bindingCount = 2;
+    layout_info.pBindings = bindings;
+    VK_CHECK(vkCreateDescriptorSetLayout(device->vkDevice, &layout_info, nullptr, &m_layout))
+
+    VkDescriptorPoolSize pool_sizes[2];
+    pool_sizes[0] = { VK_DESCRIPTOR_TYPE_SAMPLER, m_maxSamplers };
+    pool_sizes[1] = { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_maxImages };
+
+    VkDescriptorPoolCreateInfo pool_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+    VK_CHECK(vkCreateDescriptorPool(device->vkDevice, &pool_info, nullptr, &m_pool))
+
+    VkDescriptorSetAllocateInfo alloc_info = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.descriptorPool = m_pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &m_layout;
+    VK_CHECK(vkAllocateDescriptorSets(device->vkDevice, &alloc_info, &m_set))
+
+    QK_CORE_LOGI_TAG("RHI", "Bindless descriptor set created: {} images, {} samplers", m_maxImages, m_maxSamplers);
+}
+
+void BindlessDescriptorSet::destroy()
+{
+    if (m_pool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(m_device->vkDevice, m_pool, nullptr);
+    if (m_layout != VK_NULL_HANDLE)
+        vkDestroyDescriptorSetLayout(m_device->vkDevice, m_layout, nullptr);
+
+    m_pool = VK_NULL_HANDLE;
+    m_layout = VK_NULL_HANDLE;
+    m_set = VK_NULL_HANDLE;
+    m_freeImages.clear();
+}
+
+uint32_t BindlessDescriptorSet::registerImage(VkImageView view)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    uint32_t index;
+    if (!m_freeImages.empty())
+    {
+        index = m_freeImages.back();
+        m_freeImages.pop_back();
+    }
+    else
+    {
+        QK_CORE_VERIFY(m_imageCount < m_maxImages, "Out of bindless image slots")
+        index = m_imageCount++;
+    }
+
+    write(1, index, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, view, VK_NULL_HANDLE);
+    return index;
+}
+
+uint32_t BindlessDescriptorSet::registerSampler(VkSampler sampler)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+
+    QK_CORE_VERIFY(m_samplerCount < m_maxSamplers, "Out of bindless sampler slots")
+    uint32_t index = m_samplerCount++;
+
+    write(0, index, VK_DESCRIPTOR_TYPE_SAMPLER, VK_NULL_HANDLE, sampler);
+    return index;
+}
+
+void BindlessDescriptorSet::releaseImages(const std::vector<uint32_t>& indices)
+{
+    std::lock_guard<std::mutex> lock(m_lock);
+    m_freeImages.insert(m_freeImages.end(), indices.begin(), indices.end());
+}
+
+void BindlessDescriptorSet::write(uint32_t binding, uint32_t index, VkDescriptorType type, VkImageView view, VkSampler sampler)
+{
+    VkDescriptorImageInfo image_info = {};
+    image_info.imageView = view;
+    image_info.sampler = sampler;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = m_set;
+    write.dstBinding = binding;
+    write.dstArrayElement = index;
+    write.descriptorCount = 1;
+    write.descriptorType = type;
+    write.pImageInfo = &image_info;
+    vkUpdateDescriptorSets(m_device->vkDevice, 1, &write, 0, nullptr);
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "Quark/RHI/Vulkan/Common_Vulkan.h"
+
+#include <mutex>
+
+namespace quark::rhi {
+
+// The global descriptor set behind Device::RegisterBindlessImage(), owned by Device_Vulkan.
+// Binding 0 is an array of samplers and binding 1 an array of sampled images, shaders declare them as unsized arrays
+// in set BINDLESS_DESCRIPTOR_SET. Both bindings are partially bound and update after bind, so a slot is written once
+// when it is registered, even while command lists binding the set are in flight.
+// Slots are only released through Device_Vulkan, which defers them until the gpu is done with the frame.
+class BindlessDescriptorSet {
+public:
+    void init(Device_Vulkan* device);
+    void destroy();
+
+    VkDescriptorSetLayout getLayout() const { return m_layout; }
+    VkDescriptorSet getSet() const { return m_set; }
+
+    uint32_t registerImage(VkImageView view);
+    uint32_t registerSampler(VkSampler sampler);
+    void releaseImages(const std::vector<uint32_t>& indices);
+
+private:
+    void write(uint32_t binding, uint32_t index, VkDescriptorType type, VkImageView view, VkSampler sampler);
+
+    Device_Vulkan* m_device = nullptr;
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+    uint32_t m_maxImages = 0;
+    uint32_t m_maxSamplers = 0;
+    uint32_t m_imageCount = 0;      // slots ever handed out
+    uint32_t m_samplerCount = 0;
+    std::vector<uint32_t> m_freeImages;
+    std::mutex m_lock;
+};
+
+}
@@ -32,8 +32,9 @@ BufferBlock BufferPool::AllocateBlock(VkDeviceSize size)
 {
 	BufferBlock block;
 
+	// The spill region lies past the usable size, so every allocation can be bound with the full spill size as range
 	BufferDesc desc;
-	desc.size = size;
+	desc.size = size + m_spill_size;
 	desc.usageBits = m_buffer_usage_bits;
 	desc.domain = BufferMemoryDomain::CPU;
 
@@ -90,7 +91,7 @@ BufferBlockAllocation BufferBlock::Allocate(VkDeviceSize allocate_size)
 		m_offset = aligned_offset + allocate_size;
 
 		VkDeviceSize padded_size = std::max<VkDeviceSize>(allocate_size, m_spill_size);
-		padded_size = std::min<VkDeviceSize>(padded_size, m_size - aligned_offset);
+		padded_size = std::min<VkDeviceSize>(padded_size, m_size + m_spill_size - aligned_offset);
 		return { ret, m_buffer, aligned_offset, padded_size };
 	}
 	else
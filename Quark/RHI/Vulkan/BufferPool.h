@@ -47,6 +47,8 @@ public:
 
 	// used for allocating UBOs, where we want to specify a fixed size for range,
 	// and we need to make sure we don't allocate beyond the block.
+	// Blocks are created spill_size larger than their usable size, so allocations smaller than spill_size
+	// always get spill_size as padded size and a whole block can be bound as one dynamic uniform buffer.
 	void SetSpillRegionSize(VkDeviceSize spill_size);
 	void SetMaxRetainedBlocks(size_t max_blocks);
 
@@ -60,7 +62,7 @@ private:
 
 	Device_Vulkan* m_device;
 	VkDeviceSize m_block_size;
-	VkDeviceSize m_spill_size;
+	VkDeviceSize m_spill_size = 0;     // blocks are only padded if SetSpillRegionSize() was called
 	VkDeviceSize m_alignment;
 	VkBufferUsageFlags m_buffer_usage_bits;
 	size_t m_max_retained_blocks = 0;
@@ -88,16 +88,16 @@ Buffer_Vulkan::Buffer_Vulkan(Device_Vulkan* device, const BufferDesc& desc, cons
         {  // static data uplodaing
 
             CopyCmdAllocator::CopyCmd copyCmd = m_device->copyAllocator.allocate(desc.size);
-            memcpy(copyCmd.stageBuffer->GetMappedDataPtr(), init_data, m_desc.size);
+            memcpy(copyCmd.stageMappedData, init_data, m_desc.size);
 
             // copy buffer
             VkBufferCopy copyRegion = {};
             copyRegion.size = desc.size;
-            copyRegion.srcOffset = 0;
+            copyRegion.srcOffset = copyCmd.stageOffset;
             copyRegion.dstOffset = 0;
             vkCmdCopyBuffer(copyCmd.transferCmdBuffer, ToInternal(copyCmd.stageBuffer.get()).m_handle, m_handle, 1, &copyRegion);
 
-            // Submit this command which would block CPU
+            // Recorded into the current upload batch, submitted with the next flush
             m_device->copyAllocator.submit(copyCmd);
         }
     }
@@ -13,9 +13,11 @@ static VkOffset3D ConvertOffset(const Offset3D& offset)
 	return { offset.x, offset.y, offset.z };
 }
 
-CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type)
+CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type, bool secondary)
     : CommandList(type), m_device(device)
 {
+    m_secondary = secondary;
+
     QK_CORE_ASSERT(m_device != nullptr)
     auto& vulkan_context = m_device->GetVulkanContext();
     VkDevice vk_device = m_device->vkDevice;
@@ -46,9 +48,13 @@ CommandList_Vulkan::CommandList_Vulkan(Device_Vulkan* device, QueueType type)
     commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     commandBufferInfo.commandBufferCount = 1;
     commandBufferInfo.commandPool = m_cmdPool;
-    commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.level = m_secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     VK_CHECK(vkAllocateCommandBuffers(vk_device, &commandBufferInfo, &m_cmdBuffer))
 
+    // Secondary command buffers are never submitted by themselves
+    if (m_secondary)
+        return;
+
     VkSemaphoreCreateInfo semCreateInfo = {};
     semCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     VK_CHECK(vkCreateSemaphore(vk_device, &semCreateInfo, nullptr, &m_cmdCompleteSemaphore))
@@ -66,13 +72,89 @@ void CommandList_Vulkan::ResetAndBeginCmdBuffer()
 
     m_waitForSwapchainImage = false;
     m_swapChainWaitStages = 0;
+    m_signalling = false;
     m_imageBarriers.clear();
     m_bufferBarriers.clear();
     m_memoryBarriers.clear();
     state = CommandListState::IN_RECORDING;
 
+    m_timestampRegions.clear();
+    m_regionStack.clear();
+    if (m_timestampQueryCount > 0)
+        vkCmdResetQueryPool(m_cmdBuffer, m_timestampPool, m_timestampQueryBase, m_timestampQueryCount);
+
+    m_currentPipeline = nullptr;
+    ResetBindingState();
+
+    m_stats = {};
+    m_stats.commandLists = 1;
+}
+
+void CommandList_Vulkan::ResetAndBeginSecondaryCmdBuffer(const CommandList_Vulkan& primary)
+{
+    QK_CORE_ASSERT(m_secondary && !primary.m_secondary)
+    QK_CORE_ASSERT(primary.state == CommandListState::IN_RENDERPASS && primary.m_renderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+
+    const RenderPassInfo& renderPassInfo = primary.m_currentRenderPassInfo;
+    vkResetCommandPool(m_device->vkDevice, m_cmdPool, 0);
+
+    // Must match the VkRenderingInfo the primary began the pass with
+    VkFormat color_formats[MAX_COLOR_ATTHACHEMNT_NUM] = {};
+    for (uint32_t i = 0; i < renderPassInfo.numColorAttachments; ++i)
+        color_formats[i] = ConvertDataFormat(renderPassInfo.colorAttachmentFormats[i]);
+
+    VkCommandBufferInheritanceRenderingInfo rendering_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+    rendering_info.colorAttachmentCount = renderPassInfo.numColorAttachments;
+    rendering_info.pColorAttachmentFormats = color_formats;
+    rendering_info.depthAttachmentFormat = ConvertDataFormat(renderPassInfo.depthAttachmentFormat);
+    rendering_info.rasterizationSamples = (VkSampleCountFlagBits)renderPassInfo.sampleCount;
+
+    VkCommandBufferInheritanceInfo inheritance_info = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+    inheritance_info.pNext = &rendering_info;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    beginInfo.pInheritanceInfo = &inheritance_info;
+    VK_CHECK(vkBeginCommandBuffer(m_cmdBuffer, &beginInfo))
+
+    m_waitForSwapchainImage = false;
+    m_swapChainWaitStages = 0;
+    m_signalling = false;
+    m_imageBarriers.clear();
+    m_bufferBarriers.clear();
+    m_memoryBarriers.clear();
+    state = CommandListState::IN_RENDERPASS;
+
+    // Regions of secondary lists are not timed, the primary's region around ExecuteCommandLists() covers them
+    m_timestampPool = VK_NULL_HANDLE;
+    m_timestampQueryBase = 0;
+    m_timestampQueryCount = 0;
+    m_timestampRegions.clear();
+    m_regionStack.clear();
+
+    m_currentRenderPassInfo = renderPassInfo;
     m_currentPipeline = nullptr;
     ResetBindingState();
+
+    // Dynamic state is not inherited
+    m_viewport = primary.m_viewport;
+    m_scissor = primary.m_scissor;
+    if (m_viewport.width != 0.f && m_viewport.height != 0.f)
+        vkCmdSetViewport(m_cmdBuffer, 0, 1, &m_viewport);
+    if (m_scissor.extent.width != 0 && m_scissor.extent.height != 0)
+        vkCmdSetScissor(m_cmdBuffer, 0, 1, &m_scissor);
+
+    m_stats = {};
+    m_stats.commandLists = 1;
+}
+
+void CommandList_Vulkan::SetTimestampQueries(VkQueryPool pool, uint32_t base, uint32_t count)
+{
+    QK_CORE_ASSERT(state != CommandListState::IN_RECORDING && state != CommandListState::IN_RENDERPASS)
+    m_timestampPool = count > 0 ? pool : VK_NULL_HANDLE;
+    m_timestampQueryBase = base;
+    m_timestampQueryCount = count;
 }
 
 CommandList_Vulkan::~CommandList_Vulkan()
@@ -86,6 +168,7 @@ void CommandList_Vulkan::PipeLineBarriers(const PipelineMemoryBarrier *memoryBar
     QK_CORE_ASSERT(bufferBarriers == nullptr);   // do not support buffer barrier for now
 
     QK_CORE_ASSERT(m_memoryBarriers.empty() && m_imageBarriers.empty() && m_bufferBarriers.empty())
+    m_stats.barriers += memoryBarriersCount + iamgeBarriersCount + bufferBarriersCount;
 
     // Memory Barriers
     for (size_t i = 0; i < memoryBarriersCount; ++i) {
@@ -183,8 +266,9 @@ void CommandList_Vulkan::ResetBindingState()
     m_dirtyVertexBufferMask = 0u;
 }
 
-void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo)
+void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents)
 {
+    QK_CORE_ASSERT(!m_secondary)
     QK_CORE_ASSERT(renderPassInfo.numColorAttachments < MAX_COLOR_ATTHACHEMNT_NUM)
         QK_CORE_ASSERT(frameBufferInfo.numResolveAttachments < renderPassInfo.numColorAttachments)
 
@@ -196,11 +280,14 @@ void CommandList_Vulkan::BeginRenderPass(const RenderPassInfo& renderPassInfo, c
     // Change state
     state = CommandListState::IN_RENDERPASS;
     m_currentRenderPassInfo = renderPassInfo;
+    m_renderPassContents = contents;
+    m_stats.renderPasses++;
     m_currentPipeline = nullptr;
     ResetBindingState();
 
     VkRenderingInfo rendering_info = { VK_STRUCTURE_TYPE_RENDERING_INFO };
     rendering_info.layerCount = 1;
+    rendering_info.flags = contents == RenderPassContents::SECONDARY_COMMAND_LISTS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
     rendering_info.renderArea.offset.x = 0;
     rendering_info.renderArea.offset.y = 0;
     rendering_info.renderArea.extent.width = 0;
@@ -398,11 +485,34 @@ void CommandList_Vulkan::EndRenderPass()
         QK_CORE_LOGE_TAG("RHI", "You must call BeginRenderPass() before calling EndRenderPass()");
     }
 #endif
+    QK_CORE_ASSERT(!m_secondary)
+
     // Set state back to in recording
     state = CommandListState::IN_RECORDING;
+    m_renderPassContents = RenderPassContents::INLINE;
     m_device->GetVulkanContext().extendFunction.pVkCmdEndRenderingKHR(m_cmdBuffer);
 }
 
+void CommandList_Vulkan::ExecuteCommandLists(CommandList* const* cmds, uint32_t count)
+{
+    QK_CORE_ASSERT(state == CommandListState::IN_RENDERPASS && m_renderPassContents == RenderPassContents::SECONDARY_COMMAND_LISTS)
+
+    m_secondaryCmdBuffers.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        auto& internal_cmdList = ToInternal(cmds[i]);
+        QK_CORE_ASSERT(internal_cmdList.IsSecondary() && internal_cmdList.state == CommandListState::IN_RENDERPASS)
+
+        VK_CHECK(vkEndCommandBuffer(internal_cmdList.GetHandle()))
+        internal_cmdList.state = CommandListState::READY_FOR_SUBMIT;
+        m_secondaryCmdBuffers.push_back(internal_cmdList.GetHandle());
+        m_stats.Add(internal_cmdList.GetStats());
+    }
+
+    if (!m_secondaryCmdBuffers.empty())
+        vkCmdExecuteCommands(m_cmdBuffer, (uint32_t)m_secondaryCmdBuffers.size(), m_secondaryCmdBuffers.data());
+}
+
 void* CommandList_Vulkan::AllocateConstantData(uint32_t set, uint32_t binding, uint64_t size)
 {
     QK_CORE_ASSERT(size < VULKAN_MAX_UBO_SIZE);
@@ -413,8 +523,10 @@ void* CommandList_Vulkan::AllocateConstantData(uint32_t set, uint32_t binding, u
         data = m_ubo_block.Allocate(size);
         QK_CORE_ASSERT(data.host);
     }
+    m_stats.constantDataBytes += size;
 
-    // use padded size to optimize dynamic uniform buffer binding
+    // The padded size is the same for every allocation, so the binding only changes with the block. Allocations
+    // from the same block keep the descriptor set and are rebound with a new dynamic offset, without hashing.
     BindUniformBuffer(set, binding, *data.buffer, data.offset, data.padded_size);
     return data.host;
 }
@@ -428,6 +540,7 @@ void* CommandList_Vulkan::AllocateVertexData(unsigned binding, uint64_t size)
         data = m_vbo_block.Allocate(size);
         QK_CORE_ASSERT(data.host);
     }
+    m_stats.vertexDataBytes += size;
 
     BindVertexBuffer(binding, *data.buffer, data.offset);
     return data.host;
@@ -445,6 +558,20 @@ const PipeLine* CommandList_Vulkan::GetCurrentGraphicsPipeline() const
 
 void CommandList_Vulkan::BeginRegion(const char* name, const float* color)
 {
+    // Time the region while there are queries left in the reserved block
+    uint32_t region_index = ~0u;
+    uint32_t query = (uint32_t)m_timestampRegions.size() * 2;
+    if (m_timestampPool != VK_NULL_HANDLE && query + 2 <= m_timestampQueryCount)
+    {
+        region_index = (uint32_t)m_timestampRegions.size();
+        TimestampRegion& region = m_timestampRegions.emplace_back();
+        region.name = name;
+        region.parent = m_regionStack.empty() ? ~0u : m_regionStack.back();
+        region.depth = (uint32_t)m_regionStack.size();
+        m_device->GetVulkanContext().extendFunction.pVkCmdWriteTimestamp2KHR(m_cmdBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, m_timestampPool, m_timestampQueryBase + query);
+    }
+    m_regionStack.push_back(region_index);
+
     if (!m_device->GetVulkanContext().supportDebugUtils)
         return;
 
@@ -466,6 +593,15 @@ void CommandList_Vulkan::BeginRegion(const char* name, const float* color)
 
 void CommandList_Vulkan::EndRegion()
 {
+    QK_CORE_ASSERT(!m_regionStack.empty(), "EndRegion() without matching BeginRegion()")
+    if (!m_regionStack.empty())
+    {
+        uint32_t region_index = m_regionStack.back();
+        m_regionStack.pop_back();
+        if (region_index != ~0u)
+            m_device->GetVulkanContext().extendFunction.pVkCmdWriteTimestamp2KHR(m_cmdBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, m_timestampPool, m_timestampQueryBase + region_index * 2 + 1);
+    }
+
     if (m_device->GetVulkanContext().supportDebugUtils)
         m_device->GetVulkanContext().extendFunction.pVkCmdEndDebugUtilsLabelEXT(m_cmdBuffer);
 }
@@ -482,6 +618,7 @@ void CommandList_Vulkan::BindUniformBuffer(uint32_t set, uint32_t binding, const
     QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM);
     QK_CORE_ASSERT(binding < SET_BINDINGS_MAX_NUM);
     QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    m_stats.resourceBinds++;
     auto& internal_buffer = ToInternal(&buffer);
     auto& b = m_bindingState.descriptorBindings[set][binding];
 
@@ -508,11 +645,12 @@ void CommandList_Vulkan::BindStorageBuffer(uint32_t set, uint32_t binding, const
     QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM);
     QK_CORE_ASSERT(binding < SET_BINDINGS_MAX_NUM);
     QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    m_stats.resourceBinds++;
     auto& internal_buffer = ToInternal(&buffer);
     auto& b = m_bindingState.descriptorBindings[set][binding];
 
-     if (internal_buffer.GetCookie() == m_bindingState.cookies[set][binding] && b.buffer.range == size)
-         return;
+    if (internal_buffer.GetCookie() == m_bindingState.cookies[set][binding] && b.buffer.offset == offset && b.buffer.range == size)
+        return;
 
     b.buffer = { internal_buffer.GetHandle(), offset, size };
     b.dynamicOffset = 0;
@@ -524,6 +662,7 @@ void CommandList_Vulkan::BindImage(uint32_t set, uint32_t binding, const ImageVi
 {
     QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM);
     QK_CORE_ASSERT(binding < SET_BINDINGS_MAX_NUM);
+    m_stats.resourceBinds++;
     auto& internal = ToInternal(&image_view);
     auto& b = m_bindingState.descriptorBindings[set][binding];
     VkImageLayout image_layout = ConvertImageLayout(layout);
@@ -553,25 +692,52 @@ void CommandList_Vulkan::BindPipeLine(const PipeLine &pipeline)
         return;
     
     const PipeLineLayout* layout = internal_pipeline.GetLayout();
-    const GraphicPipeLineDesc& desc = internal_pipeline.GetGraphicPipelineDesc();
     const CombinedResourceLayout& resource_layout = layout->combinedLayout;
 
     m_active_vbos = 0;
-    for (const auto& attr : desc.vertexInputLayout.vertexAttribInfos)
+    if (internal_pipeline.GetBindingPoint() == PipeLineBindingPoint::GRAPHIC)
     {
-        if (resource_layout.attribute_mask & (1 << attr.location))
-            m_active_vbos |= 1 << attr.binding;
+        const GraphicPipeLineDesc& desc = internal_pipeline.GetGraphicPipelineDesc();
+        for (const auto& attr : desc.vertexInputLayout.vertexAttribInfos)
+        {
+            if (resource_layout.attribute_mask & (1 << attr.location))
+                m_active_vbos |= 1 << attr.binding;
+        }
     }
 
-    m_currentPipeline = &internal_pipeline;
+    // Graphics and compute have separate bind points, the sets bound so far belong to the other one
+    if (m_currentPipeline && m_currentPipeline->GetBindingPoint() != internal_pipeline.GetBindingPoint())
+        m_currentPipeline = nullptr;
+
+    // Compares against the layout of the previous pipeline, so it has to run before the switch
     SetPipelineLayout(layout);
+    m_currentPipeline = &internal_pipeline;
     SetDirty(COMMAND_LIST_DIRTY_PIPELINE_BIT);
 }
 
+void CommandList_Vulkan::BindStorageImage(uint32_t set, uint32_t binding, const ImageView& image_view)
+{
+    QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM)
+    QK_CORE_ASSERT(binding < SET_BINDINGS_MAX_NUM)
+    QK_CORE_ASSERT(image_view.GetDesc().image->GetDesc().usageBits & IMAGE_USAGE_STORAGE_BIT)
+    m_stats.resourceBinds++;
+    auto& internal = ToInternal(&image_view);
+    auto& b = m_bindingState.descriptorBindings[set][binding];
+
+    if (internal.GetCookie() == m_bindingState.cookies[set][binding] && b.image.imageLayout == VK_IMAGE_LAYOUT_GENERAL)
+        return;
+
+    b.image.imageView = internal.GetView();
+    b.image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    m_bindingState.cookies[set][binding] = internal.GetCookie();
+    m_dirtySetMask |= 1u << set;
+}
+
 void CommandList_Vulkan::BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler)
 {
     QK_CORE_ASSERT(set < DESCRIPTOR_SET_MAX_NUM)
     QK_CORE_ASSERT(binding < SET_BINDINGS_MAX_NUM)
+    m_stats.resourceBinds++;
 
     auto& internal_sampler = ToInternal(&sampler);
     auto& b = m_bindingState.descriptorBindings[set][binding];
@@ -600,12 +766,14 @@ void CommandList_Vulkan::CopyImageToBuffer(const Buffer& buffer, const Image& im
 	copy_region.imageExtent = { extent.width, extent.height, extent.depth };
 
 	vkCmdCopyImageToBuffer(m_cmdBuffer, internal_image.GetHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, internal_buffer.GetHandle(), 1, &copy_region);
+    m_stats.copies++;
 }
 
 void CommandList_Vulkan::GenerateMipmap(Image& image, ImageLayout base_level_layout)
 {
     const ImageDesc& desc = image.GetDesc();
     auto& internal = ToInternal(&image);
+    m_stats.copies++;
 
     // Generate mipmap layout
     TextureFormatLayout layout;
@@ -716,6 +884,7 @@ void CommandList_Vulkan::BlitImage(const Image& dst, const Image& src, const Off
     blit.dstOffsets[1] = add_offset(blit.dstOffsets[0], ConvertOffset(dst_extent));
 
     vkCmdBlitImage(m_cmdBuffer, internal_src.GetHandle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, internal_dst.GetHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, ConvertSamplerFilter(filter));
+    m_stats.copies++;
 }
 
 void CommandList_Vulkan::BindIndexBuffer(const Buffer &buffer, u64 offset, const IndexBufferFormat format)
@@ -736,6 +905,7 @@ void CommandList_Vulkan::BindIndexBuffer(const Buffer &buffer, u64 offset, const
     index_buffer_binding_state.offset = offset;
     index_buffer_binding_state.format = format;
     vkCmdBindIndexBuffer(m_cmdBuffer, internal_buffer.GetHandle(), offset, (format == IndexBufferFormat::UINT16? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32));
+    m_stats.indexBufferBinds++;
 }
 
 void CommandList_Vulkan::BindVertexBuffer(uint32_t binding, const Buffer &buffer, u64 offset)
@@ -815,6 +985,16 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
 {
     QK_CORE_ASSERT((m_currentPipeline->GetLayout()->combinedLayout.descriptor_set_mask & (1u << set)) != 0)
 
+    if (m_currentPipeline->GetLayout()->combinedLayout.bindless_set_mask & (1u << set))
+    {
+        // Nothing to hash or allocate, the global set stays valid for every pipeline using it
+        VkDescriptorSet bindless_set = m_device->GetBindlessSet().getSet();
+        vkCmdBindDescriptorSets(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE),
+            m_currentPipeline->GetLayout()->handle, set, 1, &bindless_set, 0, nullptr);
+        m_currentSets[set] = bindless_set;
+        return;
+    }
+
     auto& set_layout = m_currentPipeline->GetLayout()->combinedLayout.descriptor_set_layouts[set];
     auto& bindings = m_bindingState.descriptorBindings[set];
     auto& cookies = m_bindingState.cookies[set];
@@ -866,6 +1046,15 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
             }
             break;
         }
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        {
+            for (size_t i = 0; i < b.descriptorCount; ++i) {
+                h.pointer(bindings[b.binding + i].image.imageView);
+                h.u32(bindings[b.binding + i].image.imageLayout);
+                QK_CORE_ASSERT(bindings[b.binding + i].image.imageView != VK_NULL_HANDLE)
+            }
+            break;
+        }
         case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE: // separate image
         {
             for (size_t i = 0; i < b.descriptorCount; ++i) {
@@ -889,13 +1078,19 @@ void CommandList_Vulkan::FlushDescriptorSet(uint32_t set)
         }
     }
     util::Hash hash = h.get();
-    auto allocated = m_currentPipeline->GetLayout()->setAllocators[set]->RequestDescriptorSet(hash);
+    auto updata_template = m_currentPipeline->GetLayout()->updateTemplate[set];
+    QK_CORE_ASSERT(updata_template)
+
+    // The descriptor set is rebuilt by the allocator if it was not cached
+    auto allocated = m_currentPipeline->GetLayout()->setAllocators[set]->RequestDescriptorSet(hash, updata_template, bindings);
+    m_stats.descriptorSetRequests++;
 
-    // The descriptor set was not successfully cached, rebuild
     if (!allocated.second) {
-        auto updata_template = m_currentPipeline->GetLayout()->updateTemplate[set];
-        QK_CORE_ASSERT(updata_template)
-        vkUpdateDescriptorSetWithTemplate(m_device->vkDevice, allocated.first, updata_template, bindings);
+        m_stats.descriptorSetUpdates++;
+    }
+    else
+    {
+        m_stats.descriptorSetCacheHits++;
     }
 
     vkCmdBindDescriptorSets(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE),
@@ -926,6 +1121,7 @@ void CommandList_Vulkan::RebindDescriptorSet(uint32_t set)
 
     vkCmdBindDescriptorSets(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE),
         m_currentPipeline->GetLayout()->handle, set, 1, &m_currentSets[set], num_dynamic_offsets, dynamic_offsets);
+    m_stats.descriptorSetRebinds++;
 }
 
 void CommandList_Vulkan::DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance)
@@ -935,6 +1131,10 @@ void CommandList_Vulkan::DrawIndexed(uint32_t index_count, uint32_t instance_cou
     // Flush render state : update descriptor sets and bind vertex buffers 
     FlushRenderState();
     vkCmdDrawIndexed(m_cmdBuffer, index_count, instance_count, first_index, vertex_offset, first_instance);
+
+    m_stats.draws++;
+    m_stats.instances += instance_count;
+    m_stats.primitives += (uint64_t)index_count * instance_count;
 }
 
 void CommandList_Vulkan::Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
@@ -942,15 +1142,71 @@ void CommandList_Vulkan::Draw(uint32_t vertex_count, uint32_t instance_count, ui
     // Flush render state : update descriptor sets and bind vertex buffers 
     FlushRenderState();
     vkCmdDraw(m_cmdBuffer, vertex_count, instance_count, first_vertex, first_instance);
+
+    m_stats.draws++;
+    m_stats.instances += instance_count;
+    m_stats.primitives += (uint64_t)vertex_count * instance_count;
 }
 
-void CommandList_Vulkan::FlushRenderState()
+void CommandList_Vulkan::DrawIndexedIndirect(const Buffer& buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
+{
+    QK_CORE_ASSERT(m_bindingState.indexBufferBindingState.buffer != VK_NULL_HANDLE)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+    QK_CORE_ASSERT(draw_count <= 1 || m_device->GetDeviceFeatures().multiDrawIndirect)
+
+    FlushRenderState();
+    vkCmdDrawIndexedIndirect(m_cmdBuffer, ToInternal(&buffer).GetHandle(), offset, draw_count, stride);
+
+    m_stats.draws++;
+    m_stats.indirectDraws++;
+}
+
+void CommandList_Vulkan::DrawIndexedIndirectCount(const Buffer& buffer, uint64_t offset, const Buffer& count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+    QK_CORE_ASSERT(m_bindingState.indexBufferBindingState.buffer != VK_NULL_HANDLE)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+    QK_CORE_ASSERT(count_buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+    QK_CORE_ASSERT(m_device->GetDeviceFeatures().drawIndirectCount)
+
+    FlushRenderState();
+    vkCmdDrawIndexedIndirectCount(m_cmdBuffer, ToInternal(&buffer).GetHandle(), offset,
+        ToInternal(&count_buffer).GetHandle(), count_offset, max_draw_count, stride);
+
+    m_stats.draws++;
+    m_stats.indirectDraws++;
+}
+
+void CommandList_Vulkan::Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+    QK_CORE_ASSERT(state != CommandListState::IN_RENDERPASS)
+    QK_CORE_ASSERT(m_currentPipeline && m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::COMPUTE)
+
+    FlushComputeState();
+    vkCmdDispatch(m_cmdBuffer, group_count_x, group_count_y, group_count_z);
+    m_stats.dispatches++;
+}
+
+void CommandList_Vulkan::DispatchIndirect(const Buffer& buffer, uint64_t offset)
+{
+    QK_CORE_ASSERT(state != CommandListState::IN_RENDERPASS)
+    QK_CORE_ASSERT(m_currentPipeline && m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::COMPUTE)
+    QK_CORE_ASSERT(buffer.GetDesc().usageBits & BUFFER_USAGE_INDIRECT_BIT)
+
+    FlushComputeState();
+    vkCmdDispatchIndirect(m_cmdBuffer, ToInternal(&buffer).GetHandle(), offset);
+    m_stats.dispatches++;
+}
+
+void CommandList_Vulkan::FlushComputeState()
 {
     QK_CORE_ASSERT(m_currentPipeline)
     
     const PipeLineLayout* pipeline_layout = m_currentPipeline->GetLayout();
     if (GetAndClearDirtyFlags(COMMAND_LIST_DIRTY_PIPELINE_BIT))
+    {
         vkCmdBindPipeline(m_cmdBuffer, (m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC ? VK_PIPELINE_BIND_POINT_GRAPHICS : VK_PIPELINE_BIND_POINT_COMPUTE), m_currentPipeline->GetHandle());
+        m_stats.pipelineBinds++;
+    }
        
     // 1. flush dirty descriptor set
     uint32_t sets_need_update = pipeline_layout->combinedLayout.descriptor_set_mask & m_dirtySetMask;
@@ -974,8 +1230,15 @@ void CommandList_Vulkan::FlushRenderState()
 		{
 			QK_CORE_ASSERT(range.offset == 0);
 			vkCmdPushConstants(m_cmdBuffer, pipeline_layout->handle, range.stageFlags, 0, range.size, m_bindingState.pushConstantData);
+			m_stats.pushConstantUpdates++;
 		}
 	}
+}
+
+void CommandList_Vulkan::FlushRenderState()
+{
+    QK_CORE_ASSERT(m_currentPipeline && m_currentPipeline->GetBindingPoint() == PipeLineBindingPoint::GRAPHIC)
+    FlushComputeState();
 
     // 3. flush dirty vertex buffer
     auto& vertex_buffer_bindings = m_bindingState.vertexBufferBindingState;
@@ -986,6 +1249,7 @@ void CommandList_Vulkan::FlushRenderState()
             QK_CORE_ASSERT(vertex_buffer_bindings.buffers[binding] != VK_NULL_HANDLE)
 #endif
         vkCmdBindVertexBuffers(m_cmdBuffer, first_binding, count, vertex_buffer_bindings.buffers + first_binding, vertex_buffer_bindings.offsets + first_binding);
+        m_stats.vertexBufferBinds++;
     });
     
     m_dirtyVertexBufferMask &= ~update_vbo_mask;
@@ -54,7 +54,7 @@ class CommandList_Vulkan final : public CommandList {
 public:
     CommandListState state = CommandListState::READY_FOR_RECORDING;
 
-    CommandList_Vulkan(Device_Vulkan* device, QueueType type_);
+    CommandList_Vulkan(Device_Vulkan* device, QueueType type_, bool secondary = false);
     ~CommandList_Vulkan();
 
     // graphics api
@@ -64,15 +64,21 @@ public:
     void BindStorageBuffer(uint32_t set, uint32_t binding, const Buffer& buffer, uint64_t offset, uint64_t size) override final;
     void BindImage(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout) override final;
     void BindImageSampler(uint32_t set, uint32_t binding, const ImageView& image_view, ImageLayout layout, const Sampler& sampler) override final;
+    void BindStorageImage(uint32_t set, uint32_t binding, const ImageView& image_view) override final;
     void BindVertexBuffer(uint32_t binding, const Buffer& buffer, u64 offset) override final;
     void BindIndexBuffer(const Buffer& buffer, u64 offset, const IndexBufferFormat format) override final;
     void BindSampler(uint32_t set, uint32_t binding, const Sampler& sampler) override final;
     void Draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance) override final;
     void DrawIndexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, uint32_t vertex_offset, uint32_t first_instance) override final;
+    void DrawIndexedIndirect(const Buffer& buffer, uint64_t offset, uint32_t draw_count, uint32_t stride) override final;
+    void DrawIndexedIndirectCount(const Buffer& buffer, uint64_t offset, const Buffer& count_buffer, uint64_t count_offset, uint32_t max_draw_count, uint32_t stride) override final;
+    void Dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z) override final;
+    void DispatchIndirect(const Buffer& buffer, uint64_t offset) override final;
     void SetViewPort(const Viewport& viewport) override final;
     void SetScissor(const Scissor& scissor) override final;
     void PipeLineBarriers(const PipelineMemoryBarrier* memoryBarriers, uint32_t memoryBarriersCount, const PipelineImageBarrier* imageBarriers, uint32_t iamgeBarriersCount, const PipelineBufferBarrier* bufferBarriers, uint32_t bufferBarriersCount) override final;
-    void BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo) override final;
+    void BeginRenderPass(const RenderPassInfo& renderPassInfo, const FrameBufferInfo& frameBufferInfo, RenderPassContents contents = RenderPassContents::INLINE) override final;
+    void ExecuteCommandLists(CommandList* const* cmds, uint32_t count) override final;
     void EndRenderPass() override final;
     void CopyImageToBuffer(const Buffer& buffer, const Image& image, uint64_t buffer_offset, const Offset3D& offset, const Extent3D& extent, uint32_t row_pitch, uint32_t slice_pitch, const ImageCopySubresourceRange& subresouce) override final;
     void GenerateMipmap(Image& image, ImageLayout base_level_layout) override final;
@@ -91,8 +97,23 @@ public:
     void EndRegion() override final;
 
     ///////////////////////// Vulkan specific /////////////////////////
+    // A region timed with a pair of timestamp queries: query index 2 * i and 2 * i + 1 of the reserved block
+    struct TimestampRegion
+    {
+        std::string name;
+        uint32_t parent = ~0u;  // index of the enclosing region
+        uint32_t depth = 0;
+    };
+
     void ResetAndBeginCmdBuffer();
+    void ResetAndBeginSecondaryCmdBuffer(const CommandList_Vulkan& primary); // continues the render pass of primary
+    void SetTimestampQueries(VkQueryPool pool, uint32_t base, uint32_t count);
+    uint32_t GetTimestampQueryBase() const { return m_timestampQueryBase; }
+    uint32_t GetTimestampQueryUsed() const { return (uint32_t)m_timestampRegions.size() * 2; }
+    const std::vector<TimestampRegion>& GetTimestampRegions() const { return m_timestampRegions; }
     bool IsWaitingForSwapChainImage() const { return m_waitForSwapchainImage; }
+    void SetSignalling(bool signal) { m_signalling = signal; }
+    bool IsSignalling() const { return m_signalling; }    // submitted with its complete semaphore signaled
 
     const VkCommandBuffer GetHandle() const { return m_cmdBuffer; }
     const VkSemaphore GetCmdCompleteSemaphore() const { return m_cmdCompleteSemaphore; }
@@ -101,7 +122,8 @@ public:
 private:
     void SetPipelineLayout(const PipeLineLayout* layout);
     void FlushDescriptorSet(uint32_t set);
-    void FlushRenderState();
+    void FlushComputeState();   // pipeline, descriptor sets and push constants
+    void FlushRenderState();    // compute state and vertex buffers
     void RebindDescriptorSet(uint32_t set);  // rebind if only the buffer offset changed
     void ResetBindingState();
     void SetDirty(CommandListDirtyFlagBits flags) { m_dirtyMask |= flags; }
@@ -120,10 +142,13 @@ private:
     std::vector<VkBufferMemoryBarrier2> m_bufferBarriers;
     bool m_waitForSwapchainImage = false;
     uint32_t m_swapChainWaitStages = 0;
+    bool m_signalling = false;
 
     // Rendering state 
     const PipeLine_Vulkan* m_currentPipeline = nullptr;
     RenderPassInfo m_currentRenderPassInfo = {};
+    RenderPassContents m_renderPassContents = RenderPassContents::INLINE;
+    std::vector<VkCommandBuffer> m_secondaryCmdBuffers;
     VkDescriptorSet m_currentSets[DESCRIPTOR_SET_MAX_NUM] = {};
     VkViewport m_viewport = {};
     VkRect2D m_scissor = {};
@@ -135,6 +160,13 @@ private:
     uint32_t m_dirtyVertexBufferMask = 0;
     uint32_t m_dirtyMask = ~0u;
     
+    // gpu timestamps
+    VkQueryPool m_timestampPool = VK_NULL_HANDLE;
+    uint32_t m_timestampQueryBase = 0;
+    uint32_t m_timestampQueryCount = 0;
+    std::vector<TimestampRegion> m_timestampRegions;
+    std::vector<uint32_t> m_regionStack;   // ~0u for regions which are not timed
+
     // buffer blocks
     BufferBlock m_ubo_block;
     BufferBlock m_vbo_block;
@@ -62,6 +62,10 @@ constexpr VkFormat ConvertDataFormat(DataFormat value)
         return VK_FORMAT_BC7_UNORM_BLOCK;
     case DataFormat::BC3_UNORM_BLOCK:
         return VK_FORMAT_BC3_UNORM_BLOCK;
+    case DataFormat::BC1_RGBA_UNORM_BLOCK:
+        return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case DataFormat::BC5_UNORM_BLOCK:
+        return VK_FORMAT_BC5_UNORM_BLOCK;
     case DataFormat::R16G16B16A16_SFLOAT:
         return VK_FORMAT_R16G16B16A16_SFLOAT;
     case DataFormat::R16G16B16_SFLOAT:
@@ -240,6 +240,13 @@ void VulkanContext::CreateLogicalDevice()
     deviceFeatures.textureCompressionBC = features2.features.textureCompressionBC;
     deviceFeatures.textureCompressionASTC_LDR = features2.features.textureCompressionASTC_LDR;;
     deviceFeatures.textureCompressionETC2 = features2.features.textureCompressionETC2;
+    deviceFeatures.multiDrawIndirect = features2.features.multiDrawIndirect;
+    deviceFeatures.drawIndirectCount = features12.drawIndirectCount;
+    deviceFeatures.bindless = features12.runtimeDescriptorArray &&
+        features12.descriptorBindingPartiallyBound &&
+        features12.descriptorBindingSampledImageUpdateAfterBind &&
+        features12.descriptorBindingUpdateUnusedWhilePending &&
+        features12.shaderSampledImageArrayNonUniformIndexing;
 }
 
 void VulkanContext::SelectPhysicalDevice()
@@ -685,6 +692,8 @@ void VulkanContext::InitExtendFunctions()
         logicalDevice, "vkCmdBlitImage2KHR");
     extendFunction.pVkCmdPipelineBarrier2KHR = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(
         logicalDevice, "vkCmdPipelineBarrier2KHR");
+    extendFunction.pVkCmdWriteTimestamp2KHR = (PFN_vkCmdWriteTimestamp2KHR)vkGetDeviceProcAddr(
+        logicalDevice, "vkCmdWriteTimestamp2KHR");
     extendFunction.pVkCmdBeginRenderingKHR = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(
         logicalDevice, "vkCmdBeginRenderingKHR");
     extendFunction.pVkCmdEndRenderingKHR = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(
@@ -73,6 +73,7 @@ public:
         PFN_vkQueueSubmit2KHR pVkQueueSubmit2KHR;
         PFN_vkCmdBlitImage2KHR pVkCmdBlitImage2KHR;
         PFN_vkCmdPipelineBarrier2KHR pVkCmdPipelineBarrier2KHR;
+        PFN_vkCmdWriteTimestamp2KHR pVkCmdWriteTimestamp2KHR;
         PFN_vkCmdBeginRenderingKHR pVkCmdBeginRenderingKHR;
         PFN_vkCmdEndRenderingKHR pVkCmdEndRenderingKHR;
         PFN_vkSetDebugUtilsObjectNameEXT pVkSetDebugUtilsObjectNameEXT;
@@ -27,6 +27,7 @@ DescriptorSetAllocator::DescriptorSetAllocator(Device_Vulkan* device, const Desc
 
 void DescriptorSetAllocator::BeginFrame()
 {
+	std::lock_guard<std::mutex> lock(m_lock);
 	m_setNodes.BeginFrame();
 }
 
@@ -47,46 +48,50 @@ DescriptorSetAllocator::~DescriptorSetAllocator()
 	QK_CORE_LOGT_TAG("RHI", "Desctipor set allocator destroyed");
 }
 
-std::pair<VkDescriptorSet, bool> DescriptorSetAllocator::RequestDescriptorSet(uint64_t hash)
+std::pair<VkDescriptorSet, bool> DescriptorSetAllocator::RequestDescriptorSet(uint64_t hash, VkDescriptorUpdateTemplate update_template, const void* data)
 {
+	std::lock_guard<std::mutex> lock(m_lock);
+
 	auto* node = m_setNodes.request(hash);
 	if (node)
 		return { node->set, true };
 
 	node = m_setNodes.request_vacant(hash);
-	if (node)
-		return { node->set, false };
-
-	// need to create new descriptor pool and sets
-	VkDescriptorPool pool;
-	VkDescriptorPoolCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-	info.maxSets = s_num_sets_per_pool;
-	info.poolSizeCount = (uint32_t)m_pool_sizes.size();
-	info.pPoolSizes = m_pool_sizes.data();
-
-	if (vkCreateDescriptorPool(m_device->vkDevice, &info, nullptr, &pool) != VK_SUCCESS)
+	if (!node)
 	{
-		QK_CORE_VERIFY(0, "Failed to create descriptor pool.");
-		return { VK_NULL_HANDLE, false };
+		// need to create new descriptor pool and sets
+		VkDescriptorPool pool;
+		VkDescriptorPoolCreateInfo info = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+		info.maxSets = s_num_sets_per_pool;
+		info.poolSizeCount = (uint32_t)m_pool_sizes.size();
+		info.pPoolSizes = m_pool_sizes.data();
+
+		if (vkCreateDescriptorPool(m_device->vkDevice, &info, nullptr, &pool) != VK_SUCCESS)
+		{
+			QK_CORE_VERIFY(0, "Failed to create descriptor pool.");
+			return { VK_NULL_HANDLE, false };
+		}
+
+		VkDescriptorSet sets[s_num_sets_per_pool];
+		VkDescriptorSetLayout layouts[s_num_sets_per_pool];
+		std::fill(std::begin(layouts), std::end(layouts), m_layout_handle);
+
+		VkDescriptorSetAllocateInfo alloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+		alloc.descriptorPool = pool;
+		alloc.descriptorSetCount = s_num_sets_per_pool;
+		alloc.pSetLayouts = layouts;
+
+		if (vkAllocateDescriptorSets(m_device->vkDevice, &alloc, sets) != VK_SUCCESS)
+			QK_CORE_VERIFY(0, "Failed to allocate descriptor sets.");
+		m_pools.push_back(pool);
+
+		for (auto set : sets)
+			m_setNodes.make_vacant(set);
+
+		node = m_setNodes.request_vacant(hash);
 	}
 
-	VkDescriptorSet sets[s_num_sets_per_pool];
-	VkDescriptorSetLayout layouts[s_num_sets_per_pool];
-	std::fill(std::begin(layouts), std::end(layouts), m_layout_handle);
-
-	VkDescriptorSetAllocateInfo alloc = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-	alloc.descriptorPool = pool;
-	alloc.descriptorSetCount = s_num_sets_per_pool;
-	alloc.pSetLayouts = layouts;
-
-	if (vkAllocateDescriptorSets(m_device->vkDevice, &alloc, sets) != VK_SUCCESS)
-		QK_CORE_VERIFY(0, "Failed to allocate descriptor sets.");
-	m_pools.push_back(pool);
-
-	for (auto set : sets)
-		m_setNodes.make_vacant(set);
-
-	return { m_setNodes.request_vacant(hash)->set, false };
-
+	vkUpdateDescriptorSetWithTemplate(m_device->vkDevice, node->set, update_template, data);
+	return { node->set, false };
 }
 }
\ No newline at end of file
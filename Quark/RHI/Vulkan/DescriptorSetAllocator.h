@@ -1,7 +1,10 @@
 #pragma once
 #include "Quark/Core/Util/TemporaryHashMap.h"
+#include "Quark/Core/Util/IntrusiveHashMap.h"
 #include "Quark/RHI/Vulkan/Common_Vulkan.h"
 
+#include <mutex>
+
 namespace quark::rhi {
 
 struct DescriptorSetLayout {
@@ -27,7 +30,8 @@ struct DescriptorSetLayout {
 //* A temporary hashmap which keeps track of which descriptor sets have been requested recently. 
 //  This allows us to reuse descriptor sets directly. In the ideal case, we almost never actually need to call vkUpdateDescriptorSets. 
 //  We end up with hash -> get VkDescriptorSet -> vkCmdBindDescriptorSets.
-class DescriptorSetAllocator {
+// Requests are thread safe, command lists of several threads can share an allocator.
+class DescriptorSetAllocator : public util::IntrusiveHashMapEnabled<DescriptorSetAllocator> {
 public:
     static constexpr uint32_t s_ring_size = 8;
     static constexpr uint32_t s_num_sets_per_pool = 64;
@@ -36,7 +40,9 @@ public:
 
     void BeginFrame();
     VkDescriptorSetLayout GetLayout() const { return m_layout_handle; }
-    std::pair<VkDescriptorSet, bool> RequestDescriptorSet(uint64_t hash);
+    // Returns the set and whether it was cached. A set which was not cached is written with the update template
+    // before the lock is released, so another thread can never bind it half written.
+    std::pair<VkDescriptorSet, bool> RequestDescriptorSet(uint64_t hash, VkDescriptorUpdateTemplate update_template, const void* data);
 
 private:
     Device_Vulkan* m_device;
@@ -51,5 +57,6 @@ private:
         VkDescriptorSet set;
     };
     util::TemporaryHashmap<DescriptorSetNode, s_ring_size, true> m_setNodes;
+    std::mutex m_lock;
 };
 }
\ No newline at end of file
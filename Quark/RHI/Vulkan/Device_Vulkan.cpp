@@ -4,12 +4,14 @@
 #include "Quark/Core/Application.h"
 #include "Quark/Core/Math/Util.h"
 #include "Quark/Core/Util/Hash.h"
+#include "Quark/Core/Profiler.h"
 #include "Quark/Core/FileSystem.h"
 #include "Quark/Events/EventManager.h"
 #include "Quark/RHI/Vulkan/Shader_Vulkan.h"
 
+#include <numeric>
+
 #define LOCK() std::lock_guard<std::mutex> _holder_##__COUNTER__{m_lock.lock}
-#define LOCK_CACHE() std::lock_guard<std::mutex> _holder_##__COUNTER__{m_lock.read_only_cache_lock} //TODO: make this a read - write lock
 #define DRAIN_FRAME_LOCK() \
 	std::unique_lock<std::mutex> _holder{m_lock.lock}; \
 	m_lock.cond.wait(_holder, [&]() { \
@@ -18,6 +20,10 @@
 
 namespace quark::rhi {
 
+// Every command list on a graphics/compute queue gets a block of timestamp queries for its regions
+static constexpr uint32_t TIMESTAMP_QUERIES_PER_FRAME = 4096;
+static constexpr uint32_t TIMESTAMP_QUERIES_PER_CMD_LIST = 256;
+
 static void request_block(Device& device, BufferBlock& block, VkDeviceSize size,
     BufferPool& pool, std::vector<BufferBlock>& recycle)
 {
@@ -88,8 +94,12 @@ void Device_Vulkan::CommandQueue::init(Device_Vulkan *device, QueueType type)
 
 void Device_Vulkan::CommandQueue::submit(VkFence fence)
 {
+    QK_PROFILE_SCOPE("CommandQueue::submit");
     QK_CORE_ASSERT(!submissions.empty() || fence != VK_NULL_HANDLE)
 
+    // Anything submitted from here on may consume uploaded data, so kick off the pending upload batch first
+    device->copyAllocator.flush();
+
     std::vector<VkSubmitInfo2> submit_infos(submissions.size());
     for (size_t i = 0; i < submissions.size(); ++i) 
     {
@@ -130,7 +140,15 @@ void PerFrameContext::init(Device_Vulkan *device)
         fence_create_info.pNext = nullptr;
         vkCreateFence(device->vkDevice, &fence_create_info, nullptr, &queueFences[i]);
     }
-   
+
+    // Create timestamp query pool for gpu profiling
+    if (device->GetVulkanContext().gpu_properties2.properties.limits.timestampComputeAndGraphics)
+    {
+        VkQueryPoolCreateInfo query_pool_create_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        query_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_pool_create_info.queryCount = TIMESTAMP_QUERIES_PER_FRAME;
+        VK_CHECK(vkCreateQueryPool(device->vkDevice, &query_pool_create_info, nullptr, &timestampPool))
+    }
 }
 
 void PerFrameContext::clear()
@@ -150,6 +168,8 @@ void PerFrameContext::clear()
         vkDestroyPipeline(vk_device, pipeline, nullptr);
     for (auto& shaderModule_ : garbage_shaderModules)
         vkDestroyShaderModule(vk_device, shaderModule_, nullptr);
+    if (!garbage_bindlessImages.empty())
+        device->m_bindless_set.releaseImages(garbage_bindlessImages);
 
     garbage_samplers.clear();
     garbage_buffers.clear();
@@ -157,13 +177,17 @@ void PerFrameContext::clear()
     garbage_images.clear();
     garbage_pipelines.clear();
     garbage_shaderModules.clear();
+    garbage_bindlessImages.clear();
 }
 
 void PerFrameContext::begin()
 {
     // wait for in-flight fences
     if (!waitedFences.empty())
+    {
+        QK_PROFILE_SCOPE("PerFrameContext::WaitForFences");
         vkWaitForFences(device->vkDevice, (uint32_t)waitedFences.size(), waitedFences.data(), true, UINT64_MAX);
+    }
 
     if (!waitedFences.empty()) 
     {
@@ -171,8 +195,14 @@ void PerFrameContext::begin()
         waitedFences.clear();
     }
 
+    // The gpu is done with this frame, read back its timestamps before the command lists are reused
+    device->ResolveGpuTimingsNoLock(*this);
+    timestampQueryCount = 0;
+    frameIndex = device->m_frame_count;
+
     for (size_t i = 0; i < QUEUE_TYPE_MAX_ENUM; i++)
         cmdListCount[i] = 0;
+    secondaryCmdListCount = 0;
 
     // recycle buffer blocks
     for (auto& b : ubo_blocks)
@@ -208,6 +238,16 @@ void PerFrameContext::destroy()
         vkDestroyFence(device->vkDevice, queueFences[i], nullptr);
     }
 
+    for (auto* cmd : secondaryCmdLists)
+        delete cmd;
+    secondaryCmdLists.clear();
+
+    if (timestampPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(device->vkDevice, timestampPool, nullptr);
+        timestampPool = VK_NULL_HANDLE;
+    }
+
     ubo_blocks.clear();
     vbo_blocks.clear();
     staging_blocks.clear();
@@ -215,14 +255,21 @@ void PerFrameContext::destroy()
     clear();
 }
 
-void CopyCmdAllocator::init(Device_Vulkan *device)
+void CopyCmdAllocator::init(Device_Vulkan *device, VkDeviceSize ring_size)
 {
     m_device = device;
+    m_ringSize = ring_size;
 }
 
 void CopyCmdAllocator::destroy()
 {   
-    // Make sure all allocated cmd are in free list
+    // Submit everything pending and make sure all batches are in free list
+    {
+        std::scoped_lock lock(m_locker);
+        flushNoLock();
+        retireBatchesNoLock(true);
+    }
+
     vkQueueWaitIdle(m_device->m_queues[QUEUE_TYPE_ASYNC_TRANSFER].queue);
     for (auto& x : m_freeList)
     {
@@ -236,100 +283,148 @@ void CopyCmdAllocator::destroy()
     m_freeList.clear();
 }
 
-CopyCmdAllocator::CopyCmd CopyCmdAllocator::allocate(VkDeviceSize required_buffer_size)
+CopyCmdAllocator::CopyCmd CopyCmdAllocator::allocate(VkDeviceSize required_buffer_size, VkDeviceSize alignment)
 {
+    // Unlocked in submit()
+    m_locker.lock();
+
+    // Align the suballocation to the requested alignment, texel block sizes are not always a power of two
+    alignment = std::lcm(std::max<VkDeviceSize>(alignment, 1), VkDeviceSize(16));
+    auto aligned_offset = [&]() { return (m_openBatch.stageOffset + alignment - 1) / alignment * alignment; };
+
+    if (m_batchOpened && aligned_offset() + required_buffer_size > m_openBatch.stageBuffer->GetDesc().size)
+        flushNoLock(); // Staging ring is full, kick off what we have
+
+    if (!m_batchOpened)
+        beginBatchNoLock(required_buffer_size);
+
     CopyCmd cmd;
+    cmd.transferCmdBuffer = m_openBatch.transferCmdBuffer;
+    cmd.transitionCmdBuffer = m_openBatch.transitionCmdBuffer;
+    cmd.stageBuffer = m_openBatch.stageBuffer;
+    cmd.stageOffset = aligned_offset();
+    cmd.stageSize = required_buffer_size;
+    cmd.stageMappedData = static_cast<uint8_t*>(m_openBatch.stageBuffer->GetMappedDataPtr()) + cmd.stageOffset;
+    cmd.batchId = m_openBatch.id;
+
+    m_openBatch.stageOffset = cmd.stageOffset + required_buffer_size;
+    return cmd;
+}
 
-    // Try to find a suitable staging buffer in free list
-    m_locker.lock();
-    for (size_t i = 0; i < m_freeList.size(); ++i) 
-    {
-        if (m_freeList[i].stageBuffer->GetDesc().size >= required_buffer_size) 
-        {
-            if (vkGetFenceStatus(m_device->vkDevice, m_freeList[i].fence) == VK_SUCCESS)
-            {
-                cmd = std::move(m_freeList[i]);
-                std::swap(m_freeList[i], m_freeList.back());
-                m_freeList.pop_back();
-                break;
-            }
-        }
-    }
+void CopyCmdAllocator::submit(CopyCmd cmd)
+{
+    QK_CORE_ASSERT(m_batchOpened && cmd.batchId == m_openBatch.id)
+
+    m_openBatch.uploadCount++;
+    m_openBatch.uploadBytes += cmd.stageSize;
     m_locker.unlock();
+}
+
+void CopyCmdAllocator::beginBatchNoLock(VkDeviceSize required_buffer_size)
+{
+    QK_CORE_ASSERT(!m_batchOpened)
 
-    if (!cmd.isValid()) // No suitable staging buffer founded
+    retireBatchesNoLock(false);
+
+    // Try to find a finished batch in free list
+    Batch batch;
+    if (!m_freeList.empty())
+    {
+        batch = std::move(m_freeList.back());
+        m_freeList.pop_back();
+    }
+    else
     { 
         // Create command pool
         VkCommandPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
         poolInfo.queueFamilyIndex = m_device->GetVulkanContext().transferQueueIndex;
-        VK_CHECK(vkCreateCommandPool(m_device->vkDevice, &poolInfo, nullptr, &cmd.transferCmdPool))
+        VK_CHECK(vkCreateCommandPool(m_device->vkDevice, &poolInfo, nullptr, &batch.transferCmdPool))
 
         poolInfo.queueFamilyIndex = m_device->GetVulkanContext().graphicQueueIndex;
-        VK_CHECK(vkCreateCommandPool(m_device->vkDevice, &poolInfo, nullptr, &cmd.transitionCmdPool))
+        VK_CHECK(vkCreateCommandPool(m_device->vkDevice, &poolInfo, nullptr, &batch.transitionCmdPool))
 
         // Allocate command buffer
         VkCommandBufferAllocateInfo commandBufferInfo = {};
         commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         commandBufferInfo.commandBufferCount = 1;
         commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        commandBufferInfo.commandPool = cmd.transferCmdPool;
-        VK_CHECK(vkAllocateCommandBuffers(m_device->vkDevice, &commandBufferInfo, &cmd.transferCmdBuffer))
+        commandBufferInfo.commandPool = batch.transferCmdPool;
+        VK_CHECK(vkAllocateCommandBuffers(m_device->vkDevice, &commandBufferInfo, &batch.transferCmdBuffer))
 
-        commandBufferInfo.commandPool = cmd.transitionCmdPool;
-        VK_CHECK(vkAllocateCommandBuffers(m_device->vkDevice, &commandBufferInfo, &cmd.transitionCmdBuffer))
+        commandBufferInfo.commandPool = batch.transitionCmdPool;
+        VK_CHECK(vkAllocateCommandBuffers(m_device->vkDevice, &commandBufferInfo, &batch.transitionCmdBuffer))
 
         // Create fence
         VkFenceCreateInfo fenceInfo = {};
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        VK_CHECK(vkCreateFence(m_device->vkDevice, &fenceInfo, nullptr, &cmd.fence))
+        VK_CHECK(vkCreateFence(m_device->vkDevice, &fenceInfo, nullptr, &batch.fence))
 
         // Create Semaphores
         VkSemaphoreCreateInfo semaphoreInfo = {};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        VK_CHECK(vkCreateSemaphore(m_device->vkDevice, &semaphoreInfo, nullptr, &cmd.semaphores[0]));
-        VK_CHECK(vkCreateSemaphore(m_device->vkDevice, &semaphoreInfo, nullptr, &cmd.semaphores[1]));
+        VK_CHECK(vkCreateSemaphore(m_device->vkDevice, &semaphoreInfo, nullptr, &batch.semaphores[0]));
+        VK_CHECK(vkCreateSemaphore(m_device->vkDevice, &semaphoreInfo, nullptr, &batch.semaphores[1]));
+    }
 
-        // Create staging buffer
+    // (Re)create the staging ring if it can't hold the upload, oversized uploads get a dedicated ring
+    if (!batch.stageBuffer || batch.stageBuffer->GetDesc().size < required_buffer_size)
+    {
         BufferDesc bufferDesc;
         bufferDesc.domain = BufferMemoryDomain::CPU;
-        bufferDesc.size = math::GetNextPowerOfTwo(required_buffer_size);
-        bufferDesc.size = std::max(bufferDesc.size, uint64_t(65536));
+        bufferDesc.size = std::max(m_ringSize, math::GetNextPowerOfTwo(required_buffer_size));
         bufferDesc.usageBits = BUFFER_USAGE_TRANSFER_FROM_BIT;
-        cmd.stageBuffer = m_device->CreateBuffer(bufferDesc);
-        auto& internal = ToInternal(cmd.stageBuffer.get());
+        batch.stageBuffer = m_device->CreateBuffer(bufferDesc);
+        auto& internal = ToInternal(batch.stageBuffer.get());
         internal.SetInternalSynced();
-        m_device->SetName(cmd.stageBuffer, "CopyCmdAllocator staging buffer");
+        m_device->SetName(batch.stageBuffer, "CopyCmdAllocator staging ring");
     }
 
     // Begin command buffer in valid state:
-	VK_CHECK(vkResetCommandPool(m_device->vkDevice, cmd.transferCmdPool, 0))
-    VK_CHECK(vkResetCommandPool(m_device->vkDevice, cmd.transitionCmdPool, 0))
+	VK_CHECK(vkResetCommandPool(m_device->vkDevice, batch.transferCmdPool, 0))
+    VK_CHECK(vkResetCommandPool(m_device->vkDevice, batch.transitionCmdPool, 0))
 
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
     beginInfo.pInheritanceInfo = nullptr;
-    VK_CHECK(vkBeginCommandBuffer(cmd.transferCmdBuffer, &beginInfo))
-    VK_CHECK(vkBeginCommandBuffer(cmd.transitionCmdBuffer, &beginInfo))
+    VK_CHECK(vkBeginCommandBuffer(batch.transferCmdBuffer, &beginInfo))
+    VK_CHECK(vkBeginCommandBuffer(batch.transitionCmdBuffer, &beginInfo))
 
     // Reset fence
-    VK_CHECK(vkResetFences(m_device->vkDevice, 1, &cmd.fence))
-    return cmd;
+    VK_CHECK(vkResetFences(m_device->vkDevice, 1, &batch.fence))
+
+    batch.id = m_nextBatchId++;
+    batch.stageOffset = 0;
+    batch.uploadCount = 0;
+    batch.uploadBytes = 0;
+
+    m_openBatch = std::move(batch);
+    m_batchOpened = true;
 }
 
-void CopyCmdAllocator::submit(CopyCmd cmd)
+uint64_t CopyCmdAllocator::flush()
 {
-    VK_CHECK(vkEndCommandBuffer(cmd.transferCmdBuffer))
-    VK_CHECK(vkEndCommandBuffer(cmd.transitionCmdBuffer))
+    std::scoped_lock lock(m_locker);
+    return flushNoLock();
+}
+
+uint64_t CopyCmdAllocator::flushNoLock()
+{
+    if (!m_batchOpened)
+        return m_nextBatchId - 1; // Nothing recorded, the last submitted batch is the one to wait for
+
+    Batch& batch = m_openBatch;
+    VK_CHECK(vkEndCommandBuffer(batch.transferCmdBuffer))
+    VK_CHECK(vkEndCommandBuffer(batch.transitionCmdBuffer))
 
     VkSubmitInfo2 submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
 
     VkCommandBufferSubmitInfo cbSubmitInfo = {};
     cbSubmitInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
-    cbSubmitInfo.commandBuffer = cmd.transferCmdBuffer;
+    cbSubmitInfo.commandBuffer = batch.transferCmdBuffer;
 
     VkSemaphoreSubmitInfo signalSemaphoreInfo = {};
     signalSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
@@ -339,8 +434,8 @@ void CopyCmdAllocator::submit(CopyCmd cmd)
 
     // Submit to transfer queue
     {
-        cbSubmitInfo.commandBuffer = cmd.transferCmdBuffer;
-        signalSemaphoreInfo.semaphore = cmd.semaphores[0]; // signal for graphics queue
+        cbSubmitInfo.commandBuffer = batch.transferCmdBuffer;
+        signalSemaphoreInfo.semaphore = batch.semaphores[0]; // signal for graphics queue
         signalSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
         submitInfo.commandBufferInfoCount = 1;
@@ -355,11 +450,11 @@ void CopyCmdAllocator::submit(CopyCmd cmd)
 
     // Submit to graphics queue
     {
-        waitSemaphoreInfo.semaphore = cmd.semaphores[0]; // wait for copy queue
+        waitSemaphoreInfo.semaphore = batch.semaphores[0]; // wait for copy queue
         waitSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
-        cbSubmitInfo.commandBuffer = cmd.transitionCmdBuffer;
-        signalSemaphoreInfo.semaphore = cmd.semaphores[1]; // signal for compute queue
+        cbSubmitInfo.commandBuffer = batch.transitionCmdBuffer;
+        signalSemaphoreInfo.semaphore = batch.semaphores[1]; // signal for compute queue
         signalSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
         submitInfo.waitSemaphoreInfoCount = 1;
@@ -377,7 +472,7 @@ void CopyCmdAllocator::submit(CopyCmd cmd)
     // insert semaphore to compute queue to make sure the copy and transition is done
     // this must be final submit in this function because it will also signal a fence for state tracking by CPU!
 	{
-		waitSemaphoreInfo.semaphore = cmd.semaphores[1]; // wait for graphics queue
+		waitSemaphoreInfo.semaphore = batch.semaphores[1]; // wait for graphics queue
 		waitSemaphoreInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
 
 		submitInfo.waitSemaphoreInfoCount = 1;
@@ -389,11 +484,63 @@ void CopyCmdAllocator::submit(CopyCmd cmd)
 
 		std::scoped_lock lock(m_device->m_queues[QUEUE_TYPE_ASYNC_COMPUTE].locker);
 		m_device->GetVulkanContext().extendFunction.pVkQueueSubmit2KHR(
-			m_device->m_queues[QUEUE_TYPE_ASYNC_COMPUTE].queue, 1, &submitInfo, cmd.fence);
+			m_device->m_queues[QUEUE_TYPE_ASYNC_COMPUTE].queue, 1, &submitInfo, batch.fence);
 	}
 
+    batch.submitTime = std::chrono::steady_clock::now();
+    m_stats.submittedBatches++;
+    m_stats.uploadCount += batch.uploadCount;
+
+    uint64_t id = batch.id;
+    m_inFlight.push_back(std::move(batch));
+    m_openBatch = Batch();
+    m_batchOpened = false;
+
+    return id;
+}
+
+void CopyCmdAllocator::retireBatchesNoLock(bool wait)
+{
+    // Batches complete in submission order, stop at the first one still in flight
+    size_t retired = 0;
+    for (; retired < m_inFlight.size(); retired++)
+    {
+        Batch& batch = m_inFlight[retired];
+        if (wait)
+            VK_CHECK(vkWaitForFences(m_device->vkDevice, 1, &batch.fence, VK_TRUE, UINT64_MAX))
+        else if (vkGetFenceStatus(m_device->vkDevice, batch.fence) != VK_SUCCESS)
+            break;
+
+        // Completion is observed on the CPU, so the throughput is a lower bound of the real one
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch.submitTime).count();
+        m_stats.completedBatches++;
+        m_stats.uploadedBytes += batch.uploadBytes;
+        m_stats.busySeconds += seconds;
+        if (seconds > 0.0)
+            m_stats.lastBatchThroughputMBs = (batch.uploadBytes / (1024.0 * 1024.0)) / seconds;
+
+        m_completedBatchId = batch.id;
+        m_freeList.push_back(std::move(batch));
+    }
+
+    m_inFlight.erase(m_inFlight.begin(), m_inFlight.begin() + retired);
+}
+
+bool CopyCmdAllocator::isBatchComplete(uint64_t batch_id)
+{
     std::scoped_lock lock(m_locker);
-    m_freeList.push_back(cmd);
+    if (batch_id <= m_completedBatchId)
+        return true;
+
+    retireBatchesNoLock(false);
+    return batch_id <= m_completedBatchId;
+}
+
+UploadStats CopyCmdAllocator::getStats()
+{
+    std::scoped_lock lock(m_locker);
+    retireBatchesNoLock(false);
+    return m_stats;
 }
 
 void Device_Vulkan::OnWindowResize(const WindowResizeEvent &event)
@@ -420,6 +567,7 @@ Device_Vulkan::Device_Vulkan(const DeviceConfig& config)
 
     // store device properties in public interface
     m_properties.limits.minUniformBufferOffsetAlignment = m_vulkan_context->gpu_properties2.properties.limits.minUniformBufferOffsetAlignment;
+    m_timestamp_period_ns = m_vulkan_context->gpu_properties2.properties.limits.timestampPeriod;
 
     // create per-frame data
     m_frames.resize(config.framesInFlight);
@@ -446,13 +594,16 @@ Device_Vulkan::Device_Vulkan(const DeviceConfig& config)
     m_staging_pool.Init(this, 64 * 1024, std::max<VkDeviceSize>(m_vulkan_context->gpu_properties2.properties.limits.minStorageBufferOffsetAlignment,
         std::max<VkDeviceSize>(16u, m_vulkan_context->gpu_properties2.properties.limits.optimalBufferCopyOffsetAlignment)),
         VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
-    m_ubo_pool.SetSpillRegionSize(VULKAN_MAX_UBO_SIZE);
+    m_ubo_pool.SetSpillRegionSize(std::min<VkDeviceSize>(VULKAN_MAX_UBO_SIZE, m_vulkan_context->gpu_properties2.properties.limits.maxUniformBufferRange));
     m_ubo_pool.SetMaxRetainedBlocks(64);
     m_vbo_pool.SetMaxRetainedBlocks(256);
     m_staging_pool.SetMaxRetainedBlocks(32);
 
+    if (GetDeviceFeatures().bindless)
+        m_bindless_set.init(this);
+
     // register callback functions
-    EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event); });
+    m_resize_subscription = EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& event) { OnWindowResize(event); });
     
     QK_CORE_LOGI_TAG("RHI", "Device_Vulkan Created");
 }
@@ -461,6 +612,12 @@ Device_Vulkan::~Device_Vulkan()
 {
     QK_CORE_LOGI_TAG("RHI", "Shutdown vulkan device...");
 
+    const DeviceCacheStats cache_stats = GetCacheStats();
+    QK_CORE_LOGI_TAG("RHI", "Device caches: {} lock free hits, {} locked hits, {} misses, {} insert races",
+        cache_stats.readOnlyHits, cache_stats.readWriteHits, cache_stats.misses, cache_stats.insertRaces);
+
+    EventManager::Get().Unsubscribe(m_resize_subscription);
+
     DRAIN_FRAME_LOCK();
     if (!m_frames.empty())
         EndFrameContextNoLock();
@@ -485,6 +642,8 @@ Device_Vulkan::~Device_Vulkan()
     // destroy command list will push some garbage buffers to the current frame
     GetCurrentFrame().clear();
 
+    m_bindless_set.destroy();
+
     // destroy wsi data
     m_wsi.destroy();
 
@@ -504,11 +663,20 @@ void Device_Vulkan::NextFrameContext()
     // Flush the frame here as we might have pending staging command buffers from init stage.
     EndFrameContextNoLock();
 
+    // No command list is recording, so nobody reads the caches while the objects of the last frame
+    // are moved to the lock free portion
+    cached_pipelineLayouts.move_to_read_only();
+    cached_descriptorSetAllocator.move_to_read_only();
+
     // put unused (more than 8 frames) descriptor set back to vacant pool
-    for (auto& [k, value] : cached_descriptorSetAllocator)
-        value.BeginFrame();
+    for (auto& allocator : cached_descriptorSetAllocator.get_read_only().inner_list())
+        allocator.BeginFrame();
+
+    m_frame_stats = m_pending_frame_stats;
+    m_pending_frame_stats = {};
 
     // move to next frame
+    m_frame_count++;
     m_frame_context_index++;
     if (m_frame_context_index >= m_config.framesInFlight)
         m_frame_context_index = 0;
@@ -518,6 +686,7 @@ void Device_Vulkan::NextFrameContext()
 
 bool Device_Vulkan::BeiginFrame(TimeStep ts)
 {
+    QK_PROFILE_SCOPE("Device_Vulkan::BeiginFrame");
 
     NextFrameContext();
 
@@ -562,6 +731,7 @@ bool Device_Vulkan::BeiginFrame(TimeStep ts)
 
 bool Device_Vulkan::EndFrame(TimeStep ts)
 {
+    QK_PROFILE_SCOPE("Device_Vulkan::EndFrame");
 
     EndFrameContext();
 
@@ -631,6 +801,15 @@ Ref<PipeLine> Device_Vulkan::CreateGraphicPipeLine(const GraphicPipeLineDesc &de
     return newPso;
 }
 
+Ref<PipeLine> Device_Vulkan::CreateComputePipeLine(const ComputePipeLineDesc& desc)
+{
+    QK_CORE_ASSERT(desc.compShader)
+    Ref<PipeLine> newPso = CreateRef<PipeLine_Vulkan>(this, desc);
+    QK_CORE_LOGT_TAG("RHI", "Compute Pipeline created");
+
+    return newPso;
+}
+
 Ref<Sampler> Device_Vulkan::CreateSampler(const SamplerDesc &desc)
 {
     Ref<Sampler> newSamper = CreateRef<Sampler_Vulkan>(this, desc);
@@ -650,14 +829,70 @@ void Device_Vulkan::CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t
     copyRegion.dstOffset = dstOffset;
 
     CopyCmdAllocator::CopyCmd copyCmd = copyAllocator.allocate(0);
+
+    // Copies of a batch aren't ordered. A gpu source, e.g. a GeometryArena buffer being rebuilt, may have been
+    // written by an earlier copy of the same batch
+    if (src.GetDesc().domain == BufferMemoryDomain::GPU)
+    {
+        VkMemoryBarrier2 barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+        VkDependencyInfo dependency_info = { VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dependency_info.memoryBarrierCount = 1;
+        dependency_info.pMemoryBarriers = &barrier;
+        m_vulkan_context->extendFunction.pVkCmdPipelineBarrier2KHR(copyCmd.transferCmdBuffer, &dependency_info);
+    }
+
     vkCmdCopyBuffer(copyCmd.transferCmdBuffer, src_internal.GetHandle(), dst_internal.GetHandle(), 1, &copyRegion);
     copyAllocator.submit(copyCmd);
 }
 
+void Device_Vulkan::UpdateBuffer(Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset)
+{
+    CopyCmdAllocator::CopyCmd copyCmd = copyAllocator.allocate(size);
+    memcpy(copyCmd.stageMappedData, data, size);
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.size = size;
+    copyRegion.srcOffset = copyCmd.stageOffset;
+    copyRegion.dstOffset = dstOffset;
+    vkCmdCopyBuffer(copyCmd.transferCmdBuffer, ToInternal(copyCmd.stageBuffer.get()).GetHandle(), ToInternal(&dst).GetHandle(), 1, &copyRegion);
+
+    copyAllocator.submit(copyCmd);
+}
+
+uint64_t Device_Vulkan::FlushUploads()
+{
+    return copyAllocator.flush();
+}
+
+bool Device_Vulkan::IsUploadComplete(uint64_t batchId)
+{
+    return copyAllocator.isBatchComplete(batchId);
+}
+
+UploadStats Device_Vulkan::GetUploadStats()
+{
+    return copyAllocator.getStats();
+}
+
 void Device_Vulkan::WaitIdle()
 {
     DRAIN_FRAME_LOCK();
 
+    copyAllocator.flush();
+
+    // Lists submitted without a signal are only queued until the end of the frame, they have to reach the gpu
+    // before waiting for it. The frame's fences are still submitted by EndFrameContext().
+    for (auto& queue : m_queues)
+    {
+        if (!queue.submissions.empty())
+            queue.submit();
+    }
+
     if (vkDevice != VK_NULL_HANDLE)
     {
         auto result = vkDeviceWaitIdle(vkDevice);
@@ -682,6 +917,24 @@ void Device_Vulkan::WaitIdle()
 
 }
 
+uint32_t Device_Vulkan::RegisterBindlessImage(const ImageView& view)
+{
+    QK_CORE_ASSERT(GetDeviceFeatures().bindless)
+    return m_bindless_set.registerImage(ToInternal(&view).GetView());
+}
+
+uint32_t Device_Vulkan::RegisterBindlessSampler(const Sampler& sampler)
+{
+    QK_CORE_ASSERT(GetDeviceFeatures().bindless)
+    return m_bindless_set.registerSampler(ToInternal(&sampler).GetHandle());
+}
+
+void Device_Vulkan::UnregisterBindlessImage(uint32_t index)
+{
+    LOCK();
+    GetCurrentFrame().garbage_bindlessImages.push_back(index);
+}
+
 void Device_Vulkan::SetName(const Ref<GpuResource>& resouce, const char* name)
 {
     if (!m_vulkan_context->supportDebugUtils || !resouce)
@@ -719,10 +972,32 @@ CommandList* Device_Vulkan::BeginCommandList(QueueType type)
 
 void Device_Vulkan::SubmitCommandList(CommandList* cmd, CommandList* waitedCmds, uint32_t waitedCmdCounts, bool signal)
 {
+    QK_PROFILE_SCOPE("Device_Vulkan::SubmitCommandList");
     LOCK();
     SubmitCommandListNoLock(cmd, waitedCmds, waitedCmdCounts, signal);
 }
 
+CommandList* Device_Vulkan::BeginSecondaryCommandList(CommandList& primary)
+{
+    QK_CORE_ASSERT(primary.GetQueueType() == QUEUE_TYPE_GRAPHICS)
+
+    CommandList_Vulkan* internal_cmdList = nullptr;
+    {
+        LOCK();
+        auto& frame = GetCurrentFrame();
+        uint32_t cmd_count = frame.secondaryCmdListCount++;
+        if (cmd_count >= frame.secondaryCmdLists.size())
+            frame.secondaryCmdLists.emplace_back(new CommandList_Vulkan(this, QUEUE_TYPE_GRAPHICS, true));
+
+        internal_cmdList = frame.secondaryCmdLists[cmd_count];
+    }
+
+    // Every list has its own command pool, so beginning it doesn't need the device lock.
+    // Not counted in the frame counter, the primary executing it is.
+    internal_cmdList->ResetAndBeginSecondaryCmdBuffer(ToInternal(&primary));
+    return internal_cmdList;
+}
+
 uint32_t Device_Vulkan::AllocateCookie()
 {
     // reserve lower bits for "special purposes".
@@ -820,6 +1095,7 @@ void Device_Vulkan::SubmitCommandListNoLock(CommandList* cmd, CommandList* waite
 
     vkEndCommandBuffer(internal_cmdList.GetHandle());
     internal_cmdList.state = CommandListState::READY_FOR_SUBMIT;
+    m_pending_frame_stats.Add(internal_cmdList.GetStats());
 
     if (queue.submissions.empty())
     {
@@ -844,6 +1120,7 @@ void Device_Vulkan::SubmitCommandListNoLock(CommandList* cmd, CommandList* waite
         for (size_t i = 0; i < waitedCmdCounts; ++i)
         {
             auto& internal = ToInternal(&waitedCmds[i]);
+            QK_CORE_ASSERT(internal.IsSignalling()) // otherwise the semaphore is never signaled
             auto& semaphore_info = submission.waitSemaphoreInfos.emplace_back();
             semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
             semaphore_info.semaphore = internal.GetCmdCompleteSemaphore();
@@ -881,6 +1158,7 @@ void Device_Vulkan::SubmitCommandListNoLock(CommandList* cmd, CommandList* waite
 
         queue.submit();
     }
+    internal_cmdList.SetSignalling(signal);
 
     DecrementFrameCounterNoLock();
 }
@@ -895,10 +1173,11 @@ void Device_Vulkan::EndFrameContextNoLock()
 {
     auto& frame = GetCurrentFrame();
 
-    // Submit queued command lists with fence which would block the next next frame
+    // Submit queued command lists with fence which would block the next next frame.
+    // Lists submitted with a signal are already on the queue, the fence still has to cover them.
     for (size_t i = 0; i < QUEUE_TYPE_MAX_ENUM; ++i)
     {
-        if (frame.cmdListCount[i] > 0 && !m_queues[i].submissions.empty())
+        if (frame.cmdListCount[i] > 0)
         { // This queue is in use in this frame
             m_queues[i].submit(frame.queueFences[i]);
             frame.waitedFences.push_back(frame.queueFences[i]);
@@ -918,11 +1197,109 @@ CommandList* Device_Vulkan::RequestCommandListNoLock(QueueType type)
     }
 
     CommandList_Vulkan* internal_cmdList = cmdLists[cmd_count];
+
+    // Reserve timestamp queries for the regions of this command list. Transfer queues may not support timestamps
+    uint32_t query_base = 0;
+    uint32_t query_count = 0;
+    if (m_gpu_profiling_enabled && frame.timestampPool != VK_NULL_HANDLE && type != QUEUE_TYPE_ASYNC_TRANSFER &&
+        frame.timestampQueryCount + TIMESTAMP_QUERIES_PER_CMD_LIST <= TIMESTAMP_QUERIES_PER_FRAME)
+    {
+        query_base = frame.timestampQueryCount;
+        query_count = TIMESTAMP_QUERIES_PER_CMD_LIST;
+        frame.timestampQueryCount += query_count;
+    }
+    internal_cmdList->SetTimestampQueries(frame.timestampPool, query_base, query_count);
+
     internal_cmdList->ResetAndBeginCmdBuffer();
     AddFrameCounterNoLock();
     return static_cast<CommandList*>(internal_cmdList);
 }
 
+void Device_Vulkan::ResolveGpuTimingsNoLock(PerFrameContext& frame)
+{
+    if (frame.timestampPool == VK_NULL_HANDLE || frame.timestampQueryCount == 0)
+        return;
+
+    struct ResolvedRegion
+    {
+        GpuTimingRegion region;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    std::vector<ResolvedRegion> resolved;
+    uint64_t ticks[TIMESTAMP_QUERIES_PER_CMD_LIST];
+    uint64_t frame_begin = UINT64_MAX;
+    uint64_t frame_end = 0;
+
+    for (uint32_t q = 0; q < QUEUE_TYPE_MAX_ENUM; q++)
+    {
+        for (uint32_t i = 0; i < frame.cmdListCount[q]; i++)
+        {
+            const CommandList_Vulkan* cmd = frame.cmdLists[q][i];
+            uint32_t query_count = cmd->GetTimestampQueryUsed();
+            if (query_count == 0)
+                continue;
+
+            // Don't wait here. Command lists which were never submitted or have unbalanced regions are skipped
+            VkResult result = vkGetQueryPoolResults(vkDevice, frame.timestampPool, cmd->GetTimestampQueryBase(), query_count,
+                sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+            if (result != VK_SUCCESS)
+                continue;
+
+            uint32_t base = (uint32_t)resolved.size();
+            const auto& regions = cmd->GetTimestampRegions();
+            for (uint32_t r = 0; r < (uint32_t)regions.size(); r++)
+            {
+                ResolvedRegion& out = resolved.emplace_back();
+                out.region.name = regions[r].name;
+                out.region.depth = regions[r].depth;
+                out.region.parent = regions[r].parent == ~0u ? ~0u : base + regions[r].parent;
+                out.begin = ticks[r * 2];
+                out.end = std::max(ticks[r * 2 + 1], out.begin);
+
+                frame_begin = std::min(frame_begin, out.begin);
+                frame_end = std::max(frame_end, out.end);
+            }
+        }
+    }
+
+    if (resolved.empty())
+        return;
+
+    // Order the regions of all command lists by start time, a parent always comes before its children
+    std::vector<uint32_t> order(resolved.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        if (resolved[a].begin != resolved[b].begin)
+            return resolved[a].begin < resolved[b].begin;
+        return resolved[a].region.depth < resolved[b].region.depth;
+    });
+
+    std::vector<uint32_t> remap(resolved.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+        remap[order[i]] = i;
+
+    const double ticks_to_ms = m_timestamp_period_ns * 1e-6;
+    GpuFrameTimings timings;
+    timings.frameIndex = frame.frameIndex;
+    timings.totalMs = double(frame_end - frame_begin) * ticks_to_ms;
+    timings.regions.reserve(resolved.size());
+    for (uint32_t i : order)
+    {
+        ResolvedRegion& r = resolved[i];
+        GpuTimingRegion& region = timings.regions.emplace_back(std::move(r.region));
+        if (region.parent != ~0u)
+            region.parent = remap[region.parent];
+        region.startMs = double(r.begin - frame_begin) * ticks_to_ms;
+        region.durationMs = double(r.end - r.begin) * ticks_to_ms;
+    }
+
+    if (timings.frameIndex >= m_gpu_timings.frameIndex)
+        m_gpu_timings = std::move(timings);
+}
+
 DataFormat Device_Vulkan::GetPresentImageFormat()
 {
     VkFormat format = m_vulkan_context->surfaceFormat.format;
@@ -940,6 +1317,41 @@ DataFormat Device_Vulkan::GetPresentImageFormat()
     }
 }
 
+template <typename T, typename... P>
+T* Device_Vulkan::RequestCachedObject(util::ThreadSafeIntrusiveHashMapReadCached<T>& cache, util::Hash hash, P&&... p)
+{
+    if (T* t = cache.get_read_only().find(hash))
+    {
+        m_cache_stats.readOnlyHits.fetch_add(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    if (T* t = cache.find(hash))
+    {
+        m_cache_stats.readWriteHits.fetch_add(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    // Another thread may create the same object meanwhile, only the first insertion is kept
+    m_cache_stats.misses.fetch_add(1, std::memory_order_relaxed);
+    T* created = cache.allocate(std::forward<P>(p)...);
+    T* t = cache.insert_yield(hash, created);
+    if (t != created)
+        m_cache_stats.insertRaces.fetch_add(1, std::memory_order_relaxed);
+
+    return t;
+}
+
+DeviceCacheStats Device_Vulkan::GetCacheStats() const
+{
+    DeviceCacheStats stats;
+    stats.readOnlyHits = m_cache_stats.readOnlyHits.load(std::memory_order_relaxed);
+    stats.readWriteHits = m_cache_stats.readWriteHits.load(std::memory_order_relaxed);
+    stats.misses = m_cache_stats.misses.load(std::memory_order_relaxed);
+    stats.insertRaces = m_cache_stats.insertRaces.load(std::memory_order_relaxed);
+    return stats;
+}
+
 PipeLineLayout* Device_Vulkan::RequestPipeLineLayout(const CombinedResourceLayout& combinedLayout)
 {
     // Compute pipeline layout hash
@@ -958,17 +1370,9 @@ PipeLineLayout* Device_Vulkan::RequestPipeLineLayout(const CombinedResourceLayou
     util::hash_combine(hash, combinedLayout.push_constant_range.size);
     util::hash_combine(hash, combinedLayout.push_constant_range.stageFlags);
     util::hash_combine(hash, combinedLayout.descriptor_set_mask);
+    util::hash_combine(hash, combinedLayout.bindless_set_mask);
 
-    // LOCK_CACHE();
-    auto find = cached_pipelineLayouts.find(hash);
-    if (find == cached_pipelineLayouts.end()) {
-        // need to create a new pipeline layout
-        auto result = cached_pipelineLayouts.try_emplace(hash, this, combinedLayout);
-        return &(result.first->second);
-    }
-    else {
-        return &find->second;
-    }
+    return RequestCachedObject(cached_pipelineLayouts, hash, this, combinedLayout);
 }
 
 void Device_Vulkan::RequestUniformBlock(BufferBlock& block, VkDeviceSize size)
@@ -1055,17 +1459,11 @@ DescriptorSetAllocator* Device_Vulkan::RequestDescriptorSetAllocator(const Descr
     util::hash_combine(hash, layout.sampler_mask);
     util::hash_combine(hash, layout.input_attachment_mask);
 
-    LOCK_CACHE();
-    auto find = cached_descriptorSetAllocator.find(hash);
-    if (find == cached_descriptorSetAllocator.end()) {
-        // need to create a new descriptor set allocator
-        auto ret = cached_descriptorSetAllocator.try_emplace(hash, this, layout);
-        return &(ret.first->second);
-    }
-    else {
-        return &find->second;
-    }
+    // A compute set and a graphics set with the same bindings still need their own layouts
+    for (const auto& binding : layout.bindings)
+        util::hash_combine(hash, binding.stageFlags);
 
+    return RequestCachedObject(cached_descriptorSetAllocator, hash, this, layout);
 }
 }
 
@@ -7,8 +7,12 @@
 #include "Quark/RHI/Vulkan/CommandList_Vulkan.h"
 #include "Quark/RHI/Vulkan/PipeLine_Vulkan.h"
 #include "Quark/RHI/Vulkan/DescriptorSetAllocator.h"
+#include "Quark/RHI/Vulkan/BindlessDescriptorSet.h"
+#include "Quark/Events/EventManager.h"
 
 #include <atomic>
+#include <chrono>
+#include <mutex>
 
 namespace quark::rhi {
 
@@ -18,6 +22,8 @@ struct PerFrameContext
     VmaAllocator vmaAllocator = nullptr;
     std::vector<CommandList_Vulkan*> cmdLists[QUEUE_TYPE_MAX_ENUM];
     uint32_t cmdListCount[QUEUE_TYPE_MAX_ENUM] = {}; //  the count of cmd used in this frame. Cleared when a new frame begin
+    std::vector<CommandList_Vulkan*> secondaryCmdLists; // graphics only, executed by the primary lists of this frame
+    uint32_t secondaryCmdListCount = 0;
     VkFence queueFences[QUEUE_TYPE_MAX_ENUM];   // per queue fence. Signled when all command list submitted from this frame completed.
     std::vector<VkFence> waitedFences;
 
@@ -27,10 +33,16 @@ struct PerFrameContext
     std::vector<VkImageView> grabage_views;
     std::vector<VkShaderModule> garbage_shaderModules;
     std::vector<VkSampler> garbage_samplers;
+    std::vector<uint32_t> garbage_bindlessImages;
     std::vector<BufferBlock> ubo_blocks;
     std::vector<BufferBlock> vbo_blocks;
     std::vector<BufferBlock> staging_blocks;
 
+    // Timestamp queries of this frame, every command list reserves a block of it for its regions
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    uint32_t timestampQueryCount = 0;
+    uint64_t frameIndex = 0;
+
     void init(Device_Vulkan* device);
     void begin();   // reset this frame
     void destroy();
@@ -38,36 +50,90 @@ struct PerFrameContext
 
 };
 
-// Mostly for static data uploading with dedicated transfer queue
+// Mostly for static data uploading with dedicated transfer queue.
+// Uploads are packed into batches: every batch owns one large staging ring which is linearly
+// suballocated, one transfer command buffer and one transition command buffer. A batch is
+// submitted once, when its staging ring is full or when the device submits work which might
+// consume the uploaded data.
 class CopyCmdAllocator {
 public:
     struct CopyCmd
-    {   // command buffer for data transfering
-        VkCommandPool transferCmdPool = VK_NULL_HANDLE;
+    {   // command buffer for data transfering (shared by all uploads in the batch)
         VkCommandBuffer transferCmdBuffer = VK_NULL_HANDLE;
 
-        // command buffer for image layout transitioning and image blitting
-        VkCommandPool transitionCmdPool = VK_NULL_HANDLE;
+        // command buffer for image layout transitioning and image blitting (shared by all uploads in the batch)
         VkCommandBuffer transitionCmdBuffer = VK_NULL_HANDLE;
 
+        // staging memory reserved for this upload: [stageOffset, stageOffset + stageSize) of stageBuffer
         Ref<Buffer> stageBuffer = nullptr;
-        VkSemaphore semaphores[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
-        VkFence fence = VK_NULL_HANDLE;
+        VkDeviceSize stageOffset = 0;
+        VkDeviceSize stageSize = 0;
+        void* stageMappedData = nullptr;
+
+        uint64_t batchId = 0; // completion value of the batch this upload belongs to
 
         bool isValid() const { return transferCmdBuffer && transitionCmdBuffer; }
     };
 
-    void init(Device_Vulkan* device);
+    void init(Device_Vulkan* device, VkDeviceSize ring_size = 32 * 1024 * 1024);
     void destroy();
-    CopyCmd allocate(VkDeviceSize required_buffer_size);
+
+    // Reserve staging memory in the open batch. Recording into the batch command buffers is serialized,
+    // the allocator stays locked until the matching submit().
+    CopyCmd allocate(VkDeviceSize required_buffer_size, VkDeviceSize alignment = 16);
     void submit(CopyCmd cmd);
 
+    // Submit the open batch. Returns the batch id which can be used with isBatchComplete()
+    uint64_t flush();
+    bool isBatchComplete(uint64_t batch_id);
+
+    UploadStats getStats();
+
 private:
+    struct Batch
+    {
+        VkCommandPool transferCmdPool = VK_NULL_HANDLE;
+        VkCommandBuffer transferCmdBuffer = VK_NULL_HANDLE;
+        VkCommandPool transitionCmdPool = VK_NULL_HANDLE;
+        VkCommandBuffer transitionCmdBuffer = VK_NULL_HANDLE;
+        Ref<Buffer> stageBuffer = nullptr;
+        VkDeviceSize stageOffset = 0;
+        VkSemaphore semaphores[2] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+        VkFence fence = VK_NULL_HANDLE;
+
+        uint64_t id = 0;
+        uint32_t uploadCount = 0;
+        VkDeviceSize uploadBytes = 0;
+        std::chrono::steady_clock::time_point submitTime;
+    };
+
+    void beginBatchNoLock(VkDeviceSize required_buffer_size);
+    uint64_t flushNoLock();
+    void retireBatchesNoLock(bool wait);
+
     Device_Vulkan* m_device;
-    std::vector<CopyCmd> m_freeList;
+    VkDeviceSize m_ringSize = 0;
+
+    Batch m_openBatch;
+    bool m_batchOpened = false;
+    std::vector<Batch> m_inFlight;
+    std::vector<Batch> m_freeList;
+
+    uint64_t m_nextBatchId = 1;
+    uint64_t m_completedBatchId = 0; // all batches with id <= this are complete
+    UploadStats m_stats;
     std::mutex m_locker;
 };
 
+// Lookups into the device caches (pipeline layouts and descriptor set allocators) since the device was created
+struct DeviceCacheStats
+{
+    uint64_t readOnlyHits = 0;      // lock free, the object was created before the current frame
+    uint64_t readWriteHits = 0;     // found under the read lock, the object was created during the current frame
+    uint64_t misses = 0;            // the object was created
+    uint64_t insertRaces = 0;       // created by several threads at once, the losers' copies were dropped
+};
+
 class Device_Vulkan final: public Device {
     friend class PerFrameContext;
     friend class CopyCmdAllocator;
@@ -77,9 +143,10 @@ public:
     VmaAllocator vmaAllocator; // borrowed from context, no lifetime management here
     CopyCmdAllocator copyAllocator;
 
-    // Cached objects
-    std::unordered_map<size_t, PipeLineLayout> cached_pipelineLayouts;
-    std::unordered_map<size_t, DescriptorSetAllocator> cached_descriptorSetAllocator;
+    // Cached objects, inserted once and kept until the device is destroyed. Objects created during a frame are moved
+    // to the read only portion when the next frame begins, lookups of those don't take any lock.
+    util::ThreadSafeIntrusiveHashMapReadCached<PipeLineLayout> cached_pipelineLayouts;
+    util::ThreadSafeIntrusiveHashMapReadCached<DescriptorSetAllocator> cached_descriptorSetAllocator;
 
 public:
     Device_Vulkan(const DeviceConfig& config);
@@ -90,8 +157,17 @@ public:
     void NextFrameContext() override final;
     bool BeiginFrame(TimeStep ts) override final;
     bool EndFrame(TimeStep ts) override final;
+    uint64_t GetFrameCount() const override final { return m_frame_count; }
     void OnWindowResize(const WindowResizeEvent& event) override final;
     void CopyBuffer(Buffer& dst, Buffer& src, uint64_t size, uint64_t dstOffset = 0, uint64_t srcOffset = 0) override final;
+    void UpdateBuffer(Buffer& dst, const void* data, uint64_t size, uint64_t dstOffset = 0) override final;
+    uint64_t FlushUploads() override final;
+    bool IsUploadComplete(uint64_t batchId) override final;
+    UploadStats GetUploadStats() override final;
+    void SetGpuProfilingEnabled(bool enable) override final { m_gpu_profiling_enabled = enable; }
+    bool IsGpuProfilingEnabled() const override final { return m_gpu_profiling_enabled; }
+    const GpuFrameTimings& GetGpuFrameTimings() const override final { return m_gpu_timings; }
+    const CommandListStats& GetFrameStats() const override final { return m_frame_stats; }
     void WaitIdle() override final;
 
     /*** RESOURCES ***/
@@ -101,12 +177,19 @@ public:
     Ref<Shader>         CreateShaderFromBytes(ShaderStage stage, const void* byteCode, size_t codeSize) override final;
     Ref<Shader>         CreateShaderFromSpvFile(ShaderStage stage, const std::string& file_path) override final;
     Ref<PipeLine>       CreateGraphicPipeLine(const GraphicPipeLineDesc& desc) override final;
+    Ref<PipeLine>       CreateComputePipeLine(const ComputePipeLineDesc& desc) override final;
     Ref<Sampler>        CreateSampler(const SamplerDesc& desc) override final;
     void                SetName(const Ref<GpuResource>& resouce, const char* name) override final;
 
+    /*** BINDLESS ***/
+    uint32_t            RegisterBindlessImage(const ImageView& view) override final;
+    uint32_t            RegisterBindlessSampler(const Sampler& sampler) override final;
+    void                UnregisterBindlessImage(uint32_t index) override final;
+
     /*** COMMAND LIST ***/
     CommandList*        BeginCommandList(QueueType type = QueueType::QUEUE_TYPE_GRAPHICS) override final;
     void                SubmitCommandList(CommandList* cmd, CommandList* waitedCmds = nullptr, uint32_t waitedCmdCounts = 0, bool signal = false) override final;
+    CommandList*        BeginSecondaryCommandList(CommandList& primary) override final;
     
     /*** SWAPCHAIN ***/
     Image*              GetPresentImage() override final { return m_wsi.swapchain_images[m_wsi.swapchain_image_index].get(); }
@@ -118,9 +201,12 @@ public:
 
     ///////////////////// Vulkan specific ////////////////////////
     //////////////////////////////////////////////////////////////
+    // Thread safe, but not while the frame changes: NextFrameContext() promotes the new objects to the lock free portion
     DescriptorSetAllocator*     RequestDescriptorSetAllocator(const DescriptorSetLayout& layout);
     PipeLineLayout*             RequestPipeLineLayout(const CombinedResourceLayout& combinedLayout);
+    DeviceCacheStats            GetCacheStats() const;
     PerFrameContext&            GetCurrentFrame();
+    const BindlessDescriptorSet& GetBindlessSet() const { return m_bindless_set; }
     uint32_t 				    AllocateCookie(); 
     const VulkanContext&        GetVulkanContext() { return *m_vulkan_context.get(); }
 
@@ -147,6 +233,9 @@ private:
     void EndFrameContextNoLock();
 
     CommandList* RequestCommandListNoLock(QueueType type);
+    template <typename T, typename... P>
+    T* RequestCachedObject(util::ThreadSafeIntrusiveHashMapReadCached<T>& cache, util::Hash hash, P&&... p);
+    void ResolveGpuTimingsNoLock(PerFrameContext& frame);
 
     // represent a physical queue
     // responsible for queuing commad buffers and submit them in batch
@@ -190,7 +279,6 @@ private:
     {
         std::mutex memory_lock;
         std::mutex lock;
-        std::mutex read_only_cache_lock;
         std::condition_variable cond;
         uint32_t counter = 0;
     } m_lock;
@@ -198,13 +286,36 @@ private:
     Scope<VulkanContext> m_vulkan_context;
     std::vector<PerFrameContext> m_frames;
     uint8_t m_frame_context_index = 0;
+    uint64_t m_frame_count = 0;
+
+    EventManager::SubscriptionId m_resize_subscription = EventManager::invalid_subscription;
+
+    // gpu profiling
+    bool m_gpu_profiling_enabled = true;
+    double m_timestamp_period_ns = 1.0;
+    GpuFrameTimings m_gpu_timings;
+
+    // command list stats, summed up on submit and published when the next frame begins
+    CommandListStats m_frame_stats;
+    CommandListStats m_pending_frame_stats;
 
     std::atomic_uint64_t m_cookie;
 
+    struct
+    {
+        std::atomic_uint64_t readOnlyHits = 0;
+        std::atomic_uint64_t readWriteHits = 0;
+        std::atomic_uint64_t misses = 0;
+        std::atomic_uint64_t insertRaces = 0;
+    } m_cache_stats;
+
     // buffer pool
     BufferPool m_ubo_pool;
     BufferPool m_vbo_pool;
     BufferPool m_staging_pool;
 
+    // only initialized if DeviceFeatures::bindless is supported
+    BindlessDescriptorSet m_bindless_set;
+
 };
 }
\ No newline at end of file
@@ -152,13 +152,10 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc)
 
 }
 
-void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, Ref<Buffer> stage_buffer, std::vector<VkBufferImageCopy>& copys)
+void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout& layout, const ImageInitData* init_data, void* mapped, VkDeviceSize stage_offset, std::vector<VkBufferImageCopy>& copys)
 {
     QK_CORE_ASSERT(copys.empty())
-    QK_CORE_ASSERT(stage_buffer->GetDesc().size >= layout.GetRequiredSize())
-
-    // Get mapped data ptr
-    void* mapped = stage_buffer->GetMappedDataPtr();
+    QK_CORE_ASSERT(mapped != nullptr)
 
     size_t index = 0;
     // Loop per mipmap level to copy data into staging buffer
@@ -187,7 +184,7 @@ void Image_Vulkan::PrepareCopy(const ImageDesc& desc, const TextureFormatLayout&
 
         // Fill copy structs
         VkBufferImageCopy copy;
-        copy.bufferOffset = mip_info.offset;
+        copy.bufferOffset = stage_offset + mip_info.offset;
         copy.bufferRowLength = 0;   // padding has been removed in the above loop
         copy.bufferImageHeight = 0;
         copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -405,11 +402,11 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
         layout.SetUp2D(desc.format, desc.width, desc.height, desc.arraySize, desc.generateMipMaps? 1 : desc.mipLevels);
 
         // Allocate a copy cmd with staging buffer
-        CopyCmdAllocator::CopyCmd copyCmd = m_device->copyAllocator.allocate(layout.GetRequiredSize());
+        CopyCmdAllocator::CopyCmd copyCmd = m_device->copyAllocator.allocate(layout.GetRequiredSize(), layout.GetBlockStride());
 
         // Fill staging buffer and copy structs
         std::vector<VkBufferImageCopy> copys;
-        PrepareCopy(desc, layout, init_data, copyCmd.stageBuffer, copys);
+        PrepareCopy(desc, layout, init_data, copyCmd.stageMappedData, copyCmd.stageOffset, copys);
 
         // Transit image to transfer dst format
         VkImageMemoryBarrier2 barrier{};
@@ -457,7 +454,7 @@ Image_Vulkan::Image_Vulkan(Device_Vulkan* device, const ImageDesc& desc, const I
             vk_context.extendFunction.pVkCmdPipelineBarrier2KHR(copyCmd.transitionCmdBuffer, &dependencyInfo);
         }
 
-        // submit and block cpu
+        // recorded into the current upload batch
         m_device->copyAllocator.submit(copyCmd);
     }
     else if (desc.initialLayout != ImageLayout::UNDEFINED) {    // Transit layout to required init layout
@@ -558,7 +555,7 @@ Sampler_Vulkan::Sampler_Vulkan(Device_Vulkan* device, const SamplerDesc& desc)
 	info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	info.mipLodBias = 0.f;
 	info.minLod = 0.f;
-	info.maxLod = 1;
+	info.maxLod = VK_LOD_CLAMP_NONE; // the image view limits the levels, prefiltered cubemaps sample all of them
 
     if (desc.enableAnisotropy) {
         info.anisotropyEnable = VK_TRUE;
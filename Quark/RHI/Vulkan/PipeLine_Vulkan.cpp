@@ -123,8 +123,17 @@ PipeLineLayout::PipeLineLayout(Device_Vulkan* _device, const CombinedResourceLay
     std::vector<VkDescriptorSetLayout> vk_descriptorset_layouts;
     for (uint32_t set = 0; set < DESCRIPTOR_SET_MAX_NUM; set++) 
     {   
-        setAllocators[set] = this->device->RequestDescriptorSetAllocator(combinedLayout.descriptor_set_layouts[set]);
-        layouts[set] = setAllocators[set]->GetLayout();
+        if (combinedLayout.bindless_set_mask & 1u << set)
+        {
+            // No allocator and no update template, the set is written by the device when resources are registered
+            QK_CORE_ASSERT(combinedLayout.descriptor_set_layouts[set].bindings.empty())
+            layouts[set] = this->device->GetBindlessSet().getLayout();
+        }
+        else
+        {
+            setAllocators[set] = this->device->RequestDescriptorSetAllocator(combinedLayout.descriptor_set_layouts[set]);
+            layouts[set] = setAllocators[set]->GetLayout();
+        }
         if (combinedLayout.descriptor_set_mask & 1u << set)
             num_sets = set + 1;
 
@@ -153,7 +162,7 @@ PipeLineLayout::PipeLineLayout(Device_Vulkan* _device, const CombinedResourceLay
     // Create descriptor set update template
     for (size_t set = 0; set < DESCRIPTOR_SET_MAX_NUM; ++set) 
     {
-        if ((combinedLayout.descriptor_set_mask & (1u << set)) == 0)
+        if ((combinedLayout.descriptor_set_mask & (1u << set)) == 0 || (combinedLayout.bindless_set_mask & (1u << set)) != 0)
             continue;
 
         VkDescriptorUpdateTemplateEntry update_entries[SET_BINDINGS_MAX_NUM];
@@ -205,7 +214,7 @@ PipeLineLayout::~PipeLineLayout()
 {
     for (size_t set = 0; set < DESCRIPTOR_SET_MAX_NUM; ++set) 
     {
-        if (combinedLayout.descriptor_set_mask & (1u << set)) 
+        if (updateTemplate[set] != VK_NULL_HANDLE) 
             vkDestroyDescriptorUpdateTemplate(device->vkDevice, updateTemplate[set], nullptr);
     }
 
@@ -230,6 +239,7 @@ static void MergeResourceLayout(CombinedResourceLayout& dst, const Shader_Vulkan
             continue;
 
         dst.descriptor_set_mask |= 1u << i;
+        dst.bindless_set_mask |= shaderResourceLayout.bindless_set_mask & (1u << i);
         dst.stages_for_sets[i] |= shader.GetStageInfo().stage;
 
         const DescriptorSetLayout& srcSetLayout = shaderResourceLayout.descriptor_set_layouts[i];
@@ -506,6 +516,22 @@ PipeLine_Vulkan::PipeLine_Vulkan(Device_Vulkan* device, const GraphicPipeLineDes
     VK_CHECK(vkCreateGraphicsPipelines(m_device->vkDevice, nullptr, 1, &pipeline_create_info, nullptr, &m_handle))
 }
 
+PipeLine_Vulkan::PipeLine_Vulkan(Device_Vulkan* device, const ComputePipeLineDesc& desc)
+    :PipeLine(PipeLineBindingPoint::COMPUTE), m_device(device)
+{
+    auto& comp_shader_internal = ToInternal(desc.compShader.get());
+    QK_CORE_ASSERT(comp_shader_internal.GetStageInfo().stage == VK_SHADER_STAGE_COMPUTE_BIT)
+
+    CombinedResourceLayout combinedLayout;
+    MergeResourceLayout(combinedLayout, comp_shader_internal);
+    m_layout = m_device->RequestPipeLineLayout(combinedLayout);
+
+    VkComputePipelineCreateInfo pipeline_create_info = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+    pipeline_create_info.stage = comp_shader_internal.GetStageInfo();
+    pipeline_create_info.layout = m_layout->handle;
+    VK_CHECK(vkCreateComputePipelines(m_device->vkDevice, nullptr, 1, &pipeline_create_info, nullptr, &m_handle))
+}
+
 PipeLine_Vulkan::~PipeLine_Vulkan()
 {
     if (m_handle != VK_NULL_HANDLE) 
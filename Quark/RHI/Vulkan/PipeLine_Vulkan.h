@@ -1,5 +1,6 @@
     #pragma once
 #include "Quark/Core/Util/TemporaryHashMap.h"
+#include "Quark/Core/Util/IntrusiveHashMap.h"
 #include "Quark/RHI/PipeLine.h"
 #include "Quark/RHI/RenderPassInfo.h"
 #include "Quark/RHI/Vulkan/Common_Vulkan.h"
@@ -10,7 +11,7 @@ namespace quark::rhi {
 
 // Once we have a list of VkDescriptorSetLayouts and push constant layouts, we now have our PipelineLayout.
 // This is of course, hashed as well based on the hash of descriptor set layouts and push constant ranges.
-struct PipeLineLayout {
+struct PipeLineLayout : util::IntrusiveHashMapEnabled<PipeLineLayout> {
     Device_Vulkan* device;
     VkPipelineLayout handle = VK_NULL_HANDLE; 
 
@@ -26,7 +27,7 @@ struct PipeLineLayout {
 class PipeLine_Vulkan : public PipeLine {
 public:
     PipeLine_Vulkan(Device_Vulkan* device, const GraphicPipeLineDesc& desc);
-    PipeLine_Vulkan(Device_Vulkan* device, Ref<Shader> computeShader);
+    PipeLine_Vulkan(Device_Vulkan* device, const ComputePipeLineDesc& desc);
     ~PipeLine_Vulkan();
 
     VkPipeline GetHandle() const { return m_handle; }
@@ -112,6 +112,15 @@ Shader_Vulkan::Shader_Vulkan(Device_Vulkan* device, ShaderStage stage, const voi
         uint32_t set = b->set; 
 
         m_resourceLayout.descriptor_set_mask |= 1 << set;
+
+        // Unsized arrays can only be backed by the global bindless set, its layout is owned by the device
+        if (b->count == 0)
+        {
+            QK_CORE_VERIFY(set == BINDLESS_DESCRIPTOR_SET, "Unsized descriptor arrays are only supported in the bindless set")
+            m_resourceLayout.bindless_set_mask |= 1u << set;
+            continue;
+        }
+
         // m_resourceLayout.descriptor_set_layouts[set].set_stage_mask |= m_stageInfo.stage;
 
         VkDescriptorSetLayoutBinding& layout_binding = m_resourceLayout.descriptor_set_layouts[set].bindings.emplace_back();
@@ -143,6 +152,9 @@ Shader_Vulkan::Shader_Vulkan(Device_Vulkan* device, ShaderStage stage, const voi
         case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
             set_layout.separate_image_mask |= 1u << bind_slot;
             break;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            set_layout.storage_image_mask |= 1u << bind_slot;
+            break;
         case VK_DESCRIPTOR_TYPE_SAMPLER:
             set_layout.sampler_mask |= 1u << bind_slot;
             break;
@@ -156,6 +168,11 @@ Shader_Vulkan::Shader_Vulkan(Device_Vulkan* device, ShaderStage stage, const voi
         
         
     }
+
+    // The bindless set layout is fixed, it can't be mixed with regular bindings
+    QK_CORE_VERIFY(!(m_resourceLayout.bindless_set_mask & (1u << BINDLESS_DESCRIPTOR_SET)) ||
+        m_resourceLayout.descriptor_set_layouts[BINDLESS_DESCRIPTOR_SET].bindings.empty(), "Bindless set mixed with regular bindings")
+
     spvReflectDestroyShaderModule(&spv_reflcet_module);
 
 }
@@ -9,6 +9,7 @@ struct ShaderResourceLayout {
     DescriptorSetLayout descriptor_set_layouts[DESCRIPTOR_SET_MAX_NUM] = {};
     VkPushConstantRange push_constant_range = {};
     uint32_t descriptor_set_mask = 0;
+    uint32_t bindless_set_mask = 0; // sets declaring unsized arrays, bound to the device's bindless set
     uint32_t input_mask = 0;
     uint32_t output_mask = 0;
 };
@@ -22,6 +23,7 @@ struct CombinedResourceLayout
     uint32_t stages_for_sets[DESCRIPTOR_SET_MAX_NUM] = {};
     VkPushConstantRange push_constant_range = {};
     uint32_t descriptor_set_mask = 0;
+    uint32_t bindless_set_mask = 0;
     util::Hash push_constant_hash = 0;
 };
 
@@ -26,7 +26,7 @@ static EShLanguage FindShaderLanguage(rhi::ShaderStage stage)
 	case rhi::ShaderStage::STAGE_COMPUTE:
 		return EShLangCompute;
 	default:
-		QK_CORE_LOGE_TAG("Rernderer", "FindShaderLanguage: Unsupported shader stage");
+		QK_CORE_LOGE_TAG("Renderer", "FindShaderLanguage: Unsupported shader stage");
 		return EShLangCount;
 	}
 }
@@ -100,7 +100,7 @@ void GLSLCompiler::SetSourceFromFile(const std::string& filePath, rhi::ShaderSta
 	std::string source;
 	if (!FileSystem::ReadFileText(filePath, source))
 	{
-		QK_CORE_LOGE_TAG("Rernderer", "GLSLCompiler::SetSourceFromFile: Failed to read file {}", filePath);
+		QK_CORE_LOGE_TAG("Renderer", "GLSLCompiler::SetSourceFromFile: Failed to read file {}", filePath);
 		return;
 	}
 
@@ -117,7 +117,7 @@ bool GLSLCompiler::Compile(std::string& outMessages, std::vector<uint32_t>& outS
 
 	if (m_source.empty())
 	{
-		QK_CORE_LOGE_TAG("Rernderer", "GLSLCompiler::Compile: Source is empty. Please set source first");
+		QK_CORE_LOGE_TAG("Renderer", "GLSLCompiler::Compile: Source is empty. Please set source first");
 		return false;
 	}
 
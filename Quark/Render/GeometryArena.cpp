@@ -0,0 +1,285 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/GeometryArena.h"
+
+namespace quark
+{
+
+GeometryArena::GeometryArena(Ref<rhi::Device> device, const GeometryArenaConfig& config)
+	: m_device(device), m_config(config)
+{
+	QK_CORE_VERIFY(m_device);
+
+	StreamState& vertex_stream = m_streams[util::ecast(Stream::Vertex)];
+	vertex_stream.name = "GeometryArena: Vertex";
+	vertex_stream.usage_bits = rhi::BUFFER_USAGE_VERTEX_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT | rhi::BUFFER_USAGE_TRANSFER_FROM_BIT;
+	vertex_stream.allocator.Reset(config.vertexCapacity);
+	vertex_stream.buffers.resize(util::ecast(VertexStream::Count));
+	vertex_stream.buffers[util::ecast(VertexStream::Position)].name = "GeometryArena: Position";
+	vertex_stream.buffers[util::ecast(VertexStream::VaryingEnableBlending)].name = "GeometryArena: VaryingEnableBlending";
+	vertex_stream.buffers[util::ecast(VertexStream::Varying)].name = "GeometryArena: Varying";
+	vertex_stream.buffers[util::ecast(VertexStream::JointBinding)].name = "GeometryArena: JointBinding";
+	for (uint32_t i = 0; i < util::ecast(VertexStream::Count); i++)
+		vertex_stream.buffers[i].stride = vertex_stream_strides[i];
+
+	StreamState& index_stream = m_streams[util::ecast(Stream::Index)];
+	index_stream.name = "GeometryArena: Index";
+	index_stream.usage_bits = rhi::BUFFER_USAGE_INDEX_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT | rhi::BUFFER_USAGE_TRANSFER_FROM_BIT;
+	index_stream.allocator.Reset(config.indexCapacity);
+	index_stream.buffers.push_back({ nullptr, index_size, index_stream.name });
+
+	QK_CORE_LOGI_TAG("Renderer", "GeometryArena created: {} vertices, {} indices", config.vertexCapacity, config.indexCapacity);
+}
+
+GeometryArena::~GeometryArena()
+{
+	// Whoever destroys the arena waited for the gpu already
+	for (const RetiredRange& retired : m_retired)
+		Release(retired.handle);
+	m_retired.clear();
+
+	for (auto& stream : m_streams)
+	{
+		if (stream.allocation_count > 0)
+			QK_CORE_LOGW_TAG("Renderer", "{} destroyed with {} live allocations", stream.name, stream.allocation_count);
+		stream.buffers.clear();
+	}
+}
+
+Ref<rhi::Buffer> GeometryArena::CreateStreamBuffer(const StreamState& state, const StreamBuffer& stream_buffer, uint64_t capacity)
+{
+	rhi::BufferDesc desc;
+	desc.domain = rhi::BufferMemoryDomain::GPU;
+	desc.size = capacity * stream_buffer.stride;
+	desc.usageBits = state.usage_bits;
+
+	Ref<rhi::Buffer> buffer = m_device->CreateBuffer(desc);
+	m_device->SetName(buffer, stream_buffer.name);
+	return buffer;
+}
+
+GeometryArena::Handle GeometryArena::Allocate(Stream stream, uint32_t count)
+{
+	QK_CORE_ASSERT(stream != Stream::Count);
+	QK_CORE_ASSERT(count > 0);
+
+	ReleaseRetired();
+
+	StreamState& state = m_streams[util::ecast(stream)];
+	util::OffsetAllocator::Allocation allocation = state.allocator.Allocate(count);
+
+	if (!allocation.IsValid())
+	{
+		// Compacting is enough if the free space is there but scattered, otherwise grow the buffers
+		uint64_t capacity = state.allocator.GetCapacity();
+		bool fits_after_compaction = state.allocator.GetFreeSize() >= count;
+		if (fits_after_compaction && state.allocator.GetFragmentation() >= m_config.defragmentThreshold)
+			Rebuild(stream, capacity);
+		else
+			Rebuild(stream, std::max(capacity * 2, capacity + count));
+
+		allocation = state.allocator.Allocate(count);
+		QK_CORE_VERIFY(allocation.IsValid(), "GeometryArena: out of memory");
+	}
+
+	Handle handle;
+	if (!m_free_handles.empty())
+	{
+		handle = m_free_handles.back();
+		m_free_handles.pop_back();
+	}
+	else
+	{
+		handle = (Handle)m_ranges.size();
+		m_ranges.emplace_back();
+	}
+
+	Range& range = m_ranges[handle];
+	range.allocation = allocation;
+	range.count = count;
+	range.stream = stream;
+
+	state.allocation_count++;
+	return handle;
+}
+
+void GeometryArena::Free(Handle handle)
+{
+	if (handle == invalid_handle)
+		return;
+
+	QK_CORE_ASSERT(handle < m_ranges.size());
+	Range& range = m_ranges[handle];
+	QK_CORE_ASSERT(range.stream != Stream::Count && !range.retired, "GeometryArena: double free");
+
+	range.retired = true;
+	m_retired.push_back({ handle, m_device->GetFrameCount() });
+	ReleaseRetired();
+}
+
+void GeometryArena::Release(Handle handle)
+{
+	Range& range = m_ranges[handle];
+	StreamState& state = m_streams[util::ecast(range.stream)];
+	state.allocator.Free(range.allocation);
+	state.allocation_count--;
+
+	range = Range();
+	m_free_handles.push_back(handle);
+}
+
+void GeometryArena::ReleaseRetired(Stream rebuilt_stream)
+{
+	// Same margin as GpuDrivenRenderer, the next frame may be recorded before BeiginFrame() is called.
+	// Ranges of a stream being rebuilt can go right away, the frames in flight keep reading the old buffer.
+	const uint64_t frame_count = m_device->GetFrameCount();
+	const uint64_t frames_in_flight = m_device->GetMaxFramesCount() + 1;
+
+	size_t kept = 0;
+	for (const RetiredRange& retired : m_retired)
+	{
+		if (retired.frame + frames_in_flight <= frame_count || m_ranges[retired.handle].stream == rebuilt_stream)
+			Release(retired.handle);
+		else
+			m_retired[kept++] = retired;
+	}
+	m_retired.resize(kept);
+}
+
+void GeometryArena::Upload(Handle handle, VertexStream stream, const void* data, uint64_t size)
+{
+	Upload(handle, Stream::Vertex, util::ecast(stream), data, size);
+}
+
+void GeometryArena::UploadIndices(Handle handle, const uint32_t* indices, uint32_t count)
+{
+	Upload(handle, Stream::Index, 0, indices, uint64_t(count) * index_size);
+}
+
+void GeometryArena::Upload(Handle handle, Stream stream, uint32_t buffer_index, const void* data, uint64_t size)
+{
+	QK_CORE_ASSERT(handle < m_ranges.size());
+	const Range& range = m_ranges[handle];
+	QK_CORE_ASSERT(range.stream == stream);
+
+	StreamState& state = m_streams[util::ecast(stream)];
+	StreamBuffer& stream_buffer = state.buffers[buffer_index];
+	QK_CORE_ASSERT(size <= uint64_t(range.count) * stream_buffer.stride);
+
+	if (!stream_buffer.buffer)
+		stream_buffer.buffer = CreateStreamBuffer(state, stream_buffer, state.allocator.GetCapacity());
+
+	m_device->UpdateBuffer(*stream_buffer.buffer, data, size, range.allocation.offset * stream_buffer.stride);
+}
+
+uint32_t GeometryArena::GetFirst(Handle handle) const
+{
+	QK_CORE_ASSERT(handle < m_ranges.size());
+	return uint32_t(m_ranges[handle].allocation.offset);
+}
+
+uint32_t GeometryArena::GetCount(Handle handle) const
+{
+	QK_CORE_ASSERT(handle < m_ranges.size());
+	return m_ranges[handle].count;
+}
+
+rhi::Buffer& GeometryArena::GetVertexBuffer(VertexStream stream) const
+{
+	const StreamBuffer& stream_buffer = m_streams[util::ecast(Stream::Vertex)].buffers[util::ecast(stream)];
+	QK_CORE_ASSERT(stream_buffer.buffer, "GeometryArena: nothing was uploaded to this vertex stream");
+	return *stream_buffer.buffer;
+}
+
+rhi::Buffer& GeometryArena::GetIndexBuffer() const
+{
+	const StreamBuffer& stream_buffer = m_streams[util::ecast(Stream::Index)].buffers[0];
+	QK_CORE_ASSERT(stream_buffer.buffer, "GeometryArena: nothing was uploaded to the index stream");
+	return *stream_buffer.buffer;
+}
+
+void GeometryArena::Defragment(Stream stream)
+{
+	const StreamState& state = m_streams[util::ecast(stream)];
+	if (state.allocator.GetFreeBlockCount() <= 1)
+		return;
+
+	Rebuild(stream, state.allocator.GetCapacity());
+}
+
+void GeometryArena::Defragment()
+{
+	for (uint32_t i = 0; i < util::ecast(Stream::Count); i++)
+		Defragment(Stream(i));
+}
+
+void GeometryArena::Rebuild(Stream stream, uint64_t new_capacity)
+{
+	StreamState& state = m_streams[util::ecast(stream)];
+	ReleaseRetired(stream);
+
+	// Re-pack live ranges in their current order, which keeps relative locality
+	std::vector<Handle> live;
+	live.reserve(state.allocation_count);
+	for (Handle h = 0; h < (Handle)m_ranges.size(); h++)
+	{
+		if (m_ranges[h].stream == stream)
+			live.push_back(h);
+	}
+
+	std::sort(live.begin(), live.end(), [&](Handle a, Handle b) {
+		return m_ranges[a].allocation.offset < m_ranges[b].allocation.offset;
+	});
+
+	util::OffsetAllocator new_allocator(new_capacity);
+	std::vector<util::OffsetAllocator::Allocation> new_allocations;
+	new_allocations.reserve(live.size());
+	for (Handle h : live)
+	{
+		new_allocations.push_back(new_allocator.Allocate(m_ranges[h].count));
+		QK_CORE_VERIFY(new_allocations.back().IsValid());
+	}
+
+	// Every buffer of the stream moves its ranges the same way, so one vertex offset stays valid for all of them
+	for (StreamBuffer& stream_buffer : state.buffers)
+	{
+		if (!stream_buffer.buffer)
+			continue;
+
+		Ref<rhi::Buffer> old_buffer = stream_buffer.buffer;
+		Ref<rhi::Buffer> new_buffer = CreateStreamBuffer(state, stream_buffer, new_capacity);
+		for (size_t i = 0; i < live.size(); i++)
+		{
+			const Range& range = m_ranges[live[i]];
+			m_device->CopyBuffer(*new_buffer, *old_buffer, uint64_t(range.count) * stream_buffer.stride,
+				new_allocations[i].offset * stream_buffer.stride, range.allocation.offset * stream_buffer.stride);
+		}
+
+		// The old buffer goes to the device's deferred deletion queue once released here
+		stream_buffer.buffer = new_buffer;
+	}
+
+	for (size_t i = 0; i < live.size(); i++)
+		m_ranges[live[i]].allocation = new_allocations[i];
+
+	QK_CORE_LOGI_TAG("Renderer", "{} rebuilt: {} allocations, capacity {} -> {}, fragmentation {:.2f} -> {:.2f}",
+		state.name, live.size(), state.allocator.GetCapacity(), new_capacity,
+		state.allocator.GetFragmentation(), new_allocator.GetFragmentation());
+
+	state.allocator = std::move(new_allocator);
+}
+
+GeometryArena::Stats GeometryArena::GetStats(Stream stream) const
+{
+	const StreamState& state = m_streams[util::ecast(stream)];
+
+	Stats stats;
+	stats.capacity = state.allocator.GetCapacity();
+	stats.used = state.allocator.GetUsedSize();
+	stats.largestFreeBlock = state.allocator.GetLargestFreeBlock();
+	stats.freeBlockCount = state.allocator.GetFreeBlockCount();
+	stats.allocationCount = state.allocation_count;
+	stats.fragmentation = state.allocator.GetFragmentation();
+	return stats;
+}
+
+}
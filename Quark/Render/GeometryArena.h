@@ -0,0 +1,134 @@
+#pragma once
+#include "Quark/Core/Base.h"
+#include "Quark/Core/Util/EnumCast.h"
+#include "Quark/Core/Util/OffsetAllocator.h"
+#include "Quark/RHI/Device.h"
+
+namespace quark
+{
+
+struct GeometryArenaConfig
+{
+	uint32_t vertexCapacity = 1024 * 1024;		// vertices, in every vertex stream
+	uint32_t indexCapacity = 8 * 1024 * 1024;	// uint32 indices
+	float defragmentThreshold = 0.5f; // fragmentation ratio which triggers a compaction before growing
+};
+
+// A global geometry heap. All meshes suballocate their vertices from one large device-local buffer
+// per vertex stream and their indices from one index buffer. The buffers are bound once and a mesh
+// is only addressed by the vertexOffset and firstIndex of its draws.
+// A vertex range is reserved in all vertex streams at once, so one vertex offset is valid for every
+// stream. That's why the streams have a fixed stride, attributes a mesh doesn't have are left as padding.
+// Allocations are referenced by handles since their offsets move on defragmentation.
+class GeometryArena
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle invalid_handle = ~0u;
+
+	enum class Stream : uint8_t
+	{
+		Vertex,
+		Index,
+		Count
+	};
+
+	// Buffers of Stream::Vertex, each one is bound to the vertex input binding of the same number
+	enum class VertexStream : uint8_t
+	{
+		Position,				// position
+		VaryingEnableBlending,	// normal, tangent
+		Varying,				// uv, color
+		JointBinding,			// bone indices, bone weights
+		Count
+	};
+
+	static constexpr uint32_t vertex_stream_strides[util::ecast(VertexStream::Count)] = { 12, 24, 24, 32 };
+	static constexpr uint32_t index_size = sizeof(uint32_t);
+
+	struct Stats
+	{
+		uint64_t capacity = 0;	// in vertices or indices
+		uint64_t used = 0;
+		uint64_t largestFreeBlock = 0;
+		uint32_t freeBlockCount = 0;
+		uint32_t allocationCount = 0;
+		float fragmentation = 0.f;
+	};
+
+	GeometryArena(Ref<rhi::Device> device, const GeometryArenaConfig& config = {});
+	~GeometryArena();
+
+	// Reserve a number of vertices, in every vertex stream, or of indices
+	Handle Allocate(Stream stream, uint32_t count);
+
+	// Draws of the frames in flight may still read the range, it is only reused once they are done.
+	// Retired ranges are released by the next Allocate() or Free() after that.
+	void Free(Handle handle);
+
+	// Copy cpu data into the range of an allocation, through the device's staging ring
+	void Upload(Handle handle, VertexStream stream, const void* data, uint64_t size);
+	void UploadIndices(Handle handle, const uint32_t* indices, uint32_t count);
+
+	// First vertex or first index of the range, passed as vertexOffset / firstIndex of a draw
+	uint32_t GetFirst(Handle handle) const;
+	uint32_t GetCount(Handle handle) const;
+
+	// A vertex stream buffer is created by the first upload into it
+	rhi::Buffer& GetVertexBuffer(VertexStream stream) const;
+	rhi::Buffer& GetIndexBuffer() const;
+
+	// Compact all live allocations of a stream to the front of fresh buffers
+	void Defragment(Stream stream);
+	void Defragment();
+
+	Stats GetStats(Stream stream) const;
+
+private:
+	struct Range
+	{
+		util::OffsetAllocator::Allocation allocation;
+		uint32_t count = 0;
+		Stream stream = Stream::Count;
+		bool retired = false;
+	};
+
+	struct RetiredRange
+	{
+		Handle handle;
+		uint64_t frame; // device frame count when it was freed
+	};
+
+	struct StreamBuffer
+	{
+		Ref<rhi::Buffer> buffer;
+		uint32_t stride = 0;
+		const char* name = nullptr;
+	};
+
+	struct StreamState
+	{
+		std::vector<StreamBuffer> buffers;
+		util::OffsetAllocator allocator;
+		uint32_t usage_bits = 0;
+		uint32_t allocation_count = 0;
+		const char* name = nullptr;
+	};
+
+	Ref<rhi::Buffer> CreateStreamBuffer(const StreamState& state, const StreamBuffer& stream_buffer, uint64_t capacity);
+	void Upload(Handle handle, Stream stream, uint32_t buffer_index, const void* data, uint64_t size);
+	void Rebuild(Stream stream, uint64_t new_capacity);
+	void Release(Handle handle);
+	void ReleaseRetired(Stream rebuilt_stream = Stream::Count);
+
+	Ref<rhi::Device> m_device;
+	GeometryArenaConfig m_config;
+
+	StreamState m_streams[util::ecast(Stream::Count)];
+
+	std::vector<Range> m_ranges;
+	std::vector<Handle> m_free_handles;
+	std::vector<RetiredRange> m_retired;
+};
+
+}
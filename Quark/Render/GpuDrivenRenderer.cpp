@@ -0,0 +1,321 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/GpuDrivenRenderer.h"
+#include "Quark/Render/RenderSystem.h"
+#include "Quark/Render/RenderContext.h"
+#include "Quark/Render/GpuScene.h"
+#include "Quark/Scene/Scene.h"
+#include "Quark/Core/Profiler.h"
+
+#include <cstring>
+#include <numeric>
+
+namespace quark
+{
+static_assert(sizeof(GpuDrivenRenderer::GpuDrawInstance) == 8, "Layout must match gpu_instances.glslh");
+static_assert(sizeof(GpuDrivenRenderer::GpuDrawCommand) == 20, "Layout must match VkDrawIndexedIndirectCommand");
+static_assert(sizeof(GpuDrivenRenderer::GpuBatch) == 32, "Layout must match gpu_instances.glslh");
+
+static constexpr uint32_t cull_group_size = 64;
+
+struct CullParameters
+{
+	glm::vec4 planes[6];
+	uint32_t instance_count;
+};
+
+struct CompactParameters
+{
+	uint32_t batch_count;
+};
+
+GpuDrivenRenderer::GpuDrivenRenderer(Ref<rhi::Device> device)
+	: m_device(device)
+{
+	auto& render_resource_manager = RenderSystem::Get().GetRenderResourceManager();
+	ShaderLibrary& shader_library = render_resource_manager.GetShaderLibrary();
+
+	m_program_cull = shader_library.RequestComputeProgram("BuiltInResources/Shaders/cull_instances.comp");
+	m_program_compact = shader_library.RequestComputeProgram("BuiltInResources/Shaders/compact_draws.comp");
+	m_pipeline_cull = render_resource_manager.RequestComputePSO(*m_program_cull->RequestVariant({}));
+	m_pipeline_compact = render_resource_manager.RequestComputePSO(*m_program_compact->RequestVariant({}));
+
+	// Prepare() may run before BeiginFrame(), when the frame which used the same buffers
+	// framesInFlight frames ago can still be in flight. One more set avoids waiting for it.
+	m_frames.resize(m_device->GetMaxFramesCount() + 1);
+}
+
+void GpuDrivenRenderer::Prepare(const RenderContext& context, Scene& scene, VisibilityList& fallback)
+{
+	QK_PROFILE_SCOPE("GpuDrivenRenderer::Prepare");
+
+	m_frame_index = (m_frame_index + 1) % m_frames.size();
+	m_gpu_scene = context.GetGpuScene();
+	QK_CORE_ASSERT(m_gpu_scene)
+
+	// 1. Rebuild the batches if renderables were added, removed or replaced. Removals don't show up in the
+	// change ticks, they change the membership version.
+	bool changed = &scene != m_scene || scene.GetOpaqueRenderablesVersion() != m_opaques_version;
+	m_sync_tick = scene.ForEachChangedOpaqueRenderable(m_sync_tick, [&changed](RenderableCmpt&) { changed = true; });
+	if (changed)
+		Rebuild(scene);
+
+	const math::Frustum& frustum = context.GetVisibilityFrustum();
+	for (const RenderableInfo& info : m_fallbacks)
+	{
+		if (frustum.CheckSphere(info.render_info->world_aabb))
+			fallback.push_back(info);
+	}
+
+	const uint32_t instance_count = (uint32_t)m_draw_instances.size();
+	const uint32_t batch_count = (uint32_t)m_batches.size();
+	const uint32_t bucket_count = (uint32_t)m_buckets.size();
+	if (instance_count == 0)
+		return;
+
+	// 2. Fill this frame's buffers. The per instance data is only copied when this set hasn't seen the last rebuild,
+	// the batches are rewritten every frame since the cull pass counts their instances.
+	FrameBuffers& frame = m_frames[m_frame_index];
+	ReserveBuffer(frame.draw_instances, instance_count * sizeof(GpuDrawInstance), rhi::BufferMemoryDomain::CPU, rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	ReserveBuffer(frame.visible_instances, instance_count * sizeof(uint32_t), rhi::BufferMemoryDomain::GPU, rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	ReserveBuffer(frame.batches, batch_count * sizeof(GpuBatch), rhi::BufferMemoryDomain::CPU, rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT | rhi::BUFFER_USAGE_INDIRECT_BIT);
+	ReserveBuffer(frame.draw_commands, batch_count * sizeof(GpuDrawCommand), rhi::BufferMemoryDomain::GPU, rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT | rhi::BUFFER_USAGE_INDIRECT_BIT);
+	ReserveBuffer(frame.draw_counts, bucket_count * sizeof(uint32_t), rhi::BufferMemoryDomain::CPU, rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT | rhi::BUFFER_USAGE_INDIRECT_BIT);
+
+	// Only ids, the transforms and bounds are in the GpuScene table already
+	if (frame.revision != m_revision)
+	{
+		std::memcpy(frame.draw_instances->GetMappedDataPtr(), m_draw_instances.data(), instance_count * sizeof(GpuDrawInstance));
+		frame.revision = m_revision;
+	}
+
+	auto* gpu_batches = static_cast<GpuBatch*>(frame.batches->GetMappedDataPtr());
+	for (uint32_t b = 0; b < bucket_count; b++)
+	{
+		const Bucket& bucket = m_buckets[b];
+		for (uint32_t slot = bucket.first_batch; slot < bucket.first_batch + bucket.batch_count; slot++)
+		{
+			// Defragmenting or growing the geometry arena moves the mesh ranges and a growing material table
+			// replaces its buffer, so the drawcall data is refreshed. Per batch, not per instance.
+			Batch& batch = m_batches[slot];
+			batch.mesh->FillPerDrawcallData(batch.drawcall_data);
+
+			GpuBatch& gpu_batch = gpu_batches[slot];
+			gpu_batch.command.index_count = batch.drawcall_data.vertex_count;
+			gpu_batch.command.instance_count = 0; // counted up by the cull pass
+			gpu_batch.command.first_index = batch.drawcall_data.ibo_offset;
+			gpu_batch.command.vertex_offset = (int32_t)batch.drawcall_data.vertex_offset;
+			gpu_batch.command.first_instance = batch.first_instance;
+			gpu_batch.bucket = b;
+			gpu_batch.bucket_first_draw = bucket.first_batch;
+		}
+	}
+
+	std::memset(frame.draw_counts->GetMappedDataPtr(), 0, bucket_count * sizeof(uint32_t));
+}
+
+void GpuDrivenRenderer::Rebuild(Scene& scene)
+{
+	QK_PROFILE_SCOPE("GpuDrivenRenderer::Rebuild");
+
+	m_scene = &scene;
+	m_opaques_version = scene.GetOpaqueRenderablesVersion();
+	m_revision++;
+
+	m_batches.clear();
+	m_buckets.clear();
+	m_draw_instances.clear();
+	m_fallbacks.clear();
+	m_batch_lookup.clear();
+	const uint32_t rebuilds = m_stats.rebuilds + 1;
+	m_stats = {};
+	m_stats.rebuilds = rebuilds;
+
+	ShaderProgram* program_static_mesh = RenderSystem::Get().GetRenderResourceManager().GetShaderLibrary().program_staticMesh;
+
+	// 1. Group the instances into batches
+	for (auto& object : scene.GetComponents<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>())
+	{
+		const RenderableInfo info = { GetComponent<RenderableCmpt>(object)->renderable.get(), GetComponent<RenderInfoCmpt>(object) };
+		const StaticMesh* mesh = info.renderable->GetStaticMesh();
+		if (!mesh || info.render_info->has_skin || info.render_info->instance_id == RenderInfoCmpt::invalid_instance_id ||
+			mesh->mesh_buffers->ibo == GeometryArena::invalid_handle || mesh->GetMeshDrawPipeline() == DrawPipeline::AlphaBlend)
+		{
+			m_fallbacks.push_back(info);
+			continue;
+		}
+
+		auto [it, inserted] = m_batch_lookup.try_emplace(mesh->hash, (uint32_t)m_batches.size());
+		if (inserted)
+		{
+			Batch& batch = m_batches.emplace_back();
+			batch.mesh = mesh;
+			batch.instance_count = 0;
+			mesh->FillPerDrawcallData(batch.drawcall_data);
+
+			std::vector<std::pair<std::string, int>> defines;
+			StaticMesh::GetAttribDefines(defines, mesh->mesh_attribute_mask);
+			defines.emplace_back("GPU_DRIVEN", 1);
+			if (batch.drawcall_data.material_table)
+				defines.emplace_back("BINDLESS", 1);
+			batch.drawcall_data.shader_program = program_static_mesh->RequestVariant(defines);
+
+			// Everything BindMeshState() binds, except the index range. The arena streams are bound at offset 0
+			// for every mesh, so meshes only differ in the streams they use.
+			const MeshBuffers& mesh_buffers = *mesh->mesh_buffers;
+			util::Hasher h;
+			h.pointer(mesh_buffers.arena);
+			h.u32(uint32_t(mesh_buffers.has_varying_enable_blending) | uint32_t(mesh_buffers.has_varying) << 1);
+			h.u32(mesh->mesh_attribute_mask);
+			h.u64(mesh->material->hash);
+			h.u64(batch.drawcall_data.shader_program->GetHash());
+			h.u32(util::ecast(batch.drawcall_data.draw_pipeline));
+			batch.bucket_key = h.get();
+		}
+
+		m_batches[it->second].instance_count++;
+		m_draw_instances.push_back({ info.render_info->instance_id, it->second });
+	}
+
+	// 2. Order the batches by bucket, every bucket draws a contiguous range of them
+	m_batch_order.resize(m_batches.size());
+	std::iota(m_batch_order.begin(), m_batch_order.end(), 0);
+	std::sort(m_batch_order.begin(), m_batch_order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return m_batches[a].bucket_key < m_batches[b].bucket_key;
+	});
+
+	std::vector<Batch> sorted_batches;
+	sorted_batches.reserve(m_batches.size());
+	std::vector<uint32_t> batch_slots(m_batches.size());
+	uint32_t first_instance = 0;
+	for (uint32_t slot = 0; slot < m_batch_order.size(); slot++)
+	{
+		Batch& batch = sorted_batches.emplace_back(m_batches[m_batch_order[slot]]);
+		if (slot == 0 || batch.bucket_key != sorted_batches[slot - 1].bucket_key)
+			m_buckets.push_back({ slot, 0 });
+
+		m_buckets.back().batch_count++;
+		batch.first_instance = first_instance;
+		first_instance += batch.instance_count;
+		batch_slots[m_batch_order[slot]] = slot;
+	}
+	m_batches.swap(sorted_batches);
+
+	// The gpu batch buffer is in bucket order too
+	for (GpuDrawInstance& draw_instance : m_draw_instances)
+		draw_instance.batch = batch_slots[draw_instance.batch];
+
+	m_stats.instances = (uint32_t)m_draw_instances.size();
+	m_stats.batches = (uint32_t)m_batches.size();
+	m_stats.buckets = (uint32_t)m_buckets.size();
+	m_stats.fallbacks = (uint32_t)m_fallbacks.size();
+
+	QK_CORE_LOGI_TAG("Renderer", "GpuDrivenRenderer: rebuilt {} instances into {} batches and {} buckets",
+		m_stats.instances, m_stats.batches, m_stats.buckets);
+}
+
+void GpuDrivenRenderer::Cull(rhi::CommandList& cmd, const RenderContext& context)
+{
+	using namespace rhi;
+
+	if (m_draw_instances.empty())
+		return;
+
+	FrameBuffers& frame = m_frames[m_frame_index];
+	const uint32_t instance_count = (uint32_t)m_draw_instances.size();
+	const uint32_t batch_count = (uint32_t)m_batches.size();
+
+	cmd.BeginRegion("GPU culling");
+
+	CullParameters cull_params;
+	const auto& planes = context.GetVisibilityFrustum().GetPlanes();
+	std::copy(planes.begin(), planes.end(), cull_params.planes);
+	cull_params.instance_count = instance_count;
+
+	cmd.BindPipeLine(*m_pipeline_cull);
+	cmd.BindStorageBuffer(0, 0, *frame.draw_instances, 0, instance_count * sizeof(GpuDrawInstance));
+	cmd.BindStorageBuffer(0, 1, *frame.batches, 0, batch_count * sizeof(GpuBatch));
+	cmd.BindStorageBuffer(0, 2, *frame.visible_instances, 0, instance_count * sizeof(uint32_t));
+	cmd.BindStorageBuffer(0, 3, m_gpu_scene->GetInstanceBuffer(), 0, m_gpu_scene->GetInstanceBufferSize());
+	cmd.PushConstant(&cull_params, 0, sizeof(CullParameters));
+	cmd.Dispatch((instance_count + cull_group_size - 1) / cull_group_size, 1, 1);
+
+	PipelineMemoryBarrier barrier;
+	barrier.srcStageBits = PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.srcMemoryAccessBits = BARRIER_ACCESS_SHADER_WRITE_BIT;
+
+	if (m_device->GetDeviceFeatures().drawIndirectCount)
+	{
+		barrier.dstStageBits = PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.dstMemoryAccessBits = BARRIER_ACCESS_SHADER_READ_BIT | BARRIER_ACCESS_SHADER_WRITE_BIT;
+		cmd.PipeLineBarriers(&barrier, 1, nullptr, 0, nullptr, 0);
+
+		CompactParameters compact_params;
+		compact_params.batch_count = batch_count;
+
+		cmd.BindPipeLine(*m_pipeline_compact);
+		cmd.BindStorageBuffer(0, 0, *frame.batches, 0, batch_count * sizeof(GpuBatch));
+		cmd.BindStorageBuffer(0, 1, *frame.draw_commands, 0, batch_count * sizeof(GpuDrawCommand));
+		cmd.BindStorageBuffer(0, 2, *frame.draw_counts, 0, m_buckets.size() * sizeof(uint32_t));
+		cmd.PushConstant(&compact_params, 0, sizeof(CompactParameters));
+		cmd.Dispatch((batch_count + cull_group_size - 1) / cull_group_size, 1, 1);
+	}
+
+	// Draw() reads the commands and the visible instances
+	barrier.dstStageBits = PIPELINE_STAGE_DRAW_INDIRECT_BIT | PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	barrier.dstMemoryAccessBits = BARRIER_ACCESS_INDIRECT_COMMAND_READ_BIT | BARRIER_ACCESS_SHADER_READ_BIT;
+	cmd.PipeLineBarriers(&barrier, 1, nullptr, 0, nullptr, 0);
+
+	cmd.EndRegion();
+}
+
+void GpuDrivenRenderer::Draw(rhi::CommandList& cmd) const
+{
+	QK_PROFILE_SCOPE("GpuDrivenRenderer::Draw");
+
+	if (m_buckets.empty())
+		return;
+
+	const FrameBuffers& frame = m_frames[m_frame_index];
+	const uint64_t instance_count = m_draw_instances.size();
+	const rhi::DeviceFeatures& features = m_device->GetDeviceFeatures();
+
+	for (uint32_t b = 0; b < m_buckets.size(); b++)
+	{
+		const Bucket& bucket = m_buckets[b];
+		BindMeshState(cmd, m_batches[bucket.first_batch].drawcall_data);
+		cmd.BindStorageBuffer(2, 0, *frame.visible_instances, 0, instance_count * sizeof(uint32_t));
+		cmd.BindStorageBuffer(2, 1, m_gpu_scene->GetInstanceBuffer(), 0, m_gpu_scene->GetInstanceBufferSize());
+
+		if (features.drawIndirectCount)
+		{
+			cmd.DrawIndexedIndirectCount(*frame.draw_commands, bucket.first_batch * sizeof(GpuDrawCommand),
+				*frame.draw_counts, b * sizeof(uint32_t), bucket.batch_count, sizeof(GpuDrawCommand));
+		}
+		else if (features.multiDrawIndirect)
+		{
+			// Uncompacted, batches without visible instances are empty draws
+			cmd.DrawIndexedIndirect(*frame.batches, bucket.first_batch * sizeof(GpuBatch), bucket.batch_count, sizeof(GpuBatch));
+		}
+		else
+		{
+			for (uint32_t slot = bucket.first_batch; slot < bucket.first_batch + bucket.batch_count; slot++)
+				cmd.DrawIndexedIndirect(*frame.batches, slot * sizeof(GpuBatch), 1, sizeof(GpuBatch));
+		}
+	}
+}
+
+void GpuDrivenRenderer::ReserveBuffer(Ref<rhi::Buffer>& buffer, uint64_t size, rhi::BufferMemoryDomain domain, uint32_t usage_bits)
+{
+	if (buffer && buffer->GetDesc().size >= size)
+		return;
+
+	// Grow geometrically, the old buffer belongs to this frame's set and is no longer used by the gpu
+	rhi::BufferDesc desc;
+	desc.size = std::max<uint64_t>({ size, buffer ? buffer->GetDesc().size * 2 : 0, 256 });
+	desc.domain = domain;
+	desc.usageBits = usage_bits;
+	buffer = m_device->CreateBuffer(desc);
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "Quark/Render/Mesh.h"
+#include "Quark/Render/RenderQueue.h"
+#include "Quark/RHI/Device.h"
+
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+
+namespace quark
+{
+class RenderContext;
+class ShaderProgram;
+class GpuScene;
+class Scene;
+
+// Gpu driven path for opaque static meshes, instances are read from the context's GpuScene.
+// Prepare() groups the instances of all opaque renderables, not only the visible ones, into batches
+// (one per StaticMesh, i.e. mesh range + material) and buckets (batches sharing pipeline, material and
+// the geometry arena streams, so meshes with the same material share one). The assignment is kept until the
+// scene's opaque renderables change, moving instances only touches the GpuScene. Cull() frustum culls the
+// instances in a compute pass, appends the visible ones to their batch and compacts the non empty batches
+// into the draws of their bucket. Draw() issues one DrawIndexedIndirectCount per bucket, so the cpu cost
+// no longer grows with the object count.
+// Opt-in, only the GLTFViewer sample uses it.
+class GpuDrivenRenderer
+{
+public:
+	// Layouts shared with include/gpu_instances.glslh
+	struct GpuDrawInstance
+	{
+		uint32_t instance;	// RenderInfoCmpt::instance_id
+		uint32_t batch;
+	};
+
+	struct GpuDrawCommand // VkDrawIndexedIndirectCommand
+	{
+		uint32_t index_count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t vertex_offset;
+		uint32_t first_instance;
+	};
+
+	struct GpuBatch
+	{
+		GpuDrawCommand command;
+		uint32_t bucket;
+		uint32_t bucket_first_draw;
+		uint32_t padding;
+	};
+
+	struct Stats
+	{
+		uint32_t instances = 0;
+		uint32_t batches = 0;
+		uint32_t buckets = 0;
+		uint32_t fallbacks = 0; // renderables left to the regular render queue
+		uint32_t rebuilds = 0;	// times the batches were rebuilt
+	};
+
+	GpuDrivenRenderer(Ref<rhi::Device> device);
+
+	// Call once per frame, after GpuScene::Update(). Renderables the gpu path can't draw (skinned, non indexed,
+	// not a StaticMesh) are culled on the cpu and appended to fallback, push them to a RenderQueue as usual.
+	void Prepare(const RenderContext& context, Scene& scene, VisibilityList& fallback);
+
+	// Forces the batches to be rebuilt by the next Prepare(), e.g. after a mesh or material was edited in place
+	void Invalidate() { m_scene = nullptr; }
+
+	// Record outside of a render pass, after GpuScene::Upload() and before Draw()
+	void Cull(rhi::CommandList& cmd, const RenderContext& context);
+
+	// Record inside the render pass, the camera parameters have to be bound already
+	void Draw(rhi::CommandList& cmd) const;
+
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	struct Batch
+	{
+		const StaticMesh* mesh;
+		StaticMeshPerDrawcallData drawcall_data;
+		util::Hash bucket_key;
+		uint32_t instance_count;
+		uint32_t first_instance;
+	};
+
+	struct Bucket
+	{
+		uint32_t first_batch;
+		uint32_t batch_count;
+	};
+
+	// Buffers are written by the cpu or used by the gpu for a whole frame, so there is one set per frame in flight
+	struct FrameBuffers
+	{
+		Ref<rhi::Buffer> draw_instances;	// GpuDrawInstance, cpu written
+		Ref<rhi::Buffer> batches;			// GpuBatch, cpu written, instance counts filled by the cull pass
+		Ref<rhi::Buffer> draw_counts;		// uint per bucket, cpu cleared, filled by the compact pass
+		Ref<rhi::Buffer> visible_instances;	// uint instance indices
+		Ref<rhi::Buffer> draw_commands;		// GpuDrawCommand, compacted per bucket
+		uint32_t revision = 0;				// m_revision the draw instances were written at
+	};
+
+	void Rebuild(Scene& scene);
+	void ReserveBuffer(Ref<rhi::Buffer>& buffer, uint64_t size, rhi::BufferMemoryDomain domain, uint32_t usage_bits);
+
+	Ref<rhi::Device> m_device;
+	ShaderProgram* m_program_cull;
+	ShaderProgram* m_program_compact;
+	Ref<rhi::PipeLine> m_pipeline_cull;
+	Ref<rhi::PipeLine> m_pipeline_compact;
+
+	const GpuScene* m_gpu_scene = nullptr;
+	std::vector<FrameBuffers> m_frames;
+	uint32_t m_frame_index = 0;
+
+	// What the batches were built from, Prepare() rebuilds them when one of these changes
+	const Scene* m_scene = nullptr;
+	uint32_t m_opaques_version = 0;
+	uint32_t m_sync_tick = 0;
+	uint32_t m_revision = 0; // bumped by every rebuild
+
+	// Rebuilt by Rebuild(), the vectors keep their capacity
+	std::vector<Batch> m_batches;	// ordered by bucket
+	std::vector<Bucket> m_buckets;
+	std::vector<GpuDrawInstance> m_draw_instances;
+	std::vector<RenderableInfo> m_fallbacks; // culled on the cpu every frame
+	std::vector<uint32_t> m_batch_order;
+	std::unordered_map<uint64_t, uint32_t> m_batch_lookup; // StaticMesh hash -> batch
+	Stats m_stats;
+};
+
+}
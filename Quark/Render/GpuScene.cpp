@@ -0,0 +1,140 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/GpuScene.h"
+#include "Quark/Render/RenderSystem.h"
+#include "Quark/Scene/Scene.h"
+#include "Quark/Core/Profiler.h"
+
+#include <cstring>
+
+namespace quark
+{
+static_assert(sizeof(GpuScene::Instance) == 80, "Layout must match gpu_instances.glslh");
+static_assert(sizeof(GpuScene::InstanceUpdate) == 96, "Layout must match gpu_instances.glslh");
+
+static constexpr uint32_t scatter_group_size = 64;
+static constexpr uint32_t invalid_slot = ~0u;
+
+struct ScatterParameters
+{
+	uint32_t update_count;
+};
+
+GpuScene::GpuScene(Ref<rhi::Device> device)
+	: m_device(device)
+{
+	auto& render_resource_manager = RenderSystem::Get().GetRenderResourceManager();
+	m_program_scatter = render_resource_manager.GetShaderLibrary().RequestComputeProgram("BuiltInResources/Shaders/scatter_instances.comp");
+	m_pipeline_scatter = render_resource_manager.RequestComputePSO(*m_program_scatter->RequestVariant({}));
+
+	m_update_buffers.resize(m_device->GetMaxFramesCount());
+}
+
+void GpuScene::Update(Scene& scene)
+{
+	QK_PROFILE_SCOPE("GpuScene::Update");
+
+	if (m_scene != &scene)
+	{
+		// Pending updates of the old scene refer to its instance ids
+		for (const InstanceUpdate& update : m_updates)
+			m_update_slots[update.index] = invalid_slot;
+		m_updates.clear();
+
+		m_scene = &scene;
+		m_sync_tick = 0;
+	}
+
+	const uint32_t required = scene.GetInstanceIdCapacity();
+	if (required > m_capacity)
+	{
+		// The old table may still be read by frames in flight, so start over with a new one and upload everything.
+		// Pending updates are kept, the ones collected below overwrite them.
+		rhi::BufferDesc desc;
+		desc.size = std::max<uint64_t>(std::max(required, m_capacity * 2), 256) * sizeof(Instance);
+		desc.domain = rhi::BufferMemoryDomain::GPU;
+		desc.usageBits = rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		m_instances = m_device->CreateBuffer(desc);
+		m_capacity = uint32_t(desc.size / sizeof(Instance));
+		m_update_slots.resize(m_capacity, invalid_slot);
+		m_sync_tick = 0;
+	}
+	m_stats.capacity = m_capacity;
+
+	m_sync_tick = scene.ForEachChangedRenderInfo(m_sync_tick, [this](RenderInfoCmpt& render_info)
+	{
+		if (render_info.instance_id == RenderInfoCmpt::invalid_instance_id)
+			return;
+
+		// Scatter writes of the same index aren't ordered, a pending update is overwritten instead
+		uint32_t& slot = m_update_slots[render_info.instance_id];
+		if (slot == invalid_slot)
+		{
+			slot = (uint32_t)m_updates.size();
+			m_updates.emplace_back().index = render_info.instance_id;
+		}
+
+		InstanceUpdate& update = m_updates[slot];
+		update.data.model = render_info.world_transform;
+		update.data.bounding_sphere = glm::vec4(render_info.world_aabb.GetCenter(), render_info.world_aabb.GetRadius());
+	});
+}
+
+void GpuScene::Upload(rhi::CommandList& cmd)
+{
+	using namespace rhi;
+
+	m_stats.updates = 0;
+	if (m_updates.empty())
+		return;
+
+	// Recorded inside the frame, the buffer of this slot was last read framesInFlight frames ago
+	const uint32_t update_count = (uint32_t)m_updates.size();
+	const uint64_t size = update_count * sizeof(InstanceUpdate);
+	m_frame_index = (m_frame_index + 1) % m_update_buffers.size();
+	Ref<rhi::Buffer>& buffer = m_update_buffers[m_frame_index];
+	if (!buffer || buffer->GetDesc().size < size)
+	{
+		rhi::BufferDesc desc;
+		desc.size = std::max<uint64_t>({ size, buffer ? buffer->GetDesc().size * 2 : 0, 256 * sizeof(InstanceUpdate) });
+		desc.domain = rhi::BufferMemoryDomain::CPU;
+		desc.usageBits = rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		buffer = m_device->CreateBuffer(desc);
+	}
+	std::memcpy(buffer->GetMappedDataPtr(), m_updates.data(), size);
+
+	ScatterParameters params;
+	params.update_count = update_count;
+
+	cmd.BeginRegion("GPU scene upload");
+
+	// The table is persistent, the previous frame's culling pass and vertex shaders may still read it
+	PipelineMemoryBarrier war_barrier;
+	war_barrier.srcStageBits = PIPELINE_STAGE_VERTEX_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	war_barrier.srcMemoryAccessBits = BARRIER_ACCESS_SHADER_READ_BIT;
+	war_barrier.dstStageBits = PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	war_barrier.dstMemoryAccessBits = BARRIER_ACCESS_SHADER_WRITE_BIT;
+	cmd.PipeLineBarriers(&war_barrier, 1, nullptr, 0, nullptr, 0);
+
+	cmd.BindPipeLine(*m_pipeline_scatter);
+	cmd.BindStorageBuffer(0, 0, *buffer, 0, size);
+	cmd.BindStorageBuffer(0, 1, *m_instances, 0, GetInstanceBufferSize());
+	cmd.PushConstant(&params, 0, sizeof(ScatterParameters));
+	cmd.Dispatch((update_count + scatter_group_size - 1) / scatter_group_size, 1, 1);
+
+	// Read by the culling pass and by vertex shaders
+	PipelineMemoryBarrier barrier;
+	barrier.srcStageBits = PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.srcMemoryAccessBits = BARRIER_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstStageBits = PIPELINE_STAGE_COMPUTE_SHADER_BIT | PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	barrier.dstMemoryAccessBits = BARRIER_ACCESS_SHADER_READ_BIT;
+	cmd.PipeLineBarriers(&barrier, 1, nullptr, 0, nullptr, 0);
+	cmd.EndRegion();
+
+	// Recorded once, a second call in the same frame has nothing left to scatter
+	for (const InstanceUpdate& update : m_updates)
+		m_update_slots[update.index] = invalid_slot;
+	m_updates.clear();
+	m_stats.updates = update_count;
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "Quark/RHI/Device.h"
+
+#include <glm/glm.hpp>
+
+namespace quark
+{
+class Scene;
+class ShaderProgram;
+
+// Persistent gpu copy of the scene's renderables, indexed by the stable RenderInfoCmpt::instance_id.
+// Update() collects only the instances whose RenderInfoCmpt changed since the last call as (index, data)
+// pairs, Upload() scatters them into the table with a compute pass. Draws reference instances by index,
+// so the per frame upload follows what moves instead of what is visible.
+// Collected updates stay pending until Upload() records them, a frame which didn't begin loses nothing.
+// Opt-in: the application owns it and sets it on its RenderContext, RenderSystem and the editor don't use it yet.
+class GpuScene
+{
+public:
+	// Layouts shared with include/gpu_instances.glslh
+	struct Instance
+	{
+		glm::mat4 model;
+		glm::vec4 bounding_sphere; // world space center and radius
+	};
+
+	struct InstanceUpdate
+	{
+		uint32_t index;
+		uint32_t padding[3];
+		Instance data;
+	};
+
+	struct Stats
+	{
+		uint32_t capacity = 0;
+		uint32_t updates = 0;	// instances scattered by the last Upload()
+	};
+
+	GpuScene(Ref<rhi::Device> device);
+
+	// Call once per frame after Scene::OnUpdate(). Switching to another scene or growing the table uploads everything.
+	void Update(Scene& scene);
+
+	// Record outside of a render pass, before anything reading the instance buffer
+	void Upload(rhi::CommandList& cmd);
+
+	const rhi::Buffer& GetInstanceBuffer() const { return *m_instances; }
+	uint64_t GetInstanceBufferSize() const { return uint64_t(m_capacity) * sizeof(Instance); }
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	Ref<rhi::Device> m_device;
+	ShaderProgram* m_program_scatter;
+	Ref<rhi::PipeLine> m_pipeline_scatter;
+
+	Ref<rhi::Buffer> m_instances;	// gpu only, Instance per instance id
+	uint32_t m_capacity = 0;
+
+	// One buffer per frame in flight, written when Upload() records the scatter
+	std::vector<Ref<rhi::Buffer>> m_update_buffers;
+	uint32_t m_frame_index = 0;
+	std::vector<InstanceUpdate> m_updates;	// pending until Upload()
+	std::vector<uint32_t> m_update_slots;	// index into m_updates per instance id, an instance is scattered only once
+
+	const Scene* m_scene = nullptr;
+	uint32_t m_sync_tick = 0;		// change tick the instances were last collected at
+	Stats m_stats;
+};
+
+}
@@ -6,6 +6,7 @@
 namespace quark 
 {
 struct RenderInfoCmpt;
+struct StaticMesh;
 
 enum class DrawPipeline : uint8_t
 {
@@ -37,6 +38,9 @@ public:
 	}
 
 	virtual DrawPipeline GetMeshDrawPipeline() const { return DrawPipeline::Opaque; }
+
+	// Non null for plain static meshes, which the GpuDrivenRenderer can draw
+	virtual const StaticMesh* GetStaticMesh() const { return nullptr; }
 };
 
 }
@@ -46,6 +46,7 @@ struct PBRMaterial
 	DrawPipeline draw_pipeline = DrawPipeline::Opaque;
 	ShaderProgram* shader_program = nullptr;
 	uint64_t hash = 0;
+	uint32_t material_index = 0; // in the MaterialTable, bindless path only
 
 	std::unordered_map<std::string, ShaderProgram*> shader_programs;
 
@@ -0,0 +1,66 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/MaterialTable.h"
+
+#include <cstring>
+
+namespace quark
+{
+static_assert(sizeof(MaterialTable::GpuMaterial) == 80, "Layout must match gpu_materials.glslh");
+static_assert(util::ecast(TextureKind::Count) <= 8, "GpuMaterial::textures is too small");
+
+MaterialTable::MaterialTable(Ref<rhi::Device> device, const rhi::Sampler& sampler)
+	: m_device(device)
+{
+	QK_CORE_ASSERT(m_device->GetDeviceFeatures().bindless)
+	m_sampler_index = m_device->RegisterBindlessSampler(sampler);
+}
+
+void MaterialTable::Register(PBRMaterial& material)
+{
+	GpuMaterial gpu_material = {};
+	gpu_material.base_color = material.base_color;
+	gpu_material.emissive = glm::vec4(material.emissive_color, 0.f);
+	gpu_material.metallic = material.metallic_factor;
+	gpu_material.roughness = material.roughness_factor;
+	gpu_material.sampler_index = m_sampler_index;
+	for (unsigned i = 0; i < util::ecast(TextureKind::Count); i++)
+	{
+		if (!material.textures[i])
+			continue;
+
+		gpu_material.texture_mask |= 1u << i;
+		gpu_material.textures[i] = RegisterImage(material.textures[i]);
+	}
+
+	material.material_index = (uint32_t)m_materials.size();
+	m_materials.push_back(gpu_material);
+
+	if (m_materials.size() > m_capacity)
+	{
+		rhi::BufferDesc desc;
+		desc.size = std::max<uint64_t>(m_capacity * 2, 256) * sizeof(GpuMaterial);
+		desc.domain = rhi::BufferMemoryDomain::CPU;
+		desc.usageBits = rhi::BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		m_buffer = m_device->CreateBuffer(desc);
+		m_capacity = uint32_t(desc.size / sizeof(GpuMaterial));
+
+		std::memcpy(m_buffer->GetMappedDataPtr(), m_materials.data(), m_materials.size() * sizeof(GpuMaterial));
+	}
+	else
+	{
+		std::memcpy((GpuMaterial*)m_buffer->GetMappedDataPtr() + material.material_index, &gpu_material, sizeof(GpuMaterial));
+	}
+}
+
+uint32_t MaterialTable::RegisterImage(const Ref<rhi::Image>& image)
+{
+	auto find = m_images.find(image.get());
+	if (find != m_images.end())
+		return find->second.second;
+
+	uint32_t index = m_device->RegisterBindlessImage(image->GetDefaultView());
+	m_images.emplace(image.get(), std::make_pair(image, index));
+	return index;
+}
+
+}
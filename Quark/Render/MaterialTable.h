@@ -0,0 +1,53 @@
+#pragma once
+#include "Quark/Render/Material.h"
+#include "Quark/RHI/Device.h"
+
+#include <unordered_map>
+
+namespace quark
+{
+// Materials of the bindless path (rhi::DeviceFeatures::bindless). Every registered PBRMaterial gets a GpuMaterial
+// in one storage buffer, its textures are registered as bindless images and referenced by index. Draws bind the
+// table once and select their material with PBRMaterial::material_index, so a material change costs a push
+// constant instead of a descriptor set.
+class MaterialTable
+{
+public:
+	// Layout shared with include/gpu_materials.glslh
+	struct GpuMaterial
+	{
+		glm::vec4 base_color;
+		glm::vec4 emissive;
+		float metallic;
+		float roughness;
+		uint32_t sampler_index;
+		uint32_t texture_mask;	// bit per TextureKind, set if the material has such a texture
+		uint32_t textures[8];	// bindless image indices, indexed by TextureKind
+	};
+
+	MaterialTable(Ref<rhi::Device> device, const rhi::Sampler& sampler);
+
+	// Assigns material.material_index. Materials are immutable once registered and stay in the table for its lifetime.
+	void Register(PBRMaterial& material);
+
+	const rhi::Buffer& GetBuffer() const { return *m_buffer; }
+	uint64_t GetBufferSize() const { return uint64_t(m_capacity) * sizeof(GpuMaterial); }
+	uint32_t GetMaterialCount() const { return (uint32_t)m_materials.size(); }
+
+private:
+	uint32_t RegisterImage(const Ref<rhi::Image>& image);
+
+	Ref<rhi::Device> m_device;
+	uint32_t m_sampler_index = 0;
+
+	// Host visible, registering only appends so frames in flight never see a slot change. Growing creates
+	// a new buffer, the old one is released once the frames using it are done.
+	Ref<rhi::Buffer> m_buffer;
+	uint32_t m_capacity = 0;
+	std::vector<GpuMaterial> m_materials;
+
+	// Images are shared between materials, each one takes a single bindless slot
+	std::unordered_map<const rhi::Image*, std::pair<Ref<rhi::Image>, uint32_t>> m_images;
+};
+
+}
@@ -2,6 +2,8 @@
 #include "Quark/Render/Mesh.h"
 #include "Quark/Render/RenderQueue.h"
 #include "Quark/Render/RenderSystem.h"
+#include "Quark/Render/RenderContext.h"
+#include "Quark/Render/GpuScene.h"
 namespace quark
 {
 static Queue Material2Queue(const PBRMaterial& mat)
@@ -25,21 +27,36 @@ void StaticMesh::GetRenderData(const RenderContext& context, const RenderInfoCmp
 	QK_CORE_ASSERT(material->hash != 0);
 	h.u64(material->hash);
 	util::Hash material_hash = h.get(); // hash for a material
-	h.pointer(mesh_buffers->vbo_position.get());
+	h.u32(mesh_buffers->vbo); // arena handles stay stable across defragmentation
 	util::Hash draw_hash = h.get(); // hash for a drawcall
 
+	// With a gpu scene the transform is already on the gpu, only the instance id is uploaded
+	const GpuScene* gpu_scene = context.GetGpuScene();
+	const bool use_gpu_scene = gpu_scene && transform->instance_id != RenderInfoCmpt::invalid_instance_id;
+
 	QK_CORE_ASSERT(hash != 0);
 	uint64_t instance_key = hash;
+	if (!use_gpu_scene)
+		instance_key |= 1ull << 32; // never instanced together with ids
 	uint64_t sort_key = BuiltInSortKey::GetSortKey(context, queue_type, pipeline_hash, material_hash, draw_hash, static_aabb.Transform(transform->world_transform).GetCenter());
 
 	auto* instance_data = queue.AllocateOne<StaticMeshPerInstanceData>();
-	instance_data->vertex.model = transform->world_transform;
+	if (use_gpu_scene)
+		instance_data->vertex.instance_id = transform->instance_id;
+	else
+		instance_data->vertex.model = transform->world_transform;
 
 	auto* perdrawcall_data = queue.PushTask<StaticMeshPerDrawcallData>(queue_type, instance_key, sort_key, StaticMeshRender, instance_data);
 
 	if (perdrawcall_data)
 	{
 		FillPerDrawcallData(*perdrawcall_data);
+		if (use_gpu_scene)
+		{
+			perdrawcall_data->instance_table = &gpu_scene->GetInstanceBuffer();
+			perdrawcall_data->instance_table_size = gpu_scene->GetInstanceBufferSize();
+		}
+
 		// TODO :Remvoe hard code
 		const std::string& pass_name = queue.GetPassName();
 		if (pass_name == "ForwardBase")
@@ -47,6 +64,10 @@ void StaticMesh::GetRenderData(const RenderContext& context, const RenderInfoCmp
 			// TODO:figure out a way to avoid allocating memory here
 			std::vector<std::pair<std::string, int>> defines;
 			GetAttribDefines(defines, mesh_attribute_mask);
+			if (use_gpu_scene)
+				defines.emplace_back("GPU_SCENE", 1);
+			if (perdrawcall_data->material_table)
+				defines.emplace_back("BINDLESS", 1);
 			perdrawcall_data->shader_program = RenderSystem::Get().GetRenderResourceManager().GetShaderLibrary().program_staticMesh->RequestVariant(defines);
 		}
 		else if (pass_name == "ShadowMapDepth")
@@ -56,13 +77,21 @@ void StaticMesh::GetRenderData(const RenderContext& context, const RenderInfoCmp
 
 void StaticMesh::FillPerDrawcallData(StaticMeshPerDrawcallData& data) const
 {
-	data.vbo_position = mesh_buffers->vbo_position.get();
-	data.vbo_varying = mesh_buffers->vbo_varying.get();
-	data.vbo_varying_enable_blending = mesh_buffers->vbo_varying_enable_blending.get();
-	// data.vbo_joint_binding = mesh_buffers->vbo_joint_binding.get();
-	data.ibo = mesh_buffers->ibo.get();
+	// The arena buffers are bound at offset 0 for every mesh, the mesh range is addressed through vertexOffset / firstIndex
+	using VertexStream = GeometryArena::VertexStream;
+	const GeometryArena& arena = *mesh_buffers->arena;
+	data.vbo_position = &arena.GetVertexBuffer(VertexStream::Position);
+	data.vbo_varying_enable_blending = mesh_buffers->has_varying_enable_blending ? &arena.GetVertexBuffer(VertexStream::VaryingEnableBlending) : nullptr;
+	data.vbo_varying = mesh_buffers->has_varying ? &arena.GetVertexBuffer(VertexStream::Varying) : nullptr;
+	data.vertex_offset = vertex_offset + arena.GetFirst(mesh_buffers->vbo);
+
+	data.ibo = nullptr;
 	data.ibo_offset = ibo_offset;
-	data.vertex_offset = vertex_offset;
+	if (mesh_buffers->ibo != GeometryArena::invalid_handle)
+	{
+		data.ibo = &arena.GetIndexBuffer();
+		data.ibo_offset += arena.GetFirst(mesh_buffers->ibo);
+	}
 	data.vertex_count = vertex_count;
 	data.fragment.base_color = material->base_color;
 	data.fragment.metallic = material->metallic_factor;
@@ -75,6 +104,12 @@ void StaticMesh::FillPerDrawcallData(StaticMeshPerDrawcallData& data) const
 
 	data.draw_pipeline = material->draw_pipeline;
 
+	if (const MaterialTable* material_table = RenderSystem::Get().GetRenderResourceManager().GetMaterialTable())
+	{
+		data.material_table = &material_table->GetBuffer();
+		data.material_table_size = material_table->GetBufferSize();
+		data.material_index = material->material_index;
+	}
 }
 
 void SkinnedMesh::GetRenderData(const RenderContext& context, const RenderInfoCmpt* transform, RenderQueue& queue) const
@@ -90,7 +125,7 @@ void SkinnedMesh::GetRenderData(const RenderContext& context, const RenderInfoCm
 	QK_CORE_ASSERT(material->hash != 0);
 	h.u64(material->hash);
 	util::Hash material_hash = h.get(); // hash for a material
-	h.pointer(mesh_buffers->vbo_position.get());					// TODO: pointer is unstable due to reused
+	h.u32(mesh_buffers->vbo);
 	util::Hash draw_hash = h.get(); // hash for a drawcall
 
 	QK_CORE_ASSERT(hash != 0);
@@ -133,20 +168,41 @@ void BindMeshState(rhi::CommandList& cmd, const StaticMeshPerDrawcallData& data)
 
 	cmd.BindPipeLine(*pipeline.get());
 
-	cmd.BindImage(1, 0, data.textures[util::ecast(TextureKind::Albedo)]->GetDefaultView(), ImageLayout::SHADER_READ_ONLY_OPTIMAL);
-	cmd.BindSampler(1, 0, *render_resource_manager.sampler_linear);
-	//cmd.BindImage(2, 2, *data.textures[util::ecast(TextureKind::MetallicRoughness)], ImageLayout::SHADER_READ_ONLY_OPTIMAL);
-	//cmd.BindSampler(2, 2, *render_resource_manager.sampler_linear);
+	if (data.material_table)
+	{
+		// Same table for every draw, only the material index changes
+		cmd.BindStorageBuffer(1, 0, *data.material_table, 0, data.material_table_size);
+		cmd.PushConstant(&data.material_index, 0, sizeof(uint32_t));
+	}
+	else
+	{
+		cmd.BindImage(1, 0, data.textures[util::ecast(TextureKind::Albedo)]->GetDefaultView(), ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+		cmd.BindSampler(1, 0, *render_resource_manager.sampler_linear);
+		//cmd.BindImage(2, 2, *data.textures[util::ecast(TextureKind::MetallicRoughness)], ImageLayout::SHADER_READ_ONLY_OPTIMAL);
+		//cmd.BindSampler(2, 2, *render_resource_manager.sampler_linear);
 
-	cmd.PushConstant(&data.fragment, 0, sizeof(StaticMeshFragment));
+		cmd.PushConstant(&data.fragment, 0, sizeof(StaticMeshFragment));
+	}
 
+	// Same buffers and offsets for every mesh, only the first draw of a command list actually binds them
 	cmd.BindVertexBuffer(0, *data.vbo_position, 0);
-	cmd.BindVertexBuffer(1, *data.vbo_varying_enable_blending, 0);
+	if (data.vbo_varying_enable_blending)
+		cmd.BindVertexBuffer(1, *data.vbo_varying_enable_blending, 0);
 	if (data.vbo_varying)
 		cmd.BindVertexBuffer(2, *data.vbo_varying, 0);
 	//if (data.vbo_joint_binding)
 	//	cmd.BindVertexBuffer(3, *data.vbo_joint_binding, 0);
-	cmd.BindIndexBuffer(*data.ibo, 0, IndexBufferFormat::UINT32);
+	if (data.ibo)
+		cmd.BindIndexBuffer(*data.ibo, 0, IndexBufferFormat::UINT32);
+}
+
+MeshBuffers::~MeshBuffers()
+{
+	if (!arena)
+		return;
+
+	arena->Free(vbo);
+	arena->Free(ibo);
 }
 
 void StaticMeshRender(rhi::CommandList& cmd, const RenderQueueTask* task, unsigned instance_count)
@@ -166,9 +222,20 @@ void StaticMeshRender(rhi::CommandList& cmd, const RenderQueueTask* task, unsign
 		//desc.usageBits = rhi::BufferUsageBits::BUFFER_USAGE_UNIFORM_BUFFER_BIT;
 		//Ref<rhi::Buffer> instance_buffer = RenderSystem::Get().GetDevice()->CreateBuffer(desc);
 		//glm::mat4* instance_data = static_cast<glm::mat4*>(instance_buffer->GetMappedDataPtr());
-		glm::mat4* ptr = static_cast<glm::mat4*>(cmd.AllocateConstantData(2, 0, sizeof(glm::mat4) * to_render));
-		for (unsigned j = 0; j < to_render; j++)
-			ptr[j] = static_cast<const StaticMeshPerInstanceData*>(task[i + j].instance_data)->vertex.model;
+		if (perdrawcall_data->instance_table)
+		{
+			// 4 bytes per instance instead of a matrix, packed into uvec4s (std140 array stride)
+			uint32_t* ids = static_cast<uint32_t*>(cmd.AllocateConstantData(2, 0, sizeof(uint32_t) * ((to_render + 3) & ~3u)));
+			for (unsigned j = 0; j < to_render; j++)
+				ids[j] = static_cast<const StaticMeshPerInstanceData*>(task[i + j].instance_data)->vertex.instance_id;
+			cmd.BindStorageBuffer(2, 1, *perdrawcall_data->instance_table, 0, perdrawcall_data->instance_table_size);
+		}
+		else
+		{
+			glm::mat4* ptr = static_cast<glm::mat4*>(cmd.AllocateConstantData(2, 0, sizeof(glm::mat4) * to_render));
+			for (unsigned j = 0; j < to_render; j++)
+				ptr[j] = static_cast<const StaticMeshPerInstanceData*>(task[i + j].instance_data)->vertex.model;
+		}
 		// cmd.BindUniformBuffer(2, 0, *instance_buffer.get(), 0, desc.size);
 
 		if (perdrawcall_data->ibo)
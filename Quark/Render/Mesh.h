@@ -1,6 +1,7 @@
 #pragma once
 #include "Quark/Render/IRenderable.h"
 #include "Quark/Render/Material.h"
+#include "Quark/Render/GeometryArena.h"
 #include "Quark/Asset/MeshAsset.h"
 #include "Quark/RHI/Common.h"
 
@@ -12,6 +13,7 @@ struct StaticMeshVertex
 {
 	glm::mat4 model;
 	glm::mat4* prevModel = nullptr;
+	uint32_t instance_id = 0; // used instead of model when the drawcall reads the GpuScene instance table
 	//mat4 Normal;
 	enum
 	{
@@ -30,12 +32,19 @@ struct StaticMeshFragment
 
 struct StaticMeshPerDrawcallData
 {
+	// All meshes share the geometry arena buffers, which are bound at offset 0. A mesh is addressed
+	// by vertex_offset and ibo_offset of the draw. Null if the mesh doesn't have the stream.
 	const rhi::Buffer* vbo_position;
-	const rhi::Buffer* vbo_varying_enable_blending;
-	const rhi::Buffer* vbo_varying;
+	const rhi::Buffer* vbo_varying_enable_blending = nullptr;
+	const rhi::Buffer* vbo_varying = nullptr;
 	const rhi::Buffer* ibo;
 	const rhi::Image* textures[util::ecast(TextureKind::Count)];
 	ShaderProgramVariant* shader_program;	// TODO: use ShaderProgramVariant
+	const rhi::Buffer* instance_table = nullptr; // GpuScene instances, instances are then uploaded as ids only
+	uint64_t instance_table_size = 0;
+	const rhi::Buffer* material_table = nullptr; // MaterialTable, the textures above are then unused
+	uint64_t material_table_size = 0;
+	uint32_t material_index = 0;
 
 	uint32_t ibo_offset = 0;
 	uint32_t vertex_offset = 0;
@@ -51,7 +60,7 @@ struct StaticMeshPerDrawcallData
 struct SkinnedMeshPerDrawCallData
 {
 	StaticMeshPerDrawcallData static_mesh_perdrawcall_data;
-	const rhi::Buffer* vbo_joint_binding;
+	const rhi::Buffer* vbo_joint_binding = nullptr;
 };
 
 struct StaticMeshPerInstanceData
@@ -66,16 +75,22 @@ struct SkinnedMeshPerInstanceData
 	uint32_t num_bones;
 };
 
+void BindMeshState(rhi::CommandList& cmd, const StaticMeshPerDrawcallData& data);
 void StaticMeshRender(rhi::CommandList& cmd, const RenderQueueTask*, unsigned instance_count);
 void SkinnedMeshRender(rhi::CommandList& cmd, const RenderQueueTask*, unsigned instance_count);
 
+// Ranges of a mesh inside the global GeometryArena. The vertex range is the same in every vertex stream,
+// indices live in the arena's index buffer. Offsets are resolved through the arena since defragmentation moves them.
 struct MeshBuffers
 {
-	Ref<rhi::Buffer> vbo_position;
-	Ref<rhi::Buffer> vbo_varying_enable_blending; // normal, tangent..
-	Ref<rhi::Buffer> vbo_varying; // uv, color...
-	Ref<rhi::Buffer> vbo_joint_binding; // for skinned mesh
-	Ref<rhi::Buffer> ibo;
+	GeometryArena* arena = nullptr;
+	GeometryArena::Handle vbo = GeometryArena::invalid_handle;
+	GeometryArena::Handle ibo = GeometryArena::invalid_handle;
+	bool has_varying_enable_blending = false; // normal, tangent..
+	bool has_varying = false; // uv, color...
+	bool has_joint_binding = false; // for skinned mesh
+
+	~MeshBuffers();
 };
 
 struct StaticMesh : public IRenderable
@@ -99,9 +114,12 @@ struct StaticMesh : public IRenderable
 
 	DrawPipeline GetMeshDrawPipeline() const override { return material->draw_pipeline; }
 
+	const StaticMesh* GetStaticMesh() const override { return this; }
+
 	static void GetAttribDefines(std::vector<std::pair<std::string, int>>& defines, uint32_t mask);
 
 protected:
+	friend class GpuDrivenRenderer;
 	void FillPerDrawcallData(StaticMeshPerDrawcallData& data) const;
 };
 
@@ -109,6 +127,8 @@ struct SkinnedMesh : public StaticMesh
 {
 	void GetRenderData(const RenderContext& context, const RenderInfoCmpt* transform,
 		RenderQueue& queue) const override;
+
+	const StaticMesh* GetStaticMesh() const override { return nullptr; } // joints are not in the gpu instance data
 };
 
 
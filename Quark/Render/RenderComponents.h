@@ -1,5 +1,6 @@
 #pragma once
 #include "Quark/Ecs/Component.h"
+#include "Quark/Core/Math/Aabb.h"
 
 #include <glm/glm.hpp>
 
@@ -12,7 +13,11 @@ class Skybox;
 struct RenderInfoCmpt : public Component
 {
 	QK_COMPONENT_TYPE_DECL(RenderInfoCmpt)
+	static constexpr uint32_t invalid_instance_id = ~0u;
+
 	glm::mat4 world_transform;
+	math::Aabb world_aabb; // static aabb of the renderable in world space
+	uint32_t instance_id = invalid_instance_id; // stable slot in gpu instance tables (GpuScene), set by Scene::AddRenderableComponent()
 
 	bool has_skin = false;
 	uint32_t num_bones = 0;
@@ -35,6 +35,11 @@ void RenderContext::SetLightingParameters(const LightingParameters* lighting)
 	m_lighting_params = lighting;
 }
 
+void RenderContext::SetGpuScene(const GpuScene* gpu_scene)
+{
+	m_gpu_scene = gpu_scene;
+}
+
 const CameraParameters& RenderContext::GetCameraParameters() const
 {
 	return m_camera_params;
@@ -50,4 +55,9 @@ const math::Frustum& RenderContext::GetVisibilityFrustum() const
 	return m_frustum;
 }
 
+const GpuScene* RenderContext::GetGpuScene() const
+{
+	return m_gpu_scene;
+}
+
 }
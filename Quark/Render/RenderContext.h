@@ -5,6 +5,7 @@
 
 namespace quark 
 {
+class GpuScene;
 
 // RenderContext is a class that holds global render data for a frame
 // that is shared between all renderables
@@ -14,14 +15,17 @@ public:
     void SetScene(const Scene* scene);
     void SetCamera(const glm::mat4& view, const glm::mat4& proj);
     void SetLightingParameters(const LightingParameters* lighting);
+    void SetGpuScene(const GpuScene* gpu_scene); // optional, static meshes then reference their instances by id
     
     const CameraParameters& GetCameraParameters() const;
     const LightingParameters* GetLightingParameters() const;
     const math::Frustum& GetVisibilityFrustum() const;
+    const GpuScene* GetGpuScene() const;
     
 private:
     const Scene* m_scene;
     const LightingParameters* m_lighting_params;
+    const GpuScene* m_gpu_scene = nullptr;
     CameraParameters m_camera_params;
     math::Frustum m_frustum;
 
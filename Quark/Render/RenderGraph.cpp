@@ -0,0 +1,491 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/RenderGraph.h"
+#include "Quark/Core/Profiler.h"
+
+namespace quark
+{
+
+using namespace rhi;
+
+// Physical images which were not used for this many frames are released
+static constexpr uint32_t RENDER_GRAPH_MAX_UNUSED_FRAMES = 8;
+
+struct AccessInfo
+{
+	ImageLayout layout;
+	uint32_t stages;
+	uint64_t access;
+	uint32_t usage;
+	bool write;
+};
+
+static AccessInfo GetAccessInfo(RenderGraphAccess access)
+{
+	switch (access)
+	{
+	case RenderGraphAccess::ColorOutput:
+		return { ImageLayout::COLOR_ATTACHMENT_OPTIMAL, PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			BARRIER_ACCESS_COLOR_ATTACHMENT_READ_BIT | BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true };
+	case RenderGraphAccess::DepthStencilOutput:
+		return { ImageLayout::DEPTH_STENCIL_ATTACHMENT_OPTIMAL, PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true };
+	case RenderGraphAccess::DepthStencilInput:
+		return { ImageLayout::DEPTH_STENCIL_READ_ONLY_OPTIMAL, PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			BARRIER_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false };
+	case RenderGraphAccess::TextureInput:
+		return { ImageLayout::SHADER_READ_ONLY_OPTIMAL, PIPELINE_STAGE_FRAGMENT_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			BARRIER_ACCESS_SHADER_READ_BIT, IMAGE_USAGE_SAMPLING_BIT, false };
+	case RenderGraphAccess::StorageImage:
+		return { ImageLayout::GENERAL, PIPELINE_STAGE_FRAGMENT_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			BARRIER_ACCESS_SHADER_READ_BIT | BARRIER_ACCESS_SHADER_WRITE_BIT, IMAGE_USAGE_STORAGE_BIT, true };
+	case RenderGraphAccess::TransferInput:
+		return { ImageLayout::TRANSFER_SRC_OPTIMAL, PIPELINE_STAGE_TRANSFER_BIT,
+			BARRIER_ACCESS_TRANSFER_READ_BIT, IMAGE_USAGE_CAN_COPY_FROM_BIT, false };
+	case RenderGraphAccess::TransferOutput:
+		return { ImageLayout::TRANSFER_DST_OPTIMAL, PIPELINE_STAGE_TRANSFER_BIT,
+			BARRIER_ACCESS_TRANSFER_WRITE_BIT, IMAGE_USAGE_CAN_COPY_TO_BIT, true };
+	default:
+		QK_CORE_ASSERT(0, "RenderGraphAccess not handled!");
+		return { ImageLayout::GENERAL, PIPELINE_STAGE_ALL_COMMANDS_BIT, BARRIER_ACCESS_MEMORY_READ_BIT | BARRIER_ACCESS_MEMORY_WRITE_BIT, 0, true };
+	}
+}
+
+// Does the pass depend on the previous contents of the image
+static bool ReadsContents(RenderGraphAccess access, RenderGraphPass::LoadOp load)
+{
+	switch (access)
+	{
+	case RenderGraphAccess::ColorOutput:
+	case RenderGraphAccess::DepthStencilOutput:
+		return load == RenderGraphPass::LoadOp::LOAD;
+	case RenderGraphAccess::TransferOutput:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/******************************** RenderGraphPass ********************************/
+
+void RenderGraphPass::AddColorOutput(RenderGraphResource res, LoadOp load, const ClearValue& clear)
+{
+	QK_CORE_ASSERT(m_num_color_outputs < MAX_COLOR_ATTHACHEMNT_NUM);
+	m_accesses.push_back({ res, RenderGraphAccess::ColorOutput, load, clear });
+	m_num_color_outputs++;
+}
+
+void RenderGraphPass::SetDepthStencilOutput(RenderGraphResource res, LoadOp load, const ClearValue& clear)
+{
+	QK_CORE_ASSERT(m_depth_access == ~0u, "Depth stencil attachment already set");
+	m_depth_access = (uint32_t)m_accesses.size();
+	m_accesses.push_back({ res, RenderGraphAccess::DepthStencilOutput, load, clear });
+}
+
+void RenderGraphPass::SetDepthStencilInput(RenderGraphResource res)
+{
+	QK_CORE_ASSERT(m_depth_access == ~0u, "Depth stencil attachment already set");
+	m_depth_access = (uint32_t)m_accesses.size();
+	m_accesses.push_back({ res, RenderGraphAccess::DepthStencilInput, LoadOp::LOAD });
+}
+
+void RenderGraphPass::AddTextureInput(RenderGraphResource res)
+{
+	m_accesses.push_back({ res, RenderGraphAccess::TextureInput });
+}
+
+void RenderGraphPass::AddStorageImage(RenderGraphResource res)
+{
+	m_accesses.push_back({ res, RenderGraphAccess::StorageImage });
+}
+
+void RenderGraphPass::AddTransferInput(RenderGraphResource res)
+{
+	m_accesses.push_back({ res, RenderGraphAccess::TransferInput });
+}
+
+void RenderGraphPass::AddTransferOutput(RenderGraphResource res)
+{
+	m_accesses.push_back({ res, RenderGraphAccess::TransferOutput });
+}
+
+/********************************** RenderGraph **********************************/
+
+RenderGraph::RenderGraph(Ref<rhi::Device> device)
+	: m_device(device)
+{
+	QK_CORE_VERIFY(m_device);
+}
+
+RenderGraph::~RenderGraph()
+{
+	Reset();
+	m_physical_images.clear();
+}
+
+RenderGraphResource RenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+{
+	QK_CORE_ASSERT(desc.width > 0 && desc.height > 0);
+
+	Resource& res = m_resources.emplace_back();
+	res.name = name;
+	res.desc = desc;
+	return RenderGraphResource(m_resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::ImportImage(const std::string& name, rhi::Image* image, ImageLayout initial_layout, ImageLayout final_layout)
+{
+	QK_CORE_ASSERT(image);
+
+	Resource& res = m_resources.emplace_back();
+	res.name = name;
+	res.imported = image;
+	res.desc.width = image->GetDesc().width;
+	res.desc.height = image->GetDesc().height;
+	res.desc.format = image->GetDesc().format;
+	res.desc.samples = image->GetDesc().samples;
+	res.desc.usageBits = image->GetDesc().usageBits;
+	res.initial_layout = initial_layout;
+	res.final_layout = final_layout;
+	res.output = final_layout != ImageLayout::UNDEFINED; // e.g. the swapchain image
+	return RenderGraphResource(m_resources.size() - 1);
+}
+
+void RenderGraph::MarkOutput(RenderGraphResource res)
+{
+	QK_CORE_ASSERT(res < m_resources.size());
+	m_resources[res].output = true;
+}
+
+RenderGraphPass& RenderGraph::AddPass(const std::string& name)
+{
+	QK_CORE_ASSERT(!m_compiled, "Can't add passes to a compiled graph");
+	m_passes.emplace_back(new RenderGraphPass(*this, (uint32_t)m_passes.size(), name));
+	return *m_passes.back();
+}
+
+void RenderGraph::Reset()
+{
+	for (auto& physical : m_physical_images)
+	{
+		if (!physical.used_this_frame)
+			physical.unused_frames++;
+
+		physical.used_this_frame = false;
+		physical.busy_until_pass = 0;
+	}
+
+	// Release images nobody asked for recently, e.g. after a viewport resize
+	m_physical_images.erase(std::remove_if(m_physical_images.begin(), m_physical_images.end(),
+		[](const PhysicalImage& p) { return p.unused_frames > RENDER_GRAPH_MAX_UNUSED_FRAMES; }), m_physical_images.end());
+
+	m_resources.clear();
+	m_passes.clear();
+	m_stats = {};
+	m_compiled = false;
+}
+
+void RenderGraph::Compile()
+{
+	QK_PROFILE_SCOPE("RenderGraph::Compile");
+	QK_CORE_ASSERT(!m_compiled);
+
+	CullPasses();
+	ComputeLifetimes();
+	AssignPhysicalImages();
+
+	m_stats.passes = (uint32_t)m_passes.size();
+	m_compiled = true;
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk backwards from the outputs. A pass survives if it has side effects or writes
+	// something a later surviving pass (or the outside world) needs.
+	std::vector<bool> needed(m_resources.size(), false);
+	for (size_t i = 0; i < m_resources.size(); i++)
+		needed[i] = m_resources[i].output;
+
+	for (auto it = m_passes.rbegin(); it != m_passes.rend(); ++it)
+	{
+		RenderGraphPass& pass = **it;
+
+		bool keep = pass.m_side_effect;
+		for (const auto& a : pass.m_accesses)
+		{
+			if (GetAccessInfo(a.access).write && needed[a.resource])
+				keep = true;
+		}
+
+		pass.m_culled = !keep;
+		if (!keep)
+		{
+			m_stats.culledPasses++;
+			continue;
+		}
+
+		// Contents overwritten without reading are not needed from earlier passes
+		for (const auto& a : pass.m_accesses)
+		{
+			if (GetAccessInfo(a.access).write && !ReadsContents(a.access, a.load))
+				needed[a.resource] = false;
+		}
+
+		for (const auto& a : pass.m_accesses)
+		{
+			if (ReadsContents(a.access, a.load))
+				needed[a.resource] = true;
+		}
+	}
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (auto& pass : m_passes)
+	{
+		if (pass->m_culled)
+			continue;
+
+		for (const auto& a : pass->m_accesses)
+		{
+			Resource& res = m_resources[a.resource];
+			res.first_pass = std::min(res.first_pass, pass->m_index);
+			res.last_pass = std::max(res.last_pass, pass->m_index);
+			res.desc.usageBits |= GetAccessInfo(a.access).usage;
+		}
+	}
+}
+
+void RenderGraph::AssignPhysicalImages()
+{
+	// Transient resources sorted by first use, so an image freed by an earlier resource can be picked up by a later one
+	std::vector<uint32_t> transients;
+	for (uint32_t i = 0; i < (uint32_t)m_resources.size(); i++)
+	{
+		Resource& res = m_resources[i];
+		if (res.imported)
+		{
+			res.state.layout = res.initial_layout;
+			res.state.write_stages = PIPELINE_STAGE_ALL_COMMANDS_BIT; // we don't know what happened to it before
+			res.state.write_access = BARRIER_ACCESS_MEMORY_WRITE_BIT;
+			continue;
+		}
+
+		if (res.first_pass != ~0u)
+			transients.push_back(i);
+	}
+
+	std::sort(transients.begin(), transients.end(), [&](uint32_t a, uint32_t b) {
+		return m_resources[a].first_pass < m_resources[b].first_pass;
+	});
+
+	for (uint32_t i : transients)
+	{
+		Resource& res = m_resources[i];
+
+		uint32_t found = ~0u;
+		for (uint32_t p = 0; p < (uint32_t)m_physical_images.size(); p++)
+		{
+			PhysicalImage& physical = m_physical_images[p];
+			if (!(physical.desc == res.desc))
+				continue;
+
+			// Alias if the previous user of this image is done before we start
+			if (!physical.used_this_frame || physical.busy_until_pass < res.first_pass)
+			{
+				found = p;
+				break;
+			}
+		}
+
+		if (found == ~0u)
+		{
+			ImageDesc desc;
+			desc.type = ImageType::TYPE_2D;
+			desc.width = res.desc.width;
+			desc.height = res.desc.height;
+			desc.depth = 1;
+			desc.mipLevels = 1;
+			desc.arraySize = 1;
+			desc.format = res.desc.format;
+			desc.samples = res.desc.samples;
+			desc.usageBits = res.desc.usageBits;
+			desc.initialLayout = ImageLayout::UNDEFINED;
+
+			PhysicalImage& physical = m_physical_images.emplace_back();
+			physical.image = m_device->CreateImage(desc);
+			physical.desc = res.desc;
+			m_device->SetName(physical.image, res.name.c_str());
+			found = (uint32_t)m_physical_images.size() - 1;
+
+			QK_CORE_LOGT_TAG("Renderer", "RenderGraph: created physical image for {} ({}x{})", res.name, desc.width, desc.height);
+		}
+
+		PhysicalImage& physical = m_physical_images[found];
+		physical.used_this_frame = true;
+		physical.unused_frames = 0;
+		physical.busy_until_pass = res.last_pass;
+		res.physical = found;
+
+		// Contents of a transient image are undefined at its first use
+		res.state = ImageState();
+		m_stats.transientImages++;
+	}
+
+	for (const auto& physical : m_physical_images)
+		m_stats.physicalImages += physical.used_this_frame ? 1 : 0;
+}
+
+rhi::Image* RenderGraph::GetImage(RenderGraphResource res) const
+{
+	QK_CORE_ASSERT(res < m_resources.size());
+	const Resource& r = m_resources[res];
+	if (r.imported)
+		return r.imported;
+	if (r.physical == ~0u)
+		return nullptr; // only used by culled passes
+
+	return m_physical_images[r.physical].image.get();
+}
+
+void RenderGraph::RequireState(Resource& res, RenderGraphAccess access, bool reads_contents, std::vector<PipelineImageBarrier>& barriers)
+{
+	AccessInfo info = GetAccessInfo(access);
+	ImageState& state = res.state;
+
+	bool layout_change = state.layout != info.layout;
+	bool hazard_raw = !info.write && state.write_stages != 0 && (info.stages & ~state.visible_stages) != 0;
+	bool hazard_waw_war = info.write && (state.write_stages != 0 || state.read_stages != 0);
+
+	if (!layout_change && !hazard_raw && !hazard_waw_war)
+	{
+		state.read_stages |= info.stages;
+		return;
+	}
+
+	PipelineImageBarrier& barrier = barriers.emplace_back();
+	barrier.image = GetImage(RenderGraphResource(&res - m_resources.data()));
+	barrier.srcStageBits = state.write_stages | state.read_stages;
+	if (barrier.srcStageBits == 0)
+		barrier.srcStageBits = PIPELINE_STAGE_ALL_COMMANDS_BIT; // may still be in use by a previous frame
+	barrier.srcMemoryAccessBits = state.write_access;
+	barrier.dstStageBits = info.stages;
+	barrier.dstMemoryAccessBits = info.access;
+	// Discard the old contents if nobody reads them, this is what makes aliasing free
+	barrier.layoutBefore = reads_contents ? state.layout : ImageLayout::UNDEFINED;
+	barrier.layoutAfter = info.layout;
+
+	state.layout = info.layout;
+	if (info.write)
+	{
+		state.write_stages = info.stages;
+		state.write_access = info.access;
+		state.visible_stages = 0;
+		state.read_stages = 0;
+	}
+	else
+	{
+		// Keep the earlier readers, the next writer has to wait for all of them
+		state.visible_stages |= info.stages;
+		state.read_stages |= info.stages;
+	}
+}
+
+void RenderGraph::Execute(rhi::CommandList& cmd)
+{
+	QK_PROFILE_SCOPE("RenderGraph::Execute");
+	QK_CORE_ASSERT(m_compiled, "RenderGraph::Compile() must be called before Execute()");
+
+	std::vector<PipelineImageBarrier> barriers;
+	for (auto& pass_ptr : m_passes)
+	{
+		RenderGraphPass& pass = *pass_ptr;
+		if (pass.m_culled)
+			continue;
+
+		cmd.BeginRegion(pass.m_name.c_str());
+
+		// Barriers of all resources of the pass are batched in one call
+		barriers.clear();
+		for (const auto& a : pass.m_accesses)
+			RequireState(m_resources[a.resource], a.access, ReadsContents(a.access, a.load), barriers);
+
+		if (!barriers.empty())
+		{
+			cmd.PipeLineBarriers(nullptr, 0, barriers.data(), (uint32_t)barriers.size(), nullptr, 0);
+			m_stats.barriers += (uint32_t)barriers.size();
+		}
+
+		if (pass.IsRenderPass())
+		{
+			RenderPassInfo rp_info;
+			FrameBufferInfo fb_info;
+
+			for (const auto& a : pass.m_accesses)
+			{
+				const Resource& res = m_resources[a.resource];
+				Image* image = GetImage(a.resource);
+
+				// Nothing reads a transient attachment after its last pass
+				bool store = res.imported || res.output || res.last_pass > pass.m_index;
+				auto store_op = store ? FrameBufferInfo::AttachmentStoreOp::STORE : FrameBufferInfo::AttachmentStoreOp::DONTCARE;
+
+				if (a.access == RenderGraphAccess::ColorOutput)
+				{
+					uint32_t idx = rp_info.numColorAttachments++;
+					rp_info.colorAttachmentFormats[idx] = res.desc.format;
+					rp_info.sampleCount = res.desc.samples;
+					fb_info.colorAttachments[idx] = &image->GetDefaultView();
+					fb_info.colorAttatchemtsLoadOp[idx] = a.load;
+					fb_info.colorAttatchemtsStoreOp[idx] = store_op;
+					fb_info.clearColors[idx] = a.clear;
+				}
+				else if (a.access == RenderGraphAccess::DepthStencilOutput || a.access == RenderGraphAccess::DepthStencilInput)
+				{
+					rp_info.depthAttachmentFormat = res.desc.format;
+					fb_info.depthAttachment = &image->GetDefaultView();
+					fb_info.depthAttachmentLoadOp = a.load;
+					fb_info.depthAttachmentStoreOp = store_op;
+					fb_info.clearDepthStencil = a.clear;
+				}
+			}
+
+			cmd.BeginRenderPass(rp_info, fb_info);
+			if (pass.m_execute)
+				pass.m_execute(cmd);
+			cmd.EndRenderPass();
+		}
+		else if (pass.m_execute)
+		{
+			pass.m_execute(cmd);
+		}
+
+		cmd.EndRegion();
+	}
+
+	// Hand imported images back in the layout the outside world expects
+	barriers.clear();
+	for (auto& res : m_resources)
+	{
+		if (!res.imported || res.final_layout == ImageLayout::UNDEFINED || res.first_pass == ~0u)
+			continue;
+		if (res.state.layout == res.final_layout)
+			continue;
+
+		PipelineImageBarrier& barrier = barriers.emplace_back();
+		barrier.image = res.imported;
+		barrier.srcStageBits = res.state.write_stages | res.state.read_stages;
+		barrier.srcMemoryAccessBits = res.state.write_access;
+		barrier.dstStageBits = res.final_layout == ImageLayout::PRESENT ? PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		barrier.dstMemoryAccessBits = res.final_layout == ImageLayout::PRESENT ? 0 : BARRIER_ACCESS_MEMORY_READ_BIT;
+		barrier.layoutBefore = res.state.layout;
+		barrier.layoutAfter = res.final_layout;
+	}
+
+	if (!barriers.empty())
+	{
+		cmd.PipeLineBarriers(nullptr, 0, barriers.data(), (uint32_t)barriers.size(), nullptr, 0);
+		m_stats.barriers += (uint32_t)barriers.size();
+	}
+}
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include "Quark/Core/Base.h"
+#include "Quark/RHI/Device.h"
+
+#include <functional>
+
+namespace quark
+{
+class RenderGraph;
+
+using RenderGraphResource = uint32_t;
+constexpr RenderGraphResource RENDER_GRAPH_INVALID_RESOURCE = ~0u;
+
+// How a pass touches an image. Decides the layout, pipeline stages and memory access
+// the graph has to transition the image into before the pass runs.
+enum class RenderGraphAccess : uint8_t
+{
+	ColorOutput,
+	DepthStencilOutput,
+	DepthStencilInput,	// read-only depth test
+	TextureInput,		// sampled in fragment/compute shader
+	StorageImage,		// read-write in fragment/compute shader
+	TransferInput,		// copy/blit source
+	TransferOutput,		// copy/blit destination
+};
+
+struct RenderGraphImageDesc
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	rhi::DataFormat format = rhi::DataFormat::R8G8B8A8_UNORM;
+	rhi::SampleCount samples = rhi::SampleCount::SAMPLES_1;
+	uint32_t usageBits = 0; // extra usage, the usage implied by the pass accesses is added by the graph
+
+	bool operator==(const RenderGraphImageDesc& other) const
+	{
+		return width == other.width && height == other.height && format == other.format &&
+			samples == other.samples && usageBits == other.usageBits;
+	}
+};
+
+class RenderGraphPass
+{
+public:
+	using ExecuteFunc = std::function<void(rhi::CommandList&)>;
+	using LoadOp = rhi::FrameBufferInfo::AttachmentLoadOp;
+
+	void AddColorOutput(RenderGraphResource res, LoadOp load = LoadOp::CLEAR, const rhi::ClearValue& clear = {});
+	void SetDepthStencilOutput(RenderGraphResource res, LoadOp load = LoadOp::CLEAR, const rhi::ClearValue& clear = { 1.f, 0 });
+	void SetDepthStencilInput(RenderGraphResource res);
+	void AddTextureInput(RenderGraphResource res);
+	void AddStorageImage(RenderGraphResource res);
+	void AddTransferInput(RenderGraphResource res);
+	void AddTransferOutput(RenderGraphResource res);
+
+	// Passes with side effects (e.g. readbacks to cpu memory) are never culled
+	void SetSideEffect() { m_side_effect = true; }
+	void SetExecute(ExecuteFunc&& func) { m_execute = std::move(func); }
+
+	const std::string& GetName() const { return m_name; }
+	bool IsCulled() const { return m_culled; }
+
+private:
+	friend class RenderGraph;
+
+	struct Access
+	{
+		RenderGraphResource resource;
+		RenderGraphAccess access;
+		LoadOp load = LoadOp::DONTCARE;
+		rhi::ClearValue clear = {};
+	};
+
+	RenderGraphPass(RenderGraph& graph, uint32_t index, const std::string& name)
+		: m_graph(graph), m_index(index), m_name(name) {}
+
+	bool IsRenderPass() const { return m_num_color_outputs > 0 || m_depth_access != ~0u; }
+
+	RenderGraph& m_graph;
+	uint32_t m_index;
+	std::string m_name;
+	std::vector<Access> m_accesses;
+	uint32_t m_num_color_outputs = 0;
+	uint32_t m_depth_access = ~0u; // index into m_accesses
+	ExecuteFunc m_execute;
+	bool m_side_effect = false;
+	bool m_culled = false;
+};
+
+// Frame graph on top of rhi::CommandList.
+// Passes declare which images they read and write, the graph then
+// 1. culls passes which don't contribute to an output,
+// 2. assigns transient images to pooled physical images, images with the same desc
+//    and disjoint lifetimes share one physical image,
+// 3. computes the image barriers between passes and begins/ends render passes.
+// The graph is rebuilt every frame, physical images are kept across frames.
+class RenderGraph
+{
+public:
+	struct Stats
+	{
+		uint32_t passes = 0;
+		uint32_t culledPasses = 0;
+		uint32_t barriers = 0;
+		uint32_t transientImages = 0;
+		uint32_t physicalImages = 0;
+	};
+
+	RenderGraph(Ref<rhi::Device> device);
+	~RenderGraph();
+
+	// Declare resources
+	RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+	RenderGraphResource ImportImage(const std::string& name, rhi::Image* image,
+		rhi::ImageLayout initial_layout, rhi::ImageLayout final_layout = rhi::ImageLayout::UNDEFINED);
+	void MarkOutput(RenderGraphResource res);
+
+	RenderGraphPass& AddPass(const std::string& name);
+
+	void Compile();
+	void Execute(rhi::CommandList& cmd);
+
+	// Clear all declarations for the next frame
+	void Reset();
+
+	// Valid after Compile()
+	rhi::Image* GetImage(RenderGraphResource res) const;
+	const Stats& GetStats() const { return m_stats; }
+
+private:
+	friend class RenderGraphPass;
+
+	struct ImageState
+	{
+		rhi::ImageLayout layout = rhi::ImageLayout::UNDEFINED;
+		uint32_t write_stages = 0;
+		uint64_t write_access = 0;
+		uint32_t visible_stages = 0;	// stages the last write has been made visible to
+		uint32_t read_stages = 0;		// stages which read the image since the last write
+	};
+
+	struct Resource
+	{
+		std::string name;
+		RenderGraphImageDesc desc;
+		rhi::Image* imported = nullptr;
+		rhi::ImageLayout initial_layout = rhi::ImageLayout::UNDEFINED;
+		rhi::ImageLayout final_layout = rhi::ImageLayout::UNDEFINED;
+		bool output = false;
+
+		// compiled
+		uint32_t first_pass = ~0u;
+		uint32_t last_pass = 0;
+		uint32_t physical = ~0u;
+		ImageState state;
+	};
+
+	struct PhysicalImage
+	{
+		Ref<rhi::Image> image;
+		RenderGraphImageDesc desc;
+		uint32_t busy_until_pass = 0;	// last pass of the transient resource currently aliased on it
+		bool used_this_frame = false;
+		uint32_t unused_frames = 0;
+	};
+
+	void CullPasses();
+	void ComputeLifetimes();
+	void AssignPhysicalImages();
+	void RequireState(Resource& res, RenderGraphAccess access, bool reads_contents, std::vector<rhi::PipelineImageBarrier>& barriers);
+
+	Ref<rhi::Device> m_device;
+	std::vector<Resource> m_resources;
+	std::vector<Scope<RenderGraphPass>> m_passes;
+	std::vector<PhysicalImage> m_physical_images;
+	Stats m_stats;
+	bool m_compiled = false;
+};
+
+}
@@ -35,13 +35,29 @@ struct DirectionalParameters
 	alignas(16) glm::vec3 direction;
 };
 
+// L2 spherical harmonics of the irradiance, rgb in xyz, see SphericalHarmonics.h and lighting_parameters.glslh
+struct IrradianceParameters
+{
+	glm::vec4 sh[9];
+
+	// The same irradiance from every direction, the shaders' former constant ambient term is Uniform(vec3(0.1 * pi))
+	static IrradianceParameters Uniform(const glm::vec3& irradiance)
+	{
+		IrradianceParameters params = {};
+		params.sh[0] = glm::vec4(irradiance / 0.282095f, 0.f);
+		return params;
+	}
+};
+
 struct CombinedRenderParameters
 {
 	alignas(16) DirectionalParameters directional;
+	alignas(16) IrradianceParameters irradiance;
 };
 struct LightingParameters
 {
 	DirectionalParameters directional;
+	IrradianceParameters irradiance = IrradianceParameters::Uniform(glm::vec3(0.1f * 3.14159265f));
 };
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Quark/Render/IRenderable.h"
 #include "Quark/Render/RenderContext.h"
 #include "Quark/Core/Math/Util.h"
+#include "Quark/Core/Profiler.h"
 
 namespace quark
 {
@@ -39,6 +40,8 @@ const RenderQueue::RenderQueueTaskVector RenderQueue::GetQueueTasks(Queue queue_
 
 void RenderQueue::PushRenderables(const RenderContext& context, const RenderableInfo* renderables, size_t count)
 {
+	QK_PROFILE_SCOPE("RenderQueue::PushRenderables");
+
 	for (size_t i = 0; i < count; i++)
 	{
 		renderables[i].renderable->GetRenderData(context, renderables[i].render_info, *this);
@@ -57,6 +60,8 @@ void RenderQueue::Reset()
 
 void RenderQueue::Sort()
 {
+	QK_PROFILE_SCOPE("RenderQueue::Sort");
+
 	for (auto& q : m_queues)
 	{
 		q.util_indices.resize(q.raw_input.size());
@@ -77,16 +82,24 @@ void RenderQueue::Sort()
 
 void RenderQueue::Dispatch(Queue que, rhi::CommandList& cmd) const
 {
+	Dispatch(que, cmd, { 0, m_queues[util::ecast(que)].sorted_output.size() });
+}
+
+void RenderQueue::Dispatch(Queue que, rhi::CommandList& cmd, const TaskRange& range) const
+{
+	QK_PROFILE_SCOPE("RenderQueue::Dispatch");
+
 	const RenderQueueTaskVector& queue = m_queues[util::ecast(que)];
 
 	// assert that we did in fact sort.
 	QK_CORE_ASSERT(m_queues[util::ecast(que)].sorted_output.size() == m_queues[util::ecast(que)].raw_input.size());
+	QK_CORE_ASSERT(range.begin <= range.end && range.end <= queue.sorted_output.size());
 
 	const RenderQueueTask* tasks = queue.sorted_output.data();
-	size_t begin = 0, end = queue.sorted_output.size();
+	size_t begin = range.begin, end = range.end;
 	while (begin < end)
 	{
-		uint8_t instances = 1;
+		unsigned instances = 1;
 		for (size_t i = begin + 1; i < end && tasks[i].perdrawcall_data == tasks[begin].perdrawcall_data; i++)
 		{
 			QK_CORE_ASSERT(tasks[i].render == tasks[begin].render);
@@ -97,6 +110,27 @@ void RenderQueue::Dispatch(Queue que, rhi::CommandList& cmd) const
 	}
 }
 
+void RenderQueue::GetSlices(Queue que, uint32_t slice_count, std::vector<TaskRange>& slices, size_t min_slice_size) const
+{
+	slices.clear();
+
+	const std::vector<RenderQueueTask>& tasks = m_queues[util::ecast(que)].sorted_output;
+	if (tasks.empty() || slice_count == 0)
+		return;
+
+	const size_t target_size = std::max((tasks.size() + slice_count - 1) / slice_count, std::max<size_t>(min_slice_size, 1));
+	size_t begin = 0;
+	while (begin < tasks.size())
+	{
+		size_t end = std::min(begin + target_size, tasks.size());
+		while (end < tasks.size() && tasks[end].perdrawcall_data == tasks[end - 1].perdrawcall_data)
+			end++;
+
+		slices.push_back({ begin, end });
+		begin = end;
+	}
+}
+
 RenderQueue::Block* RenderQueue::InsertBlock()
 {
 	Block* ret = m_block_pool.allocate();
@@ -92,6 +92,13 @@ struct PerDrawcallDataWrapped : public PerDrawcallDataWrappedErased
 class RenderQueue 
 {
 public:
+    // [begin, end) of a sorted queue
+    struct TaskRange
+    {
+        size_t begin;
+        size_t end;
+    };
+
     struct RenderQueueTaskVector
     {
         static const size_t init_size = 64;
@@ -176,6 +183,12 @@ public:
     void Reset();
     void Sort();
     void Dispatch(Queue que, rhi::CommandList& cmd) const;
+    void Dispatch(Queue que, rhi::CommandList& cmd, const TaskRange& range) const;
+
+    // Splits the sorted queue into at most slice_count ranges of about the same size, but no smaller than
+    // min_slice_size, which can be dispatched into separate command lists. Instances of one draw call are
+    // never split across two ranges.
+    void GetSlices(Queue que, uint32_t slice_count, std::vector<TaskRange>& slices, size_t min_slice_size = 1) const;
 
 private:
     struct Block 
@@ -13,6 +13,7 @@ RenderResourceManager::RenderResourceManager(Ref<rhi::Device> device)
 
     QK_CORE_VERIFY(device);
     m_shader_library = CreateScope<ShaderLibrary>();
+    m_geometry_arena = CreateScope<GeometryArena>(m_device);
 
     // depth stencil states
     {
@@ -242,6 +243,12 @@ RenderResourceManager::RenderResourceManager(Ref<rhi::Device> device)
         default_material->shader_program = GetShaderLibrary().program_staticMesh;
         default_material->hash = 1; // TODO: any better way?
     }
+
+    if (device->GetDeviceFeatures().bindless)
+    {
+        m_material_table = CreateScope<MaterialTable>(device, *sampler_linear);
+        m_material_table->Register(*default_material);
+    }
 }
 
 std::vector<Ref<StaticMesh>> RenderResourceManager::RequestStaticMeshRenderables(Ref<MeshAsset> mesh_asset)
@@ -294,135 +301,67 @@ Ref<MeshBuffers> RenderResourceManager::RequestMeshBuffers(Ref<MeshAsset> mesh_a
         return find->second;
 
     Ref<MeshBuffers> new_mesh_buffers = CreateRef<MeshBuffers>();
+    new_mesh_buffers->arena = m_geometry_arena.get();
 
     // upload index buffer
-    uint32_t index_buffer_size = sizeof(uint32_t) * mesh_asset->indices.size();
-    uint32_t* index_buffer_data = mesh_asset->indices.data();
-
-    rhi::BufferDesc index_buffer_desc;
-    index_buffer_desc.size = index_buffer_size;
-    index_buffer_desc.usageBits = rhi::BUFFER_USAGE_INDEX_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT;
-    index_buffer_desc.domain = rhi::BufferMemoryDomain::GPU;
-    new_mesh_buffers->ibo = m_device->CreateBuffer(index_buffer_desc, index_buffer_data);
-
-    // prepare staging buffer
-    uint64_t vertex_position_buffer_size = sizeof(glm::vec3) * mesh_asset->vertex_positions.size();
-    uint64_t vertex_varying_enable_blending_buffer_size = 0;
-    uint64_t vertex_varying_buffer_size = 0;
-    uint64_t vertex_joint_binding_buffer_size = 0;
-
-    if (!mesh_asset->vertex_normals.empty())
-        vertex_varying_enable_blending_buffer_size += sizeof(glm::vec3) * mesh_asset->vertex_normals.size();
-    if (!mesh_asset->vertex_tangents.empty())
-        vertex_varying_enable_blending_buffer_size += sizeof(glm::vec3) * mesh_asset->vertex_tangents.size();
-    if (!mesh_asset->vertex_uvs.empty())
-        vertex_varying_buffer_size += sizeof(glm::vec2) * mesh_asset->vertex_uvs.size();
-    if (!mesh_asset->vertex_colors.empty())
-        vertex_varying_buffer_size += sizeof(glm::vec4) * mesh_asset->vertex_colors.size();
-    if (!mesh_asset->vertex_bone_indices.empty())
-        vertex_joint_binding_buffer_size += sizeof(glm::uvec4) * mesh_asset->vertex_bone_indices.size();
-    if (!mesh_asset->vertex_bone_weights.empty())
-        vertex_joint_binding_buffer_size += sizeof(glm::vec4) * mesh_asset->vertex_bone_weights.size();
-
-    rhi::BufferDesc stage_buffer_desc;
-    stage_buffer_desc.size = vertex_position_buffer_size + vertex_varying_enable_blending_buffer_size +
-        vertex_varying_buffer_size + vertex_joint_binding_buffer_size;
-    stage_buffer_desc.usageBits = rhi::BUFFER_USAGE_TRANSFER_FROM_BIT;
-    stage_buffer_desc.domain = rhi::BufferMemoryDomain::CPU;
-    Ref<rhi::Buffer> stage_buffer = m_device->CreateBuffer(stage_buffer_desc, nullptr);
-    void* stage_buffer_data = stage_buffer->GetMappedDataPtr();
-    QK_CORE_VERIFY(stage_buffer_data, "Failed to map stage buffer");
-
-    // upload vertex data to staging buffer
-    uint64_t vertex_position_buffer_offset = 0;
-    uint64_t vertex_varying_enable_blending_buffer_offset = vertex_position_buffer_offset + vertex_position_buffer_size;
-    uint64_t vertex_varying_buffer_offset = vertex_varying_enable_blending_buffer_offset + vertex_varying_enable_blending_buffer_size;
-    uint64_t vertex_joint_binding_buffer_offset = vertex_varying_buffer_offset + vertex_varying_buffer_size;
-
-    glm::vec3* vertex_positions_buffer_data = reinterpret_cast<glm::vec3*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_position_buffer_offset);
-    uint8_t* vertex_varying_enable_blending_buffer_data = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_varying_enable_blending_buffer_offset);
-    uint8_t* vertex_varying_buffer_data = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_varying_buffer_offset);
-    uint8_t* vertex_joint_binding_buffer_data = reinterpret_cast<uint8_t*>(reinterpret_cast<uintptr_t>(stage_buffer_data) + vertex_joint_binding_buffer_offset);
-
-    size_t offset_in_vertex_varying_enable_blending_buffer = 0;
-    size_t offset_in_vertex_varying_buffer = 0;
-    size_t offset_in_vertex_joint_binding_buffer = 0;
-    for (uint32_t i = 0; i < mesh_asset->GetVertexCount(); ++i)
-    {
-        vertex_positions_buffer_data[i] = mesh_asset->vertex_positions[i];
-
-        if (!mesh_asset->vertex_normals.empty())
-        {
-            memcpy(vertex_varying_enable_blending_buffer_data + offset_in_vertex_varying_enable_blending_buffer,
-                &mesh_asset->vertex_normals[i], sizeof(glm::vec3));
-            offset_in_vertex_varying_enable_blending_buffer += sizeof(glm::vec3);
-        }
-
-        if (!mesh_asset->vertex_tangents.empty())
-        {
-            memcpy(vertex_varying_enable_blending_buffer_data + offset_in_vertex_varying_enable_blending_buffer,
-                &mesh_asset->vertex_tangents[i], sizeof(glm::vec3));
-            offset_in_vertex_varying_enable_blending_buffer += sizeof(glm::vec3);
-        }
-
-        if (!mesh_asset->vertex_uvs.empty())
-        {
-            memcpy(vertex_varying_buffer_data + offset_in_vertex_varying_buffer,
-                &mesh_asset->vertex_uvs[i], sizeof(glm::vec2));
-            offset_in_vertex_varying_buffer += sizeof(glm::vec2);
-        }
-
-        if (!mesh_asset->vertex_colors.empty())
-        {
-            memcpy(vertex_varying_buffer_data + offset_in_vertex_varying_buffer,
-                &mesh_asset->vertex_colors[i], sizeof(glm::vec4));
-            offset_in_vertex_varying_buffer += sizeof(glm::vec4);
-        }
-
-        if (!mesh_asset->vertex_bone_indices.empty())
-        {
-            memcpy(vertex_joint_binding_buffer_data + offset_in_vertex_joint_binding_buffer,
-                &mesh_asset->vertex_bone_indices[i], sizeof(glm::uvec4));
-            offset_in_vertex_joint_binding_buffer += sizeof(glm::uvec4);
-        }
-
-        if (!mesh_asset->vertex_bone_weights.empty())
-        {
-            memcpy(vertex_joint_binding_buffer_data + offset_in_vertex_joint_binding_buffer,
-                &mesh_asset->vertex_bone_weights[i], sizeof(glm::vec4));
-            offset_in_vertex_joint_binding_buffer += sizeof(glm::vec4);
-        }
-
+    if (!mesh_asset->indices.empty())
+    {
+        uint32_t index_count = (uint32_t)mesh_asset->indices.size();
+        new_mesh_buffers->ibo = m_geometry_arena->Allocate(GeometryArena::Stream::Index, index_count);
+        m_geometry_arena->UploadIndices(new_mesh_buffers->ibo, mesh_asset->indices.data(), index_count);
     }
 
-    // copy staging buffer to gpu buffer
-    rhi::BufferDesc buffer_desc;
-    buffer_desc.domain = rhi::BufferMemoryDomain::GPU;
-    buffer_desc.usageBits = rhi::BUFFER_USAGE_VERTEX_BUFFER_BIT | rhi::BUFFER_USAGE_TRANSFER_TO_BIT;
+    // One vertex range in all streams of the arena, each stream has a fixed stride and attributes the mesh
+    // doesn't have are left as padding. The attribute offsets are the ones of RequestMeshVertexLayout().
+    using VertexStream = GeometryArena::VertexStream;
+    const uint32_t vertex_count = mesh_asset->GetVertexCount();
+    new_mesh_buffers->vbo = m_geometry_arena->Allocate(GeometryArena::Stream::Vertex, vertex_count);
+    m_geometry_arena->Upload(new_mesh_buffers->vbo, VertexStream::Position, mesh_asset->vertex_positions.data(), sizeof(glm::vec3) * vertex_count);
 
-    buffer_desc.size = vertex_position_buffer_size;
-    new_mesh_buffers->vbo_position = m_device->CreateBuffer(buffer_desc, nullptr);
-    m_device->CopyBuffer(*new_mesh_buffers->vbo_position, *stage_buffer, vertex_position_buffer_size, 0, vertex_position_buffer_offset);
+    std::vector<uint8_t> stream_data;
+    auto upload_stream = [&](VertexStream stream, auto&& write_vertex)
+    {
+        const uint32_t stride = GeometryArena::vertex_stream_strides[util::ecast(stream)];
+        stream_data.assign(uint64_t(stride) * vertex_count, 0);
+        for (uint32_t i = 0; i < vertex_count; ++i)
+            write_vertex(stream_data.data() + uint64_t(stride) * i, i);
+        m_geometry_arena->Upload(new_mesh_buffers->vbo, stream, stream_data.data(), stream_data.size());
+    };
 
-    if (vertex_varying_enable_blending_buffer_size > 0)
+    new_mesh_buffers->has_varying_enable_blending = !mesh_asset->vertex_normals.empty() || !mesh_asset->vertex_tangents.empty();
+    if (new_mesh_buffers->has_varying_enable_blending)
     {
-        buffer_desc.size = vertex_varying_enable_blending_buffer_size;
-        new_mesh_buffers->vbo_varying_enable_blending = m_device->CreateBuffer(buffer_desc, nullptr);
-        m_device->CopyBuffer(*new_mesh_buffers->vbo_varying_enable_blending, *stage_buffer, vertex_varying_enable_blending_buffer_size, 0, vertex_varying_enable_blending_buffer_offset);
+        upload_stream(VertexStream::VaryingEnableBlending, [&](uint8_t* vertex, uint32_t i)
+        {
+            if (!mesh_asset->vertex_normals.empty())
+                memcpy(vertex, &mesh_asset->vertex_normals[i], sizeof(glm::vec3));
+            if (!mesh_asset->vertex_tangents.empty())
+                memcpy(vertex + sizeof(glm::vec3), &mesh_asset->vertex_tangents[i], sizeof(glm::vec3));
+        });
     }
 
-    if (vertex_varying_buffer_size > 0)
+    new_mesh_buffers->has_varying = !mesh_asset->vertex_uvs.empty() || !mesh_asset->vertex_colors.empty();
+    if (new_mesh_buffers->has_varying)
     {
-        buffer_desc.size = vertex_varying_buffer_size;
-        new_mesh_buffers->vbo_varying = m_device->CreateBuffer(buffer_desc, nullptr);
-        m_device->CopyBuffer(*new_mesh_buffers->vbo_varying, *stage_buffer, vertex_varying_buffer_size, 0, vertex_varying_buffer_offset);
+        upload_stream(VertexStream::Varying, [&](uint8_t* vertex, uint32_t i)
+        {
+            if (!mesh_asset->vertex_uvs.empty())
+                memcpy(vertex, &mesh_asset->vertex_uvs[i], sizeof(glm::vec2));
+            if (!mesh_asset->vertex_colors.empty())
+                memcpy(vertex + sizeof(glm::vec2), &mesh_asset->vertex_colors[i], sizeof(glm::vec4));
+        });
     }
 
-    if (vertex_joint_binding_buffer_size > 0)
+    new_mesh_buffers->has_joint_binding = !mesh_asset->vertex_bone_indices.empty() || !mesh_asset->vertex_bone_weights.empty();
+    if (new_mesh_buffers->has_joint_binding)
     {
-        buffer_desc.size = vertex_joint_binding_buffer_size;
-        new_mesh_buffers->vbo_joint_binding = m_device->CreateBuffer(buffer_desc, nullptr);
-        m_device->CopyBuffer(*new_mesh_buffers->vbo_joint_binding, *stage_buffer, vertex_joint_binding_buffer_size, 0, vertex_joint_binding_buffer_offset);
+        upload_stream(VertexStream::JointBinding, [&](uint8_t* vertex, uint32_t i)
+        {
+            if (!mesh_asset->vertex_bone_indices.empty())
+                memcpy(vertex, &mesh_asset->vertex_bone_indices[i], sizeof(glm::uvec4));
+            if (!mesh_asset->vertex_bone_weights.empty())
+                memcpy(vertex + sizeof(glm::uvec4), &mesh_asset->vertex_bone_weights[i], sizeof(glm::vec4));
+        });
     }
 
     m_mesh_buffers[mesh_asset->GetAssetID()] = new_mesh_buffers;
@@ -469,6 +408,9 @@ Ref<PBRMaterial> RenderResourceManager::RequestMateral(Ref<MaterialAsset> mat_as
     else
         new_material->shader_program = m_shader_library->RequestGraphicsProgram(mat_asset->vertexShaderPath, mat_asset->fragmentShaderPath);
 
+    if (m_material_table)
+        m_material_table->Register(*new_material);
+
     m_materials[mat_asset->GetAssetID()] = new_material;
 
     return new_material;
@@ -554,10 +496,9 @@ Ref<rhi::PipeLine> RenderResourceManager::RequestGraphicsPSO(ShaderProgramVarian
     }
 
     util::Hash hash = h.get();
-    auto it = m_cached_psos.find(hash);
-    if (it != m_cached_psos.end())
+    if (Ref<rhi::PipeLine> cached = FindPSO(hash))
     {
-        return it->second;
+        return cached;
     }
     else
     {
@@ -572,10 +513,7 @@ Ref<rhi::PipeLine> RenderResourceManager::RequestGraphicsPSO(ShaderProgramVarian
         if (vertex_layout.isValid())
             desc.vertexInputLayout = vertex_layout;
 
-        Ref<rhi::PipeLine> newPipeline = m_device->CreateGraphicPipeLine(desc);
-        m_cached_psos[hash] = newPipeline;
-
-        return newPipeline;
+        return InsertPSO(hash, m_device->CreateGraphicPipeLine(desc));
     }
 }
 
@@ -587,10 +525,9 @@ Ref<rhi::PipeLine> RenderResourceManager::RequestFullScreenQuadPSO(ShaderProgram
     h.u32(depth_write);
     h.u32(util::ecast(depth_compare));
 
-    auto find = m_cached_psos.find(h.get());
-    if (find != m_cached_psos.end())
+    if (Ref<rhi::PipeLine> cached = FindPSO(h.get()))
     {
-        return find->second;
+        return cached;
     }
     else
     {
@@ -611,16 +548,37 @@ Ref<rhi::PipeLine> RenderResourceManager::RequestFullScreenQuadPSO(ShaderProgram
         desc.topologyType = rhi::TopologyType::TRANGLE_LIST;
         desc.renderPassInfo = rp_info;
         desc.vertexInputLayout = vertexInputLayout_fullscreenQuad;
-        Ref<rhi::PipeLine> newPipeline = m_device->CreateGraphicPipeLine(desc);
-		m_cached_psos[h.get()] = newPipeline;
-
-		return newPipeline;
-
+        return InsertPSO(h.get(), m_device->CreateGraphicPipeLine(desc));
     }
 
     return nullptr;
 }
 
+Ref<rhi::PipeLine> RenderResourceManager::RequestComputePSO(ShaderProgramVariant& program)
+{
+    if (Ref<rhi::PipeLine> cached = FindPSO(program.GetHash()))
+        return cached;
+
+    rhi::ComputePipeLineDesc desc;
+    desc.compShader = program.GetShader(rhi::ShaderStage::STAGE_COMPUTE);
+    return InsertPSO(program.GetHash(), m_device->CreateComputePipeLine(desc));
+}
+
+Ref<rhi::PipeLine> RenderResourceManager::FindPSO(uint64_t hash) const
+{
+    util::RWSpinLockReadHolder holder(m_pso_lock);
+    auto find = m_cached_psos.find(hash);
+    return find != m_cached_psos.end() ? find->second : nullptr;
+}
+
+Ref<rhi::PipeLine> RenderResourceManager::InsertPSO(uint64_t hash, Ref<rhi::PipeLine> pso)
+{
+    // Pipelines are compiled without holding the lock, if two threads compiled the same one the first stays cached
+    util::RWSpinLockWriteHolder holder(m_pso_lock);
+    auto [it, inserted] = m_cached_psos.try_emplace(hash, std::move(pso));
+    return it->second;
+}
+
 Ref<rhi::Image> RenderResourceManager::RequestImage(Ref<ImageAsset> image_asset)
 {
     if (!image_asset)
@@ -654,6 +612,7 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
     h.u32(meshAttributesMask);
     uint64_t hash = h.get();
 
+    std::lock_guard<std::mutex> lock(m_vertex_layout_lock);
     auto it = m_mesh_vertex_layouts.find(hash);
     if (it != m_mesh_vertex_layouts.end())
         return it->second;
@@ -670,16 +629,17 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
         attrib.offset = 0;
     }
 
-    // varying enable blending attris
-    uint32_t enable_blending_buffer_offset = 0;
+    // varying enable blending attris, the streams of the geometry arena have a fixed layout
+    // whatever attributes a mesh has, see RequestMeshBuffers()
+    bool has_varying_enable_blending = false;
     if (meshAttributesMask & MESH_ATTRIBUTE_NORMAL_BIT)
     {
         rhi::VertexInputLayout::VertexAttribInfo& attrib = newLayout.vertexAttribInfos.emplace_back();
 		attrib.location = 1;
 		attrib.binding = 1;
 		attrib.format = rhi::VertexInputLayout::VertexAttribInfo::ATTRIB_FORMAT_VEC3;
-		attrib.offset = enable_blending_buffer_offset;
-        enable_blending_buffer_offset += sizeof(glm::vec3);
+		attrib.offset = 0;
+        has_varying_enable_blending = true;
     }
            
     if (meshAttributesMask & MESH_ATTRIBUTE_TANGENT_BIT)
@@ -688,20 +648,20 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
         attrib.location = 2;
         attrib.binding = 1;
         attrib.format = rhi::VertexInputLayout::VertexAttribInfo::ATTRIB_FORMAT_VEC3;
-        attrib.offset = enable_blending_buffer_offset;
-        enable_blending_buffer_offset += sizeof(glm::vec3);
+        attrib.offset = sizeof(glm::vec3);
+        has_varying_enable_blending = true;
     }
 
     // varying attris
-    uint32_t varing_offset = 0;
+    bool has_varying = false;
     if (meshAttributesMask & MESH_ATTRIBUTE_UV_BIT)
     {
         rhi::VertexInputLayout::VertexAttribInfo& attrib = newLayout.vertexAttribInfos.emplace_back();
 		attrib.location = 3;
 		attrib.binding = 2;
 		attrib.format = rhi::VertexInputLayout::VertexAttribInfo::ATTRIB_FORMAT_VEC2;
-		attrib.offset = varing_offset;
-        varing_offset += sizeof(glm::vec2);
+		attrib.offset = 0;
+        has_varying = true;
     }
 
     if (meshAttributesMask & MESH_ATTRIBUTE_VERTEX_COLOR_BIT)
@@ -710,8 +670,8 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
 		attrib.location = 4;
 		attrib.binding = 2;
 		attrib.format = rhi::VertexInputLayout::VertexAttribInfo::ATTRIB_FORMAT_VEC4;
-		attrib.offset = varing_offset;
-        varing_offset += sizeof(glm::vec4);
+		attrib.offset = sizeof(glm::vec2);
+        has_varying = true;
     }
 
     // joint binding attributes
@@ -735,26 +695,27 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
 
     // buffer binding infos
     rhi::VertexInputLayout::VertexBindInfo bindInfo = {};
+    using VertexStream = GeometryArena::VertexStream;
     if (meshAttributesMask & MESH_ATTRIBUTE_POSITION_BIT)
     {
         bindInfo.binding = 0;
-        bindInfo.stride = sizeof(glm::vec3);
+        bindInfo.stride = GeometryArena::vertex_stream_strides[util::ecast(VertexStream::Position)];
         bindInfo.inputRate = rhi::VertexInputLayout::VertexBindInfo::INPUT_RATE_VERTEX;
         newLayout.vertexBindInfos.push_back(bindInfo);
     }
 
-    if (enable_blending_buffer_offset > 0)
+    if (has_varying_enable_blending)
     {
         bindInfo.binding = 1;
-		bindInfo.stride = enable_blending_buffer_offset;
+		bindInfo.stride = GeometryArena::vertex_stream_strides[util::ecast(VertexStream::VaryingEnableBlending)];
 		bindInfo.inputRate = rhi::VertexInputLayout::VertexBindInfo::INPUT_RATE_VERTEX;
 		newLayout.vertexBindInfos.push_back(bindInfo);
     }
 
-    if (varing_offset > 0)
+    if (has_varying)
     {
         bindInfo.binding = 2;
-        bindInfo.stride = varing_offset;
+        bindInfo.stride = GeometryArena::vertex_stream_strides[util::ecast(VertexStream::Varying)];
         bindInfo.inputRate = rhi::VertexInputLayout::VertexBindInfo::INPUT_RATE_VERTEX;
         newLayout.vertexBindInfos.push_back(bindInfo);
     }
@@ -762,7 +723,7 @@ rhi::VertexInputLayout& RenderResourceManager::RequestMeshVertexLayout(uint32_t
     if ((meshAttributesMask & MESH_ATTRIBUTE_BONE_INDEX_BIT) || (meshAttributesMask & MESH_ATTRIBUTE_BONE_WEIGHT_BIT))
     {
         bindInfo.binding = 3;
-		bindInfo.stride = sizeof(glm::uvec4) + sizeof(glm::vec4);
+		bindInfo.stride = GeometryArena::vertex_stream_strides[util::ecast(VertexStream::JointBinding)];
 		bindInfo.inputRate = rhi::VertexInputLayout::VertexBindInfo::INPUT_RATE_VERTEX;
 		newLayout.vertexBindInfos.push_back(bindInfo);
     }
@@ -1,8 +1,12 @@
 #pragma once
 #include "Quark/Render/ShaderLibrary.h"
 #include "Quark/Render/Mesh.h"
+#include "Quark/Render/MaterialTable.h"
 
 #include "Quark/RHI/Device.h"
+#include "Quark/Core/Util/ReadWriteLock.h"
+
+#include <mutex>
 
 namespace quark
 {
@@ -63,18 +67,29 @@ public:
 	RenderResourceManager(Ref<rhi::Device> device);
 
 	ShaderLibrary& GetShaderLibrary() { return *m_shader_library; }
+	GeometryArena& GetGeometryArena() { return *m_geometry_arena; }
+	// nullptr if the device doesn't support bindless, materials are then bound per draw
+	const MaterialTable* GetMaterialTable() const { return m_material_table.get(); }
 
 	std::vector<Ref<StaticMesh>>   RequestStaticMeshRenderables(Ref<MeshAsset> mesh_asset); // Should we cache renderables? or let scene manage their lifelong
 	Ref<MeshBuffers>				RequestMeshBuffers(Ref<MeshAsset> mesh_asset);
 	Ref<PBRMaterial>				RequestMateral(Ref<MaterialAsset> mat_asset);
+	// Pipeline and vertex layout requests are thread safe, render callbacks call them while recording on worker threads.
+	// Cached pipelines are found under a read lock, new ones are compiled outside of any lock.
 	Ref<rhi::PipeLine>				RequestGraphicsPSO(ShaderProgramVariant& program, const rhi::RenderPassInfo& rp, const uint32_t mesh_attrib_mask, DrawPipeline draw_pipeline);
 	Ref<rhi::PipeLine>				RequestFullScreenQuadPSO(ShaderProgramVariant& program, const rhi::RenderPassInfo& rp_info, bool depth_test, bool depth_write, rhi::CompareOperation depth_compare);
+	Ref<rhi::PipeLine>				RequestComputePSO(ShaderProgramVariant& program);
 	Ref<rhi::Image>					RequestImage(Ref<ImageAsset> image_asset);
 	rhi::VertexInputLayout&			RequestMeshVertexLayout(uint32_t meshAttributesMask);
 
 private:
+	Ref<rhi::PipeLine> FindPSO(uint64_t hash) const;
+	Ref<rhi::PipeLine> InsertPSO(uint64_t hash, Ref<rhi::PipeLine> pso);
+
 	Ref<rhi::Device> m_device;
 	Scope<ShaderLibrary> m_shader_library;
+	Scope<GeometryArena> m_geometry_arena; // must outlive the cached mesh buffers below
+	Scope<MaterialTable> m_material_table;
 
 	// cached render resources
 	std::unordered_map<uint64_t, rhi::VertexInputLayout> m_mesh_vertex_layouts;
@@ -84,6 +99,9 @@ private:
 	std::unordered_map<uint64_t, Ref<PBRMaterial>> m_materials;
 	std::unordered_map<uint64_t, std::vector<Ref<StaticMesh>>> m_static_meshes; //TODO: any better way caching or not caching?
 	std::unordered_map<uint64_t, Ref<MeshBuffers>> m_mesh_buffers;
+
+	mutable util::RWSpinLock m_pso_lock; // m_cached_psos
+	std::mutex m_vertex_layout_lock;	// m_mesh_vertex_layouts
 };
 
 }
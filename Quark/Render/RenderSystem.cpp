@@ -2,6 +2,7 @@
 #include "Quark/Render/RenderSystem.h"
 #include "Quark/Render/RenderParameters.h"
 #include "Quark/RHI/Vulkan/Device_Vulkan.h"
+#include "Quark/RHI/Null/Device_Null.h"
 #include "Quark/Asset/AssetManager.h"
 #include "Quark/Asset/MeshAsset.h"
 #include "Quark/Scene/Scene.h"
@@ -9,6 +10,8 @@
 #include "Quark/Scene/Components/TransformCmpt.h"
 #include "Quark/Scene/Components/MeshRendererCmpt.h"
 #include "Quark/Core/Util/Hash.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Profiler.h"
 
 enum GlobalDescriptorSetBindings
 {
@@ -16,6 +19,9 @@ enum GlobalDescriptorSetBindings
     BINDING_GLOBAL_RENDER_PARAMETERS = 1,
 };
 
+// Below this a slice costs more to set up (command list, camera and lighting constants) than it saves
+static constexpr size_t parallel_flush_min_slice_size = 64;
+
 namespace quark {
 
 using namespace rhi;
@@ -24,13 +30,16 @@ RenderSystem::RenderSystem(const RenderSystemConfig& config)
 {
     rhi::DeviceConfig rhi_config;
     rhi_config.framesInFlight = 2;
+    if (config.nullDevice)
+        m_device = CreateRef<rhi::Device_Null>(rhi_config);
 #ifdef USE_VULKAN_DRIVER
-    m_device = CreateRef<rhi::Device_Vulkan>(rhi_config);
+    else
+        m_device = CreateRef<rhi::Device_Vulkan>(rhi_config);
 #endif
 
     m_renderResourceManager = CreateScope<RenderResourceManager>(m_device);
 
-    QK_CORE_LOGI_TAG("Rernderer", "RenderSystem Initialized");
+    QK_CORE_LOGI_TAG("Renderer", "RenderSystem Initialized");
 }
 
 RenderSystem::~RenderSystem()
@@ -63,6 +72,7 @@ void RenderSystem::BindLightingParameters(rhi::CommandList& cmd, const RenderCon
         return;
     CombinedRenderParameters* mapped = (CombinedRenderParameters*)cmd.AllocateConstantData(0, BINDING_GLOBAL_RENDER_PARAMETERS, sizeof(CombinedRenderParameters));
     mapped->directional = light_params->directional;
+    mapped->irradiance = light_params->irradiance;
 
 }
 
@@ -74,6 +84,31 @@ void RenderSystem::Flush(rhi::CommandList& cmd, const RenderQueue& queue, const
     queue.Dispatch(Queue::Opaque, cmd);
 }
 
+void RenderSystem::FlushParallel(rhi::CommandList& cmd, const RenderQueue& queue, const RenderContext& ctx, JobSystem& job_system)
+{
+    QK_PROFILE_SCOPE("RenderSystem::FlushParallel");
+
+    queue.GetSlices(Queue::Opaque, std::max(job_system.GetNumWorkerThreads(), 1u), m_slices, parallel_flush_min_slice_size);
+    m_secondary_cmds.resize(m_slices.size());
+
+    JobSystem::Counter counter;
+    for (size_t i = 0; i < m_slices.size(); i++)
+    {
+        // Each secondary list records into its own command pool and uniform/vertex blocks
+        job_system.Execute([this, &cmd, &queue, &ctx, i]()
+        {
+            rhi::CommandList* secondary = m_device->BeginSecondaryCommandList(cmd);
+            BindCameraParameters(*secondary, ctx);
+            BindLightingParameters(*secondary, ctx);
+            queue.Dispatch(Queue::Opaque, *secondary, m_slices[i]);
+            m_secondary_cmds[i] = secondary;
+        }, &counter);
+    }
+    job_system.Wait(&counter, 1);
+
+    cmd.ExecuteCommandLists(m_secondary_cmds.data(), (uint32_t)m_secondary_cmds.size());
+}
+
  //void RenderSystem::DrawSkybox(Ref<ImageAsset> cubemap, const RenderContext& ctx, rhi::CommandList& cmd)
  //{
  //   Ref<MeshAsset> cubeMesh = AssetManager::Get().mesh_cube;
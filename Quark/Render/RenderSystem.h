@@ -6,10 +6,12 @@
 
 namespace quark {
 class Scene;
+class JobSystem;
 
 struct RenderSystemConfig 
 {
 	uint32_t maxFramesInFlight = 2;
+	bool nullDevice = false;	// cpu only rhi::Device_Null, for running headless without a gpu
 };
 
 // 1. high level rendering api
@@ -28,6 +30,11 @@ public:
     void BindLightingParameters(rhi::CommandList& cmd, const RenderContext& cxt);
     void Flush(rhi::CommandList& cmd, const RenderQueue& queue, const RenderContext& ctx);
 
+    // Same as Flush(), but the opaque queue is split into slices recorded into secondary command lists on the
+    // job system's workers, then executed in queue order. cmd must be in a render pass begun with
+    // rhi::RenderPassContents::SECONDARY_COMMAND_LISTS.
+    void FlushParallel(rhi::CommandList& cmd, const RenderQueue& queue, const RenderContext& ctx, JobSystem& job_system);
+
     // update per frame buffer first then draw
     // void DrawSkybox(Ref<ImageAsset> cubemap, const RenderContext& ctx, rhi::CommandList& cmd);
     void DrawGrid(rhi::CommandList* cmd);
@@ -37,6 +44,8 @@ public:
 private:
     Ref<rhi::Device> m_device;
     Scope<RenderResourceManager> m_renderResourceManager;
+    std::vector<RenderQueue::TaskRange> m_slices;
+    std::vector<rhi::CommandList*> m_secondary_cmds;
 
 };
 }
\ No newline at end of file
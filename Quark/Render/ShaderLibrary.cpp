@@ -18,6 +18,10 @@ namespace quark {
 ShaderProgram::ShaderProgram(ShaderTemplate* compute)
 {
 	m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)] = compute;
+
+	util::Hasher h;
+	h.string(compute->GetPath());
+	m_hash = h.get();
 }
 
 ShaderProgram::ShaderProgram(ShaderTemplate* vert, ShaderTemplate* frag)
@@ -73,6 +77,10 @@ ShaderTemplateVariant* ShaderTemplate::RequestVariant(const std::vector<std::pai
 		// newVariant->signatureKey = key;
 		newVariant->spirv = spirv;
 
+		util::Hasher spirv_hasher;
+		spirv_hasher.data(spirv.data(), spirv.size() * sizeof(uint32_t));
+		newVariant->spirvHash = spirv_hasher.get();
+
 		m_Variants[hash] = std::move(newVariant);
 		return m_Variants[hash].get();
 
@@ -96,10 +104,17 @@ ShaderProgramVariant* ShaderProgram::RequestVariant(const std::vector<std::pair<
 	}
 	else
 	{
-		ShaderTemplateVariant* vert = m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->RequestVariant(defines);
-		ShaderTemplateVariant* frag = m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->RequestVariant(defines);
-
-		Scope<ShaderProgramVariant> newVariant = CreateScope<ShaderProgramVariant>(vert, frag);
+		Scope<ShaderProgramVariant> newVariant;
+		if (ShaderTemplate* comp = m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)])
+		{
+			newVariant = CreateScope<ShaderProgramVariant>(comp->RequestVariant(defines));
+		}
+		else
+		{
+			ShaderTemplateVariant* vert = m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->RequestVariant(defines);
+			ShaderTemplateVariant* frag = m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->RequestVariant(defines);
+			newVariant = CreateScope<ShaderProgramVariant>(vert, frag);
+		}
 
 		m_variants[hasher.get()] = std::move(newVariant);
 
@@ -126,9 +141,17 @@ ShaderProgramVariant* ShaderProgram::GetPrecompiledVariant()
 	}
 	else
 	{
-		ShaderTemplateVariant* vert = m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->GetPrecompiledVariant();
-		ShaderTemplateVariant* frag = m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->GetPrecompiledVariant();
-		Scope<ShaderProgramVariant> newProgram = CreateScope<ShaderProgramVariant>(vert, frag);
+		Scope<ShaderProgramVariant> newProgram;
+		if (ShaderTemplate* comp = m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)])
+		{
+			newProgram = CreateScope<ShaderProgramVariant>(comp->GetPrecompiledVariant());
+		}
+		else
+		{
+			ShaderTemplateVariant* vert = m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->GetPrecompiledVariant();
+			ShaderTemplateVariant* frag = m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->GetPrecompiledVariant();
+			newProgram = CreateScope<ShaderProgramVariant>(vert, frag);
+		}
 		
 		m_variants[hash] = std::move(newProgram);
 		return m_variants[hash].get();
@@ -195,7 +218,25 @@ ShaderProgram* ShaderLibrary::RequestGraphicsProgram(const std::string& vert_pat
 
 ShaderProgram* ShaderLibrary::RequestComputeProgram(const std::string& comp_path)
 {
-	return nullptr;
+	util::Hasher h;
+	h.string(comp_path);
+	uint64_t programHash = h.get();
+
+	auto it = m_shaderPrograms.find(programHash);
+	if (it != m_shaderPrograms.end())
+	{
+		return it->second.get();
+	}
+	else // Create ShaderProgram
+	{
+		ShaderTemplate* compTemp = RequestShaderTemplate(comp_path, rhi::ShaderStage::STAGE_COMPUTE);
+
+		Scope<ShaderProgram> newProgram = CreateScope<ShaderProgram>(compTemp);
+
+		m_shaderPrograms[programHash] = std::move(newProgram);
+
+		return m_shaderPrograms[programHash].get();
+	}
 }
 
 ShaderTemplate* ShaderLibrary::RequestShaderTemplate(const std::string& path, rhi::ShaderStage stage)
@@ -255,6 +296,10 @@ ShaderTemplateVariant* ShaderTemplate::GetPrecompiledVariant()
 		newVariant->gpuShaderHandle = newShader;
 		// newVariant->signatureKey = ShaderVariantKey();
 		newVariant->spirv = std::vector<uint32_t>(spirv.begin(), spirv.end());
+
+		util::Hasher spirv_hasher;
+		spirv_hasher.data(spirv.data(), spirv.size());
+		newVariant->spirvHash = spirv_hasher.get();
 		m_Variants[hash] = std::move(newVariant);
 
 		return m_Variants[hash].get();
@@ -266,11 +311,23 @@ ShaderProgramVariant::ShaderProgramVariant(ShaderTemplateVariant* vert, ShaderTe
 	m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)] = frag;
 }
 
+ShaderProgramVariant::ShaderProgramVariant(ShaderTemplateVariant* compute)
+{
+	m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)] = compute;
+}
+
 uint64_t ShaderProgramVariant::GetHash() const
 {
 	util::Hasher h;
-	h.u64(m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->spirvHash);
-	h.u64(m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->spirvHash);
+	if (m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)])
+	{
+		h.u64(m_stages[util::ecast(rhi::ShaderStage::STAGE_COMPUTE)]->spirvHash);
+	}
+	else
+	{
+		h.u64(m_stages[util::ecast(rhi::ShaderStage::STAGE_VERTEX)]->spirvHash);
+		h.u64(m_stages[util::ecast(rhi::ShaderStage::STAGE_FRAGEMNT)]->spirvHash);
+	}
 
 	return h.get();
 }
@@ -25,11 +25,12 @@ void SkyboxRender(rhi::CommandList& cmd, const RenderQueueTask* task, unsigned i
 
 	cmd.BindImage(2, 0, data->cubemap->GetDefaultView(), ImageLayout::SHADER_READ_ONLY_OPTIMAL);
 	cmd.BindSampler(2, 0, *resource_manager.sampler_cube);
-	cmd.BindVertexBuffer(0, *cubeRenderMesh->vbo_position, 0);
-	cmd.BindIndexBuffer(*cubeRenderMesh->ibo, 0, IndexBufferFormat::UINT32);
+	const GeometryArena& arena = *cubeRenderMesh->arena;
+	cmd.BindVertexBuffer(0, arena.GetVertexBuffer(GeometryArena::VertexStream::Position), 0);
+	cmd.BindIndexBuffer(arena.GetIndexBuffer(), 0, IndexBufferFormat::UINT32);
 
 	cmd.BindPipeLine(*pipeline_skybox);
-	cmd.DrawIndexed((uint32_t)cubeMesh->indices.size(), 1, 0, 0, 0);
+	cmd.DrawIndexed((uint32_t)cubeMesh->indices.size(), 1, arena.GetFirst(cubeRenderMesh->ibo), arena.GetFirst(cubeRenderMesh->vbo), 0);
 
 }
 void Skybox::GetRenderData(const RenderContext& context, const RenderInfoCmpt* transform, RenderQueue& queue) const
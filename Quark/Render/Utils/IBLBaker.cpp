@@ -0,0 +1,194 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/Utils/IBLBaker.h"
+#include "Quark/Render/Utils/ImageUtils.h"
+#include "Quark/Render/Utils/SphericalHarmonics.h"
+#include "Quark/Render/RenderSystem.h"
+#include "Quark/Asset/ImageImporter.h"
+#include "Quark/Asset/ImageExporter.h"
+#include "Quark/Core/FileSystem.h"
+#include "Quark/Core/Util/Hash.h"
+
+#include <cmath>
+
+namespace quark
+{
+// Bump when the baked output changes, e.g. the prefilter shader, so stale cache files are not picked up
+static constexpr uint32_t ibl_bake_version = 3;
+
+static util::Hash HashEnvironment(const ImageAsset& equirect, const IBLBakeSettings& settings)
+{
+	util::Hasher h;
+	h.u32(ibl_bake_version);
+	h.u32(equirect.width);
+	h.u32(equirect.height);
+	h.u32(uint32_t(equirect.format));
+	h.f32(settings.cube_scale);
+	h.u32(settings.prefilter_size);
+	h.u32(settings.prefilter_levels);
+
+	// Texel strides are multiples of 4 bytes, hash a word at a time
+	h.data(reinterpret_cast<const uint32_t*>(equirect.data.data()), equirect.data.size());
+	return h.get();
+}
+
+// The coefficients are cached as a 9x1 RGBA32F image
+static Ref<ImageAsset> CreateSHImageAsset(const SHL2& sh)
+{
+	Ref<ImageAsset> asset = CreateRef<ImageAsset>();
+	asset->format = rhi::DataFormat::R32G32B32A32_SFLOAT;
+	asset->width = 9;
+	asset->height = 1;
+	asset->layout.SetUp2D(asset->format, asset->width, asset->height, 1, 1);
+	asset->data.resize(asset->layout.GetRequiredSize());
+
+	for (uint32_t i = 0; i < 9; i++)
+	{
+		glm::vec4 texel(sh[i], 1.f);
+		memcpy(asset->data.data() + i * sizeof(texel), &texel, sizeof(texel));
+	}
+
+	return asset;
+}
+
+static bool ReadSHImageAsset(const ImageAsset& asset, SHL2& sh)
+{
+	if (asset.format != rhi::DataFormat::R32G32B32A32_SFLOAT || asset.width != 9 || asset.data.size() < 9 * sizeof(glm::vec4))
+		return false;
+
+	for (uint32_t i = 0; i < 9; i++)
+	{
+		glm::vec4 texel;
+		memcpy(&texel, asset.data.data() + i * sizeof(texel), sizeof(texel));
+		if (!std::isfinite(texel.r) || !std::isfinite(texel.g) || !std::isfinite(texel.b))
+			return false;
+		sh[i] = glm::vec3(texel);
+	}
+
+	return true;
+}
+
+// Texels have to be finite and not all zero. A file written from a readback which didn't wait for the gpu
+// would otherwise be loaded on every run, an environment which really is black is just baked again.
+static bool HasValidTexels(const ImageAsset& asset)
+{
+	bool any_nonzero = false;
+	switch (asset.format)
+	{
+	case rhi::DataFormat::R32G32B32A32_SFLOAT:
+		for (size_t offset = 0; offset + sizeof(float) <= asset.data.size(); offset += sizeof(float))
+		{
+			float value;
+			memcpy(&value, asset.data.data() + offset, sizeof(value));
+			if (!std::isfinite(value))
+				return false;
+			any_nonzero |= value != 0.f;
+		}
+		return any_nonzero;
+	case rhi::DataFormat::R16G16B16A16_SFLOAT:
+		for (size_t offset = 0; offset + sizeof(uint16_t) <= asset.data.size(); offset += sizeof(uint16_t))
+		{
+			uint16_t value;
+			memcpy(&value, asset.data.data() + offset, sizeof(value));
+			if ((value & 0x7c00) == 0x7c00) // inf or nan
+				return false;
+			any_nonzero |= (value & 0x7fff) != 0;
+		}
+		return any_nonzero;
+	default:
+		return std::any_of(asset.data.begin(), asset.data.end(), [](uint8_t byte) { return byte != 0; });
+	}
+}
+
+static Ref<rhi::Image> LoadCachedImage(ImageImporter& importer, const std::string& path, bool is_cube, uint32_t size, uint32_t mip_levels)
+{
+	Ref<ImageAsset> asset = importer.ImportKtx2(path, is_cube);
+	if (!asset || asset->width != size || asset->height != size || asset->mipLevels != mip_levels || (asset->type == rhi::ImageType::TYPE_CUBE) != is_cube
+		|| !HasValidTexels(*asset))
+	{
+		QK_CORE_LOGW_TAG("Renderer", "BakeIBL: Cache file {} doesn't match the settings or holds invalid texels", path);
+		return nullptr;
+	}
+
+	return RenderSystem::Get().GetRenderResourceManager().RequestImage(asset);
+}
+
+static void CacheImage(rhi::Device& device, const rhi::Image& image, const std::string& path)
+{
+	Ref<ImageAsset> asset = ReadBackToImageAsset(SaveImageToCpuBuffer(device, image, rhi::QUEUE_TYPE_GRAPHICS));
+	ImageExporter().ExportKtx2(*asset, path);
+}
+
+IBLData BakeIBL(rhi::Device& device, const Ref<ImageAsset>& equirect, const IBLBakeSettings& settings)
+{
+	QK_PROFILE_SCOPE("BakeIBL");
+	QK_CORE_ASSERT(equirect)
+
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)HashEnvironment(*equirect, settings));
+
+	const std::filesystem::path directory(settings.cache_directory);
+	const std::string cube_path = (directory / (std::string(key) + "_cube.ktx2")).string();
+	const std::string prefilter_path = (directory / (std::string(key) + "_prefilter.ktx2")).string();
+	const std::string sh_path = (directory / (std::string(key) + "_sh.ktx2")).string();
+	const std::string lut_path = (directory / ("brdf_lut_" + std::to_string(settings.brdf_lut_size) + "_v" + std::to_string(ibl_bake_version) + ".ktx2")).string();
+
+	if (!FileSystem::Exists(directory))
+		FileSystem::CreateDirectory(directory);
+
+	IBLData data;
+	ImageImporter importer;
+
+	// Sizes of the baked images, see ConvertEquirectToCube() and CreatePrefilterMap()
+	const uint32_t cube_size = uint32_t(settings.cube_scale * std::max(equirect->width / 3, equirect->height / 2));
+	const uint32_t cube_levels = rhi::TextureFormatLayout::GeneratedMipCount(cube_size, cube_size, 1);
+	const uint32_t prefilter_levels = std::min(settings.prefilter_levels, rhi::TextureFormatLayout::GeneratedMipCount(settings.prefilter_size, settings.prefilter_size, 1));
+
+	// The lut doesn't depend on the environment, it is baked once for all of them
+	if (FileSystem::Exists(lut_path))
+		data.brdf_lut = LoadCachedImage(importer, lut_path, false, settings.brdf_lut_size, 1);
+	if (!data.brdf_lut)
+	{
+		data.brdf_lut = CreateBRDFLut(device, settings.brdf_lut_size);
+		CacheImage(device, *data.brdf_lut, lut_path);
+	}
+
+	if (FileSystem::Exists(cube_path) && FileSystem::Exists(prefilter_path) && FileSystem::Exists(sh_path))
+	{
+		Ref<ImageAsset> sh_asset = importer.ImportKtx2(sh_path);
+		if (sh_asset && ReadSHImageAsset(*sh_asset, data.irradiance_sh))
+		{
+			data.cubemap = LoadCachedImage(importer, cube_path, true, cube_size, cube_levels);
+			data.prefiltered = LoadCachedImage(importer, prefilter_path, true, settings.prefilter_size, prefilter_levels);
+		}
+
+		if (data.cubemap && data.prefiltered)
+		{
+			data.from_cache = true;
+			QK_CORE_LOGI_TAG("Renderer", "BakeIBL: Loaded environment {} from {}", key, settings.cache_directory);
+			return data;
+		}
+
+		QK_CORE_LOGW_TAG("Renderer", "BakeIBL: Cache of environment {} is invalid, baking it again", key);
+	}
+
+	Ref<rhi::Image> source = RenderSystem::Get().GetRenderResourceManager().RequestImage(equirect);
+	data.cubemap = ConvertEquirectToCube(device, *source, settings.cube_scale);
+	data.prefiltered = CreatePrefilterMap(device, *data.cubemap, settings.prefilter_size, settings.prefilter_levels);
+
+	// Projected from the source on the cpu, while the gpu converts and prefilters
+	SHProjectionDesc sh_desc;
+	sh_desc.job_system = settings.job_system;
+	data.irradiance_sh = ConvolveIrradianceSH(ProjectRadianceSH(*equirect, sh_desc));
+
+	Ref<ImageAsset> cube_asset = ReadBackToImageAsset(SaveImageToCpuBuffer(device, *data.cubemap, rhi::QUEUE_TYPE_GRAPHICS));
+
+	ImageExporter exporter;
+	exporter.ExportKtx2(*cube_asset, cube_path);
+	exporter.ExportKtx2(*CreateSHImageAsset(data.irradiance_sh), sh_path);
+	CacheImage(device, *data.prefiltered, prefilter_path);
+
+	QK_CORE_LOGI_TAG("Renderer", "BakeIBL: Baked environment {} into {}", key, settings.cache_directory);
+	return data;
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "Quark/RHI/Device.h"
+#include "Quark/Asset/ImageAsset.h"
+#include "Quark/Render/Utils/SphericalHarmonics.h"
+
+namespace quark
+{
+
+struct IBLBakeSettings
+{
+	std::string cache_directory = "BuiltInResources/Cache/IBL";
+	float cube_scale = 1.f;			// see ConvertEquirectToCube()
+	uint32_t prefilter_size = 128;
+	uint32_t prefilter_levels = 5;
+	uint32_t brdf_lut_size = 512;
+	JobSystem* job_system = nullptr;	// see SHProjectionDesc
+};
+
+// Image based lighting of one environment, all images are in SHADER_READ_ONLY_OPTIMAL layout
+struct IBLData
+{
+	Ref<rhi::Image> cubemap;		// radiance with a full mip chain, for the skybox
+	Ref<rhi::Image> prefiltered;	// see CreatePrefilterMap()
+	Ref<rhi::Image> brdf_lut;		// see CreateBRDFLut(), the same for every environment
+
+	// L2 irradiance with the cosine lobe applied, see ConvolveIrradianceSH() and ToIrradianceParameters()
+	SHL2 irradiance_sh = {};
+	bool from_cache = false;
+};
+
+// Bakes the image based lighting of an equirectangular environment once and stores the results as KTX2 files
+// in the cache directory, named after a hash of the source image and the settings. Later calls load the files
+// through ImageImporter, so switching environments only costs the uploads.
+IBLData BakeIBL(rhi::Device& device, const Ref<ImageAsset>& equirect, const IBLBakeSettings& settings = {});
+
+}
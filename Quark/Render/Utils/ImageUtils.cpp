@@ -109,48 +109,214 @@ Ref<rhi::Image> ConvertEquirectToCube(rhi::Device& device, const rhi::Image& equ
 
 	return handle;
 }
-Ref<rhi::Image> CreateIrradianceMap(rhi::Device& device, const rhi::Image& cube)
+Ref<rhi::Image> CreatePrefilterMap(rhi::Device& device, const rhi::Image& cube, uint32_t size, uint32_t mip_levels)
 {
 	using namespace rhi;
-	uint32_t size = 32;
-	rhi::ImageDesc desc = ImageDesc::RenderTarget(size, size, DataFormat::R16G16B16A16_SFLOAT);
-	desc.mipLevels = 1;
-	desc.arraySize = 6;
+	mip_levels = std::min(mip_levels, TextureFormatLayout::GeneratedMipCount(size, size, 1));
+
+	ImageDesc desc = ImageDesc::RenderTarget(size, size, DataFormat::R16G16B16A16_SFLOAT);
 	desc.type = ImageType::TYPE_CUBE;
-	desc.usageBits |= IMAGE_USAGE_SAMPLING_BIT | IMAGE_USAGE_CAN_COPY_FROM_BIT;
+	desc.mipLevels = mip_levels;
+	desc.arraySize = 6;
+	desc.usageBits |= IMAGE_USAGE_SAMPLING_BIT;
 	desc.initialLayout = ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
 
 	Ref<Image> handle = device.CreateImage(desc);
 	CommandList* cmd = device.BeginCommandList();
 
+	// Shared with prefilter_cube.frag
+	struct PrefilterParameters
+	{
+		float roughness;
+		float source_size;
+	} prefilter;
+	prefilter.source_size = float(cube.GetDesc().width);
+
 	CameraParameters params;
-	for (uint32_t i = 0; i < 6; i++)
+	for (uint32_t level = 0; level < mip_levels; level++)
 	{
-		ImageViewDesc view_desc;
-		view_desc.layerCount = 1;
-		view_desc.baseLayer = i;
-		view_desc.format = desc.format;
-		view_desc.baseLevel = 0;
-		view_desc.levelCount = 1;
+		uint32_t level_size = std::max(size >> level, 1u);
+		prefilter.roughness = mip_levels > 1 ? float(level) / float(mip_levels - 1) : 0.f;
 
-		Ref<ImageView> rt_view = device.CreateImageView(view_desc);
-		RenderPassInfo rp_info;
-		rp_info.numColorAttachments = 1;
-		rp_info.colorAttachmentFormats[0] = desc.format;
-		FrameBufferInfo fb_info;
-		fb_info.colorAttachments[0] = rt_view.get();
-		fb_info.colorAttatchemtsLoadOp[0] = FrameBufferInfo::AttachmentLoadOp::DONTCARE;
-		
-		cmd->BeginRenderPass(rp_info, fb_info);
+		for (uint32_t i = 0; i < 6; i++)
+		{
+			ImageViewDesc view_desc = {};
+			view_desc.layerCount = 1;
+			view_desc.baseLayer = i;
+			view_desc.format = desc.format;
+			view_desc.baseLevel = level;
+			view_desc.levelCount = 1;
+			view_desc.image = handle.get();
+			Ref<ImageView> rt_view = device.CreateImageView(view_desc);
 
-		glm::mat4 look, proj;
-		ComputeCubeFaceRenderTransform(glm::vec3(0.f), i, proj, look, 0.1f, 100.f);
-		params.inv_local_view_projection = glm::inverse(proj * look);
-		memcpy(cmd->AllocateConstantData(0, 0, sizeof(params)), &params, sizeof(params));
-		cmd->BindImageSampler(2, 0, cube.GetDefaultView(), ImageLayout::SHADER_READ_ONLY_OPTIMAL,
-			*RenderSystem::Get().GetRenderResourceManager().sampler_linear);
+			RenderPassInfo rp = {};
+			rp.colorAttachmentFormats[0] = desc.format;
+			rp.numColorAttachments = 1;
+
+			FrameBufferInfo fb = {};
+			fb.colorAttachments[0] = rt_view.get();
+			fb.colorAttatchemtsLoadOp[0] = FrameBufferInfo::AttachmentLoadOp::DONTCARE;
 
+			rhi::Viewport viewport;
+			viewport.x = 0;
+			viewport.y = 0;
+			viewport.width = (float)level_size;
+			viewport.height = (float)level_size;
+			viewport.minDepth = 0;
+			viewport.maxDepth = 1;
+
+			rhi::Scissor scissor;
+			scissor.extent.width = (int)level_size;
+			scissor.extent.height = (int)level_size;
+			scissor.offset.x = 0;
+			scissor.offset.y = 0;
+			cmd->SetViewPort(viewport);
+			cmd->SetScissor(scissor);
+
+			cmd->BeginRenderPass(rp, fb);
+
+			glm::mat4 look, proj;
+			ComputeCubeFaceRenderTransform(glm::vec3(0.f), i, proj, look, 0.1f, 100.f);
+
+			params.inv_local_view_projection = glm::inverse(proj * look);
+			memcpy(cmd->AllocateConstantData(0, 0, sizeof(params)), &params, sizeof(params));
+			cmd->BindImageSampler(2, 0, cube.GetDefaultView(), ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+				*RenderSystem::Get().GetRenderResourceManager().sampler_cube);
+			cmd->PushConstant(&prefilter, 0, sizeof(prefilter));
+
+			CommandListUtils::DrawFullScreenQuad(*cmd, "BuiltInResources/Shaders/skybox_quad.vert", "BuiltInResources/Shaders/prefilter_cube.frag");
+
+			cmd->EndRenderPass();
+		}
 	}
-	return Ref<Image>();
+
+	CommandListUtils::ImageBarrier(*cmd, *handle, ImageLayout::COLOR_ATTACHMENT_OPTIMAL, ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+		PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		PIPELINE_STAGE_FRAGMENT_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT, BARRIER_ACCESS_SHADER_SAMPLED_READ_BIT);
+	device.SubmitCommandList(cmd);
+
+	return handle;
+}
+
+Ref<rhi::Image> CreateBRDFLut(rhi::Device& device, uint32_t size)
+{
+	using namespace rhi;
+	ImageDesc desc = ImageDesc::RenderTarget(size, size, DataFormat::R16G16B16A16_SFLOAT);
+	desc.usageBits |= IMAGE_USAGE_SAMPLING_BIT;
+	desc.initialLayout = ImageLayout::COLOR_ATTACHMENT_OPTIMAL;
+
+	Ref<Image> handle = device.CreateImage(desc);
+	CommandList* cmd = device.BeginCommandList();
+
+	RenderPassInfo rp = {};
+	rp.colorAttachmentFormats[0] = desc.format;
+	rp.numColorAttachments = 1;
+
+	FrameBufferInfo fb = {};
+	fb.colorAttachments[0] = &handle->GetDefaultView();
+	fb.colorAttatchemtsLoadOp[0] = FrameBufferInfo::AttachmentLoadOp::DONTCARE;
+
+	rhi::Viewport viewport;
+	viewport.x = 0;
+	viewport.y = 0;
+	viewport.width = (float)size;
+	viewport.height = (float)size;
+	viewport.minDepth = 0;
+	viewport.maxDepth = 1;
+
+	rhi::Scissor scissor;
+	scissor.extent.width = (int)size;
+	scissor.extent.height = (int)size;
+	scissor.offset.x = 0;
+	scissor.offset.y = 0;
+	cmd->SetViewPort(viewport);
+	cmd->SetScissor(scissor);
+
+	cmd->BeginRenderPass(rp, fb);
+	CommandListUtils::DrawFullScreenQuad(*cmd, "BuiltInResources/Shaders/quad.vert", "BuiltInResources/Shaders/brdf_lut.frag");
+	cmd->EndRenderPass();
+
+	CommandListUtils::ImageBarrier(*cmd, *handle, ImageLayout::COLOR_ATTACHMENT_OPTIMAL, ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+		PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, BARRIER_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		PIPELINE_STAGE_FRAGMENT_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT, BARRIER_ACCESS_SHADER_SAMPLED_READ_BIT);
+	device.SubmitCommandList(cmd);
+
+	return handle;
+}
+
+ImageReadBack SaveImageToCpuBuffer(rhi::Device& device, const rhi::Image& image, rhi::QueueType queue_type)
+{
+	using namespace rhi;
+	ImageReadBack readback;
+	readback.image_desc = image.GetDesc();
+	if (readback.image_desc.mipLevels == 0)
+		readback.image_desc.mipLevels = TextureFormatLayout::GeneratedMipCount(readback.image_desc.width, readback.image_desc.height, 1);
+
+	const ImageDesc& desc = readback.image_desc;
+	readback.layout.SetUp2D(desc.format, desc.width, desc.height, desc.arraySize, desc.mipLevels);
+
+	BufferDesc buffer_desc;
+	buffer_desc.size = readback.layout.GetRequiredSize();
+	buffer_desc.domain = BufferMemoryDomain::CPU;
+	buffer_desc.usageBits = BUFFER_USAGE_TRANSFER_TO_BIT;
+	readback.buffer = device.CreateBuffer(buffer_desc);
+
+	CommandList* cmd = device.BeginCommandList(queue_type);
+	CommandListUtils::ImageBarrier(*cmd, image, ImageLayout::SHADER_READ_ONLY_OPTIMAL, ImageLayout::TRANSFER_SRC_OPTIMAL,
+		PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, PIPELINE_STAGE_TRANSFER_BIT, BARRIER_ACCESS_TRANSFER_READ_BIT);
+
+	for (uint32_t level = 0; level < desc.mipLevels; level++)
+	{
+		const auto& mip_info = readback.layout.GetMipInfo(level);
+
+		ImageCopySubresourceRange subresource;
+		subresource.aspect = IMAGE_ASPECT_COLOR_BIT;
+		subresource.mipLevel = level;
+		subresource.baseArrayLayer = 0;
+		subresource.layerCount = desc.arraySize;
+
+		// Row length and image height of 0 mean tightly packed, like the TextureFormatLayout
+		cmd->CopyImageToBuffer(*readback.buffer, image, mip_info.offset, Offset3D{ 0, 0, 0 },
+			Extent3D{ mip_info.width, mip_info.height, 1 }, 0, 0, subresource);
+	}
+
+	CommandListUtils::ImageBarrier(*cmd, image, ImageLayout::TRANSFER_SRC_OPTIMAL, ImageLayout::SHADER_READ_ONLY_OPTIMAL,
+		PIPELINE_STAGE_TRANSFER_BIT, 0, PIPELINE_STAGE_FRAGMENT_SHADER_BIT | PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		BARRIER_ACCESS_SHADER_SAMPLED_READ_BIT);
+	// WaitIdle() submits the queued list before waiting, the buffer can be read once it returns
+	device.SubmitCommandList(cmd);
+	device.WaitIdle();
+
+	return readback;
+}
+
+Ref<ImageAsset> ReadBackToImageAsset(const ImageReadBack& readback)
+{
+	Ref<ImageAsset> asset = CreateRef<ImageAsset>();
+	asset->layout = readback.layout;
+	asset->type = readback.image_desc.type;
+	asset->format = readback.image_desc.format;
+	asset->width = readback.image_desc.width;
+	asset->height = readback.image_desc.height;
+	asset->depth = 1;
+	asset->arraySize = readback.image_desc.arraySize;
+	asset->mipLevels = readback.image_desc.mipLevels;
+
+	const uint8_t* mapped = static_cast<const uint8_t*>(readback.buffer->GetMappedDataPtr());
+	asset->data.assign(mapped, mapped + readback.layout.GetRequiredSize());
+
+	for (uint32_t level = 0; level < asset->mipLevels; level++)
+	{
+		const auto& mip_info = readback.layout.GetMipInfo(level);
+		for (uint32_t layer = 0; layer < asset->arraySize; layer++)
+		{
+			rhi::ImageInitData& subresource = asset->slices.emplace_back();
+			subresource.data = asset->data.data() + mip_info.offset + uint64_t(mip_info.slice_pitch) * layer;
+			subresource.rowPitch = mip_info.row_pitch;
+			subresource.slicePitch = mip_info.slice_pitch;
+		}
+	}
+
+	return asset;
 }
 }
@@ -1,11 +1,17 @@
 #pragma once
 #include "Quark/RHI/Device.h"
 #include "Quark/RHI/TextureFormatLayout.h"
+#include "Quark/Asset/ImageAsset.h"
 namespace quark
 {
+// The returned images are in SHADER_READ_ONLY_OPTIMAL layout, the work is submitted but not waited for
 Ref<rhi::Image> ConvertEquirectToCube(rhi::Device& device, const rhi::Image& equirect, float scale);
-Ref<rhi::Image> CreateIrradianceMap(rhi::Device& device, const rhi::Image& cube);
-Ref<rhi::Image> CreatePrefilterMap(rhi::Device& device, const rhi::Image& cube);
+
+// GGX prefiltered radiance of a mipmapped cubemap, level i holds roughness i / (mip_levels - 1)
+Ref<rhi::Image> CreatePrefilterMap(rhi::Device& device, const rhi::Image& cube, uint32_t size = 128, uint32_t mip_levels = 5);
+
+// Split sum environment BRDF, rg = scale and bias of F0, u = NdotV, v = roughness
+Ref<rhi::Image> CreateBRDFLut(rhi::Device& device, uint32_t size = 512);
 
 struct ImageReadBack
 {
@@ -14,7 +20,9 @@ struct ImageReadBack
 	rhi::TextureFormatLayout layout;
 };
 
+// Copies all levels and layers of an image in SHADER_READ_ONLY_OPTIMAL layout and waits for the device to be idle.
+// The buffer is laid out like the readback's TextureFormatLayout.
 ImageReadBack SaveImageToCpuBuffer(rhi::Device& device, const rhi::Image& image, rhi::QueueType queue_type);
-bool SaveImageBufferToGtx(rhi::Device& device, ImageReadBack& readback, const char* path);
+Ref<ImageAsset> ReadBackToImageAsset(const ImageReadBack& readback);
 
 }
\ No newline at end of file
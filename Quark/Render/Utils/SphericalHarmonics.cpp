@@ -0,0 +1,492 @@
+#include "Quark/qkpch.h"
+#include "Quark/Render/Utils/SphericalHarmonics.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/Profiler.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+// The AVX2 kernels are compiled for the target with function attributes and picked at runtime,
+// so the library itself doesn't need to be built with -mavx2
+#if defined(__x86_64__) || defined(_M_X64)
+	#define QK_SH_AVX2
+	#include <immintrin.h>
+	#if defined(__GNUC__) || defined(__clang__)
+		#define QK_SH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#else
+		#include <intrin.h>
+		#define QK_SH_TARGET_AVX2
+	#endif
+#endif
+
+namespace quark
+{
+// The basis functions are accumulated as raw polynomials, the normalization constants are applied once at the end
+static constexpr double sh_constants[9] = { 0.282095, 0.488603, 0.488603, 0.488603, 1.092548, 1.092548, 0.315392, 1.092548, 0.546274 };
+
+// Rows are reduced in fixed groups into double partial sums, which are added in order.
+// The result doesn't depend on how the groups are scheduled, with or without a job system.
+static constexpr uint32_t sh_rows_per_group = 16;
+
+namespace {
+
+struct SHPartialSum
+{
+	double sh[9][3] = {};
+	double weight = 0.0;
+};
+
+// Maps the texels of one row to directions and solid angle weights, up to a constant factor
+struct SHRowMapping
+{
+	// Equirect: direction = (cos_lat * cos_phi[x], sin_lat, cos_lat * sin_phi[x]), weight = cos_lat
+	const float* cos_phi = nullptr;
+	const float* sin_phi = nullptr;
+	float cos_lat = 0.f;
+	float sin_lat = 0.f;
+
+	// Cube: r = origin + u * axis with u = (x + 0.5) * u_scale - 1, direction = r / |r|, weight = |r|^-3
+	glm::vec3 origin = glm::vec3(0.f);
+	glm::vec3 axis = glm::vec3(0.f);
+	float u_scale = 0.f;
+};
+
+struct SHSource
+{
+	bool is_cube = false;
+	rhi::DataFormat format = rhi::DataFormat::UNDEFINED;
+	uint32_t stride = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	const uint8_t* data = nullptr;
+	uint64_t row_pitch = 0;
+	uint64_t slice_pitch = 0;
+	std::vector<float> cos_phi;
+	std::vector<float> sin_phi;
+};
+
+}
+
+static glm::vec3 FetchTexel(rhi::DataFormat format, const uint8_t* texel)
+{
+	switch (format)
+	{
+	case rhi::DataFormat::R32G32B32A32_SFLOAT:
+	{
+		float rgba[4];
+		memcpy(rgba, texel, sizeof(rgba));
+		return glm::vec3(rgba[0], rgba[1], rgba[2]);
+	}
+	case rhi::DataFormat::R16G16B16A16_SFLOAT:
+	{
+		uint16_t rgba[4];
+		memcpy(rgba, texel, sizeof(rgba));
+		return glm::vec3(glm::unpackHalf1x16(rgba[0]), glm::unpackHalf1x16(rgba[1]), glm::unpackHalf1x16(rgba[2]));
+	}
+	case rhi::DataFormat::R8G8B8A8_UNORM:
+		return glm::vec3(texel[0], texel[1], texel[2]) * (1.f / 255.f);
+	default:
+		return glm::vec3(0.f);
+	}
+}
+
+// Direction through the texel center, faces and texel coordinates follow the cube map addressing of the vulkan spec
+static glm::vec3 CubeTexelDirection(uint32_t face, float u, float v)
+{
+	switch (face)
+	{
+	case 0: return glm::vec3(1.f, -v, -u);
+	case 1: return glm::vec3(-1.f, -v, u);
+	case 2: return glm::vec3(u, 1.f, v);
+	case 3: return glm::vec3(u, -1.f, -v);
+	case 4: return glm::vec3(u, -v, 1.f);
+	default: return glm::vec3(-u, -v, -1.f);
+	}
+}
+
+static void AddRowSum(const float acc[9][3], float acc_weight, SHPartialSum& sum)
+{
+	for (uint32_t i = 0; i < 9; i++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+			sum.sh[i][c] += acc[i][c];
+	}
+	sum.weight += acc_weight;
+}
+
+template<bool equirect>
+static void AccumulateRowScalar(const SHRowMapping& m, const SHSource& src, const uint8_t* row, uint32_t begin, uint32_t end, SHPartialSum& sum)
+{
+	float acc[9][3] = {};
+	float acc_weight = 0.f;
+	for (uint32_t x = begin; x < end; x++)
+	{
+		glm::vec3 d;
+		float w;
+		if constexpr (equirect)
+		{
+			d = glm::vec3(m.cos_lat * m.cos_phi[x], m.sin_lat, m.cos_lat * m.sin_phi[x]);
+			w = m.cos_lat;
+		}
+		else
+		{
+			const float u = (float(x) + 0.5f) * m.u_scale - 1.f;
+			const glm::vec3 r = m.origin + u * m.axis;
+			const float inv_len = 1.f / std::sqrt(glm::dot(r, r));
+			d = r * inv_len;
+			w = inv_len * inv_len * inv_len;
+		}
+
+		const glm::vec3 wr = FetchTexel(src.format, row + uint64_t(src.stride) * x) * w;
+		const float poly[9] = { 1.f, d.y, d.z, d.x, d.x * d.y, d.y * d.z, 3.f * d.z * d.z - 1.f, d.x * d.z, d.x * d.x - d.y * d.y };
+		for (uint32_t i = 0; i < 9; i++)
+		{
+			acc[i][0] += wr.x * poly[i];
+			acc[i][1] += wr.y * poly[i];
+			acc[i][2] += wr.z * poly[i];
+		}
+		acc_weight += w;
+	}
+
+	AddRowSum(acc, acc_weight, sum);
+}
+
+#ifdef QK_SH_AVX2
+// h holds a half float in the low 16 bits of each lane, the upper bits are ignored
+QK_SH_TARGET_AVX2 static inline __m256 HalfToFloatAvx2(__m256i h)
+{
+	const __m256i exp_mantissa = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x7fff)), 13);
+	const __m256i sign = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(0x8000)), 16);
+
+	// Multiplying by 2^112 rebiases the exponent and normalizes denormals
+	__m256 f = _mm256_mul_ps(_mm256_castsi256_ps(exp_mantissa), _mm256_castsi256_ps(_mm256_set1_epi32(0x77800000)));
+
+	// Inf and NaN keep an all ones exponent
+	const __m256i is_inf_nan = _mm256_cmpgt_epi32(exp_mantissa, _mm256_set1_epi32(0x0f7fffff));
+	const __m256 inf_nan = _mm256_castsi256_ps(_mm256_or_si256(exp_mantissa, _mm256_set1_epi32(0x70000000)));
+	f = _mm256_blendv_ps(f, inf_nan, _mm256_castsi256_ps(is_inf_nan));
+
+	return _mm256_or_ps(f, _mm256_castsi256_ps(sign));
+}
+
+// Loads rgb of 8 consecutive texels
+QK_SH_TARGET_AVX2 static inline void FetchTexelsAvx2(rhi::DataFormat format, const uint8_t* texels, __m256& r, __m256& g, __m256& b)
+{
+	switch (format)
+	{
+	case rhi::DataFormat::R32G32B32A32_SFLOAT:
+	{
+		const __m256i index = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+		const float* p = reinterpret_cast<const float*>(texels);
+		r = _mm256_i32gather_ps(p, index, 4);
+		g = _mm256_i32gather_ps(p + 1, index, 4);
+		b = _mm256_i32gather_ps(p + 2, index, 4);
+		break;
+	}
+	case rhi::DataFormat::R16G16B16A16_SFLOAT:
+	{
+		const __m256i index = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+		const int* p = reinterpret_cast<const int*>(texels);
+		const __m256i rg = _mm256_i32gather_epi32(p, index, 4);
+		const __m256i ba = _mm256_i32gather_epi32(p + 1, index, 4);
+		r = HalfToFloatAvx2(rg);
+		g = HalfToFloatAvx2(_mm256_srli_epi32(rg, 16));
+		b = HalfToFloatAvx2(ba);
+		break;
+	}
+	default: // R8G8B8A8_UNORM
+	{
+		const __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(texels));
+		const __m256i mask = _mm256_set1_epi32(0xff);
+		const __m256 scale = _mm256_set1_ps(1.f / 255.f);
+		r = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(rgba, mask)), scale);
+		g = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(rgba, 8), mask)), scale);
+		b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(rgba, 16), mask)), scale);
+		break;
+	}
+	}
+}
+
+QK_SH_TARGET_AVX2 static inline float HorizontalSumAvx2(__m256 v)
+{
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_movehdup_ps(s));
+	return _mm_cvtss_f32(s);
+}
+
+// 8 texels per iteration, the remainder of the row goes through the scalar kernel
+template<bool equirect>
+QK_SH_TARGET_AVX2 static void AccumulateRowAvx2(const SHRowMapping& m, const SHSource& src, const uint8_t* row, SHPartialSum& sum)
+{
+	const uint32_t simd_end = src.width & ~7u;
+
+	__m256 acc[9][3];
+	for (uint32_t i = 0; i < 9; i++)
+		acc[i][0] = acc[i][1] = acc[i][2] = _mm256_setzero_ps();
+	__m256 acc_weight = _mm256_setzero_ps();
+
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 three = _mm256_set1_ps(3.f);
+	const __m256 lane_center = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+	for (uint32_t x = 0; x < simd_end; x += 8)
+	{
+		__m256 dx, dy, dz, w;
+		if constexpr (equirect)
+		{
+			w = _mm256_set1_ps(m.cos_lat);
+			dx = _mm256_mul_ps(w, _mm256_loadu_ps(m.cos_phi + x));
+			dy = _mm256_set1_ps(m.sin_lat);
+			dz = _mm256_mul_ps(w, _mm256_loadu_ps(m.sin_phi + x));
+		}
+		else
+		{
+			const __m256 u = _mm256_fmsub_ps(_mm256_add_ps(_mm256_set1_ps(float(x)), lane_center), _mm256_set1_ps(m.u_scale), one);
+			const __m256 rx = _mm256_fmadd_ps(u, _mm256_set1_ps(m.axis.x), _mm256_set1_ps(m.origin.x));
+			const __m256 ry = _mm256_fmadd_ps(u, _mm256_set1_ps(m.axis.y), _mm256_set1_ps(m.origin.y));
+			const __m256 rz = _mm256_fmadd_ps(u, _mm256_set1_ps(m.axis.z), _mm256_set1_ps(m.origin.z));
+			const __m256 len2 = _mm256_fmadd_ps(rx, rx, _mm256_fmadd_ps(ry, ry, _mm256_mul_ps(rz, rz)));
+			const __m256 inv_len = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+			dx = _mm256_mul_ps(rx, inv_len);
+			dy = _mm256_mul_ps(ry, inv_len);
+			dz = _mm256_mul_ps(rz, inv_len);
+			w = _mm256_mul_ps(_mm256_mul_ps(inv_len, inv_len), inv_len);
+		}
+
+		__m256 wr[3];
+		FetchTexelsAvx2(src.format, row + uint64_t(src.stride) * x, wr[0], wr[1], wr[2]);
+		for (uint32_t c = 0; c < 3; c++)
+			wr[c] = _mm256_mul_ps(wr[c], w);
+
+		const __m256 poly[8] = {
+			dy, dz, dx,
+			_mm256_mul_ps(dx, dy),
+			_mm256_mul_ps(dy, dz),
+			_mm256_fmsub_ps(_mm256_mul_ps(three, dz), dz, one),
+			_mm256_mul_ps(dx, dz),
+			_mm256_fmsub_ps(dx, dx, _mm256_mul_ps(dy, dy)),
+		};
+
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			acc[0][c] = _mm256_add_ps(acc[0][c], wr[c]);
+			for (uint32_t i = 0; i < 8; i++)
+				acc[i + 1][c] = _mm256_fmadd_ps(wr[c], poly[i], acc[i + 1][c]);
+		}
+		acc_weight = _mm256_add_ps(acc_weight, w);
+	}
+
+	float row_acc[9][3];
+	for (uint32_t i = 0; i < 9; i++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+			row_acc[i][c] = HorizontalSumAvx2(acc[i][c]);
+	}
+	AddRowSum(row_acc, HorizontalSumAvx2(acc_weight), sum);
+
+	if (simd_end < src.width)
+		AccumulateRowScalar<equirect>(m, src, row, simd_end, src.width, sum);
+}
+#endif
+
+// Rows of a cubemap are numbered face by face
+static void AccumulateRows(const SHSource& src, uint32_t row_begin, uint32_t row_end, bool use_simd, SHPartialSum& sum)
+{
+	for (uint32_t r = row_begin; r < row_end; r++)
+	{
+		SHRowMapping m;
+		const uint8_t* row;
+		if (src.is_cube)
+		{
+			const uint32_t face = r / src.height;
+			const uint32_t y = r % src.height;
+			const float v = 2.f * (float(y) + 0.5f) / float(src.height) - 1.f;
+			m.origin = CubeTexelDirection(face, 0.f, v);
+			m.axis = CubeTexelDirection(face, 1.f, v) - m.origin;
+			m.u_scale = 2.f / float(src.width);
+			row = src.data + src.slice_pitch * face + src.row_pitch * y;
+		}
+		else
+		{
+			const double lat = ((double(r) + 0.5) / double(src.height) - 0.5) * glm::pi<double>();
+			m.cos_phi = src.cos_phi.data();
+			m.sin_phi = src.sin_phi.data();
+			m.cos_lat = float(std::cos(lat));
+			m.sin_lat = float(std::sin(lat));
+			row = src.data + src.row_pitch * r;
+		}
+
+#ifdef QK_SH_AVX2
+		if (use_simd)
+		{
+			if (src.is_cube)
+				AccumulateRowAvx2<false>(m, src, row, sum);
+			else
+				AccumulateRowAvx2<true>(m, src, row, sum);
+			continue;
+		}
+#endif
+		if (src.is_cube)
+			AccumulateRowScalar<false>(m, src, row, 0, src.width, sum);
+		else
+			AccumulateRowScalar<true>(m, src, row, 0, src.width, sum);
+	}
+}
+
+bool IsSHProjectionSimdSupported()
+{
+#if defined(QK_SH_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+	static const bool supported = []()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		__cpuid(info, 1);
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		const bool os_avx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+		__cpuidex(info, 7, 0);
+		return fma && os_avx && (info[1] & (1 << 5)) != 0;
+	}();
+	return supported;
+#elif defined(QK_SH_AVX2)
+	static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return supported;
+#else
+	return false;
+#endif
+}
+
+SHL2 ProjectRadianceSH(const ImageAsset& image, const SHProjectionDesc& desc)
+{
+	QK_PROFILE_SCOPE("ProjectRadianceSH");
+
+	SHL2 result = {};
+	if (image.format != rhi::DataFormat::R8G8B8A8_UNORM && image.format != rhi::DataFormat::R16G16B16A16_SFLOAT
+		&& image.format != rhi::DataFormat::R32G32B32A32_SFLOAT)
+	{
+		QK_CORE_LOGW_TAG("Renderer", "ProjectRadianceSH: Unsupported image format");
+		return result;
+	}
+
+	SHSource src;
+	src.is_cube = image.type == rhi::ImageType::TYPE_CUBE;
+	if (src.is_cube && image.arraySize < 6)
+	{
+		QK_CORE_LOGW_TAG("Renderer", "ProjectRadianceSH: Cubemap has {} layers", image.arraySize);
+		return result;
+	}
+
+	// Importers don't always fill in the layout, the data is laid out like this either way
+	rhi::TextureFormatLayout layout;
+	layout.SetUp2D(image.format, image.width, image.height, image.arraySize, image.mipLevels);
+	if (image.data.size() < layout.GetRequiredSize())
+	{
+		QK_CORE_LOGW_TAG("Renderer", "ProjectRadianceSH: Image data is smaller than its layout");
+		return result;
+	}
+
+	const auto& mip_info = layout.GetMipInfo(std::min(desc.mip_level, layout.GetMipLevels() - 1));
+	src.format = image.format;
+	src.stride = layout.GetBlockStride();
+	src.width = mip_info.width;
+	src.height = mip_info.height;
+	src.data = image.data.data() + mip_info.offset;
+	src.row_pitch = mip_info.row_pitch;
+	src.slice_pitch = mip_info.slice_pitch;
+
+	if (!src.is_cube)
+	{
+		src.cos_phi.resize(src.width);
+		src.sin_phi.resize(src.width);
+		for (uint32_t x = 0; x < src.width; x++)
+		{
+			const double phi = ((double(x) + 0.5) / double(src.width) - 0.5) * 2.0 * glm::pi<double>();
+			src.cos_phi[x] = float(std::cos(phi));
+			src.sin_phi[x] = float(std::sin(phi));
+		}
+	}
+
+	const bool use_simd = desc.use_simd && IsSHProjectionSimdSupported();
+	const uint32_t row_count = src.is_cube ? src.height * 6 : src.height;
+	const uint32_t group_count = (row_count + sh_rows_per_group - 1) / sh_rows_per_group;
+	std::vector<SHPartialSum> partials(group_count);
+
+	auto project_groups = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t g = begin; g < end; g++)
+			AccumulateRows(src, g * sh_rows_per_group, std::min((g + 1) * sh_rows_per_group, row_count), use_simd, partials[g]);
+	};
+
+	if (desc.job_system && desc.job_system->GetNumWorkerThreads() > 0 && group_count > 1)
+	{
+		JobSystem::Counter counter;
+		desc.job_system->Dispatch(group_count, 1, project_groups, &counter);
+		desc.job_system->Wait(&counter, 1);
+	}
+	else
+	{
+		project_groups(0, group_count);
+	}
+
+	SHPartialSum total;
+	for (const SHPartialSum& p : partials)
+	{
+		for (uint32_t i = 0; i < 9; i++)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+				total.sh[i][c] += p.sh[i][c];
+		}
+		total.weight += p.weight;
+	}
+
+	if (total.weight <= 0.0)
+		return result;
+
+	// The weights only hold up to a constant factor, normalize them to the area of the sphere
+	const double scale = 4.0 * glm::pi<double>() / total.weight;
+	for (uint32_t i = 0; i < 9; i++)
+		result[i] = glm::vec3(total.sh[i][0], total.sh[i][1], total.sh[i][2]) * float(sh_constants[i] * scale);
+
+	return result;
+}
+
+SHL2 ConvolveIrradianceSH(const SHL2& radiance)
+{
+	const float pi = glm::pi<float>();
+	const float band_factors[3] = { pi, 2.f * pi / 3.f, pi / 4.f };
+
+	SHL2 irradiance;
+	for (uint32_t i = 0; i < 9; i++)
+		irradiance[i] = radiance[i] * band_factors[i == 0 ? 0 : (i < 4 ? 1 : 2)];
+
+	return irradiance;
+}
+
+glm::vec3 EvaluateSH(const SHL2& sh, const glm::vec3& d)
+{
+	glm::vec3 result = sh[0] * 0.282095f;
+	result += sh[1] * (0.488603f * d.y);
+	result += sh[2] * (0.488603f * d.z);
+	result += sh[3] * (0.488603f * d.x);
+	result += sh[4] * (1.092548f * d.x * d.y);
+	result += sh[5] * (1.092548f * d.y * d.z);
+	result += sh[6] * (0.315392f * (3.f * d.z * d.z - 1.f));
+	result += sh[7] * (1.092548f * d.x * d.z);
+	result += sh[8] * (0.546274f * (d.x * d.x - d.y * d.y));
+	return result;
+}
+
+IrradianceParameters ToIrradianceParameters(const SHL2& irradiance)
+{
+	IrradianceParameters params;
+	for (uint32_t i = 0; i < 9; i++)
+		params.sh[i] = glm::vec4(irradiance[i], 0.f);
+
+	return params;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include "Quark/Asset/ImageAsset.h"
+#include "Quark/Render/RenderParameters.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+namespace quark
+{
+class JobSystem;
+
+// Order 2 (9 coefficient) real spherical harmonics, rgb per coefficient, in the order
+// Y00, Y1-1 (y), Y10 (z), Y11 (x), Y2-2 (xy), Y2-1 (yz), Y20 (3z^2 - 1), Y21 (xz), Y22 (x^2 - y^2)
+using SHL2 = std::array<glm::vec3, 9>;
+
+struct SHProjectionDesc
+{
+	uint32_t mip_level = 0;				// clamped to the last level, L2 doesn't need more than a few thousand texels
+	JobSystem* job_system = nullptr;	// rows are projected on the workers if set, results are identical either way
+	bool use_simd = true;				// AVX2 kernels where the cpu supports them
+};
+
+// Projects the radiance of an environment into L2 spherical harmonics on the cpu. The image is either an equirectangular
+// 2D image, addressed like equirect_to_cube.frag, or a cubemap. Supports RGBA8, RGBA16F and RGBA32F texels.
+SHL2 ProjectRadianceSH(const ImageAsset& image, const SHProjectionDesc& desc = {});
+
+// Convolves radiance with the clamped cosine lobe, E(n) = EvaluateSH(irradiance, n) is the irradiance at a surface with normal n
+SHL2 ConvolveIrradianceSH(const SHL2& radiance);
+
+glm::vec3 EvaluateSH(const SHL2& sh, const glm::vec3& direction);
+
+IrradianceParameters ToIrradianceParameters(const SHL2& irradiance);
+
+// Whether ProjectRadianceSH() can use the AVX2 kernels on this cpu
+bool IsSHProjectionSimdSupported();
+
+}
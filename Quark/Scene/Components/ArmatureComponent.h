@@ -1,5 +1,6 @@
 #pragma once
 #include "Quark/Ecs/Component.h"
+#include "Quark/Ecs/EntityHandle.h"
 #include "Quark/Core/UUID.h"
 #include "Quark/Animation/SkeletonAsset.h"
 
@@ -11,9 +12,9 @@ namespace quark
 	{
 		QK_COMPONENT_TYPE_DECL(ArmatureCmpt)
 
-		std::vector<Entity*> bone_entities;
-		Entity* root_bone_entity = nullptr;
-		std::unordered_map<uint32_t, Entity*> bone_index_to_entity_map;
+		std::vector<EntityHandle> bone_entities;
+		EntityHandle root_bone_entity;
+		std::vector<EntityHandle> bone_index_to_entity; // indexed by bone index
 		std::vector<glm::mat4> joint_matrices;
 		// AssetID skeleton_asset_id;
 		Ref<SkeletonAsset> skeleton_asset;
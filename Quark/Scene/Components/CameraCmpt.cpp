@@ -12,12 +12,22 @@ namespace quark {
 CameraCmpt::CameraCmpt(float _aspect, float _fov, float _zNear, float _zFar)
     : aspect(_aspect), fov(_fov), zNear(_zNear), zFar(_zFar)
 {
-    EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& e) {
-        aspect = static_cast<float>(e.width) / e.height;
-    });
+    // Scenes can be loaded without a running application, e.g. by the scene converter
+    if (EventManager::IsAllocated())
+    {
+        m_resizeSubscription = EventManager::Get().Subscribe<WindowResizeEvent>([this](const WindowResizeEvent& e) {
+            aspect = static_cast<float>(e.width) / e.height;
+        });
+    }
 
 }
 
+CameraCmpt::~CameraCmpt()
+{
+    if (EventManager::IsAllocated())
+        EventManager::Get().Unsubscribe(m_resizeSubscription);
+}
+
 glm::mat4 CameraCmpt::GetViewMatrix()
 {
     // view matrix transform geometry from world space to eye/view space
@@ -1,5 +1,6 @@
 #pragma once
 #include "Quark/Events/ApplicationEvent.h"
+#include "Quark/Events/EventManager.h"
 #include "Quark/Scene/Components/TransformCmpt.h"
 
 #include <glm/glm.hpp>
@@ -14,12 +15,16 @@ public:
     float zFar;
 
     CameraCmpt(float aspect = 1.f, float fov = 60.f, float zNear = 0.1f, float zFar = 100.f);
+    ~CameraCmpt();
     QK_COMPONENT_TYPE_DECL(Camera)
     
     glm::mat4 GetViewMatrix();
     glm::mat4 GetProjectionMatrix();
 
     void OnWindowResize(const WindowResizeEvent& e);
+
+private:
+    EventManager::SubscriptionId m_resizeSubscription = EventManager::invalid_subscription;
 };
 
 }
\ No newline at end of file
@@ -29,6 +29,16 @@ void RelationshipCmpt::AddChildEntity(Entity* child)
     m_childEntities.push_back(child);
 }
 
+void RelationshipCmpt::AddChildEntitiesUnchecked(Entity* const* children, size_t count)
+{
+    m_childEntities.reserve(m_childEntities.size() + count);
+    for (size_t i = 0; i < count; i++)
+    {
+        children[i]->GetComponent<RelationshipCmpt>()->m_parentEntity = GetEntity();
+        m_childEntities.push_back(children[i]);
+    }
+}
+
 void RelationshipCmpt::RemoveChildEntity(Entity* child)
 {
     QK_CORE_ASSERT(child != nullptr)
@@ -15,6 +15,10 @@ public:
 
     void RemoveChildEntity(Entity* child);
 
+    // Bulk version of AddChildEntity() for loaders. The caller guarantees the children are
+    // unique and don't have a parent yet, so the per-child checks are skipped.
+    void AddChildEntitiesUnchecked(Entity* const* children, size_t count);
+
 private:
     Entity* m_parentEntity = nullptr;
     std::vector<Entity*> m_childEntities;
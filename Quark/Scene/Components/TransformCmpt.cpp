@@ -205,7 +205,10 @@ void TransformCmpt::UpdateWorldMatrix_Parent()
 void TransformCmpt::SetDirty(bool b)
 {
     if (b)
+    {
 		m_flags |= Flags::DIRTY;
+        GetEntity()->MarkChanged<TransformCmpt>(); // world matrix is going to change
+    }
 	else
 		m_flags &= ~Flags::DIRTY;
 }
@@ -213,7 +216,10 @@ void TransformCmpt::SetDirty(bool b)
 void TransformCmpt::SetParentDirty(bool b)
 {
 	if (b)
+    {
 		m_flags |= Flags::PARENT_DIRTY;
+        GetEntity()->MarkChanged<TransformCmpt>();
+    }
 	else
 		m_flags &= ~Flags::PARENT_DIRTY;
 }
@@ -1,5 +1,7 @@
 #include "Quark/qkpch.h"
 #include "Quark/Scene/Scene.h"
+#include "Quark/Core/Profiler.h"
+#include "Quark/Ecs/EntityCommandBuffer.h"
 #include "Quark/Scene/Components/CommonCmpts.h"
 #include "Quark/Scene/Components/TransformCmpt.h"
 #include "Quark/Scene/Components/MeshRendererCmpt.h"
@@ -18,7 +20,7 @@ namespace quark {
 void Scene::BuildBoneEntities(Entity* bone_entity, uint32_t bone_index, ArmatureCmpt* armature_cmpt)
 {
     auto skeleton_asset = armature_cmpt->skeleton_asset;
-    armature_cmpt->bone_index_to_entity_map[bone_index] = bone_entity;
+    armature_cmpt->bone_index_to_entity[bone_index] = bone_entity->GetHandle();
 
     auto* transformCmpt = bone_entity->GetComponent<TransformCmpt>();
     transformCmpt->SetLocalPosition(skeleton_asset->bone_translations[bone_index]);
@@ -35,11 +37,18 @@ void Scene::BuildBoneEntities(Entity* bone_entity, uint32_t bone_index, Armature
 }
 
 Scene::Scene(const std::string& name)
-    : sceneName(name), m_main_camera_entity(nullptr),
+    : sceneName(name),
       m_opaques(m_entity_registry.GetEntityGroup<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>()->GetComponentGroup()),
       m_transparents(m_entity_registry.GetEntityGroup<RenderableCmpt, RenderInfoCmpt, TransparentCmpt>()->GetComponentGroup())
 
 {
+    // Instance ids are reused once their RenderInfoCmpt is gone, however it was removed
+    m_entity_registry.SetComponentRemovedCallback<RenderInfoCmpt>([this](Entity&, Component& component)
+    {
+        const uint32_t instance_id = static_cast<RenderInfoCmpt&>(component).instance_id;
+        if (instance_id != RenderInfoCmpt::invalid_instance_id)
+            m_free_instance_ids.push_back(instance_id);
+    });
 }
 
 Scene::~Scene()
@@ -64,9 +73,26 @@ void Scene::DeleteEntity(Entity* entity)
         DeleteEntity(c);
 
     // Delete entity
+    m_id_to_entity_map.erase(entity->GetComponent<IdCmpt>()->id);
     m_entity_registry.DeleteEntity(entity);
 }
 
+void Scene::ReserveEntities(uint32_t count)
+{
+    m_entity_registry.GetEntities().reserve(count);
+    m_id_to_entity_map.reserve(count);
+}
+
+void Scene::PlaybackCommands(EntityCommandQueue& queue)
+{
+    QK_PROFILE_SCOPE("Scene::PlaybackCommands");
+
+    EntityCommandQueue::PlaybackHooks hooks;
+    hooks.create_entity = [this]() { return CreateEntity(); };
+    hooks.destroy_entity = [this](Entity* entity) { DeleteEntity(entity); };
+    queue.Playback(m_entity_registry, hooks);
+}
+
 void Scene::AttachChild(Entity* child, Entity* parent)
 {
     auto* childRelationshipCmpt = child->GetComponent<RelationshipCmpt>();
@@ -119,7 +145,7 @@ Entity* Scene::CreateEntityWithID(UUID id, const std::string& name, Entity* pare
     }
 
     QK_CORE_ASSERT(m_id_to_entity_map.find(id) == m_id_to_entity_map.end())
-    m_id_to_entity_map[id] = newEntity;
+    m_id_to_entity_map[id] = newEntity->GetHandle();
 
     return newEntity;
 }
@@ -129,7 +155,7 @@ Entity* Scene::GetEntityWithID(UUID id)
 {
     auto find = m_id_to_entity_map.find(id);
     if (find != m_id_to_entity_map.end())
-        return find->second;
+        return m_entity_registry.GetEntity(find->second);
     else
         return nullptr;
 }
@@ -168,14 +194,8 @@ std::vector<Entity*> Scene::GetChildEntities(Entity* parent, bool recursive)
 
 Entity* Scene::GetMainCameraEntity()
 {
-    if (m_main_camera_entity)
-    {
-        return m_main_camera_entity;
-    }
-    else 
-    {
-        return nullptr;
-    }
+    // Null if the camera entity was deleted
+    return m_entity_registry.GetEntity(m_main_camera_entity);
 }
 
 void Scene::AddArmatureComponent(Entity* entity, Ref<SkeletonAsset> skeleton_asset)
@@ -184,15 +204,16 @@ void Scene::AddArmatureComponent(Entity* entity, Ref<SkeletonAsset> skeleton_ass
 
     auto* armature_cmpt = entity->AddComponent<ArmatureCmpt>();
     armature_cmpt->skeleton_asset = skeleton_asset;
+    armature_cmpt->bone_index_to_entity.resize(skeleton_asset->bone_names.size());
 
     // build skeleton hierarchy
     Entity* root_bone_entity = CreateEntity(skeleton_asset->bone_names[skeleton_asset->root_bone_index], entity);
     BuildBoneEntities(root_bone_entity, skeleton_asset->root_bone_index, armature_cmpt);
 
-    armature_cmpt->root_bone_entity = root_bone_entity;
-    armature_cmpt->bone_entities.push_back(root_bone_entity);
-    std::vector<Entity*> child_bone_entities = GetChildEntities(root_bone_entity, true);
-    armature_cmpt->bone_entities.insert(armature_cmpt->bone_entities.end(), child_bone_entities.begin(), child_bone_entities.end());
+    armature_cmpt->root_bone_entity = root_bone_entity->GetHandle();
+    armature_cmpt->bone_entities.push_back(root_bone_entity->GetHandle());
+    for (Entity* child : GetChildEntities(root_bone_entity, true))
+        armature_cmpt->bone_entities.push_back(child->GetHandle());
 }
 
 void Scene::AddStaticMeshComponent(Entity* entity, Ref<MeshAsset> mesh_asset)
@@ -228,9 +249,23 @@ void Scene::AddBackGroundComponent(Entity* entity, Ref<ImageAsset> cubemap, cons
 
 void Scene::AddRenderableComponent(Entity* entity, Ref<IRenderable> renderable)
 {
+    // Adding an existing component constructs it again, keep its instance id
+    uint32_t instance_id = RenderInfoCmpt::invalid_instance_id;
+    if (auto* render_info = entity->GetComponent<RenderInfoCmpt>())
+        instance_id = render_info->instance_id;
+
     auto* renderableCmpt = entity->AddComponent<RenderableCmpt>();
     auto* renderInfoCmpt = entity->AddComponent<RenderInfoCmpt>();
     renderableCmpt->renderable = renderable;
+    if (instance_id != RenderInfoCmpt::invalid_instance_id)
+        renderInfoCmpt->instance_id = instance_id;
+    else if (!m_free_instance_ids.empty())
+    {
+        renderInfoCmpt->instance_id = m_free_instance_ids.back();
+        m_free_instance_ids.pop_back();
+    }
+    else
+        renderInfoCmpt->instance_id = m_instance_id_count++;
     if (renderable->GetMeshDrawPipeline() == DrawPipeline::Opaque)
         entity->AddComponent<OpaqueCmpt>();
     else
@@ -239,14 +274,15 @@ void Scene::AddRenderableComponent(Entity* entity, Ref<IRenderable> renderable)
 
 void Scene::GatherVisibleOpaqueRenderables(const math::Frustum& frustum, VisibilityList& list)
 {
+    QK_PROFILE_SCOPE("Scene::GatherVisibleOpaqueRenderables");
+
     for (size_t i = 0; i < m_opaques.size(); ++i)
     {
         auto& object = m_opaques[i];
         auto* render_info = GetComponent<RenderInfoCmpt>(object);
         auto* renderable = GetComponent<RenderableCmpt>(object);
 
-        math::Aabb transfromed_aabb = renderable->renderable->GetStaticAabb()->Transform(render_info->world_transform);
-        if (frustum.CheckSphere(transfromed_aabb))
+        if (frustum.CheckSphere(render_info->world_aabb))
 		{
             list.push_back({ renderable->renderable.get(), render_info });
 		}
@@ -255,10 +291,12 @@ void Scene::GatherVisibleOpaqueRenderables(const math::Frustum& frustum, Visibil
 
 void Scene::OnUpdate(TimeStep delta_time)
 {
+    QK_PROFILE_SCOPE("Scene::OnUpdate");
+
     // update main camera movement
-    if (m_main_camera_entity)
+    if (Entity* main_camera_entity = GetMainCameraEntity())
 	{
-		auto* movCmpt = m_main_camera_entity->GetComponent<MoveControlCmpt>();
+		auto* movCmpt = main_camera_entity->GetComponent<MoveControlCmpt>();
         if (movCmpt)
 			movCmpt->Update(delta_time);
 	}
@@ -303,6 +341,8 @@ void Scene::OnUpdate(TimeStep delta_time)
 
 void Scene::RunAnimationUpdateSystem(TimeStep delta_time)
 {
+    QK_PROFILE_SCOPE("Scene::RunAnimationUpdateSystem");
+
     auto& groupVector = GetComponents<AnimationCmpt, ArmatureCmpt, TransformCmpt>();
 
     for (auto& group : groupVector)
@@ -323,7 +363,9 @@ void Scene::RunAnimationUpdateSystem(TimeStep delta_time)
         for (auto& channel : animation_asset->channels)
         {
             AnimationSampler& sampler = animation_asset->samplers[channel.samplerIndex];
-            Entity* bone_entity = armature_cmpt->bone_index_to_entity_map[channel.boneIndex];
+            Entity* bone_entity = m_entity_registry.GetEntity(armature_cmpt->bone_index_to_entity[channel.boneIndex]);
+            if (!bone_entity)
+                continue;
             TransformCmpt* bone_transform_cmpt = bone_entity->GetComponent<TransformCmpt>();
 
             for (size_t i = 0; i < sampler.inputs.size() - 1; i++)
@@ -371,6 +413,8 @@ void Scene::RunAnimationUpdateSystem(TimeStep delta_time)
 
 void Scene::RunJointsUpdateSystem()
 {
+    QK_PROFILE_SCOPE("Scene::RunJointsUpdateSystem");
+
     auto& groupVector = GetComponents<ArmatureCmpt, TransformCmpt>();
 
     for (auto& group : groupVector)
@@ -385,7 +429,9 @@ void Scene::RunJointsUpdateSystem()
         for (size_t i = 0; i < skeleton_asset->bone_names.size(); i++)
         {
             glm::mat4 inverse_world_transform = glm::inverse(skin_entity_transform_cmpt->GetWorldMatrix());
-            Entity* bone_entity = armature_cmpt->bone_index_to_entity_map[i];
+            Entity* bone_entity = m_entity_registry.GetEntity(armature_cmpt->bone_index_to_entity[i]);
+            if (!bone_entity)
+                continue;
             TransformCmpt* transform_cmpt = bone_entity->GetComponent<TransformCmpt>();
             glm::mat4 joint_matrix = transform_cmpt->GetWorldMatrix() * skeleton_asset->inverse_bind_matrices[i];
             armature_cmpt->joint_matrices[i] = inverse_world_transform * joint_matrix;
@@ -396,14 +442,27 @@ void Scene::RunJointsUpdateSystem()
 
 void Scene::RunRenderInfoUpdateSystem()
 {
-    // update static meshes
-    auto& static_meshes = GetComponents<RenderInfoCmpt, TransformCmpt>();
-    for (auto& group : static_meshes)
-	{
-		auto* renderInfoCmpt = GetComponent<RenderInfoCmpt>(group);
-		auto* transformCmpt = GetComponent<TransformCmpt>(group);
-		renderInfoCmpt->world_transform = transformCmpt->GetWorldMatrix();
-	}
+    QK_PROFILE_SCOPE("Scene::RunRenderInfoUpdateSystem");
+
+    // update static meshes, only the ones that moved or were just added
+    const uint32_t tick = m_entity_registry.GetChangeTick();
+    auto* static_meshes = m_entity_registry.GetEntityGroup<RenderInfoCmpt, TransformCmpt>();
+    static_meshes->ForEachChangedSince<TransformCmpt, RenderInfoCmpt, RenderableCmpt>(m_render_info_sync_tick,
+        [](Entity& entity, ComponentGroup<RenderInfoCmpt, TransformCmpt>& group)
+        {
+            auto* renderInfoCmpt = GetComponent<RenderInfoCmpt>(group);
+            auto* transformCmpt = GetComponent<TransformCmpt>(group);
+            renderInfoCmpt->world_transform = transformCmpt->GetWorldMatrix();
+
+            if (auto* renderableCmpt = entity.GetComponent<RenderableCmpt>())
+                renderInfoCmpt->world_aabb = renderableCmpt->renderable->GetStaticAabb()->Transform(renderInfoCmpt->world_transform);
+
+            // Stamped with 'tick', so this system won't pick it up again but later stages can
+            entity.MarkChanged<RenderInfoCmpt>();
+        });
+
+    m_render_info_sync_tick = tick;
+    m_entity_registry.AdvanceChangeTick();
 
     // update skinned meshes
     //auto& skinned_meshes = GetComponents<RenderInfoCmpt, TransformCmpt, ArmatureCmpt>();
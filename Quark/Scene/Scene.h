@@ -13,6 +13,7 @@
 namespace quark {
 
 struct CameraCmpt;
+class EntityCommandQueue;
 struct Texture;
 struct ArmatureCmpt;
 struct SkeletonAsset;
@@ -39,13 +40,18 @@ public:
     Entity* CreateEntityWithID(UUID id, const std::string& name = "", Entity* parent = nullptr);
     Entity* GetEntityWithID(UUID id);
     Entity* GetEntityWithName(const std::string& name);
+    Entity* GetEntity(EntityHandle handle) const { return m_entity_registry.GetEntity(handle); }
     Entity* GetParentEntity(Entity* entity);
     std::vector<Entity*> GetChildEntities(Entity* parent, bool recursive);
     std::vector<Entity*>& GetEntities() { return m_entity_registry.GetEntities(); }
     void DeleteEntity(Entity* entity);
+    void ReserveEntities(uint32_t count);
     void AttachChild(Entity* child, Entity* parent);
     void DetachChild(Entity* child);
 
+    // Apply structural changes recorded by systems, created entities get the default components
+    void PlaybackCommands(EntityCommandQueue& queue);
+
     // components
     void AddArmatureComponent(Entity* entity, Ref<SkeletonAsset> skeleton_asset);
     void AddRenderableComponent(Entity* entity, Ref<IRenderable> renderable);
@@ -55,6 +61,36 @@ public:
     void GatherVisibleOpaqueRenderables(const math::Frustum& frustum, VisibilityList& list);
     void GatherVisibleTransparentRenderables(const math::Frustum& frustum, VisibilityList& list);
 
+    // Instance ids (RenderInfoCmpt::instance_id) are below this, ids of deleted entities are reused
+    uint32_t GetInstanceIdCapacity() const { return m_instance_id_count; }
+
+    // Calls func(RenderInfoCmpt&) for every renderable whose render info was added or changed after since_tick,
+    // returns the tick to pass next time. Same bookkeeping as RunRenderInfoUpdateSystem().
+    template<typename Func>
+    uint32_t ForEachChangedRenderInfo(uint32_t since_tick, Func&& func)
+    {
+        const uint32_t tick = m_entity_registry.GetChangeTick();
+        m_entity_registry.GetEntityGroup<RenderableCmpt, RenderInfoCmpt>()->ForEachChangedSince<RenderInfoCmpt>(since_tick,
+            [&func](Entity& entity, ComponentGroup<RenderableCmpt, RenderInfoCmpt>& group) { func(*GetComponent<RenderInfoCmpt>(group)); });
+        m_entity_registry.AdvanceChangeTick();
+        return tick;
+    }
+
+    // Calls func(RenderableCmpt&) for every opaque renderable whose RenderableCmpt was added or replaced after since_tick,
+    // returns the tick to pass next time. Removed renderables aren't visited, they change GetOpaqueRenderablesVersion().
+    template<typename Func>
+    uint32_t ForEachChangedOpaqueRenderable(uint32_t since_tick, Func&& func)
+    {
+        const uint32_t tick = m_entity_registry.GetChangeTick();
+        m_entity_registry.GetEntityGroup<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>()->ForEachChangedSince<RenderableCmpt>(since_tick,
+            [&func](Entity& entity, ComponentGroup<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>& group) { func(*GetComponent<RenderableCmpt>(group)); });
+        m_entity_registry.AdvanceChangeTick();
+        return tick;
+    }
+
+    // Bumped whenever an entity joins or leaves the opaque renderables, e.g. for GpuDrivenRenderer which caches them
+    uint32_t GetOpaqueRenderablesVersion() { return m_entity_registry.GetEntityGroup<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>()->GetMembershipVersion(); }
+
     template<typename... Ts>
     ComponentGroupVector<Ts...>& GetComponents() 
     { 
@@ -73,16 +109,32 @@ public:
         return m_entity_registry.GetEntityGroup<Ts...>()->GetEntities();
     }
 
+    // e.g. GetComponents<RenderInfoCmpt, TransformCmpt>(Without<ArmatureCmpt>{})
+    template<typename... Ts, typename... Us>
+    ComponentGroupVector<Ts...>& GetComponents(Without<Us...> exclude)
+    {
+        return m_entity_registry.GetEntityGroup<Ts...>(exclude)->GetComponentGroup();
+    }
+
+    template<typename... Ts, typename... Us>
+    std::vector<Entity*>& GetAllEntitiesWith(Without<Us...> exclude)
+    {
+        return m_entity_registry.GetEntityGroup<Ts...>(exclude)->GetEntities();
+    }
+
     // utils
-    void SetMainCameraEntity(Entity* cam) { m_main_camera_entity = cam; }
+    void SetMainCameraEntity(Entity* cam) { m_main_camera_entity = cam ? cam->GetHandle() : EntityHandle(); }
     Entity* GetMainCameraEntity();
 
 private:
     void BuildBoneEntities(Entity*bone_intity, uint32_t bone_index, ArmatureCmpt* armature_cmpt);
 
     EntityRegistry m_entity_registry;
-    Entity* m_main_camera_entity;
-    std::unordered_map<uint64_t, Entity*> m_id_to_entity_map;
+    uint32_t m_render_info_sync_tick = 0; // change tick RunRenderInfoUpdateSystem() last ran at
+    uint32_t m_instance_id_count = 0;
+    std::vector<uint32_t> m_free_instance_ids;
+    EntityHandle m_main_camera_entity;
+    std::unordered_map<uint64_t, EntityHandle> m_id_to_entity_map;
     std::unordered_map<std::string, Entity*> m_name_to_entity_map;
 
     ComponentGroupVector<RenderableCmpt, RenderInfoCmpt, OpaqueCmpt>& m_opaques; 
@@ -2,6 +2,9 @@
 #include "Quark/Scene/SceneSerializer.h"
 #include "Quark/Core/Application.h"
 #include "Quark/Core/Util/SerializationUtils.h"
+#include "Quark/Core/JobSystem.h"
+#include "Quark/Core/MappedFile.h"
+#include "Quark/Core/Profiler.h"
 #include "Quark/Asset/AssetManager.h"
 #include "Quark/Scene/Scene.h"
 #include "Quark/Scene/Components/CommonCmpts.h"
@@ -79,8 +82,7 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 		out << YAML::Key << "MeshComponent";
 
 		out << YAML::BeginMap; 
-		// TODO
-		// out << YAML::Key << "AssetID" << YAML::Value << meshCmpt->sharedMesh->GetAssetID();
+		QK_SERIALIZE_PROPERTY_ASSET(AssetID, meshCmpt->mesh_asset, out);
 		out << YAML::EndMap;
 	}
 		
@@ -110,8 +112,8 @@ static void SerializeEntity(YAML::Emitter& out, Entity* entity)
 	//out << YAML::EndMap; // Entity
 }
 
-SceneSerializer::SceneSerializer(Ref<Scene>& scene)
-	: m_Scene(scene)
+SceneSerializer::SceneSerializer(Ref<Scene>& scene, Ref<JobSystem> jobSystem)
+	: m_Scene(scene), m_JobSystem(jobSystem)
 {
 
 }
@@ -136,12 +138,6 @@ void SceneSerializer::Serialize(const std::filesystem::path& filepath)
 
 }
 
-void SceneSerializer::SerializeBinary(AssetID scene)
-{
-	// Not implemented
-	QK_CORE_VERIFY(false);
-}
-
 bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 {
 	YAML::Node data = YAML::LoadFile(filepath.string());
@@ -205,12 +201,9 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 			if (meshCmpt)
 			{
 				auto* mc = deserializedEntity->AddComponent<MeshCmpt>();
-				uint64_t assetId = meshCmpt["AssetID"].as<uint64_t>();
-				auto mesh = AssetManager::Get().GetAsset<MeshAsset>(assetId);
-				
-				// TODO
-				//mc->sharedMesh = mesh;
-				//mc->uniqueMesh = nullptr;
+				uint64_t assetId = meshCmpt["AssetID"] ? meshCmpt["AssetID"].as<uint64_t>() : 0;
+				if (assetId != 0 && AssetManager::IsAllocated())
+					mc->mesh_asset = AssetManager::Get().GetAsset<MeshAsset>(assetId);
 			}
 
 			//auto meshRendererCmpt = entity["MeshRendererComponent"];
@@ -258,11 +251,450 @@ bool SceneSerializer::Deserialize(const std::filesystem::path& filepath)
 }
 
 
-bool SceneSerializer::DeserializeBinary(AssetID scene)
+////////////////////////////////////// Binary format /////////////////////////////////////
+//
+// [BinarySceneHeader][BinarySceneChunk x chunkCount][chunk data, each 16 byte aligned]
+// Entities are stored depth first, so a parent always comes before its children and the
+// children keep their order. Per-entity tables (ids, parents, names, transforms) have one
+// element per entity, sparse component tables store the entity index in every element.
+
+namespace {
+
+constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+{
+	return uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24);
+}
+
+constexpr uint32_t SCENE_BINARY_MAGIC = MakeFourCC('Q', 'K', 'S', 'B');
+constexpr uint32_t SCENE_BINARY_VERSION = 1;
+constexpr uint32_t SCENE_BINARY_NO_PARENT = ~0u;
+constexpr uint32_t SCENE_BINARY_LOAD_GROUP_SIZE = 4096; // entities per job
+
+enum SceneChunkType : uint32_t
+{
+	SCENE_CHUNK_IDS = MakeFourCC('I', 'D', 'S', ' '),
+	SCENE_CHUNK_PARENTS = MakeFourCC('P', 'R', 'N', 'T'),
+	SCENE_CHUNK_NAMES = MakeFourCC('N', 'A', 'M', 'E'),
+	SCENE_CHUNK_STRINGS = MakeFourCC('S', 'T', 'R', 'S'),
+	SCENE_CHUNK_TRANSFORMS = MakeFourCC('T', 'R', 'F', 'M'),
+	SCENE_CHUNK_CAMERAS = MakeFourCC('C', 'A', 'M', 'R'),
+	SCENE_CHUNK_MESHES = MakeFourCC('M', 'E', 'S', 'H'),
+};
+
+struct BinarySceneHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entityCount;
+	uint32_t chunkCount;
+	uint32_t sceneNameOffset; // into the string table
+	uint32_t sceneNameLength;
+	uint64_t reserved;
+};
+
+struct BinarySceneChunk
+{
+	uint32_t type;
+	uint32_t count;
+	uint32_t stride;
+	uint32_t reserved;
+	uint64_t offset;
+	uint64_t size;
+};
+
+struct BinaryName
+{
+	uint32_t offset; // into the string table
+	uint32_t length; // 0 if the entity has no NameCmpt
+};
+
+struct BinaryTransform
+{
+	float position[3];
+	float rotation[4]; // x, y, z, w
+	float scale[3];
+};
+
+struct BinaryCamera
+{
+	uint32_t entity;
+	float fov;
+	float zNear;
+	float zFar;
+	float aspect;
+};
+
+struct BinaryMesh
+{
+	uint32_t entity;
+	uint32_t reserved;
+	uint64_t assetId;
+};
+
+static_assert(sizeof(BinarySceneHeader) == 32 && sizeof(BinarySceneChunk) == 32);
+
+class BinarySceneWriter
+{
+public:
+	uint32_t AddString(const std::string& str)
+	{
+		uint32_t offset = (uint32_t)m_strings.size();
+		m_strings.insert(m_strings.end(), str.begin(), str.end());
+		return offset;
+	}
+
+	template<typename T>
+	void AddChunk(uint32_t type, const std::vector<T>& elements)
+	{
+		AddChunk(type, (uint32_t)elements.size(), sizeof(T), elements.data(), elements.size() * sizeof(T));
+	}
+
+	void AddChunk(uint32_t type, uint32_t count, uint32_t stride, const void* data, size_t size)
+	{
+		BinarySceneChunk chunk = {};
+		chunk.type = type;
+		chunk.count = count;
+		chunk.stride = stride;
+		chunk.size = size;
+		m_chunks.push_back(chunk);
+
+		const byte* begin = static_cast<const byte*>(data);
+		m_chunkData.emplace_back(begin, begin + size);
+	}
+
+	bool Write(const std::filesystem::path& filepath, BinarySceneHeader header)
+	{
+		AddChunk(SCENE_CHUNK_STRINGS, (uint32_t)m_strings.size(), 1, m_strings.data(), m_strings.size());
+
+		header.magic = SCENE_BINARY_MAGIC;
+		header.version = SCENE_BINARY_VERSION;
+		header.chunkCount = (uint32_t)m_chunks.size();
+
+		uint64_t offset = sizeof(BinarySceneHeader) + m_chunks.size() * sizeof(BinarySceneChunk);
+		for (auto& chunk : m_chunks)
+		{
+			offset = (offset + 15) & ~uint64_t(15);
+			chunk.offset = offset;
+			offset += chunk.size;
+		}
+
+		std::vector<byte> file(offset, 0);
+		std::memcpy(file.data(), &header, sizeof(header));
+		std::memcpy(file.data() + sizeof(header), m_chunks.data(), m_chunks.size() * sizeof(BinarySceneChunk));
+		for (size_t i = 0; i < m_chunks.size(); i++)
+		{
+			if (!m_chunkData[i].empty())
+				std::memcpy(file.data() + m_chunks[i].offset, m_chunkData[i].data(), m_chunkData[i].size());
+		}
+
+		std::ofstream fout(filepath, std::ios::binary);
+		if (!fout)
+			return false;
+		fout.write(reinterpret_cast<const char*>(file.data()), file.size());
+		return fout.good();
+	}
+
+private:
+	std::vector<char> m_strings;
+	std::vector<BinarySceneChunk> m_chunks;
+	std::vector<std::vector<byte>> m_chunkData;
+};
+
+class BinarySceneReader
+{
+public:
+	bool Open(const std::filesystem::path& filepath)
+	{
+		if (!m_file.Open(filepath))
+			return false;
+
+		if (m_file.GetSize() < sizeof(BinarySceneHeader))
+			return false;
+
+		std::memcpy(&m_header, m_file.GetData(), sizeof(m_header));
+		if (m_header.magic != SCENE_BINARY_MAGIC || m_header.version != SCENE_BINARY_VERSION)
+			return false;
+
+		uint64_t table_end = sizeof(BinarySceneHeader) + uint64_t(m_header.chunkCount) * sizeof(BinarySceneChunk);
+		if (table_end > m_file.GetSize())
+			return false;
+
+		m_chunks = reinterpret_cast<const BinarySceneChunk*>(m_file.GetData() + sizeof(BinarySceneHeader));
+		for (uint32_t i = 0; i < m_header.chunkCount; i++)
+		{
+			const BinarySceneChunk& chunk = m_chunks[i];
+			if (chunk.offset > m_file.GetSize() || chunk.size > m_file.GetSize() - chunk.offset ||
+				uint64_t(chunk.count) * chunk.stride != chunk.size)
+				return false;
+		}
+
+		return true;
+	}
+
+	const BinarySceneHeader& GetHeader() const { return m_header; }
+
+	// nullptr if the chunk is missing or its layout doesn't match T
+	template<typename T>
+	const T* GetChunk(uint32_t type, uint32_t* out_count = nullptr) const
+	{
+		for (uint32_t i = 0; i < m_header.chunkCount; i++)
+		{
+			if (m_chunks[i].type != type)
+				continue;
+			if (m_chunks[i].stride != sizeof(T))
+				return nullptr;
+
+			if (out_count)
+				*out_count = m_chunks[i].count;
+			return reinterpret_cast<const T*>(m_file.GetData() + m_chunks[i].offset);
+		}
+
+		if (out_count)
+			*out_count = 0;
+		return nullptr;
+	}
+
+private:
+	MappedFile m_file;
+	BinarySceneHeader m_header = {};
+	const BinarySceneChunk* m_chunks = nullptr;
+};
+
+}
+
+void SceneSerializer::SerializeBinary(const std::filesystem::path& filepath)
+{
+	QK_PROFILE_FUNCTION();
+
+	// Depth first order, parents before children
+	std::vector<Entity*> entities;
+	std::unordered_map<Entity*, uint32_t> entityToIndex;
+	{
+		auto& allEntities = m_Scene->GetAllEntitiesWith<IdCmpt, RelationshipCmpt>();
+		entities.reserve(allEntities.size());
+		entityToIndex.reserve(allEntities.size());
+
+		std::vector<Entity*> stack;
+		for (auto* root : allEntities)
+		{
+			if (root->GetComponent<RelationshipCmpt>()->GetParentEntity() != nullptr)
+				continue;
+
+			stack.push_back(root);
+			while (!stack.empty())
+			{
+				Entity* e = stack.back();
+				stack.pop_back();
+				entityToIndex[e] = (uint32_t)entities.size();
+				entities.push_back(e);
+
+				auto& children = e->GetComponent<RelationshipCmpt>()->GetChildEntities();
+				for (auto it = children.rbegin(); it != children.rend(); ++it)
+					stack.push_back(*it);
+			}
+		}
+	}
+
+	const uint32_t entityCount = (uint32_t)entities.size();
+
+	BinarySceneWriter writer;
+	std::vector<uint64_t> ids(entityCount);
+	std::vector<uint32_t> parents(entityCount);
+	std::vector<BinaryName> names(entityCount);
+	std::vector<BinaryTransform> transforms(entityCount);
+	std::vector<BinaryCamera> cameras;
+	std::vector<BinaryMesh> meshes;
+
+	for (uint32_t i = 0; i < entityCount; i++)
+	{
+		Entity* e = entities[i];
+		ids[i] = e->GetComponent<IdCmpt>()->id;
+
+		Entity* parent = e->GetComponent<RelationshipCmpt>()->GetParentEntity();
+		parents[i] = parent ? entityToIndex.at(parent) : SCENE_BINARY_NO_PARENT;
+
+		if (auto* nameCmpt = e->GetComponent<NameCmpt>())
+			names[i] = { writer.AddString(nameCmpt->name), (uint32_t)nameCmpt->name.size() };
+		else
+			names[i] = { 0, 0 };
+
+		auto* transformCmpt = e->GetComponent<TransformCmpt>();
+		glm::vec3 position = transformCmpt->GetLocalPosition();
+		glm::quat rotation = transformCmpt->GetLocalRotate();
+		glm::vec3 scale = transformCmpt->GetLocalScale();
+		transforms[i] = { { position.x, position.y, position.z }, { rotation.x, rotation.y, rotation.z, rotation.w }, { scale.x, scale.y, scale.z } };
+
+		if (auto* cameraCmpt = e->GetComponent<CameraCmpt>())
+			cameras.push_back({ i, cameraCmpt->fov, cameraCmpt->zNear, cameraCmpt->zFar, cameraCmpt->aspect });
+
+		if (auto* meshCmpt = e->GetComponent<MeshCmpt>())
+			meshes.push_back({ i, 0, meshCmpt->mesh_asset ? (uint64_t)meshCmpt->mesh_asset->GetAssetID() : 0 });
+	}
+
+	writer.AddChunk(SCENE_CHUNK_IDS, ids);
+	writer.AddChunk(SCENE_CHUNK_PARENTS, parents);
+	writer.AddChunk(SCENE_CHUNK_NAMES, names);
+	writer.AddChunk(SCENE_CHUNK_TRANSFORMS, transforms);
+	writer.AddChunk(SCENE_CHUNK_CAMERAS, cameras);
+	writer.AddChunk(SCENE_CHUNK_MESHES, meshes);
+
+	BinarySceneHeader header = {};
+	header.entityCount = entityCount;
+	header.sceneNameOffset = writer.AddString(m_Scene->sceneName);
+	header.sceneNameLength = (uint32_t)m_Scene->sceneName.size();
+
+	if (!writer.Write(filepath, header))
+		QK_CORE_LOGE_TAG("Scene", "Failed to write binary scene file: {}", filepath.string());
+}
+
+bool SceneSerializer::DeserializeBinary(const std::filesystem::path& filepath)
+{
+	QK_PROFILE_FUNCTION();
+
+	BinarySceneReader reader;
+	if (!reader.Open(filepath))
+	{
+		QK_CORE_LOGE_TAG("Scene", "Failed to load binary scene file: {}", filepath.string());
+		return false;
+	}
+
+	const BinarySceneHeader& header = reader.GetHeader();
+	const uint32_t entityCount = header.entityCount;
+
+	uint32_t idCount, parentCount, nameCount, transformCount, stringCount, cameraCount, meshCount;
+	const uint64_t* ids = reader.GetChunk<uint64_t>(SCENE_CHUNK_IDS, &idCount);
+	const uint32_t* parents = reader.GetChunk<uint32_t>(SCENE_CHUNK_PARENTS, &parentCount);
+	const BinaryName* names = reader.GetChunk<BinaryName>(SCENE_CHUNK_NAMES, &nameCount);
+	const BinaryTransform* transforms = reader.GetChunk<BinaryTransform>(SCENE_CHUNK_TRANSFORMS, &transformCount);
+	const char* strings = reader.GetChunk<char>(SCENE_CHUNK_STRINGS, &stringCount);
+	const BinaryCamera* cameras = reader.GetChunk<BinaryCamera>(SCENE_CHUNK_CAMERAS, &cameraCount);
+	const BinaryMesh* meshes = reader.GetChunk<BinaryMesh>(SCENE_CHUNK_MESHES, &meshCount);
+
+	auto validString = [stringCount](uint32_t offset, uint32_t length) { return uint64_t(offset) + length <= stringCount; };
+	bool valid = ids && parents && names && transforms && (strings || stringCount == 0) &&
+		idCount == entityCount && parentCount == entityCount && nameCount == entityCount && transformCount == entityCount &&
+		validString(header.sceneNameOffset, header.sceneNameLength);
+	for (uint32_t i = 0; valid && i < entityCount; i++)
+		valid = (parents[i] == SCENE_BINARY_NO_PARENT || parents[i] < i) && validString(names[i].offset, names[i].length);
+	for (uint32_t i = 0; valid && i < cameraCount; i++)
+		valid = cameras[i].entity < entityCount;
+	for (uint32_t i = 0; valid && i < meshCount; i++)
+		valid = meshes[i].entity < entityCount;
+
+	if (!valid)
+	{
+		QK_CORE_LOGE_TAG("Scene", "Binary scene file: {} is corrupted", filepath.string());
+		return false;
+	}
+
+	m_Scene->sceneName = std::string(strings + header.sceneNameOffset, header.sceneNameLength);
+	QK_CORE_LOGI_TAG("Scene", "Deserializing binary scene: {} ({} entities)", m_Scene->sceneName, entityCount);
+
+	// Structural changes go through the entity registry, which is single threaded
+	std::vector<Entity*> entities(entityCount);
+	{
+		QK_PROFILE_SCOPE("CreateEntities");
+		m_Scene->ReserveEntities(entityCount);
+
+		std::string name;
+		for (uint32_t i = 0; i < entityCount; i++)
+		{
+			name.assign(strings ? strings + names[i].offset : "", names[i].length);
+			entities[i] = m_Scene->CreateEntityWithID(ids[i], name);
+		}
+
+		for (uint32_t i = 0; i < cameraCount; i++)
+		{
+			auto* cc = entities[cameras[i].entity]->AddComponent<CameraCmpt>();
+			cc->fov = cameras[i].fov;
+			cc->zNear = cameras[i].zNear;
+			cc->zFar = cameras[i].zFar;
+			cc->aspect = cameras[i].aspect;
+		}
+
+		for (uint32_t i = 0; i < meshCount; i++)
+		{
+			auto* mc = entities[meshes[i].entity]->AddComponent<MeshCmpt>();
+			if (meshes[i].assetId != 0 && AssetManager::IsAllocated())
+				mc->mesh_asset = AssetManager::Get().GetAsset<MeshAsset>(meshes[i].assetId);
+		}
+	}
+
+	// Children of every parent, flattened. Depth first order keeps the original child order.
+	std::vector<uint32_t> childOffsets(entityCount + 1, 0);
+	std::vector<Entity*> children(entityCount);
+	{
+		for (uint32_t i = 0; i < entityCount; i++)
+		{
+			if (parents[i] != SCENE_BINARY_NO_PARENT)
+				childOffsets[parents[i] + 1]++;
+		}
+		for (uint32_t i = 0; i < entityCount; i++)
+			childOffsets[i + 1] += childOffsets[i];
+
+		std::vector<uint32_t> cursor(childOffsets.begin(), childOffsets.end() - 1);
+		for (uint32_t i = 0; i < entityCount; i++)
+		{
+			if (parents[i] != SCENE_BINARY_NO_PARENT)
+				children[cursor[parents[i]]++] = entities[i];
+		}
+	}
+
+	// Every job only touches the components of its own entities (and the parent pointers of
+	// their children), so transforms and relationships are filled in parallel
+	auto fillComponents = [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const BinaryTransform& t = transforms[i];
+			auto* tc = entities[i]->GetComponent<TransformCmpt>();
+			tc->SetLocalPosition(glm::vec3(t.position[0], t.position[1], t.position[2]));
+			tc->SetLocalRotate(glm::quat(t.rotation[3], t.rotation[0], t.rotation[1], t.rotation[2]));
+			tc->SetLocalScale(glm::vec3(t.scale[0], t.scale[1], t.scale[2]));
+
+			uint32_t childCount = childOffsets[i + 1] - childOffsets[i];
+			if (childCount > 0)
+				entities[i]->GetComponent<RelationshipCmpt>()->AddChildEntitiesUnchecked(&children[childOffsets[i]], childCount);
+		}
+	};
+
+	{
+		QK_PROFILE_SCOPE("FillComponents");
+		if (m_JobSystem && entityCount > SCENE_BINARY_LOAD_GROUP_SIZE)
+		{
+			JobSystem::Counter counter;
+			m_JobSystem->Dispatch(entityCount, SCENE_BINARY_LOAD_GROUP_SIZE, fillComponents, &counter);
+			m_JobSystem->Wait(&counter, 1);
+		}
+		else
+		{
+			fillComponents(0, entityCount);
+		}
+	}
+
+	return true;
+}
+
+bool SceneSerializer::ConvertToBinary(const std::filesystem::path& yamlPath, const std::filesystem::path& binaryPath)
+{
+	Ref<Scene> scene = CreateRef<Scene>("");
+	SceneSerializer serializer(scene);
+	if (!serializer.Deserialize(yamlPath))
+		return false;
+
+	serializer.SerializeBinary(binaryPath);
+	return true;
+}
+
+bool SceneSerializer::ConvertToYaml(const std::filesystem::path& binaryPath, const std::filesystem::path& yamlPath)
 {
-	// Not implemented
-	QK_CORE_ASSERT(false);
-	return false;
+	Ref<Scene> scene = CreateRef<Scene>("");
+	SceneSerializer serializer(scene);
+	if (!serializer.DeserializeBinary(binaryPath))
+		return false;
+
+	serializer.Serialize(yamlPath);
+	return true;
 }
 
 }
\ No newline at end of file
@@ -5,22 +5,35 @@
 
 namespace quark {
 class Scene;
+class JobSystem;
+
+// Scenes are authored in yaml (.qkscene), which diffs well but is slow to parse.
+// The binary format (.qkbscene) stores component tables as flat arrays and is memory mapped on load.
 class SceneSerializer
 {
 public:
-	SceneSerializer(Ref<Scene>& scene);
+	// Without a job system the binary loader runs on the calling thread only
+	SceneSerializer(Ref<Scene>& scene, Ref<JobSystem> jobSystem = nullptr);
 
 	void Serialize(const std::filesystem::path& filepath);
-	void SerializeBinary(AssetID scene);
+	void SerializeBinary(const std::filesystem::path& filepath);
 
 	bool Deserialize(const std::filesystem::path& filepath);
-	bool DeserializeBinary(AssetID scene);
+	bool DeserializeBinary(const std::filesystem::path& filepath);
+
+	static bool IsBinaryScene(const std::filesystem::path& filepath) { return filepath.extension() == s_BinaryExtension; }
+
+	// Converters between the two formats
+	static bool ConvertToBinary(const std::filesystem::path& yamlPath, const std::filesystem::path& binaryPath);
+	static bool ConvertToYaml(const std::filesystem::path& binaryPath, const std::filesystem::path& yamlPath);
 
 public:
 	inline static std::string_view s_FileFilter = "Quark Scene (*.qkscene)\0*.qkscene\0";
 	inline static std::string_view s_DefaultExtension = ".qkscene";
+	inline static std::string_view s_BinaryExtension = ".qkbscene";
 
 private:
 	Ref<Scene> m_Scene;
+	Ref<JobSystem> m_JobSystem;
 };
-}
\ No newline at end of file
+}
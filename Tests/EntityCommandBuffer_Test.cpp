@@ -0,0 +1,208 @@
+// Tests of EntityCommandQueue playback: commands recorded on several threads in any order have to be played back
+// in sort key order, and temporary entities have to resolve to the entities created for them.
+
+#include <Quark/Core/Logger.h>
+#include <Quark/Ecs/EntityCommandBuffer.h>
+
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <tuple>
+
+using namespace std;
+using namespace quark;
+using test::Check;
+
+struct ValueCmpt : public Component
+{
+	QK_COMPONENT_TYPE_DECL(ValueCmpt)
+
+	int value = 0;
+
+	ValueCmpt() = default;
+	ValueCmpt(int v) : value(v) {}
+};
+
+struct LinkCmpt : public Component
+{
+	QK_COMPONENT_TYPE_DECL(LinkCmpt)
+
+	int item = 0;
+
+	LinkCmpt() = default;
+	LinkCmpt(int i) : item(i) {}
+};
+
+static constexpr int num_items = 96;
+static constexpr int num_existing = 48;
+
+// What a work item of a system would record. Every item creates two entities, the first one is destroyed again
+// by every fourth item, so its slot is reused by a later item and the indices depend on the playback order.
+static void RecordItem(EntityCommandBuffer& buffer, int item, const vector<EntityHandle>& existing, EntityHandle shared)
+{
+	buffer.SetSortKey(uint32_t(item));
+
+	CommandEntity first = buffer.CreateEntity();
+	CommandEntity second = buffer.CreateEntity();
+	buffer.AddComponent<ValueCmpt>(first, 2 * item);
+	buffer.AddComponent<ValueCmpt>(second, 2 * item + 1);
+	buffer.AddComponent<LinkCmpt>(second, item);
+	if (item % 4 == 0)
+		buffer.DestroyEntity(first);
+
+	if (item < num_existing)
+	{
+		switch (item % 3)
+		{
+		case 0: buffer.DestroyEntity(existing[item]); break;
+		case 1: buffer.RemoveComponent<ValueCmpt>(existing[item]); break;
+		default: buffer.AddComponent<LinkCmpt>(existing[item], 1000 + item); break;
+		}
+	}
+
+	// Every item overwrites the same component, the highest sort key has to win
+	buffer.AddComponent<LinkCmpt>(shared, item);
+}
+
+// (handle, value, link) of every entity in the order of the registry, -1 for a missing component
+using Snapshot = vector<tuple<uint32_t, int, int>>;
+
+// Records the items on the given number of threads, each thread gets a shuffled share of them
+static Snapshot Run(uint32_t num_threads, uint32_t seed)
+{
+	EntityRegistry registry;
+	vector<EntityHandle> existing;
+	for (int i = 0; i < num_existing; i++)
+	{
+		Entity* entity = registry.CreateEntity();
+		entity->AddComponent<ValueCmpt>(-2 - i);
+		existing.push_back(entity->GetHandle());
+	}
+	const EntityHandle shared = registry.CreateEntity()->GetHandle();
+
+	vector<int> items(num_items);
+	for (int i = 0; i < num_items; i++)
+		items[i] = i;
+	if (seed != 0)
+		shuffle(items.begin(), items.end(), mt19937(seed));
+
+	EntityCommandQueue queue;
+	vector<thread> threads;
+	for (uint32_t t = 0; t < num_threads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			EntityCommandBuffer& buffer = queue.GetThreadBuffer();
+			for (size_t i = t; i < items.size(); i += num_threads)
+				RecordItem(buffer, items[i], existing, shared);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	queue.Playback(registry);
+
+	Snapshot snapshot;
+	for (Entity* entity : registry.GetEntities())
+	{
+		const ValueCmpt* value = entity->GetComponent<ValueCmpt>();
+		const LinkCmpt* link = entity->GetComponent<LinkCmpt>();
+		snapshot.emplace_back(entity->GetHandle().value, value ? value->value : -1, link ? link->item : -1);
+	}
+	return snapshot;
+}
+
+// The outcome of recording on one thread in item order, which is what playback has to reproduce
+static void TestSerial(const Snapshot& serial)
+{
+	int destroyed = 0;
+	for (int i = 0; i < num_items; i++)
+		destroyed += (i % 4 == 0) + (i < num_existing && i % 3 == 0);
+	Check(int(serial.size()) == num_existing + 1 + 2 * num_items - destroyed, "serial", "entity count");
+
+	vector<int> value_count(2 * num_items, 0);
+	int shared_link = -1;
+	for (const auto& [handle, value, link] : serial)
+	{
+		if (value >= 0)
+		{
+			value_count[value]++;
+
+			// The component recorded for the second temporary entity of an item lands on that entity, and only there
+			const int item = value / 2;
+			if (value % 2 == 1)
+				Check(link == item, "temp ids", "second entity of an item has a wrong link");
+			else
+				Check(link == -1 && item % 4 != 0, "temp ids", "first entity of an item is wrong");
+		}
+		else if (value == -1 && link >= 0 && link < num_items)
+		{
+			shared_link = link;
+		}
+	}
+
+	for (int v = 0; v < 2 * num_items; v++)
+		Check(value_count[v] == ((v % 2 == 0 && (v / 2) % 4 == 0) ? 0 : 1), "temp ids", "value is missing or duplicated");
+	Check(shared_link == num_items - 1, "sort key", "last component added isn't the one of the highest key");
+
+	// Commands on entities which existed before recording
+	for (int i = 0; i < num_existing; i++)
+	{
+		const auto found = find_if(serial.begin(), serial.end(), [i](const auto& e) { return get<1>(e) == -2 - i; });
+		const auto linked = find_if(serial.begin(), serial.end(), [i](const auto& e) { return get<2>(e) == 1000 + i; });
+		switch (i % 3)
+		{
+		case 0: Check(found == serial.end(), "existing", "destroyed entity is alive"); break;
+		case 1: Check(found == serial.end(), "existing", "removed component is alive"); break;
+		default: Check(found != serial.end() && found == linked, "existing", "added component is missing"); break;
+		}
+	}
+}
+
+static void TestThreadsMatchSerial(const Snapshot& serial)
+{
+	for (uint32_t num_threads : { 2u, 4u, 7u })
+	{
+		for (uint32_t seed : { 1u, 2u, 3u })
+		{
+			const Snapshot threaded = Run(num_threads, seed);
+			Check(threaded == serial, "threads", "playback differs from serial recording");
+		}
+	}
+}
+
+// Buffers are kept and cleared after playback, temporary ids start over for the next recording
+static void TestReuse()
+{
+	EntityRegistry registry;
+	EntityCommandQueue queue;
+	for (int frame = 0; frame < 3; frame++)
+	{
+		EntityCommandBuffer& buffer = queue.GetThreadBuffer();
+		CommandEntity entity = buffer.CreateEntity();
+		Check(entity.temp_id == 0, "reuse", "temporary ids don't start over");
+		buffer.AddComponent<ValueCmpt>(entity, frame);
+		queue.Playback(registry);
+		Check(buffer.IsEmpty(), "reuse", "buffer isn't empty after playback");
+	}
+
+	vector<int> values;
+	for (Entity* entity : registry.GetEntities())
+		values.push_back(entity->GetComponent<ValueCmpt>()->value);
+	sort(values.begin(), values.end());
+	Check(values == vector<int>{ 0, 1, 2 }, "reuse", "entities of the frames");
+}
+
+int main()
+{
+	Logger::Init();
+
+	const Snapshot serial = Run(1, 0);
+	TestSerial(serial);
+	TestThreadsMatchSerial(serial);
+	TestReuse();
+
+	return test::TestResult("EntityCommandBuffer_Test");
+}
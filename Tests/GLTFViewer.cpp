@@ -3,6 +3,8 @@
 #include <Quark/Asset/ImageImporter.h>
 #include <Quark/Render/RenderContext.h>
 #include <Quark/Render/RenderQueue.h>
+#include <Quark/Render/GpuDrivenRenderer.h>
+#include <Quark/Render/GpuScene.h>
 #include <Quark/Scene/Components/MoveControlCmpt.h>
 #include <Quark/EntryPoint.h>
 
@@ -51,6 +53,10 @@ public:
 		camera_entity->GetComponent<TransformCmpt>()->SetLocalPosition(glm::vec3(0.f, 0.f, 5.f));
 		camera_entity->AddComponent<MoveControlCmpt>();
 		m_gltf_importer.GetScene()->SetMainCameraEntity(camera_entity);
+
+		m_gpu_scene = CreateScope<GpuScene>(RenderSystem::Get().GetDevice());
+		m_gpu_driven_renderer = CreateScope<GpuDrivenRenderer>(RenderSystem::Get().GetDevice());
+		m_render_context.SetGpuScene(m_gpu_scene.get());
 	}
 
 	void OnUpdate(TimeStep ts) override final
@@ -79,9 +85,18 @@ public:
 		proj[1][1] *= -1;
 		m_render_context.SetCamera(view, proj);
 
+		// only the instances which moved since the last frame are uploaded
+		m_gpu_scene->Update(*scene);
+
 		// simple forward renderer, so we render opaque, transparent and background renderables in one go.
 		m_visibility_list.clear();
-		scene->GatherVisibleOpaqueRenderables(m_render_context.GetVisibilityFrustum(), m_visibility_list);
+		if (m_gpu_driven)
+		{
+			// culled on the gpu, only what it can't draw ends up in the visibility list
+			m_gpu_driven_renderer->Prepare(m_render_context, *scene, m_visibility_list);
+		}
+		else
+			scene->GatherVisibleOpaqueRenderables(m_render_context.GetVisibilityFrustum(), m_visibility_list);
 		m_render_queue.Reset();
 		m_render_queue.PushRenderables(m_render_context, m_visibility_list.data(), m_visibility_list.size());
 		m_render_queue.Sort();
@@ -131,11 +146,35 @@ public:
 			rhi::RenderPassInfo render_pass_info = render_system.GetRenderResourceManager().renderPassInfo_swapchainPass;
 			render_pass_info.depthAttachmentFormat = m_depth_attachment->GetDesc().format;
 
+			m_gpu_scene->Upload(*cmd);
+			if (m_gpu_driven)
+				m_gpu_driven_renderer->Cull(*cmd, m_render_context);
+
 			cmd->BeginRegion("Main pass");
-			cmd->BeginRenderPass(render_pass_info, fb_info);
-			cmd->SetViewPort(viewport);
-			cmd->SetScissor(scissor);
-			render_system.Flush(*cmd, m_render_queue, m_render_context);
+			if (m_parallel_recording)
+			{
+				// Secondary command lists inherit the viewport and scissor the primary has when they begin
+				cmd->SetViewPort(viewport);
+				cmd->SetScissor(scissor);
+				cmd->BeginRenderPass(render_pass_info, fb_info, rhi::RenderPassContents::SECONDARY_COMMAND_LISTS);
+				render_system.FlushParallel(*cmd, m_render_queue, m_render_context, *GetJobSystem());
+				if (m_gpu_driven)
+				{
+					rhi::CommandList* secondary = rhi_device->BeginSecondaryCommandList(*cmd);
+					render_system.BindCameraParameters(*secondary, m_render_context);
+					m_gpu_driven_renderer->Draw(*secondary);
+					cmd->ExecuteCommandLists(&secondary, 1);
+				}
+			}
+			else
+			{
+				cmd->BeginRenderPass(render_pass_info, fb_info);
+				cmd->SetViewPort(viewport);
+				cmd->SetScissor(scissor);
+				render_system.Flush(*cmd, m_render_queue, m_render_context);
+				if (m_gpu_driven)
+					m_gpu_driven_renderer->Draw(*cmd);
+			}
 			cmd->EndRenderPass();
 			cmd->EndRegion();
 
@@ -179,6 +218,16 @@ public:
 			ImGui::Text("FPS: %f", m_status.fps);
 			ImGui::Text("Frame Time: %f ms", m_status.lastFrameDuration);
 
+			const auto& scene_stats = m_gpu_scene->GetStats();
+			ImGui::Text("GPU scene: %u slots, %u uploaded", scene_stats.capacity, scene_stats.updates);
+
+			ImGui::Checkbox("Parallel recording", &m_parallel_recording);
+			ImGui::Checkbox("GPU driven", &m_gpu_driven);
+			if (m_gpu_driven)
+			{
+				const auto& stats = m_gpu_driven_renderer->GetStats();
+				ImGui::Text("Instances: %u Batches: %u Buckets: %u Fallbacks: %u Rebuilds: %u", stats.instances, stats.batches, stats.buckets, stats.fallbacks, stats.rebuilds);
+			}
 		}
 		ImGui::End();
 
@@ -190,6 +239,10 @@ public:
 	RenderQueue m_render_queue;
 	LightingParameters m_lighting_params;
 	VisibilityList m_visibility_list;
+	Scope<GpuScene> m_gpu_scene;
+	Scope<GpuDrivenRenderer> m_gpu_driven_renderer;
+	bool m_gpu_driven = true;
+	bool m_parallel_recording = false;
 	Ref<rhi::Image> m_depth_attachment;
 	AssetID m_cubeMapId;
 };
@@ -4,7 +4,7 @@
 #include <Quark/Render/RenderContext.h>
 #include <Quark/Render/RenderQueue.h>
 #include <Quark/Render/Skybox.h>
-#include <Quark/Render/Utils/ImageUtils.h>
+#include <Quark/Render/Utils/IBLBaker.h>
 #include <Quark/Scene/Components/MoveControlCmpt.h>
 #include <Quark/EntryPoint.h>
 
@@ -56,11 +56,18 @@ public:
 		camera_entity->AddComponent<MoveControlCmpt>();
 		m_scene->SetMainCameraEntity(camera_entity);
 
-		auto& render_system = RenderSystem::Get();
-		Ref<rhi::Device> rhi_device = render_system.GetDevice();
-		Ref<rhi::Image> hdr = RenderSystem::Get().GetRenderResourceManager().RequestImage(m_hdr);
-		Ref<rhi::Image> cube = ConvertEquirectToCube(*rhi_device, *hdr, 1);
-		m_skybox->SetCubemap(cube);
+		// Baked on the first run, later runs load the cached results
+		Ref<rhi::Device> rhi_device = RenderSystem::Get().GetDevice();
+		IBLBakeSettings ibl_settings;
+		ibl_settings.job_system = GetJobSystem().get();
+		m_ibl = BakeIBL(*rhi_device, m_hdr, ibl_settings);
+		m_skybox->SetCubemap(m_ibl.cubemap);
+
+		// Diffuse ambient of the meshes comes from the environment
+		m_lighting_params.directional.color = glm::vec3(1.0f, 0.9f, 0.8f);
+		m_lighting_params.directional.direction = glm::normalize(glm::vec3(1.f, 1.f, 1.f));
+		m_lighting_params.irradiance = ToIrradianceParameters(m_ibl.irradiance_sh);
+		m_render_context.SetLightingParameters(&m_lighting_params);
 	}
 
 	void OnUpdate(TimeStep ts) override final
@@ -181,6 +188,7 @@ public:
 		{
 			ImGui::Text("FPS: %f", m_status.fps);
 			ImGui::Text("Frame Time: %f ms", m_status.lastFrameDuration);
+			ImGui::Text("IBL: %s", m_ibl.from_cache ? "loaded from cache" : "baked");
 
 		}
 		ImGui::End();
@@ -190,11 +198,13 @@ public:
 
 	Ref<Scene> m_scene;
 	RenderContext m_render_context;
+	LightingParameters m_lighting_params;
 	RenderQueue m_render_queue;
 	Ref<rhi::Image> m_depth_attachment;
 	Ref<ImageAsset> m_cubeMap;
 	Ref<ImageAsset> m_hdr;
 	Ref<Skybox> m_skybox;
+	IBLData m_ibl;
 };
 
 namespace quark
@@ -0,0 +1,290 @@
+// Numeric tests of ProjectRadianceSH() against a reference integrator.
+
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Render/Utils/SphericalHarmonics.h>
+
+#include "TestCheck.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+
+using namespace std;
+using namespace quark;
+using test::Check;
+
+using RadianceFunction = function<glm::dvec3(const glm::dvec3&)>;
+
+// Written out independently of SphericalHarmonics.cpp, same order and normalization
+static void EvaluateBasis(const glm::dvec3& d, double y[9])
+{
+	y[0] = 0.5 * sqrt(1.0 / glm::pi<double>());
+	y[1] = sqrt(3.0 / (4.0 * glm::pi<double>())) * d.y;
+	y[2] = sqrt(3.0 / (4.0 * glm::pi<double>())) * d.z;
+	y[3] = sqrt(3.0 / (4.0 * glm::pi<double>())) * d.x;
+	y[4] = 0.5 * sqrt(15.0 / glm::pi<double>()) * d.x * d.y;
+	y[5] = 0.5 * sqrt(15.0 / glm::pi<double>()) * d.y * d.z;
+	y[6] = 0.25 * sqrt(5.0 / glm::pi<double>()) * (3.0 * d.z * d.z - 1.0);
+	y[7] = 0.5 * sqrt(15.0 / glm::pi<double>()) * d.x * d.z;
+	y[8] = 0.25 * sqrt(15.0 / glm::pi<double>()) * (d.x * d.x - d.y * d.y);
+}
+
+// Midpoint quadrature over polar angles in double precision
+static SHL2 ReferenceProjection(const RadianceFunction& radiance)
+{
+	const uint32_t theta_steps = 512;
+	const uint32_t phi_steps = 1024;
+	const double d_theta = glm::pi<double>() / theta_steps;
+	const double d_phi = 2.0 * glm::pi<double>() / phi_steps;
+
+	glm::dvec3 sum[9] = {};
+	for (uint32_t i = 0; i < theta_steps; i++)
+	{
+		const double theta = (i + 0.5) * d_theta;
+		for (uint32_t j = 0; j < phi_steps; j++)
+		{
+			const double phi = (j + 0.5) * d_phi;
+			const glm::dvec3 d(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+			const glm::dvec3 l = radiance(d) * (sin(theta) * d_theta * d_phi);
+
+			double y[9];
+			EvaluateBasis(d, y);
+			for (uint32_t k = 0; k < 9; k++)
+				sum[k] += l * y[k];
+		}
+	}
+
+	SHL2 result;
+	for (uint32_t k = 0; k < 9; k++)
+		result[k] = glm::vec3(sum[k]);
+	return result;
+}
+
+static void StoreTexel(rhi::DataFormat format, uint8_t* texel, const glm::dvec3& value)
+{
+	const glm::vec4 rgba(glm::vec3(value), 1.f);
+	switch (format)
+	{
+	case rhi::DataFormat::R32G32B32A32_SFLOAT:
+		memcpy(texel, &rgba, sizeof(rgba));
+		break;
+	case rhi::DataFormat::R16G16B16A16_SFLOAT:
+	{
+		const uint16_t halfs[4] = { glm::packHalf1x16(rgba.r), glm::packHalf1x16(rgba.g), glm::packHalf1x16(rgba.b), glm::packHalf1x16(rgba.a) };
+		memcpy(texel, halfs, sizeof(halfs));
+		break;
+	}
+	default:
+		for (uint32_t c = 0; c < 4; c++)
+			texel[c] = uint8_t(std::lround(glm::clamp(rgba[c], 0.f, 1.f) * 255.f));
+		break;
+	}
+}
+
+static ImageAsset MakeImage(rhi::DataFormat format, bool is_cube, uint32_t width, uint32_t height)
+{
+	ImageAsset image;
+	image.format = format;
+	image.type = is_cube ? rhi::ImageType::TYPE_CUBE : rhi::ImageType::TYPE_2D;
+	image.width = width;
+	image.height = height;
+	image.arraySize = is_cube ? 6 : 1;
+	image.layout.SetUp2D(format, width, height, image.arraySize, 1);
+	image.data.resize(image.layout.GetRequiredSize());
+	return image;
+}
+
+// Same mapping as equirect_to_cube.frag
+static ImageAsset MakeEquirect(rhi::DataFormat format, uint32_t width, const RadianceFunction& radiance)
+{
+	ImageAsset image = MakeImage(format, false, width, width / 2);
+	const auto& mip = image.layout.GetMipInfo(0);
+	for (uint32_t y = 0; y < image.height; y++)
+	{
+		const double lat = ((y + 0.5) / image.height - 0.5) * glm::pi<double>();
+		for (uint32_t x = 0; x < image.width; x++)
+		{
+			const double phi = ((x + 0.5) / image.width - 0.5) * 2.0 * glm::pi<double>();
+			const glm::dvec3 d(cos(lat) * cos(phi), sin(lat), cos(lat) * sin(phi));
+			StoreTexel(format, image.data.data() + mip.row_pitch * y + image.layout.GetBlockStride() * x, radiance(d));
+		}
+	}
+	return image;
+}
+
+// Cube map addressing of the vulkan spec
+static ImageAsset MakeCube(rhi::DataFormat format, uint32_t size, const RadianceFunction& radiance)
+{
+	ImageAsset image = MakeImage(format, true, size, size);
+	const auto& mip = image.layout.GetMipInfo(0);
+	for (uint32_t face = 0; face < 6; face++)
+	{
+		for (uint32_t y = 0; y < size; y++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				const double u = 2.0 * (x + 0.5) / size - 1.0;
+				const double v = 2.0 * (y + 0.5) / size - 1.0;
+				const glm::dvec3 faces[6] = { { 1, -v, -u }, { -1, -v, u }, { u, 1, v }, { u, -1, -v }, { u, -v, 1 }, { -u, -v, -1 } };
+				uint8_t* texel = image.data.data() + uint64_t(mip.slice_pitch) * face + mip.row_pitch * y + image.layout.GetBlockStride() * x;
+				StoreTexel(format, texel, radiance(glm::normalize(faces[face])));
+			}
+		}
+	}
+	return image;
+}
+
+static double MaxDifference(const SHL2& a, const SHL2& b)
+{
+	double diff = 0.0;
+	for (uint32_t i = 0; i < 9; i++)
+	{
+		for (uint32_t c = 0; c < 3; c++)
+			diff = std::max(diff, (double)std::abs(a[i][c] - b[i][c]));
+	}
+	return diff;
+}
+
+static RadianceFunction BandLimited(const SHL2& coefficients)
+{
+	return [coefficients](const glm::dvec3& d)
+	{
+		double y[9];
+		EvaluateBasis(d, y);
+		glm::dvec3 l(0.0);
+		for (uint32_t k = 0; k < 9; k++)
+			l += glm::dvec3(coefficients[k]) * y[k];
+		return l;
+	};
+}
+
+static void TestConstant()
+{
+	const glm::dvec3 c(1.0, 0.5, 0.25);
+	const RadianceFunction radiance = [c](const glm::dvec3&) { return c; };
+	const SHL2 reference = ReferenceProjection(radiance);
+
+	for (bool is_cube : { false, true })
+	{
+		const ImageAsset image = is_cube ? MakeCube(rhi::DataFormat::R32G32B32A32_SFLOAT, 32, radiance) : MakeEquirect(rhi::DataFormat::R32G32B32A32_SFLOAT, 256, radiance);
+		const SHL2 sh = ProjectRadianceSH(image);
+		Check(MaxDifference(sh, reference) < 1e-3, "constant", is_cube ? "cube differs from reference" : "equirect differs from reference", MaxDifference(sh, reference));
+
+		// Uniform radiance L gives an irradiance of pi * L for every normal
+		const glm::vec3 e = EvaluateSH(ConvolveIrradianceSH(sh), glm::normalize(glm::vec3(0.3f, -0.8f, 0.5f)));
+		Check(glm::length(e - glm::vec3(c * glm::pi<double>())) < 1e-3, "constant", "irradiance is not pi * radiance", glm::length(e - glm::vec3(c * glm::pi<double>())));
+	}
+}
+
+// A band limited environment is reproduced exactly up to the discretization of the image
+static void TestBandLimited()
+{
+	mt19937 rng(7);
+	uniform_real_distribution<float> dist(-0.3f, 0.3f);
+	SHL2 coefficients;
+	for (auto& c : coefficients)
+		c = glm::vec3(dist(rng), dist(rng), dist(rng));
+	coefficients[0] += glm::vec3(2.f);
+
+	const RadianceFunction radiance = BandLimited(coefficients);
+	const SHL2 reference = ReferenceProjection(radiance);
+	Check(MaxDifference(reference, coefficients) < 1e-4, "band limited", "reference integrator is off", MaxDifference(reference, coefficients));
+
+	const SHL2 equirect = ProjectRadianceSH(MakeEquirect(rhi::DataFormat::R32G32B32A32_SFLOAT, 256, radiance));
+	const SHL2 cube = ProjectRadianceSH(MakeCube(rhi::DataFormat::R32G32B32A32_SFLOAT, 64, radiance));
+	Check(MaxDifference(equirect, reference) < 1e-3, "band limited", "equirect differs from reference", MaxDifference(equirect, reference));
+	Check(MaxDifference(cube, reference) < 1e-3, "band limited", "cube differs from reference", MaxDifference(cube, reference));
+
+	// Halfs and bytes lose precision, bytes also need radiance in [0, 1]
+	const SHL2 half = ProjectRadianceSH(MakeEquirect(rhi::DataFormat::R16G16B16A16_SFLOAT, 256, radiance));
+	Check(MaxDifference(half, reference) < 1e-3, "band limited", "RGBA16F differs from reference", MaxDifference(half, reference));
+
+	SHL2 ldr_coefficients = coefficients;
+	for (auto& c : ldr_coefficients)
+		c *= 0.25f;
+	const RadianceFunction ldr_radiance = BandLimited(ldr_coefficients);
+	const SHL2 ldr = ProjectRadianceSH(MakeEquirect(rhi::DataFormat::R8G8B8A8_UNORM, 256, ldr_radiance));
+	Check(MaxDifference(ldr, ReferenceProjection(ldr_radiance)) < 1e-3, "band limited", "RGBA8 differs from reference", MaxDifference(ldr, ReferenceProjection(ldr_radiance)));
+}
+
+// A narrow lobe has most of its energy above L2, its projection still has to match texel for texel directions and weights
+static void TestLobe()
+{
+	const glm::dvec3 axis = glm::normalize(glm::dvec3(0.4, 0.7, -0.6));
+	const RadianceFunction radiance = [axis](const glm::dvec3& d) { return glm::dvec3(1.0, 2.0, 3.0) * pow(std::max(glm::dot(d, axis), 0.0), 8.0); };
+	const SHL2 reference = ReferenceProjection(radiance);
+
+	const SHL2 equirect = ProjectRadianceSH(MakeEquirect(rhi::DataFormat::R32G32B32A32_SFLOAT, 512, radiance));
+	const SHL2 cube = ProjectRadianceSH(MakeCube(rhi::DataFormat::R32G32B32A32_SFLOAT, 128, radiance));
+	Check(MaxDifference(equirect, reference) < 1e-4, "lobe", "equirect differs from reference", MaxDifference(equirect, reference));
+	Check(MaxDifference(cube, reference) < 1e-4, "lobe", "cube differs from reference", MaxDifference(cube, reference));
+}
+
+// Noise in every format, with rows which don't fill the last vector
+static void TestSimdMatchesScalar()
+{
+	if (!IsSHProjectionSimdSupported())
+	{
+		printf("simd: not supported on this cpu, skipped\n");
+		return;
+	}
+
+	mt19937 rng(11);
+	uniform_real_distribution<double> dist(0.0, 1.0);
+	const RadianceFunction noise = [&](const glm::dvec3&) { return glm::dvec3(dist(rng), dist(rng), dist(rng)) * 4.0; };
+	const RadianceFunction ldr_noise = [&](const glm::dvec3&) { return glm::dvec3(dist(rng), dist(rng), dist(rng)); };
+
+	for (rhi::DataFormat format : { rhi::DataFormat::R32G32B32A32_SFLOAT, rhi::DataFormat::R16G16B16A16_SFLOAT, rhi::DataFormat::R8G8B8A8_UNORM })
+	{
+		const RadianceFunction& radiance = format == rhi::DataFormat::R8G8B8A8_UNORM ? ldr_noise : noise;
+		for (bool is_cube : { false, true })
+		{
+			const ImageAsset image = is_cube ? MakeCube(format, 37, radiance) : MakeEquirect(format, 202, radiance);
+
+			SHProjectionDesc desc;
+			desc.use_simd = false;
+			const SHL2 scalar = ProjectRadianceSH(image, desc);
+			desc.use_simd = true;
+			const SHL2 simd = ProjectRadianceSH(image, desc);
+			Check(MaxDifference(scalar, simd) < 1e-4, "simd", is_cube ? "cube differs from scalar" : "equirect differs from scalar", MaxDifference(scalar, simd));
+		}
+	}
+}
+
+static void TestJobsMatchSerial(JobSystem& job_system)
+{
+	mt19937 rng(3);
+	uniform_real_distribution<double> dist(0.0, 8.0);
+	const RadianceFunction noise = [&](const glm::dvec3&) { return glm::dvec3(dist(rng), dist(rng), dist(rng)); };
+
+	for (bool is_cube : { false, true })
+	{
+		const ImageAsset image = is_cube ? MakeCube(rhi::DataFormat::R16G16B16A16_SFLOAT, 64, noise) : MakeEquirect(rhi::DataFormat::R16G16B16A16_SFLOAT, 512, noise);
+
+		SHProjectionDesc desc;
+		const SHL2 serial = ProjectRadianceSH(image, desc);
+		desc.job_system = &job_system;
+		const SHL2 parallel = ProjectRadianceSH(image, desc);
+		Check(memcmp(serial.data(), parallel.data(), sizeof(SHL2)) == 0, "jobs", is_cube ? "cube differs from serial" : "equirect differs from serial");
+	}
+}
+
+int main()
+{
+	Logger::Init();
+	JobSystem job_system;
+
+	TestConstant();
+	TestBandLimited();
+	TestLobe();
+	TestSimdMatchesScalar();
+	TestJobsMatchSerial(job_system);
+
+	return test::TestResult("SphericalHarmonics_Test");
+}
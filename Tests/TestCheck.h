@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdio>
+
+// Checks of the tests which run without a window, a failed check is printed and counted, main returns TestResult()
+namespace quark::test {
+
+inline int& GetFailureCount()
+{
+	static int failures = 0;
+	return failures;
+}
+
+inline void Check(bool condition, const char* test, const char* what)
+{
+	if (!condition)
+	{
+		printf("FAILED %s: %s\n", test, what);
+		GetFailureCount()++;
+	}
+}
+
+// value is printed on failure, e.g. the error that exceeded a bound
+inline void Check(bool condition, const char* test, const char* what, double value)
+{
+	if (!condition)
+	{
+		printf("FAILED %s: %s (%g)\n", test, what, value);
+		GetFailureCount()++;
+	}
+}
+
+inline int TestResult(const char* name)
+{
+	if (GetFailureCount() == 0)
+		printf("%s: all checks passed\n", name);
+	return GetFailureCount() == 0 ? 0 : 1;
+}
+
+}
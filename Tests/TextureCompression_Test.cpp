@@ -0,0 +1,428 @@
+// Round trip tests of the BC1, BC5 and BC7 block encoders and of TextureCooker. The blocks are decoded by
+// reference decoders written after the format specification.
+
+#include <Quark/Core/Logger.h>
+#include <Quark/Core/JobSystem.h>
+#include <Quark/Asset/TextureCompression.h>
+#include <Quark/Asset/TextureCooker.h>
+
+#include "TestCheck.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace std;
+using namespace quark;
+using test::Check;
+
+static void UnpackRGB565(uint16_t packed, int* rgb)
+{
+	const int r = (packed >> 11) & 31;
+	const int g = (packed >> 5) & 63;
+	const int b = packed & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Both the four and the three color mode, alpha is written as 255
+static void DecodeBC1(const uint8_t* block, uint8_t* texels)
+{
+	uint16_t c0, c1;
+	uint32_t indices;
+	memcpy(&c0, block, 2);
+	memcpy(&c1, block + 2, 2);
+	memcpy(&indices, block + 4, 4);
+
+	int palette[4][3];
+	UnpackRGB565(c0, palette[0]);
+	UnpackRGB565(c1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		if (c0 > c1)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int index = (indices >> (2 * i)) & 3;
+		for (int c = 0; c < 3; c++)
+			texels[i * 4 + c] = uint8_t(palette[index][c]);
+		texels[i * 4 + 3] = 255;
+	}
+}
+
+// Writes a single channel of the texels
+static void DecodeBC4(const uint8_t* block, uint8_t* texels, int channel)
+{
+	const int r0 = block[0];
+	const int r1 = block[1];
+	int palette[8] = { r0, r1 };
+	if (r0 > r1)
+	{
+		for (int i = 2; i < 8; i++)
+			palette[i] = ((8 - i) * r0 + (i - 1) * r1) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			palette[i] = ((6 - i) * r0 + (i - 1) * r1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= uint64_t(block[2 + i]) << (8 * i);
+	for (int i = 0; i < 16; i++)
+		texels[i * 4 + channel] = uint8_t(palette[(indices >> (3 * i)) & 7]);
+}
+
+struct BitReader
+{
+	const uint8_t* data;
+	uint32_t offset = 0;
+
+	uint32_t Read(uint32_t bits)
+	{
+		uint32_t value = 0;
+		for (uint32_t b = 0; b < bits; b++, offset++)
+			value |= uint32_t((data[offset >> 3] >> (offset & 7)) & 1) << b;
+		return value;
+	}
+};
+
+struct BC7Mode6Block
+{
+	uint32_t mode = 0;
+	uint32_t endpoints[2][4] = {};	// 8 bit values with the p-bit as the least significant bit
+	uint32_t indices[16] = {};
+	uint32_t bits_read = 0;
+};
+
+static BC7Mode6Block ParseBC7Mode6(const uint8_t* block)
+{
+	BC7Mode6Block result;
+	BitReader reader = { block };
+	result.mode = reader.Read(7);
+	for (int c = 0; c < 4; c++)
+	{
+		result.endpoints[0][c] = reader.Read(7);
+		result.endpoints[1][c] = reader.Read(7);
+	}
+
+	const uint32_t p0 = reader.Read(1);
+	const uint32_t p1 = reader.Read(1);
+	for (int c = 0; c < 4; c++)
+	{
+		result.endpoints[0][c] = (result.endpoints[0][c] << 1) | p0;
+		result.endpoints[1][c] = (result.endpoints[1][c] << 1) | p1;
+	}
+
+	// The anchor index has its most significant bit implied to be 0
+	for (int i = 0; i < 16; i++)
+		result.indices[i] = reader.Read(i == 0 ? 3 : 4);
+	result.bits_read = reader.offset;
+	return result;
+}
+
+static void DecodeBC7(const uint8_t* block, uint8_t* texels)
+{
+	static const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	const BC7Mode6Block parsed = ParseBC7Mode6(block);
+	for (int i = 0; i < 16; i++)
+	{
+		const uint32_t w = weights[parsed.indices[i]];
+		for (int c = 0; c < 4; c++)
+			texels[i * 4 + c] = uint8_t(((64 - w) * parsed.endpoints[0][c] + w * parsed.endpoints[1][c] + 32) >> 6);
+	}
+}
+
+static int MaxError(const uint8_t* a, const uint8_t* b, int channels)
+{
+	int error = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < channels; c++)
+			error = std::max(error, std::abs(int(a[i * 4 + c]) - int(b[i * 4 + c])));
+	}
+	return error;
+}
+
+static double SquaredError(const uint8_t* a, const uint8_t* b, int channels)
+{
+	double error = 0.0;
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			const double d = double(a[i * 4 + c]) - double(b[i * 4 + c]);
+			error += d * d;
+		}
+	}
+	return error;
+}
+
+static void MakeSolidBlock(const uint8_t* color, uint8_t* texels)
+{
+	for (int i = 0; i < 16; i++)
+		memcpy(texels + i * 4, color, 4);
+}
+
+// Smooth gradient along a color axis with a little noise, what most blocks of a real texture look like
+static void MakeGradientBlock(mt19937& rng, uint8_t* texels)
+{
+	uniform_real_distribution<float> base_dist(0.f, 255.f);
+	uniform_real_distribution<float> axis_dist(-1.f, 1.f);
+	uniform_real_distribution<float> slope_dist(-12.f, 12.f);
+	uniform_int_distribution<int> noise_dist(-2, 2);
+
+	float base[4], axis[4];
+	for (int c = 0; c < 4; c++)
+	{
+		base[c] = base_dist(rng);
+		axis[c] = axis_dist(rng);
+	}
+	const float slope_x = slope_dist(rng);
+	const float slope_y = slope_dist(rng);
+
+	for (int y = 0; y < 4; y++)
+	{
+		for (int x = 0; x < 4; x++)
+		{
+			const float t = slope_x * x + slope_y * y;
+			for (int c = 0; c < 4; c++)
+			{
+				const float v = base[c] + axis[c] * t + noise_dist(rng);
+				texels[(y * 4 + x) * 4 + c] = uint8_t(std::clamp(v, 0.f, 255.f) + 0.5f);
+			}
+		}
+	}
+}
+
+static void TestSolidBlocks()
+{
+	const uint8_t colors[][4] = { { 0, 0, 0, 255 }, { 255, 255, 255, 255 }, { 255, 0, 0, 0 }, { 12, 200, 99, 128 }, { 127, 128, 129, 7 } };
+	for (const auto& color : colors)
+	{
+		uint8_t texels[64], decoded[64];
+		MakeSolidBlock(color, texels);
+
+		// RGB565 is off by at most half a quantization step, i.e. 4 for red and blue
+		uint8_t bc1[8];
+		CompressBlockBC1(texels, bc1);
+		DecodeBC1(bc1, decoded);
+		Check(MaxError(texels, decoded, 3) <= 4, "solid", "bc1 error", MaxError(texels, decoded, 3));
+
+		uint8_t bc5[16];
+		CompressBlockBC5(texels, bc5);
+		DecodeBC4(bc5, decoded, 0);
+		DecodeBC4(bc5 + 8, decoded, 1);
+		Check(MaxError(texels, decoded, 2) == 0, "solid", "bc5 is not exact", MaxError(texels, decoded, 2));
+
+		// 7 bits plus a shared p-bit are within 1 of every 8 bit value
+		uint8_t bc7[16];
+		CompressBlockBC7(texels, bc7);
+		DecodeBC7(bc7, decoded);
+		Check(MaxError(texels, decoded, 4) <= 1, "solid", "bc7 error", MaxError(texels, decoded, 4));
+	}
+}
+
+static void TestGradientBlocks()
+{
+	mt19937 rng(5);
+	constexpr int num_blocks = 4000;
+	double bc1_error = 0.0, bc5_error = 0.0, bc7_error = 0.0;
+	for (int n = 0; n < num_blocks; n++)
+	{
+		uint8_t texels[64], decoded[64];
+		MakeGradientBlock(rng, texels);
+
+		uint8_t bc1[8];
+		CompressBlockBC1(texels, bc1);
+		DecodeBC1(bc1, decoded);
+		bc1_error += SquaredError(texels, decoded, 3);
+
+		uint8_t bc5[16];
+		CompressBlockBC5(texels, bc5);
+		DecodeBC4(bc5, decoded, 0);
+		DecodeBC4(bc5 + 8, decoded, 1);
+		bc5_error += SquaredError(texels, decoded, 2);
+
+		uint8_t bc7[16];
+		CompressBlockBC7(texels, bc7);
+		DecodeBC7(bc7, decoded);
+		bc7_error += SquaredError(texels, decoded, 4);
+	}
+
+	auto psnr = [](double squared_error, int channels) { return 10.0 * log10(255.0 * 255.0 / (squared_error / (num_blocks * 16.0 * channels) + 1e-9)); };
+	Check(psnr(bc1_error, 3) > 36.0, "gradient", "bc1 psnr", psnr(bc1_error, 3));
+	Check(psnr(bc5_error, 2) > 44.0, "gradient", "bc5 psnr", psnr(bc5_error, 2));
+	Check(psnr(bc7_error, 4) > 42.0, "gradient", "bc7 psnr", psnr(bc7_error, 4));
+}
+
+// Mode bits, field order and the implied anchor bit, for texel 0 at either end of the fitted axis. The encoder
+// puts the brighter end first, so a dark texel 0 exercises the endpoint swap.
+static void TestBC7Layout()
+{
+	for (bool dark_anchor : { false, true })
+	{
+		uint8_t texels[64];
+		for (int i = 0; i < 16; i++)
+		{
+			const int v = dark_anchor ? 16 + i * 14 : 240 - i * 14;
+			texels[i * 4 + 0] = uint8_t(v);
+			texels[i * 4 + 1] = uint8_t(v / 2);
+			texels[i * 4 + 2] = uint8_t(255 - v);
+			texels[i * 4 + 3] = 255;
+		}
+
+		uint8_t block[16];
+		CompressBlockBC7(texels, block);
+		const BC7Mode6Block parsed = ParseBC7Mode6(block);
+		Check((block[0] & 0x7f) == 0x40, "bc7 layout", "first byte is not mode 6", block[0]);
+		Check(parsed.mode == (1u << 6), "bc7 layout", "mode bits", parsed.mode);
+		Check(parsed.bits_read == 128, "bc7 layout", "block is not 128 bits", parsed.bits_read);
+
+		// Texel 0 has to be interpolated from close to the first endpoint, its index is stored in 3 bits
+		Check(parsed.indices[0] < 8, "bc7 layout", "anchor index", parsed.indices[0]);
+		Check(std::abs(int(parsed.endpoints[0][0]) - int(texels[0])) <= 16, "bc7 layout", "first endpoint is not at texel 0", parsed.endpoints[0][0]);
+		Check(parsed.indices[15] >= 8, "bc7 layout", "last texel is not at the second endpoint", parsed.indices[15]);
+
+		uint8_t decoded[64];
+		DecodeBC7(block, decoded);
+		Check(MaxError(texels, decoded, 4) <= 4, "bc7 layout", "ramp error", MaxError(texels, decoded, 4));
+	}
+}
+
+// Endpoints quantizing to the same RGB565 value select the three color mode, where only index 0 is safe to use
+static void TestBC1EqualEndpoints()
+{
+	uint8_t texels[64];
+	for (int i = 0; i < 16; i++)
+	{
+		texels[i * 4 + 0] = uint8_t(100 + (i & 1));
+		texels[i * 4 + 1] = 60;
+		texels[i * 4 + 2] = uint8_t(200 + (i & 1));
+		texels[i * 4 + 3] = 255;
+	}
+
+	uint8_t block[8];
+	CompressBlockBC1(texels, block);
+	uint16_t c0, c1;
+	uint32_t indices;
+	memcpy(&c0, block, 2);
+	memcpy(&c1, block + 2, 2);
+	memcpy(&indices, block + 4, 4);
+	Check(c0 == c1, "bc1 equal", "endpoints differ", double(c0) - double(c1));
+	Check(indices == 0, "bc1 equal", "indices are not all 0", indices);
+
+	uint8_t decoded[64];
+	DecodeBC1(block, decoded);
+	Check(MaxError(texels, decoded, 3) <= 4, "bc1 equal", "error", MaxError(texels, decoded, 3));
+}
+
+// A constant channel gives r0 == r1, which is the mode with 4 interpolated values and 0 and 255 at 6 and 7
+static void TestBC4EqualEndpoints()
+{
+	for (uint8_t value : { uint8_t(0), uint8_t(77), uint8_t(255) })
+	{
+		uint8_t texels[64];
+		for (int i = 0; i < 16; i++)
+		{
+			texels[i * 4 + 0] = value;
+			texels[i * 4 + 1] = uint8_t(i * 17);
+			texels[i * 4 + 2] = 0;
+			texels[i * 4 + 3] = 255;
+		}
+
+		uint8_t block[16];
+		CompressBlockBC5(texels, block);
+		Check(block[0] == value && block[1] == value, "bc4 equal", "endpoints are not the value", block[0]);
+
+		bool zero_indices = true;
+		for (int i = 2; i < 8; i++)
+			zero_indices = zero_indices && block[i] == 0;
+		Check(zero_indices, "bc4 equal", "indices are not all 0");
+
+		uint8_t decoded[64] = {};
+		DecodeBC4(block, decoded, 0);
+		DecodeBC4(block + 8, decoded, 1);
+		Check(MaxError(texels, decoded, 1) == 0, "bc4 equal", "constant red is not exact", MaxError(texels, decoded, 1));
+		Check(MaxError(texels, decoded, 2) <= 19, "bc4 equal", "green ramp error", MaxError(texels, decoded, 2));
+	}
+}
+
+static ImageAsset MakeNoiseImage(uint32_t width, uint32_t height)
+{
+	mt19937 rng(17);
+	uniform_int_distribution<int> dist(0, 255);
+
+	ImageAsset image;
+	image.format = rhi::DataFormat::R8G8B8A8_UNORM;
+	image.type = rhi::ImageType::TYPE_2D;
+	image.width = width;
+	image.height = height;
+	image.layout.SetUp2D(image.format, width, height, 1, 1);
+	image.data.resize(size_t(width) * height * 4);
+	for (auto& texel : image.data)
+		texel = uint8_t(dist(rng));
+	return image;
+}
+
+// Neither the split into rows and tiles nor their order may change the output
+static void TestCookerJobsMatchSerial(JobSystem& job_system)
+{
+	for (TextureRole role : { TextureRole::Color, TextureRole::Normal, TextureRole::Data })
+	{
+		for (bool compress : { true, false })
+		{
+			// Not a multiple of the block size, so the edge blocks and the small levels are covered too
+			const ImageAsset source = MakeNoiseImage(301, 190);
+
+			TextureCookSettings settings;
+			settings.role = role;
+			settings.compress = compress;
+			settings.cache_directory = "";
+
+			ImageAsset serial = source;
+			const bool serial_cooked = TextureCooker().Cook(serial, settings);
+
+			settings.job_system = &job_system;
+			ImageAsset parallel = source;
+			const bool parallel_cooked = TextureCooker().Cook(parallel, settings);
+
+			const rhi::DataFormat expected_format = compress ? TextureCooker::GetCompressedFormat(role) : rhi::DataFormat::R8G8B8A8_UNORM;
+			Check(serial_cooked && parallel_cooked, "cooker jobs", "cook failed");
+			Check(serial.format == expected_format && parallel.format == expected_format, "cooker jobs", "format", double(parallel.format));
+			Check(serial.mipLevels == 9 && parallel.mipLevels == 9, "cooker jobs", "mip levels", parallel.mipLevels);
+			Check(serial.data.size() == parallel.data.size() && memcmp(serial.data.data(), parallel.data.data(), serial.data.size()) == 0,
+				"cooker jobs", "output differs from serial", double(role));
+		}
+	}
+}
+
+int main()
+{
+	Logger::Init();
+	JobSystem job_system;
+
+	TestSolidBlocks();
+	TestGradientBlocks();
+	TestBC7Layout();
+	TestBC1EqualEndpoints();
+	TestBC4EqualEndpoints();
+	TestCookerJobsMatchSerial(job_system);
+
+	return test::TestResult("TextureCompression_Test");
+}